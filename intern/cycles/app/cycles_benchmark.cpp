@@ -0,0 +1,1082 @@
+/*
+ * Copyright 2011-2015 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Cycles Benchmark
+ *
+ * Renders a set of procedurally generated scenes, each stressing one part of
+ * the renderer, in the background on the CPU and reports the time spent
+ * loading, updating the device and rendering as JSON. Scenes are generated
+ * from fixed seeds and rendered with a fixed number of samples, so results
+ * are comparable between commits and builds. The optimized kernel can be
+ * restricted to compare instruction sets on the same machine. */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "buffers.h"
+#include "camera.h"
+#include "device.h"
+#include "integrator.h"
+#include "light.h"
+#include "mesh.h"
+#include "scene.h"
+#include "session.h"
+
+#include "util_algorithm.h"
+#include "util_args.h"
+#include "util_foreach.h"
+#include "util_hash.h"
+#include "util_image.h"
+#include "util_logging.h"
+#include "util_math.h"
+#include "util_path.h"
+#include "util_stats.h"
+#include "util_string.h"
+#include "util_system.h"
+#include "util_time.h"
+
+#include "cycles_xml.h"
+
+CCL_NAMESPACE_BEGIN
+
+struct BenchmarkOptions {
+	string scene_dir;
+	string output;
+	string cpu_kernel;
+	vector<string> scenes;
+	int width, height;
+	int samples;
+	int threads;
+	int tile_size;
+	int repeat;
+	bool quiet;
+	bool denoise;
+} options;
+
+/* Random Numbers
+ *
+ * Scene generation must not depend on the platform, so no rand(). */
+
+class BenchmarkRandom {
+public:
+	explicit BenchmarkRandom(uint seed_) : seed(seed_), index(0) {}
+
+	float next()
+	{
+		return (hash_int_2d(seed, index++) & 0xFFFFFF) * (1.0f/16777216.0f);
+	}
+
+	float range(float a, float b)
+	{
+		return a + (b - a)*next();
+	}
+
+	float3 range(float3 a, float3 b)
+	{
+		float x = range(a.x, b.x);
+		float y = range(a.y, b.y);
+		float z = range(a.z, b.z);
+		return make_float3(x, y, z);
+	}
+
+protected:
+	uint seed;
+	uint index;
+};
+
+/* Mesh Generation */
+
+class BenchmarkMesh {
+public:
+	vector<float3> P;
+	vector<int> nverts;
+	vector<int> verts;
+
+	void add_quad(int v0, int v1, int v2, int v3)
+	{
+		nverts.push_back(4);
+		verts.push_back(v0);
+		verts.push_back(v1);
+		verts.push_back(v2);
+		verts.push_back(v3);
+	}
+
+	void add_triangle(int v0, int v1, int v2)
+	{
+		nverts.push_back(3);
+		verts.push_back(v0);
+		verts.push_back(v1);
+		verts.push_back(v2);
+	}
+
+	void add_box(float3 center, float3 size)
+	{
+		int v = P.size();
+		float3 h = size*0.5f;
+
+		for(int i = 0; i < 8; i++) {
+			P.push_back(center + make_float3((i & 1)? h.x: -h.x,
+			                                 (i & 2)? h.y: -h.y,
+			                                 (i & 4)? h.z: -h.z));
+		}
+
+		add_quad(v + 0, v + 2, v + 3, v + 1);
+		add_quad(v + 4, v + 5, v + 7, v + 6);
+		add_quad(v + 0, v + 1, v + 5, v + 4);
+		add_quad(v + 2, v + 6, v + 7, v + 3);
+		add_quad(v + 0, v + 4, v + 6, v + 2);
+		add_quad(v + 1, v + 3, v + 7, v + 5);
+	}
+
+	/* grid in the xz plane with height from a few waves */
+	void add_grid(float3 center, float size, int resolution, float amplitude)
+	{
+		int v = P.size();
+
+		for(int j = 0; j <= resolution; j++) {
+			for(int i = 0; i <= resolution; i++) {
+				float u = (float)i/resolution - 0.5f;
+				float w = (float)j/resolution - 0.5f;
+				float y = amplitude*(sinf(u*23.0f)*cosf(w*17.0f) + 0.5f*sinf((u + w)*61.0f));
+
+				P.push_back(center + make_float3(u*size, y, w*size));
+			}
+		}
+
+		for(int j = 0; j < resolution; j++) {
+			for(int i = 0; i < resolution; i++) {
+				int v0 = v + j*(resolution + 1) + i;
+				int v1 = v0 + resolution + 1;
+
+				add_quad(v0, v0 + 1, v1 + 1, v1);
+			}
+		}
+	}
+
+	void add_sphere(float3 center, float radius, int segments, int rings)
+	{
+		int v = P.size();
+
+		P.push_back(center + make_float3(0.0f, -radius, 0.0f));
+
+		for(int j = 1; j < rings; j++) {
+			float theta = M_PI_F*j/rings;
+
+			for(int i = 0; i < segments; i++) {
+				float phi = M_2PI_F*i/segments;
+				float3 N = make_float3(sinf(theta)*cosf(phi), -cosf(theta), sinf(theta)*sinf(phi));
+
+				P.push_back(center + N*radius);
+			}
+		}
+
+		P.push_back(center + make_float3(0.0f, radius, 0.0f));
+
+		int top = P.size() - 1;
+
+		for(int i = 0; i < segments; i++) {
+			int i1 = (i + 1) % segments;
+
+			add_triangle(v, v + 1 + i1, v + 1 + i);
+
+			for(int j = 0; j < rings - 2; j++) {
+				int r0 = v + 1 + j*segments;
+				int r1 = r0 + segments;
+
+				add_quad(r0 + i, r0 + i1, r1 + i1, r1 + i);
+			}
+
+			int last = v + 1 + (rings - 2)*segments;
+			add_triangle(last + i, last + i1, top);
+		}
+	}
+
+	string xml(const char *attributes = "") const
+	{
+		string str = "<mesh ";
+		str += attributes;
+
+		str += " P=\"";
+		foreach(const float3& co, P)
+			str += string_printf("%g %g %g ", (double)co.x, (double)co.y, (double)co.z);
+
+		str += "\" nverts=\"";
+		foreach(int n, nverts)
+			str += string_printf("%d ", n);
+
+		str += "\" verts=\"";
+		foreach(int n, verts)
+			str += string_printf("%d ", n);
+
+		str += "\" />\n";
+
+		return str;
+	}
+};
+
+/* Scene Generation */
+
+static string xml_float3(float3 f)
+{
+	return string_printf("%g %g %g", (double)f.x, (double)f.y, (double)f.z);
+}
+
+static string xml_header(float3 camera, float fov, int max_bounce, int min_bounce = 2)
+{
+	string xml = "<cycles>\n";
+
+	xml += string_printf("<integrator min_bounce=\"%d\" max_bounce=\"%d\" max_diffuse_bounce=\"%d\" "
+	                     "max_glossy_bounce=\"%d\" max_transmission_bounce=\"%d\" max_volume_bounce=\"%d\" "
+	                     "transparent_max_bounce=\"%d\" />\n",
+	                     min_bounce, max_bounce, max_bounce, max_bounce, max_bounce, max_bounce, max_bounce);
+
+	xml += "<transform translate=\"" + xml_float3(camera) + "\">\n";
+	xml += string_printf("\t<camera type=\"perspective\" fov=\"%g\" />\n", (double)fov);
+	xml += "</transform>\n";
+
+	xml += "<background>\n"
+	       "\t<background name=\"bg\" color=\"0.6 0.7 0.9\" strength=\"0.5\" />\n"
+	       "\t<connect from=\"bg background\" to=\"output surface\" />\n"
+	       "</background>\n";
+
+	xml += "<shader name=\"diffuse\">\n"
+	       "\t<diffuse_bsdf name=\"bsdf\" color=\"0.8 0.8 0.8\" />\n"
+	       "\t<connect from=\"bsdf bsdf\" to=\"output surface\" />\n"
+	       "</shader>\n";
+
+	return xml;
+}
+
+static string xml_emission_shader(const char *name, float3 color, float strength)
+{
+	return string_printf("<shader name=\"%s\">\n"
+	                     "\t<emission name=\"emit\" color=\"%s\" strength=\"%g\" />\n"
+	                     "\t<connect from=\"emit emission\" to=\"output surface\" />\n"
+	                     "</shader>\n",
+	                     name, xml_float3(color).c_str(), (double)strength);
+}
+
+static string xml_point_light(const char *shader, float3 co, float size)
+{
+	return string_printf("<state shader=\"%s\"><light type=\"%d\" P=\"%s\" size=\"%g\" /></state>\n",
+	                     shader, (int)LIGHT_POINT, xml_float3(co).c_str(), (double)size);
+}
+
+static string xml_footer()
+{
+	return "</cycles>\n";
+}
+
+/* Many small and a few large objects, most of the time goes into building
+ * the BVH, with few bounces to keep the render itself short. */
+static bool benchmark_scene_bvh(const string& /*dir*/, string& xml)
+{
+	BenchmarkRandom rng(1);
+	BenchmarkMesh ground, boxes;
+
+	ground.add_grid(make_float3(0.0f, -1.0f, 6.0f), 20.0f, 512, 0.15f);
+
+	for(int i = 0; i < 4096; i++) {
+		float3 co = rng.range(make_float3(-5.0f, -1.0f, -1.0f), make_float3(5.0f, 2.5f, 10.0f));
+		float3 size = rng.range(make_float3(0.02f, 0.02f, 0.02f), make_float3(0.2f, 0.2f, 0.2f));
+		boxes.add_box(co, size);
+	}
+
+	xml = xml_header(make_float3(0.0f, 0.5f, -6.0f), 50.0f, 2);
+	xml += xml_emission_shader("lamp", make_float3(1.0f, 0.9f, 0.8f), 2000.0f);
+	xml += xml_point_light("lamp", make_float3(2.0f, 6.0f, 0.0f), 0.5f);
+	xml += "<state shader=\"diffuse\">\n";
+	xml += ground.xml();
+	xml += boxes.xml();
+	xml += "</state>\n";
+	xml += xml_footer();
+
+	return true;
+}
+
+/* Floor with blocks lit by many small lights of different colors. */
+static bool benchmark_scene_lights(const string& /*dir*/, string& xml)
+{
+	BenchmarkRandom rng(2);
+	BenchmarkMesh ground, blocks;
+	const int num_colors = 8;
+
+	ground.add_grid(make_float3(0.0f, -1.0f, 6.0f), 20.0f, 16, 0.0f);
+
+	for(int i = 0; i < 256; i++) {
+		float3 co = rng.range(make_float3(-6.0f, -1.0f, 0.0f), make_float3(6.0f, -1.0f, 12.0f));
+		float3 size = rng.range(make_float3(0.2f, 0.2f, 0.2f), make_float3(0.8f, 2.0f, 0.8f));
+		blocks.add_box(co + make_float3(0.0f, size.y*0.5f, 0.0f), size);
+	}
+
+	xml = xml_header(make_float3(0.0f, 1.0f, -6.0f), 50.0f, 2);
+
+	for(int i = 0; i < num_colors; i++) {
+		float3 color = rng.range(make_float3(0.2f, 0.2f, 0.2f), make_float3(1.0f, 1.0f, 1.0f));
+		xml += xml_emission_shader(string_printf("lamp%d", i).c_str(), color, 20.0f);
+	}
+
+	for(int i = 0; i < 1024; i++) {
+		float3 co = rng.range(make_float3(-8.0f, -0.9f, -2.0f), make_float3(8.0f, 3.0f, 14.0f));
+		xml += xml_point_light(string_printf("lamp%d", i % num_colors).c_str(), co, 0.02f);
+	}
+
+	for(int i = 0; i < 16; i++) {
+		float3 co = rng.range(make_float3(-8.0f, 4.0f, -2.0f), make_float3(8.0f, 4.0f, 14.0f));
+		xml += string_printf("<state shader=\"lamp%d\"><light type=\"%d\" P=\"%s\" dir=\"0 -1 0\" "
+		                     "axisu=\"1 0 0\" axisv=\"0 0 1\" sizeu=\"0.5\" sizev=\"0.5\" /></state>\n",
+		                     i % num_colors, (int)LIGHT_AREA, xml_float3(co).c_str());
+	}
+
+	xml += "<state shader=\"diffuse\">\n";
+	xml += ground.xml();
+	xml += blocks.xml();
+	xml += "</state>\n";
+	xml += xml_footer();
+
+	return true;
+}
+
+/* Sphere covered in hair, curves grown along the normal and bent down. */
+static bool benchmark_scene_hair(const string& /*dir*/, string& xml)
+{
+	BenchmarkRandom rng(3);
+	BenchmarkMesh ground, head;
+	const int num_curves = 40000;
+	const int num_keys = 6;
+	const float radius = 1.0f;
+	const float length = 0.5f;
+
+	ground.add_grid(make_float3(0.0f, -1.5f, 6.0f), 20.0f, 16, 0.0f);
+	head.add_sphere(make_float3(0.0f, 0.0f, 0.0f), radius, 64, 32);
+
+	string P, nkeys;
+
+	for(int i = 0; i < num_curves; i++) {
+		float3 N = normalize(rng.range(make_float3(-1.0f, -1.0f, -1.0f), make_float3(1.0f, 1.0f, 1.0f)));
+		float3 co = N*radius;
+		float step = length*rng.range(0.7f, 1.0f)/(num_keys - 1);
+
+		for(int k = 0; k < num_keys; k++) {
+			P += xml_float3(co) + " ";
+
+			/* gravity bends the hair down further from the root */
+			float3 dir = normalize(N + make_float3(0.0f, -0.4f*k, 0.0f));
+			co += dir*step;
+		}
+
+		nkeys += string_printf("%d ", num_keys);
+	}
+
+	xml = xml_header(make_float3(0.0f, 0.0f, -4.0f), 45.0f, 4);
+	xml += xml_emission_shader("lamp", make_float3(1.0f, 1.0f, 1.0f), 1000.0f);
+	xml += "<shader name=\"hair\">\n"
+	       "\t<hair_bsdf name=\"bsdf\" color=\"0.6 0.4 0.2\" roughnessu=\"0.2\" roughnessv=\"0.6\" />\n"
+	       "\t<connect from=\"bsdf bsdf\" to=\"output surface\" />\n"
+	       "</shader>\n";
+	xml += xml_point_light("lamp", make_float3(3.0f, 4.0f, -3.0f), 0.5f);
+
+	xml += "<state shader=\"diffuse\" interpolation=\"smooth\">\n";
+	xml += ground.xml();
+	xml += head.xml();
+	xml += "</state>\n";
+
+	xml += "<state shader=\"hair\">\n";
+	xml += "<curves radius=\"0.004\" P=\"" + P + "\" nkeys=\"" + nkeys + "\" />\n";
+	xml += "</state>\n";
+	xml += xml_footer();
+
+	return true;
+}
+
+/* Heterogeneous scattering volume with noise density above a floor. */
+static bool benchmark_scene_volume(const string& /*dir*/, string& xml)
+{
+	BenchmarkMesh ground, domain;
+
+	ground.add_grid(make_float3(0.0f, -1.0f, 6.0f), 20.0f, 16, 0.0f);
+	domain.add_box(make_float3(0.0f, 0.5f, 0.0f), make_float3(3.0f, 3.0f, 3.0f));
+
+	xml = xml_header(make_float3(0.0f, 0.5f, -6.0f), 50.0f, 8);
+	xml += xml_emission_shader("lamp", make_float3(1.0f, 0.9f, 0.7f), 3000.0f);
+	xml += "<shader name=\"smoke\" heterogeneous_volume=\"true\">\n"
+	       "\t<texture_coordinate name=\"coord\" />\n"
+	       "\t<noise_texture name=\"noise\" scale=\"2\" detail=\"4\" />\n"
+	       "\t<math name=\"density\" type=\"Multiply\" value2=\"6\" />\n"
+	       "\t<scatter_volume name=\"scatter\" color=\"0.8 0.8 0.8\" anisotropy=\"0.3\" />\n"
+	       "\t<connect from=\"coord object\" to=\"noise vector\" />\n"
+	       "\t<connect from=\"noise fac\" to=\"density value1\" />\n"
+	       "\t<connect from=\"density value\" to=\"scatter density\" />\n"
+	       "\t<connect from=\"scatter volume\" to=\"output volume\" />\n"
+	       "</shader>\n";
+	xml += "<integrator volume_step_size=\"0.05\" />\n";
+	xml += xml_point_light("lamp", make_float3(3.0f, 5.0f, -2.0f), 0.5f);
+
+	xml += "<state shader=\"diffuse\">\n";
+	xml += ground.xml();
+	xml += "</state>\n";
+	xml += "<state shader=\"smoke\">\n";
+	xml += domain.xml();
+	xml += "</state>\n";
+	xml += xml_footer();
+
+	return true;
+}
+
+/* Cubes diced into many micropolygons when the scene is loaded. */
+static bool benchmark_scene_subdivision(const string& /*dir*/, string& xml)
+{
+	BenchmarkMesh ground;
+
+	ground.add_grid(make_float3(0.0f, -1.0f, 6.0f), 20.0f, 16, 0.0f);
+
+	xml = xml_header(make_float3(0.0f, 0.5f, -6.0f), 50.0f, 3);
+	xml += xml_emission_shader("lamp", make_float3(1.0f, 1.0f, 1.0f), 2000.0f);
+	xml += xml_point_light("lamp", make_float3(2.0f, 6.0f, -3.0f), 0.5f);
+
+	xml += "<state shader=\"diffuse\" interpolation=\"smooth\">\n";
+	xml += ground.xml();
+
+	for(int i = 0; i < 3; i++) {
+		BenchmarkMesh cube;
+		cube.add_box(make_float3(-2.5f + 2.5f*i, 0.0f, 1.0f), make_float3(1.6f, 1.6f, 1.6f));
+		xml += cube.xml("subdivision=\"catmull-clark\" dicing_rate=\"0.01\"");
+	}
+
+	xml += "</state>\n";
+	xml += xml_footer();
+
+	return true;
+}
+
+/* Write a procedural RGBA image for the texture scene. */
+static bool benchmark_write_texture(const string& filepath, int size, uint seed)
+{
+	vector<uchar> pixels(size*size*4);
+	float3 color = make_float3(0.3f + 0.7f*((seed & 1)? 1.0f: 0.2f),
+	                           0.3f + 0.7f*((seed & 2)? 1.0f: 0.2f),
+	                           0.3f + 0.7f*((seed & 4)? 1.0f: 0.2f));
+
+	for(int y = 0; y < size; y++) {
+		for(int x = 0; x < size; x++) {
+			bool checker = ((x >> 6) + (y >> 6)) & 1;
+			float noise = (hash_int_2d(x + y*size, seed) & 0xFF) * (1.0f/255.0f);
+			float f = (checker? 0.8f: 0.3f) + 0.2f*noise;
+			uchar *pixel = &pixels[(y*size + x)*4];
+
+			pixel[0] = (uchar)(255.0f*clamp(color.x*f, 0.0f, 1.0f));
+			pixel[1] = (uchar)(255.0f*clamp(color.y*f, 0.0f, 1.0f));
+			pixel[2] = (uchar)(255.0f*clamp(color.z*f, 0.0f, 1.0f));
+			pixel[3] = 255;
+		}
+	}
+
+	ImageOutput *out = ImageOutput::create(filepath);
+
+	if(!out)
+		return false;
+
+	ImageSpec spec(size, size, 4, TypeDesc::UINT8);
+	bool ok = out->open(filepath, spec) &&
+	          out->write_image(TypeDesc::UINT8, &pixels[0]);
+
+	out->close();
+	delete out;
+
+	return ok;
+}
+
+/* Blocks with image textures and a floor with layered procedural textures. */
+static bool benchmark_scene_textures(const string& dir, string& xml)
+{
+	BenchmarkRandom rng(6);
+	BenchmarkMesh ground;
+	const int num_textures = 8;
+
+	ground.add_grid(make_float3(0.0f, -1.0f, 6.0f), 20.0f, 16, 0.0f);
+
+	xml = xml_header(make_float3(0.0f, 1.0f, -6.0f), 50.0f, 2);
+	xml += xml_emission_shader("lamp", make_float3(1.0f, 1.0f, 1.0f), 3000.0f);
+
+	for(int i = 0; i < num_textures; i++) {
+		string filename = string_printf("benchmark_texture_%d.png", i);
+
+		if(!benchmark_write_texture(path_join(dir, filename), 1024, i)) {
+			fprintf(stderr, "Failed to write texture %s.\n", filename.c_str());
+			return false;
+		}
+
+		xml += string_printf("<shader name=\"image%d\">\n"
+		                     "\t<texture_coordinate name=\"coord\" />\n"
+		                     "\t<image_texture name=\"image\" src=\"%s\" />\n"
+		                     "\t<diffuse_bsdf name=\"bsdf\" />\n"
+		                     "\t<connect from=\"coord object\" to=\"image vector\" />\n"
+		                     "\t<connect from=\"image color\" to=\"bsdf color\" />\n"
+		                     "\t<connect from=\"bsdf bsdf\" to=\"output surface\" />\n"
+		                     "</shader>\n",
+		                     i, filename.c_str());
+	}
+
+	xml += "<shader name=\"procedural\">\n"
+	       "\t<texture_coordinate name=\"coord\" />\n"
+	       "\t<voronoi_texture name=\"voronoi\" scale=\"4\" />\n"
+	       "\t<musgrave_texture name=\"musgrave\" scale=\"2\" detail=\"8\" />\n"
+	       "\t<noise_texture name=\"noise\" scale=\"8\" detail=\"6\" />\n"
+	       "\t<mix name=\"mix\" type=\"Multiply\" />\n"
+	       "\t<diffuse_bsdf name=\"bsdf\" />\n"
+	       "\t<connect from=\"coord object\" to=\"voronoi vector\" />\n"
+	       "\t<connect from=\"coord object\" to=\"musgrave vector\" />\n"
+	       "\t<connect from=\"coord object\" to=\"noise vector\" />\n"
+	       "\t<connect from=\"noise fac\" to=\"mix fac\" />\n"
+	       "\t<connect from=\"voronoi color\" to=\"mix color1\" />\n"
+	       "\t<connect from=\"musgrave color\" to=\"mix color2\" />\n"
+	       "\t<connect from=\"mix color\" to=\"bsdf color\" />\n"
+	       "\t<connect from=\"bsdf bsdf\" to=\"output surface\" />\n"
+	       "</shader>\n";
+
+	xml += xml_point_light("lamp", make_float3(2.0f, 8.0f, -3.0f), 1.0f);
+
+	xml += "<state shader=\"procedural\">\n";
+	xml += ground.xml();
+	xml += "</state>\n";
+
+	for(int i = 0; i < 64; i++) {
+		BenchmarkMesh block;
+		float3 co = rng.range(make_float3(-5.0f, -1.0f, 0.0f), make_float3(5.0f, -1.0f, 10.0f));
+		float3 size = rng.range(make_float3(0.4f, 0.4f, 0.4f), make_float3(1.0f, 2.0f, 1.0f));
+
+		block.add_box(co + make_float3(0.0f, size.y*0.5f, 0.0f), size);
+
+		xml += string_printf("<state shader=\"image%d\">\n", i % num_textures);
+		xml += block.xml();
+		xml += "</state>\n";
+	}
+
+	xml += xml_footer();
+
+	return true;
+}
+
+/* Closed glossy room with glass spheres, paths only end at the maximum
+ * number of bounces or by russian roulette late in the path. */
+static bool benchmark_scene_bounces(const string& /*dir*/, string& xml)
+{
+	BenchmarkMesh room, spheres;
+
+	room.add_box(make_float3(0.0f, 1.0f, 0.0f), make_float3(6.0f, 4.0f, 14.0f));
+
+	for(int j = 0; j < 3; j++)
+		for(int i = 0; i < 3; i++)
+			spheres.add_sphere(make_float3(-1.8f + 1.8f*i, -0.3f + 0.9f*j, 2.0f + 0.5f*j), 0.4f, 48, 24);
+
+	xml = xml_header(make_float3(0.0f, 0.5f, -5.0f), 60.0f, 128, 32);
+	xml += xml_emission_shader("lamp", make_float3(1.0f, 1.0f, 1.0f), 500.0f);
+	xml += "<integrator caustics_reflective=\"true\" caustics_refractive=\"true\" filter_glossy=\"0\" />\n";
+	xml += "<shader name=\"wall\">\n"
+	       "\t<glossy_bsdf name=\"glossy\" color=\"0.9 0.9 0.9\" roughness=\"0.15\" />\n"
+	       "\t<diffuse_bsdf name=\"diffuse\" color=\"0.9 0.8 0.7\" />\n"
+	       "\t<mix_closure name=\"mix\" fac=\"0.5\" />\n"
+	       "\t<connect from=\"glossy bsdf\" to=\"mix closure1\" />\n"
+	       "\t<connect from=\"diffuse bsdf\" to=\"mix closure2\" />\n"
+	       "\t<connect from=\"mix closure\" to=\"output surface\" />\n"
+	       "</shader>\n";
+	xml += "<shader name=\"glass\">\n"
+	       "\t<glass_bsdf name=\"bsdf\" color=\"0.95 0.95 0.95\" roughness=\"0\" ior=\"1.45\" />\n"
+	       "\t<connect from=\"bsdf bsdf\" to=\"output surface\" />\n"
+	       "</shader>\n";
+	xml += xml_point_light("lamp", make_float3(0.0f, 2.5f, 1.0f), 0.2f);
+
+	xml += "<state shader=\"wall\">\n";
+	xml += room.xml();
+	xml += "</state>\n";
+	xml += "<state shader=\"glass\" interpolation=\"smooth\">\n";
+	xml += spheres.xml();
+	xml += "</state>\n";
+	xml += xml_footer();
+
+	return true;
+}
+
+struct BenchmarkScene {
+	const char *name;
+	const char *description;
+	bool (*generate)(const string& dir, string& xml);
+};
+
+static const BenchmarkScene benchmark_scenes[] = {
+	{"bvh", "Large heightfield and thousands of boxes", benchmark_scene_bvh},
+	{"lights", "Over a thousand point and area lights", benchmark_scene_lights},
+	{"hair", "Sphere with 40000 hair curves", benchmark_scene_hair},
+	{"volume", "Heterogeneous scattering volume", benchmark_scene_volume},
+	{"subdivision", "Catmull-Clark subdivision surfaces", benchmark_scene_subdivision},
+	{"textures", "Image and procedural textures", benchmark_scene_textures},
+	{"bounces", "Glossy room with glass, up to 128 bounces", benchmark_scene_bounces},
+};
+
+static const int num_benchmark_scenes = sizeof(benchmark_scenes)/sizeof(benchmark_scenes[0]);
+
+/* Results */
+
+struct BenchmarkResult {
+	double load_time;
+	double device_update_time;
+	double bvh_time;
+	double render_time;
+	double denoise_time;
+	size_t mem_peak;
+	size_t num_triangles;
+	size_t num_curve_segments;
+	size_t num_lights;
+	uint64_t num_rays;
+
+	BenchmarkResult()
+	: load_time(0.0), device_update_time(0.0), bvh_time(0.0), render_time(0.0), denoise_time(0.0),
+	  mem_peak(0), num_triangles(0), num_curve_segments(0), num_lights(0), num_rays(0)
+	{
+	}
+};
+
+static double benchmark_median(vector<double> values)
+{
+	if(values.empty())
+		return 0.0;
+
+	sort(values.begin(), values.end());
+
+	size_t n = values.size();
+	return (n & 1)? values[n/2]: 0.5*(values[n/2 - 1] + values[n/2]);
+}
+
+/* Render */
+
+static bool benchmark_render(const string& filepath, const DeviceInfo& device_info, BenchmarkResult& result)
+{
+	SceneParams scene_params;
+	SessionParams session_params;
+
+	session_params.device = device_info;
+	session_params.background = true;
+	session_params.progressive = false;
+	session_params.samples = options.samples;
+	session_params.threads = options.threads;
+	session_params.tile_size = make_int2(options.tile_size, options.tile_size);
+	/* only collected in debug builds */
+	session_params.use_ray_stats = true;
+	session_params.use_denoising = options.denoise;
+
+	/* load, including subdivision dicing */
+	double time_start = time_dt();
+
+	Scene *scene = new Scene(scene_params, device_info);
+	xml_read_file(scene, filepath.c_str());
+
+	scene->camera->width = options.width;
+	scene->camera->height = options.height;
+	scene->camera->compute_auto_viewplane();
+
+	result.load_time = time_dt() - time_start;
+
+	/* device update and render */
+	BufferParams buffer_params;
+	buffer_params.width = options.width;
+	buffer_params.height = options.height;
+	buffer_params.full_width = options.width;
+	buffer_params.full_height = options.height;
+
+	Session *session = new Session(session_params);
+	session->scene = scene;
+	session->reset(buffer_params, options.samples);
+
+	time_start = time_dt();
+	session->start();
+	session->wait();
+	double session_time = time_dt() - time_start;
+
+	bool ok = !session->progress.get_cancel();
+
+	if(!ok)
+		fprintf(stderr, "Render failed: %s\n", session->progress.get_cancel_message().c_str());
+
+	const SceneUpdateTimes& times = scene->update_times;
+
+	result.device_update_time = times.total;
+	result.bvh_time = times.bvh;
+	result.render_time = max(session_time - times.total, 0.0);
+	result.denoise_time = session->stats.denoise_time;
+	result.mem_peak = session->stats.mem_peak;
+
+	foreach(Mesh *mesh, scene->meshes) {
+		result.num_triangles += mesh->triangles.size();
+		result.num_curve_segments += mesh->curve_keys.size() - mesh->curves.size();
+	}
+
+	result.num_lights = scene->lights.size();
+
+	for(int i = 0; i < RAY_STATS_NUM_RAYS; i++)
+		result.num_rays += session->stats.ray_stats.rays[i];
+
+	/* also frees the scene */
+	delete session;
+
+	return ok;
+}
+
+/* Report */
+
+static string benchmark_json_string(const string& str)
+{
+	string result = "\"";
+
+	foreach(char c, str) {
+		if(c == '"' || c == '\\')
+			result += string("\\") + c;
+		else if((unsigned char)c >= 0x20)
+			result += c;
+	}
+
+	return result + "\"";
+}
+
+static string benchmark_cpu_kernel()
+{
+	if(system_cpu_support_avx2())
+		return "avx2";
+	else if(system_cpu_support_avx())
+		return "avx";
+	else if(system_cpu_support_sse41())
+		return "sse41";
+	else if(system_cpu_support_sse3())
+		return "sse3";
+	else if(system_cpu_support_sse2())
+		return "sse2";
+
+	return "none";
+}
+
+static string benchmark_report_scene(const BenchmarkScene& bscene, const vector<BenchmarkResult>& results)
+{
+	vector<double> load, device_update, bvh, render, denoise;
+	size_t mem_peak = 0;
+
+	foreach(const BenchmarkResult& result, results) {
+		load.push_back(result.load_time);
+		device_update.push_back(result.device_update_time);
+		bvh.push_back(result.bvh_time);
+		render.push_back(result.render_time);
+		denoise.push_back(result.denoise_time);
+		mem_peak = max(mem_peak, result.mem_peak);
+	}
+
+	const BenchmarkResult& first = results[0];
+	double render_time = benchmark_median(render);
+	double pixel_samples = (double)options.width*options.height*options.samples;
+
+	string report = "\t\t{\n";
+
+	report += string_printf("\t\t\t\"name\": \"%s\",\n", bscene.name);
+	report += string_printf("\t\t\t\"triangles\": %llu,\n", (unsigned long long)first.num_triangles);
+	report += string_printf("\t\t\t\"curve_segments\": %llu,\n", (unsigned long long)first.num_curve_segments);
+	report += string_printf("\t\t\t\"lights\": %llu,\n", (unsigned long long)first.num_lights);
+	report += string_printf("\t\t\t\"load_time\": %f,\n", benchmark_median(load));
+	report += string_printf("\t\t\t\"device_update_time\": %f,\n", benchmark_median(device_update));
+	report += string_printf("\t\t\t\"bvh_build_time\": %f,\n", benchmark_median(bvh));
+	report += string_printf("\t\t\t\"render_time\": %f,\n", render_time);
+	report += string_printf("\t\t\t\"sample_time\": %f,\n", render_time/options.samples);
+	report += string_printf("\t\t\t\"samples_per_second\": %f,\n",
+	                        (render_time > 0.0)? pixel_samples/render_time: 0.0);
+
+	/* summed over render threads, part of the render time */
+	if(options.denoise)
+		report += string_printf("\t\t\t\"denoise_time\": %f,\n", benchmark_median(denoise));
+
+	/* ray counts are only collected in debug builds */
+	if(first.num_rays > 0) {
+		report += string_printf("\t\t\t\"rays\": %llu,\n", (unsigned long long)first.num_rays);
+		report += string_printf("\t\t\t\"rays_per_second\": %f,\n",
+		                        (render_time > 0.0)? first.num_rays/render_time: 0.0);
+	}
+	else {
+		report += "\t\t\t\"rays\": null,\n";
+		report += "\t\t\t\"rays_per_second\": null,\n";
+	}
+
+	report += string_printf("\t\t\t\"memory_peak\": %llu\n", (unsigned long long)mem_peak);
+	report += "\t\t}";
+
+	return report;
+}
+
+/* Options */
+
+static bool benchmark_scene_enabled(const BenchmarkScene& bscene)
+{
+	if(options.scenes.empty())
+		return true;
+
+	foreach(const string& name, options.scenes)
+		if(name == bscene.name)
+			return true;
+
+	return false;
+}
+
+/* Restrict the CPU capabilities, and with that the optimized kernel used,
+ * must be done before anything queries them. */
+static bool benchmark_set_cpu_kernel(const string& kernel)
+{
+	static const char *kernels[] = {"sse2", "sse3", "sse41", "avx", "avx2"};
+	static const char *variables[] = {"CYCLES_CPU_NO_SSE2", "CYCLES_CPU_NO_SSE3",
+	                                  "CYCLES_CPU_NO_SSE41", "CYCLES_CPU_NO_AVX",
+	                                  "CYCLES_CPU_NO_AVX2"};
+	const int num_kernels = sizeof(kernels)/sizeof(kernels[0]);
+
+	if(kernel == "auto")
+		return true;
+
+	int index = -1;
+
+	if(kernel == "none")
+		index = -1;
+	else {
+		for(int i = 0; i < num_kernels; i++)
+			if(kernel == kernels[i])
+				index = i;
+
+		if(index == -1)
+			return false;
+	}
+
+	for(int i = index + 1; i < num_kernels; i++) {
+#ifdef _WIN32
+		_putenv_s(variables[i], "1");
+#else
+		setenv(variables[i], "1", 1);
+#endif
+	}
+
+	return true;
+}
+
+static void options_parse(int argc, const char **argv)
+{
+	options.scene_dir = "cycles_benchmark_scenes";
+	options.output = "";
+	options.cpu_kernel = "auto";
+	options.width = 640;
+	options.height = 360;
+	options.samples = 16;
+	options.threads = 0;
+	options.tile_size = 32;
+	options.repeat = 3;
+	options.quiet = false;
+	options.denoise = false;
+
+	string scenes = "";
+	bool list = false, debug = false, help = false;
+	int verbosity = 1;
+
+	ArgParse ap;
+
+	ap.options ("Usage: cycles_benchmark [options]",
+		"--scenes %s", &scenes, "Comma separated names of scenes to render, all by default",
+		"--scene-dir %s", &options.scene_dir, "Directory to write the generated scenes to",
+		"--output %s", &options.output, "File path to write the JSON report to, standard output by default",
+		"--samples %d", &options.samples, "Number of samples to render",
+		"--width %d", &options.width, "Image width in pixels",
+		"--height %d", &options.height, "Image height in pixels",
+		"--threads %d", &options.threads, "CPU rendering threads, 0 for all",
+		"--tile-size %d", &options.tile_size, "Tile size in pixels",
+		"--repeat %d", &options.repeat, "Number of times to render each scene, the median time is reported",
+		"--cpu-kernel %s", &options.cpu_kernel, "Optimized kernel to use at most: auto, none, sse2, sse3, sse41, avx, avx2",
+		"--denoise", &options.denoise, "Denoise the renders, the denoising time is reported separately",
+		"--quiet", &options.quiet, "Don't print progress messages",
+		"--list", &list, "List the benchmark scenes",
+#ifdef WITH_CYCLES_LOGGING
+		"--debug", &debug, "Enable debug logging",
+		"--verbose %d", &verbosity, "Set verbosity of the logger",
+#endif
+		"--help", &help, "Print help message",
+		NULL);
+
+	if(ap.parse(argc, argv) < 0) {
+		fprintf(stderr, "%s\n", ap.geterror().c_str());
+		ap.usage();
+		exit(EXIT_FAILURE);
+	}
+
+	if(debug) {
+		util_logging_start();
+		util_logging_verbosity_set(verbosity);
+	}
+
+	if(help) {
+		ap.usage();
+		exit(EXIT_SUCCESS);
+	}
+	else if(list) {
+		for(int i = 0; i < num_benchmark_scenes; i++)
+			printf("    %-14s%s\n", benchmark_scenes[i].name, benchmark_scenes[i].description);
+
+		exit(EXIT_SUCCESS);
+	}
+
+	if(scenes != "") {
+		string_split(options.scenes, scenes, ",");
+
+		foreach(const string& name, options.scenes) {
+			bool found = false;
+
+			for(int i = 0; i < num_benchmark_scenes; i++)
+				if(name == benchmark_scenes[i].name)
+					found = true;
+
+			if(!found) {
+				fprintf(stderr, "Unknown scene: %s\n", name.c_str());
+				exit(EXIT_FAILURE);
+			}
+		}
+	}
+
+	if(!benchmark_set_cpu_kernel(options.cpu_kernel)) {
+		fprintf(stderr, "Unknown CPU kernel: %s\n", options.cpu_kernel.c_str());
+		exit(EXIT_FAILURE);
+	}
+	else if(options.samples < 1 || options.width < 1 || options.height < 1 ||
+	        options.tile_size < 1 || options.repeat < 1 || options.threads < 0)
+	{
+		fprintf(stderr, "Invalid samples, resolution, tile size, threads or repeat count\n");
+		exit(EXIT_FAILURE);
+	}
+}
+
+/* Render all enabled scenes and write the report */
+
+static bool benchmark_run()
+{
+	/* find CPU device */
+	vector<DeviceInfo>& devices = Device::available_devices();
+	DeviceInfo device_info;
+	bool device_available = false;
+
+	foreach(DeviceInfo& device, devices) {
+		if(device.type == DEVICE_CPU) {
+			device_info = device;
+			device_available = true;
+			break;
+		}
+	}
+
+	if(!device_available) {
+		fprintf(stderr, "No CPU device available\n");
+		return false;
+	}
+
+	string report = "{\n";
+
+	report += "\t\"cpu\": " + benchmark_json_string(system_cpu_brand_string()) + ",\n";
+	report += "\t\"cpu_kernel\": \"" + benchmark_cpu_kernel() + "\",\n";
+	report += string_printf("\t\"threads\": %d,\n",
+	                        (options.threads)? options.threads: system_cpu_thread_count());
+	report += string_printf("\t\"resolution\": [%d, %d],\n", options.width, options.height);
+	report += string_printf("\t\"samples\": %d,\n", options.samples);
+	report += string_printf("\t\"denoise\": %s,\n", (options.denoise)? "true": "false");
+	report += string_printf("\t\"repeat\": %d,\n", options.repeat);
+	report += "\t\"scenes\": [\n";
+
+	bool ok = true;
+	bool first_scene = true;
+
+	for(int i = 0; i < num_benchmark_scenes && ok; i++) {
+		const BenchmarkScene& bscene = benchmark_scenes[i];
+
+		if(!benchmark_scene_enabled(bscene))
+			continue;
+
+		/* generate scene */
+		string filepath = path_join(options.scene_dir, string(bscene.name) + ".xml");
+		string xml;
+
+		if(!options.quiet)
+			fprintf(stderr, "Generating %s\n", bscene.name);
+
+		path_create_directories(filepath);
+
+		if(!bscene.generate(options.scene_dir, xml) || !path_write_text(filepath, xml)) {
+			fprintf(stderr, "Failed to write scene %s\n", filepath.c_str());
+			ok = false;
+			break;
+		}
+
+		/* render */
+		vector<BenchmarkResult> results;
+
+		for(int r = 0; r < options.repeat; r++) {
+			if(!options.quiet)
+				fprintf(stderr, "Rendering %s (%d/%d)\n", bscene.name, r + 1, options.repeat);
+
+			BenchmarkResult result;
+
+			if(!benchmark_render(filepath, device_info, result)) {
+				ok = false;
+				break;
+			}
+
+			results.push_back(result);
+		}
+
+		if(!ok)
+			break;
+
+		if(!first_scene)
+			report += ",\n";
+
+		report += benchmark_report_scene(bscene, results);
+		first_scene = false;
+	}
+
+	report += "\n\t]\n";
+	report += "}\n";
+
+	if(!ok)
+		return false;
+
+	if(options.output == "") {
+		printf("%s", report.c_str());
+	}
+	else {
+		path_create_directories(options.output);
+
+		if(!path_write_text(options.output, report)) {
+			fprintf(stderr, "Failed to write report %s\n", options.output.c_str());
+			return false;
+		}
+	}
+
+	return true;
+}
+
+CCL_NAMESPACE_END
+
+using namespace ccl;
+
+int main(int argc, const char **argv)
+{
+	util_logging_init(argv[0]);
+	path_init();
+	options_parse(argc, argv);
+
+	return (benchmark_run())? EXIT_SUCCESS: EXIT_FAILURE;
+}
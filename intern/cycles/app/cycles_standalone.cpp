@@ -48,6 +48,7 @@ struct Options {
 	int width, height;
 	SceneParams scene_params;
 	SessionParams session_params;
+	string ray_stats_filepath;
 	bool quiet;
 	bool show_help, interactive, pause;
 } options;
@@ -105,6 +106,9 @@ static void session_init()
 	options.session->reset(session_buffer_params(), options.session_params.samples);
 	options.session->scene = options.scene;
 
+	if(options.ray_stats_filepath != "")
+		options.session->set_ray_stats_report(options.ray_stats_filepath);
+
 	if(options.session_params.background && !options.quiet)
 		options.session->progress.set_update_callback(function_bind(&session_print_status));
 #ifdef WITH_CYCLES_STANDALONE_GUI
@@ -356,6 +360,9 @@ static void options_parse(int argc, const char **argv)
 	/* shading system */
 	string ssname = "svm";
 
+	/* texture cache size in MB, 0 loads images into memory */
+	int texture_cache_size = 0;
+
 	/* parse options */
 	ArgParse ap;
 	bool help = false, debug = false;
@@ -370,8 +377,18 @@ static void options_parse(int argc, const char **argv)
 		"--background", &options.session_params.background, "Render in background, without user interface",
 		"--quiet", &options.quiet, "In background mode, don't print progress messages",
 		"--samples %d", &options.session_params.samples, "Number of samples to render",
+		"--adaptive-threshold %f", &options.session_params.adaptive_threshold, "Noise level at which pixels stop sampling, 0 disables adaptive sampling",
+		"--adaptive-min-samples %d", &options.session_params.adaptive_min_samples, "Minimum number of samples before adaptive sampling starts, 0 for automatic",
+		"--adaptive-max-samples %d", &options.session_params.adaptive_max_samples, "Number of samples pixels that are still noisy continue up to",
+		"--denoise", &options.session_params.use_denoising, "Denoise the render (background only)",
+		"--denoise-radius %d", &options.session_params.denoising.radius, "Half size of the denoising search window in pixels",
+		"--denoise-strength %f", &options.session_params.denoising.strength, "Denoising strength, higher values remove more noise",
+		"--ray-stream", &options.session_params.use_ray_stream, "Trace camera rays in batches sorted by shader (CPU only)",
+		"--ray-stats", &options.session_params.use_ray_stats, "Collect ray and shading statistics (CPU debug builds only)",
+		"--ray-stats-report %s", &options.ray_stats_filepath, "File path to write the ray statistics report to as JSON",
 		"--output %s", &options.session_params.output_path, "File path to write output image",
 		"--threads %d", &options.session_params.threads, "CPU Rendering Threads",
+		"--texture-cache %d", &texture_cache_size, "Read image textures on demand through a cache of this size in MB, 0 loads them fully (CPU only)",
 		"--width  %d", &options.width, "Window width in pixel",
 		"--height %d", &options.height, "Window height in pixel",
 		"--list-devices", &list, "List information about all available devices",
@@ -416,6 +433,11 @@ static void options_parse(int argc, const char **argv)
 	else if(ssname == "svm")
 		options.scene_params.shadingsystem = SHADINGSYSTEM_SVM;
 
+	if(texture_cache_size > 0) {
+		options.scene_params.use_texture_cache = true;
+		options.scene_params.texture_cache_size = texture_cache_size;
+	}
+
 #ifndef WITH_CYCLES_STANDALONE_GUI
 	options.session_params.background = true;
 #endif
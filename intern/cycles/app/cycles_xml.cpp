@@ -312,6 +312,15 @@ static void xml_read_integrator(const XMLReadState& state, pugi::xml_node node)
 	xml_read_float(&integrator->volume_step_size, node, "volume_step_size");
 	xml_read_int(&integrator->volume_max_steps, node, "volume_max_steps");
 	
+	/* Lights */
+	bool use_light_tree = integrator->use_light_tree;
+	xml_read_bool(&use_light_tree, node, "use_light_tree");
+
+	if(use_light_tree != integrator->use_light_tree) {
+		integrator->use_light_tree = use_light_tree;
+		state.scene->light_manager->tag_update(state.scene);
+	}
+
 	/* Various Settings */
 	xml_read_bool(&integrator->caustics_reflective, node, "caustics_reflective");
 	xml_read_bool(&integrator->caustics_refractive, node, "caustics_refractive");
@@ -973,6 +982,48 @@ static void xml_read_mesh(const XMLReadState& state, pugi::xml_node node)
 	mesh->attributes.remove(ATTR_STD_VERTEX_NORMAL);
 }
 
+/* Curves */
+
+static void xml_read_curves(const XMLReadState& state, pugi::xml_node node)
+{
+	/* add mesh */
+	Mesh *mesh = xml_add_mesh(state.scene, state.tfm);
+	mesh->used_shaders.push_back(state.shader);
+
+	/* read keys and number of keys per curve, with either a radius
+	 * per key or a single radius for all keys */
+	vector<float3> P;
+	vector<float> radius;
+	vector<int> nkeys;
+
+	xml_read_float3_array(P, node, "P");
+	xml_read_float_array(radius, node, "radius");
+	xml_read_int_array(nkeys, node, "nkeys");
+
+	if(radius.size() != P.size() && radius.size() != 1) {
+		fprintf(stderr, "Curves need one radius or a radius per key.\n");
+		return;
+	}
+
+	/* create curves */
+	size_t key_offset = 0;
+
+	for(size_t i = 0; i < nkeys.size(); i++) {
+		if(nkeys[i] < 2 || key_offset + nkeys[i] > P.size()) {
+			fprintf(stderr, "Invalid number of curve keys.\n");
+			break;
+		}
+
+		for(int j = 0; j < nkeys[i]; j++) {
+			size_t k = key_offset + j;
+			mesh->add_curve_key(P[k], (radius.size() == 1)? radius[0]: radius[k]);
+		}
+
+		mesh->add_curve(key_offset, nkeys[i], state.shader);
+		key_offset += nkeys[i];
+	}
+}
+
 /* Patch */
 
 static void xml_read_patch(const XMLReadState& state, pugi::xml_node node)
@@ -1180,6 +1231,9 @@ static void xml_read_scene(const XMLReadState& state, pugi::xml_node scene_node)
 		else if(string_iequals(node.name(), "patch")) {
 			xml_read_patch(state, node);
 		}
+		else if(string_iequals(node.name(), "curves")) {
+			xml_read_curves(state, node);
+		}
 		else if(string_iequals(node.name(), "light")) {
 			xml_read_light(state, node);
 		}
@@ -362,6 +362,14 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
                 min=2, max=65536
                 )
 
+        cls.use_volume_majorant = BoolProperty(
+                name="Majorant Grid",
+                description="Use a coarse grid of maximum density to skip empty space and track "
+                            "through single heterogeneous volume objects without bias, "
+                            "instead of stepping through them with fixed step size (experimental)",
+                default=False,
+                )
+
         cls.film_exposure = FloatProperty(
                 name="Exposure",
                 description="Image brightness scale",
@@ -418,6 +426,68 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
                 default=0.0,
                 )
 
+        cls.use_light_tree = BoolProperty(
+                name="Light Tree",
+                description="Pick lights by their estimated contribution to the shading point "
+                            "instead of by area only, helps scenes with many lights (CPU only)",
+                default=True,
+                )
+
+        cls.adaptive_threshold = FloatProperty(
+                name="Adaptive Threshold",
+                description="If non-zero, pixels stop sampling once their estimated noise "
+                            "level is below this value, lower values give less noise "
+                            "at the cost of render time. Samples are only moved to noisy "
+                            "regions when Adaptive Max Samples is higher than the number "
+                            "of samples (CPU only)",
+                min=0.0, max=1.0,
+                default=0.0,
+                precision=4,
+                )
+        cls.adaptive_min_samples = IntProperty(
+                name="Adaptive Min Samples",
+                description="Minimum number of samples a pixel receives before adaptive "
+                            "sampling can stop it, automatic if 0",
+                min=0, max=4096,
+                default=0,
+                )
+        cls.adaptive_max_samples = IntProperty(
+                name="Adaptive Max Samples",
+                description="Pixels that are still noisy after the number of samples continue "
+                            "sampling up to this many samples, disabled if not higher than "
+                            "the number of samples",
+                min=0, max=2147483647,
+                default=0,
+                )
+
+        cls.use_denoising = BoolProperty(
+                name="Denoising",
+                description="Remove noise from the final render, guided by the normal, color and depth "
+                            "of the first surface hit (not used with progressive refine)",
+                default=False,
+                )
+        cls.denoising_radius = IntProperty(
+                name="Radius",
+                description="Size of the image area searched for similar pixels, "
+                            "larger values remove more noise but are slower",
+                min=1, max=25,
+                default=8,
+                )
+        cls.denoising_strength = FloatProperty(
+                name="Strength",
+                description="Controls how different the colors of pixels averaged together can be, "
+                            "higher values remove more noise but blur more detail",
+                min=0.0, max=1.0,
+                default=0.5,
+                )
+        cls.denoising_feature_strength = FloatProperty(
+                name="Feature Strength",
+                description="Controls how different the normal, color and depth of pixels averaged "
+                            "together can be, higher values blur more across edges and textures",
+                min=0.0, max=1.0,
+                default=1.0,
+                )
+
         cls.debug_tile_size = IntProperty(
                 name="Tile Size",
                 description="",
@@ -463,11 +533,60 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
                 description="Use BVH spatial splits: longer builder time, faster render",
                 default=False,
                 )
+        cls.debug_use_ray_stats = BoolProperty(
+                name="Ray Statistics",
+                description="Count rays and time render stages and shaders, and write a report next to the output "
+                            "file for every frame (background rendering on the CPU, debug builds only)",
+                default=False,
+                )
         cls.use_cache = BoolProperty(
                 name="Cache BVH",
                 description="Cache last built BVH to disk for faster re-render if no geometry changed",
                 default=False,
                 )
+        cls.use_bvh_compression = BoolProperty(
+                name="Compressed BVH",
+                description="Store BVH node bounds quantized to 8 bits, which uses less memory and "
+                            "memory bandwidth in very large scenes at the cost of a few more ray tests (CPU only)",
+                default=False,
+                )
+        cls.use_ray_stream = BoolProperty(
+                name="Ray Stream",
+                description="Trace camera rays of a tile row together and shade them sorted by the shader "
+                            "they hit, which makes better use of the CPU caches in complex scenes (CPU only)",
+                default=False,
+                )
+        cls.use_threaded_sync = BoolProperty(
+                name="Threaded Sync",
+                description="Convert meshes and compute their tangents on all threads while synchronizing "
+                            "the scene, only reading Blender data stays on the main thread",
+                default=False,
+                )
+        cls.use_memory_cache = BoolProperty(
+                name="Keep Mesh BVH",
+                description="Keep BVHs of meshes in memory between frames, so only changed meshes are rebuilt "
+                            "(meshes are always instanced, which can render slightly slower)",
+                default=False,
+                )
+        cls.use_bvh_refit = BoolProperty(
+                name="Refit Mesh BVH",
+                description="Refit kept BVHs of deformed meshes with unchanged topology instead of rebuilding them, "
+                            "they are rebuilt once refitting degraded their quality too much",
+                default=False,
+                )
+        cls.use_texture_cache = BoolProperty(
+                name="Texture Cache",
+                description="Read image textures on demand from disk instead of loading them fully, "
+                            "only the parts and MIP levels that are needed are kept in memory "
+                            "(CPU only, works best with tiled and MIP-mapped files)",
+                default=False,
+                )
+        cls.texture_cache_size = IntProperty(
+                name="Cache Size",
+                description="Maximum memory used by the texture cache, in megabytes",
+                min=64, max=65536,
+                default=1024,
+                )
         cls.tile_order = EnumProperty(
                 name="Tile Order",
                 description="Tile order for rendering",
@@ -483,6 +602,14 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
                             "but time can be saved by manually stopping the render when the noise is low enough)",
                 default=False,
                 )
+        cls.checkpoint_interval = FloatProperty(
+                name="Checkpoint Interval",
+                description="Minutes between saving the render progress next to the output file, so an interrupted "
+                            "render continues where it left off when started again with the same settings "
+                            "(0 to disable, background rendering only)",
+                min=0.0, max=1440.0,
+                default=0.0,
+                )
 
         cls.bake_type = EnumProperty(
             name="Bake Type",
@@ -148,6 +148,22 @@ class CyclesRender_PT_sampling(CyclesButtonsPanel, Panel):
         sub.prop(cscene, "sample_clamp_direct")
         sub.prop(cscene, "sample_clamp_indirect")
 
+        sub = col.column(align=True)
+        sub.active = use_cpu(context)
+        sub.prop(cscene, "adaptive_threshold")
+        sub.prop(cscene, "adaptive_min_samples")
+        sub.prop(cscene, "adaptive_max_samples")
+        sub.prop(cscene, "use_light_tree")
+
+        sub = col.column(align=True)
+        sub.active = not cscene.use_progressive_refine
+        sub.prop(cscene, "use_denoising")
+        subsub = sub.column(align=True)
+        subsub.active = cscene.use_denoising
+        subsub.prop(cscene, "denoising_radius")
+        subsub.prop(cscene, "denoising_strength")
+        subsub.prop(cscene, "denoising_feature_strength")
+
         if cscene.progressive == 'PATH' or use_branched_path(context) == False:
             col = split.column()
             sub = col.column(align=True)
@@ -200,6 +216,7 @@ class CyclesRender_PT_volume_sampling(CyclesButtonsPanel, Panel):
         row = layout.row()
         row.prop(cscene, "volume_step_size")
         row.prop(cscene, "volume_max_steps")
+        layout.prop(cscene, "use_volume_majorant")
 
 
 class CyclesRender_PT_light_paths(CyclesButtonsPanel, Panel):
@@ -308,6 +325,7 @@ class CyclesRender_PT_performance(CyclesButtonsPanel, Panel):
         sub = col.column(align=True)
         sub.enabled = rd.threads_mode == 'FIXED'
         sub.prop(rd, "threads")
+        col.prop(cscene, "use_threaded_sync")
 
         sub = col.column(align=True)
         sub.label(text="Tiles:")
@@ -333,12 +351,32 @@ class CyclesRender_PT_performance(CyclesButtonsPanel, Panel):
 
         col.label(text="Final Render:")
         col.prop(cscene, "use_cache")
+        col.prop(cscene, "use_memory_cache")
+        sub = col.column()
+        sub.active = cscene.use_memory_cache
+        sub.prop(cscene, "use_bvh_refit")
         col.prop(rd, "use_persistent_data", text="Persistent Images")
+        col.prop(cscene, "checkpoint_interval")
+        col.prop(cscene, "debug_use_ray_stats")
+
+        col.separator()
+
+        col.label(text="Images:")
+        sub = col.column(align=True)
+        sub.active = use_cpu(context)
+        sub.prop(cscene, "use_texture_cache")
+        subsub = sub.column(align=True)
+        subsub.active = cscene.use_texture_cache
+        subsub.prop(cscene, "texture_cache_size")
 
         col.separator()
 
         col.label(text="Acceleration structure:")
         col.prop(cscene, "debug_use_spatial_splits")
+        sub = col.column()
+        sub.active = use_cpu(context)
+        sub.prop(cscene, "use_bvh_compression")
+        sub.prop(cscene, "use_ray_stream")
 
 
 class CyclesRender_PT_layer_options(CyclesButtonsPanel, Panel):
@@ -30,6 +30,7 @@
 #include "util_foreach.h"
 #include "util_logging.h"
 #include "util_math.h"
+#include "util_time.h"
 
 #include "mikktspace.h"
 
@@ -543,7 +544,7 @@ static void create_mesh(Scene *scene, Mesh *mesh, BL::Mesh b_mesh, const vector<
 	}
 }
 
-static void create_subd_mesh(Scene *scene, Mesh *mesh, BL::Mesh b_mesh, PointerRNA *cmesh, const vector<uint>& used_shaders)
+static void create_subd_mesh(Scene *scene, Mesh *mesh, BL::Mesh b_mesh, PointerRNA *cmesh, const vector<uint>& used_shaders, bool use_cache)
 {
 	/* create subd mesh */
 	SubdMesh sdmesh;
@@ -580,13 +581,45 @@ static void create_subd_mesh(Scene *scene, Mesh *mesh, BL::Mesh b_mesh, PointerR
 	//scene->camera->update();
 	//sdparams.camera = scene->camera;
 
+	/* keep diced patches around for the next sync, unchanged patches are
+	 * then copied rather than diced again */
+	if(use_cache) {
+		if(!mesh->subd_cache)
+			mesh->subd_cache = new SubdCache();
+	}
+	else {
+		delete mesh->subd_cache;
+		mesh->subd_cache = NULL;
+	}
+
 	/* tesselate */
 	DiagSplit dsplit(sdparams);
-	sdmesh.tessellate(&dsplit);
+	sdmesh.tessellate(&dsplit, mesh->subd_cache);
 }
 
 /* Sync */
 
+/* Mesh conversion started by sync_mesh(). Reading the derived mesh and
+ * filling in the Cycles mesh can be done on a worker thread, everything that
+ * changes Blender data or scene state is done afterwards in sync_mesh_finish()
+ * on the main thread. */
+struct BlenderMeshSync {
+	BlenderMeshSync(Mesh *mesh_, BL::Object b_ob_)
+	: mesh(mesh_), b_ob(b_ob_), b_mesh(PointerRNA_NULL),
+	  need_volume(false), need_hair(false), free_caches(false)
+	{}
+
+	Mesh *mesh;
+	BL::Object b_ob;
+	BL::Mesh b_mesh;
+	bool need_volume;
+	bool need_hair;
+	bool free_caches;
+
+	vector<Mesh::Triangle> oldtriangle;
+	vector<float4> oldcurve_keys;
+};
+
 Mesh *BlenderSync::sync_mesh(BL::Object b_ob, bool object_updated, bool hide_tris)
 {
 	/* When viewport display is not needed during render we can force some
@@ -660,11 +693,15 @@ Mesh *BlenderSync::sync_mesh(BL::Object b_ob, bool object_updated, bool hide_tri
 	/* create derived mesh */
 	PointerRNA cmesh = RNA_pointer_get(&b_ob_data.ptr, "cycles");
 
-	vector<Mesh::Triangle> oldtriangle = mesh->triangles;
-	
+	BlenderMeshSync *msync = new BlenderMeshSync(mesh, b_ob);
+
+	/* old geometry is kept to test if the BVH needs a rebuild, the mesh is
+	 * cleared anyway so no need to copy it */
+	msync->oldtriangle.swap(mesh->triangles);
+
 	/* compares curve_keys rather than strands in order to handle quick hair
 	 * adjustments in dynamic BVH - other methods could probably do this better*/
-	vector<float4> oldcurve_keys = mesh->curve_keys;
+	msync->oldcurve_keys.swap(mesh->curve_keys);
 
 	mesh->clear();
 	mesh->used_shaders = used_shaders;
@@ -684,24 +721,23 @@ Mesh *BlenderSync::sync_mesh(BL::Object b_ob, bool object_updated, bool hide_tri
 		BL::Mesh b_mesh = object_to_mesh(b_data, b_ob, b_scene, true, !preview, need_undeformed);
 
 		if(b_mesh) {
+			msync->b_mesh = b_mesh;
+
 			if(render_layer.use_surfaces && !hide_tris) {
+				/* subdivision is already multithreaded */
 				if(cmesh.data && experimental && RNA_boolean_get(&cmesh, "use_subdivision"))
-					create_subd_mesh(scene, mesh, b_mesh, &cmesh, used_shaders);
+					create_subd_mesh(scene, mesh, b_mesh, &cmesh, used_shaders,
+					                 preview || b_scene.render().use_persistent_data());
+				else if(use_threaded_sync)
+					mesh_task_pool.push(function_bind(&create_mesh, scene, mesh, b_mesh, used_shaders));
 				else
 					create_mesh(scene, mesh, b_mesh, used_shaders);
 
-				create_mesh_volume_attributes(scene, b_ob, mesh, b_scene.frame_current());
-			}
-
-			if(render_layer.use_hair)
-				sync_curves(mesh, b_mesh, b_ob, false);
-
-			if(can_free_caches) {
-				b_ob.cache_release();
+				msync->need_volume = true;
 			}
 
-			/* free derived mesh */
-			b_data.meshes.remove(b_mesh);
+			msync->need_hair = render_layer.use_hair;
+			msync->free_caches = can_free_caches;
 		}
 	}
 	mesh->geometry_flags = requested_geometry_flags;
@@ -718,7 +754,44 @@ Mesh *BlenderSync::sync_mesh(BL::Object b_ob, bool object_updated, bool hide_tri
 			mesh->displacement_method = Mesh::DISPLACE_BOTH;
 	}
 
+	/* with threaded sync the rest is done once the mesh is converted, mark
+	 * it as updated already for the object sync */
+	if(use_threaded_sync) {
+		mesh->need_update = true;
+		mesh_sync_queue.push_back(msync);
+	}
+	else {
+		sync_mesh_finish(msync);
+		delete msync;
+	}
+
+	return mesh;
+}
+
+void BlenderSync::sync_mesh_finish(BlenderMeshSync *msync)
+{
+	Mesh *mesh = msync->mesh;
+	BL::Object b_ob = msync->b_ob;
+	BL::Mesh b_mesh = msync->b_mesh;
+
+	if(b_mesh) {
+		if(msync->need_volume)
+			create_mesh_volume_attributes(scene, b_ob, mesh, b_scene.frame_current());
+
+		if(msync->need_hair)
+			sync_curves(mesh, b_mesh, b_ob, false);
+
+		if(msync->free_caches) {
+			b_ob.cache_release();
+		}
+
+		/* free derived mesh */
+		b_data.meshes.remove(b_mesh);
+	}
+
 	/* tag update */
+	const vector<Mesh::Triangle>& oldtriangle = msync->oldtriangle;
+	const vector<float4>& oldcurve_keys = msync->oldcurve_keys;
 	bool rebuild = false;
 
 	if(oldtriangle.size() != mesh->triangles.size())
@@ -736,8 +809,28 @@ Mesh *BlenderSync::sync_mesh(BL::Object b_ob, bool object_updated, bool hide_tri
 	}
 	
 	mesh->tag_update(scene, rebuild);
+}
 
-	return mesh;
+void BlenderSync::sync_mesh_tasks_finish()
+{
+	if(mesh_sync_queue.empty())
+		return;
+
+	/* wait for mesh conversion, helping out from this thread too */
+	double time_start = time_dt();
+
+	mesh_task_pool.wait_work();
+
+	VLOG(1) << "Waited " << time_dt() - time_start << " seconds for conversion of "
+	        << mesh_sync_queue.size() << " meshes.";
+
+	/* finish in the same order as without threads */
+	foreach(BlenderMeshSync *msync, mesh_sync_queue) {
+		sync_mesh_finish(msync);
+		delete msync;
+	}
+
+	mesh_sync_queue.clear();
 }
 
 void BlenderSync::sync_mesh_motion(BL::Object b_ob, Object *object, float motion_time)
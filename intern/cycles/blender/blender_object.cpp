@@ -285,6 +285,7 @@ Object *BlenderSync::sync_object(BL::Object b_parent, int persistent_id[OBJECT_P
 
 	/* test if we need to sync */
 	bool object_updated = false;
+	bool flags_updated = false;
 
 	if(object_map.sync(&object, b_ob, b_parent, key))
 		object_updated = true;
@@ -299,8 +300,7 @@ Object *BlenderSync::sync_object(BL::Object b_parent, int persistent_id[OBJECT_P
 	/* holdout */
 	if(use_holdout != object->use_holdout) {
 		object->use_holdout = use_holdout;
-		scene->object_manager->tag_update(scene);
-		object_updated = true;
+		flags_updated = true;
 	}
 
 	/* visibility flags for both parent and child */
@@ -322,7 +322,7 @@ Object *BlenderSync::sync_object(BL::Object b_parent, int persistent_id[OBJECT_P
 
 	if(visibility != object->visibility) {
 		object->visibility = visibility;
-		object_updated = true;
+		flags_updated = true;
 	}
 
 	/* object sync
@@ -379,6 +379,12 @@ Object *BlenderSync::sync_object(BL::Object b_parent, int persistent_id[OBJECT_P
 
 		object->tag_update(scene);
 	}
+	else if(flags_updated) {
+		/* holdout and visibility only change object flags and the BVH, this
+		 * way render layers switch without updating meshes */
+		scene->camera->need_flags_update = true;
+		scene->object_manager->tag_update(scene);
+	}
 
 	return object;
 }
@@ -547,11 +553,21 @@ void BlenderSync::sync_objects(BL::SpaceView3D b_v3d, float motion_time)
 		}
 	}
 
+	/* converted meshes must be finished even when cancelled, to free the
+	 * derived meshes */
+	if(!motion) {
+		progress.set_sync_status("Synchronizing meshes");
+		sync_mesh_tasks_finish();
+	}
+
 	progress.set_sync_status("");
 
 	if(!cancel && !motion) {
 		sync_background_light(use_portal);
 
+		if(keep_hidden_objects)
+			sync_hidden_objects();
+
 		/* handle removed data and modified pointers */
 		if(light_map.post_sync())
 			scene->light_manager->tag_update(scene);
@@ -567,6 +583,42 @@ void BlenderSync::sync_objects(BL::SpaceView3D b_v3d, float motion_time)
 		mesh_motion_synced.clear();
 }
 
+/* Objects that were synced for another render layer of the same frame are
+ * kept, with no ray visibility, along with their mesh and particle system.
+ * Switching render layers then only changes visibility flags, rather than
+ * syncing meshes from Blender and building their BVHs again. Objects not
+ * synced by any render layer of the frame, like deleted objects or dupli
+ * instances of previous frames, are not kept, so post_sync deletes them. */
+
+void BlenderSync::sync_render_layers_begin()
+{
+	render_layer_objects.clear();
+}
+
+void BlenderSync::sync_hidden_objects()
+{
+	foreach(Object *object, scene->objects) {
+		if(object_map.is_used(object)) {
+			render_layer_objects.insert(object);
+			continue;
+		}
+
+		if(render_layer_objects.find(object) == render_layer_objects.end())
+			continue;
+
+		if(object->visibility != 0) {
+			object->visibility = 0;
+			scene->object_manager->tag_update(scene);
+		}
+
+		object_map.used(object);
+		mesh_map.used(object->mesh);
+
+		if(object->particle_system)
+			particle_system_map.used(object->particle_system);
+	}
+}
+
 void BlenderSync::sync_motion(BL::SpaceView3D b_v3d, BL::Object b_override, void **python_thread_state)
 {
 	if(scene->need_motion() == Scene::MOTION_NONE)
@@ -32,6 +32,7 @@
 #include "util_color.h"
 #include "util_foreach.h"
 #include "util_function.h"
+#include "util_path.h"
 #include "util_progress.h"
 #include "util_time.h"
 
@@ -271,6 +272,8 @@ static PassType get_pass_type(BL::RenderPass b_pass)
 		{
 			if(b_pass.debug_type() == BL::RenderPass::debug_type_BVH_TRAVERSAL_STEPS)
 				return PASS_BVH_TRAVERSAL_STEPS;
+			if(b_pass.debug_type() == BL::RenderPass::debug_type_RENDER_TIME)
+				return PASS_RENDER_TIME;
 			break;
 		}
 #endif
@@ -413,8 +416,9 @@ void BlenderSession::render()
 	SessionParams session_params = BlenderSync::get_session_params(b_engine, b_userpref, b_scene, background);
 	BufferParams buffer_params = BlenderSync::get_buffer_params(b_render, b_v3d, b_rv3d, scene->camera, width, height);
 
-	/* render each layer */
+	/* render each layer, objects of other layers of this frame are kept */
 	BL::RenderSettings r = b_scene.render();
+	sync->sync_render_layers_begin();
 	BL::RenderSettings::layers_iterator b_layer_iter;
 	BL::RenderResult::views_iterator b_view_iter;
 	
@@ -439,6 +443,7 @@ void BlenderSession::render()
 		Pass::add(PASS_COMBINED, passes);
 #ifdef WITH_CYCLES_DEBUG
 		Pass::add(PASS_BVH_TRAVERSAL_STEPS, passes);
+		Pass::add(PASS_RENDER_TIME, passes);
 #endif
 
 		if(session_params.device.advanced_shading) {
@@ -463,15 +468,23 @@ void BlenderSession::render()
 		scene->film->tag_update(scene);
 		scene->integrator->tag_update(scene);
 
+		bool first_view = true;
+
 		for(b_rr.views.begin(b_view_iter); b_view_iter != b_rr.views.end(); ++b_view_iter) {
 			b_rview_name = b_view_iter->name();
 
 			/* set the current view */
 			b_engine.active_view_set(b_rview_name.c_str());
 
-			/* update scene */
+			/* update scene, views of a render layer only differ in the camera
+			 * so they share the synced data, unless camera motion has to be
+			 * synced by changing frames */
 			sync->sync_camera(b_render, b_engine.camera_override(), width, height);
-			sync->sync_data(b_v3d, b_engine.camera_override(), &python_thread_state, b_rlay_name.c_str());
+
+			if(first_view || scene->need_motion() != Scene::MOTION_NONE)
+				sync->sync_data(b_v3d, b_engine.camera_override(), &python_thread_state, b_rlay_name.c_str());
+
+			first_view = false;
 
 			/* update number of samples per layer */
 			int samples = sync->get_layer_samples();
@@ -482,6 +495,20 @@ void BlenderSession::render()
 			else
 				session->reset(buffer_params, session_params.samples);
 
+			/* checkpoint and statistics next to the output file, for every
+			 * frame, layer and view */
+			string output_dirname = path_dirname(blender_absolute_path(b_data, b_scene, b_render.filepath()));
+			string output_name = string_printf("%04d_%s_%s",
+			                                   b_scene.frame_current(),
+			                                   b_rlay_name.c_str(),
+			                                   b_rview_name.c_str());
+
+			if(session_params.checkpoint_interval > 0.0)
+				session->set_checkpoint(path_join(output_dirname, "cycles_checkpoint_" + output_name),
+				                        b_data.filepath());
+			if(session_params.use_ray_stats)
+				session->set_ray_stats_report(path_join(output_dirname, "cycles_stats_" + output_name + ".json"));
+
 			/* render */
 			session->start();
 			session->wait();
@@ -874,6 +901,12 @@ void BlenderSession::update_status_progress()
 
 	timestatus += string_printf("Mem:%.2fM, Peak:%.2fM", (double)mem_used, (double)mem_peak);
 
+	if(session->stats.texture_cache_hits || session->stats.texture_cache_misses) {
+		timestatus += string_printf(", Tex Cache Hits:%lu, Misses:%lu",
+		                            (unsigned long)session->stats.texture_cache_hits,
+		                            (unsigned long)session->stats.texture_cache_misses);
+	}
+
 	if(status.size() > 0)
 		status = " | " + status;
 	if(substatus.size() > 0)
@@ -37,6 +37,8 @@
 #include "util_foreach.h"
 #include "util_opengl.h"
 #include "util_hash.h"
+#include "util_logging.h"
+#include "util_time.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -53,11 +55,13 @@ BlenderSync::BlenderSync(BL::RenderEngine b_engine_, BL::BlendData b_data_, BL::
   world_map(NULL),
   world_recalc(false),
   experimental(false),
+  use_threaded_sync(false),
   progress(progress_)
 {
 	scene = scene_;
 	preview = preview_;
 	is_cpu = is_cpu_;
+	keep_hidden_objects = !preview;
 }
 
 BlenderSync::~BlenderSync()
@@ -147,19 +151,45 @@ bool BlenderSync::sync_recalc()
 
 void BlenderSync::sync_data(BL::SpaceView3D b_v3d, BL::Object b_override, void **python_thread_state, const char *layer)
 {
+	PointerRNA cscene = RNA_pointer_get(&b_scene.ptr, "cycles");
+	use_threaded_sync = get_boolean(cscene, "use_threaded_sync");
+
+	double time_start = time_dt();
+
 	sync_render_layers(b_v3d, layer);
 	sync_integrator();
 	sync_film();
+
+	double time_settings = time_dt();
+
 	sync_shaders();
+
+	double time_shaders = time_dt();
+
 	sync_images();
 	sync_curve_settings();
 
+	double time_images = time_dt();
+
 	mesh_synced.clear(); /* use for objects and motion sync */
 
 	sync_objects(b_v3d);
+
+	double time_objects = time_dt();
+
 	sync_motion(b_v3d, b_override, python_thread_state);
 
+	double time_motion = time_dt();
+
 	mesh_synced.clear();
+
+	VLOG(1) << "Synchronized scene in " << time_motion - time_start << " seconds"
+	        << (use_threaded_sync? " (threaded)": "") << ": "
+	        << "settings " << time_settings - time_start << ", "
+	        << "shaders " << time_shaders - time_settings << ", "
+	        << "images " << time_images - time_shaders << ", "
+	        << "objects " << time_objects - time_images << ", "
+	        << "motion " << time_motion - time_objects << ".";
 }
 
 /* Integrator */
@@ -190,6 +220,7 @@ void BlenderSync::sync_integrator()
 
 	integrator->volume_max_steps = get_int(cscene, "volume_max_steps");
 	integrator->volume_step_size = get_float(cscene, "volume_step_size");
+	integrator->use_volume_majorant = get_boolean(cscene, "use_volume_majorant");
 
 	integrator->caustics_reflective = get_boolean(cscene, "caustics_reflective");
 	integrator->caustics_refractive = get_boolean(cscene, "caustics_refractive");
@@ -221,6 +252,13 @@ void BlenderSync::sync_integrator()
 	integrator->sample_all_lights_direct = get_boolean(cscene, "sample_all_lights_direct");
 	integrator->sample_all_lights_indirect = get_boolean(cscene, "sample_all_lights_indirect");
 
+	bool use_light_tree = get_boolean(cscene, "use_light_tree");
+
+	if(integrator->use_light_tree != use_light_tree) {
+		integrator->use_light_tree = use_light_tree;
+		scene->light_manager->tag_update(scene);
+	}
+
 	int diffuse_samples = get_int(cscene, "diffuse_samples");
 	int glossy_samples = get_int(cscene, "glossy_samples");
 	int transmission_samples = get_int(cscene, "transmission_samples");
@@ -419,6 +457,11 @@ SceneParams BlenderSync::get_scene_params(BL::Scene b_scene, bool background, bo
 
 	params.use_bvh_spatial_split = RNA_boolean_get(&cscene, "debug_use_spatial_splits");
 	params.use_bvh_cache = (background)? RNA_boolean_get(&cscene, "use_cache"): false;
+	params.use_bvh_memory_cache = (background)? RNA_boolean_get(&cscene, "use_memory_cache"): false;
+	params.use_bvh_refit = (background)? RNA_boolean_get(&cscene, "use_bvh_refit"): false;
+
+	params.use_texture_cache = RNA_boolean_get(&cscene, "use_texture_cache");
+	params.texture_cache_size = RNA_int_get(&cscene, "texture_cache_size");
 
 	if(background && params.shadingsystem != SHADINGSYSTEM_OSL)
 		params.persistent_data = r.use_persistent_data();
@@ -428,11 +471,13 @@ SceneParams BlenderSync::get_scene_params(BL::Scene b_scene, bool background, bo
 #if !(defined(__GNUC__) && (defined(i386) || defined(_M_IX86)))
 	if(is_cpu) {
 		params.use_qbvh = system_cpu_support_sse2();
+		params.use_qbvh_compressed = params.use_qbvh && RNA_boolean_get(&cscene, "use_bvh_compression");
 	}
 	else
 #endif
 	{
 		params.use_qbvh = false;
+		params.use_qbvh_compressed = false;
 	}
 
 	return params;
@@ -522,6 +567,24 @@ SessionParams BlenderSync::get_session_params(BL::RenderEngine b_engine,
 		}
 	}
 
+	/* adaptive sampling */
+	params.adaptive_threshold = get_float(cscene, "adaptive_threshold");
+	params.adaptive_min_samples = get_int(cscene, "adaptive_min_samples");
+	params.adaptive_max_samples = get_int(cscene, "adaptive_max_samples");
+
+	if(get_boolean(cscene, "use_square_samples"))
+		params.adaptive_max_samples *= params.adaptive_max_samples;
+
+	/* denoising */
+	params.use_denoising = get_boolean(cscene, "use_denoising");
+	params.denoising.radius = get_int(cscene, "denoising_radius");
+	params.denoising.strength = get_float(cscene, "denoising_strength");
+	params.denoising.feature_strength = get_float(cscene, "denoising_feature_strength");
+
+	/* ray stream */
+	params.use_ray_stream = get_boolean(cscene, "use_ray_stream");
+	params.use_ray_stats = background && get_boolean(cscene, "debug_use_ray_stats");
+
 	/* tiles */
 	if(params.device.type != DEVICE_CPU && !background) {
 		/* currently GPU could be much slower than CPU when using tiles,
@@ -559,6 +622,7 @@ SessionParams BlenderSync::get_session_params(BL::RenderEngine b_engine,
 	params.text_timeout = get_float(cscene, "debug_text_timeout");
 
 	params.progressive_refine = get_boolean(cscene, "use_progressive_refine");
+	params.checkpoint_interval = (double)get_float(cscene, "checkpoint_interval")*60.0;
 
 	if(background) {
 		if(params.progressive_refine)
@@ -29,12 +29,14 @@
 
 #include "util_map.h"
 #include "util_set.h"
+#include "util_task.h"
 #include "util_transform.h"
 #include "util_vector.h"
 
 CCL_NAMESPACE_BEGIN
 
 class Background;
+struct BlenderMeshSync;
 class Camera;
 class Film;
 class Light;
@@ -55,6 +57,7 @@ public:
 	bool sync_recalc();
 	void sync_data(BL::SpaceView3D b_v3d, BL::Object b_override, void **python_thread_state, const char *layer = 0);
 	void sync_render_layers(BL::SpaceView3D b_v3d, const char *layer);
+	void sync_render_layers_begin();
 	void sync_integrator();
 	void sync_camera(BL::RenderSettings b_render, BL::Object b_override, int width, int height);
 	void sync_view(BL::SpaceView3D b_v3d, BL::RegionView3D b_rv3d, int width, int height);
@@ -75,6 +78,7 @@ private:
 	void sync_lamps(bool update_all);
 	void sync_materials(bool update_all);
 	void sync_objects(BL::SpaceView3D b_v3d, float motion_time = 0.0f);
+	void sync_hidden_objects();
 	void sync_motion(BL::SpaceView3D b_v3d, BL::Object b_override, void **python_thread_state);
 	void sync_film();
 	void sync_view();
@@ -84,6 +88,8 @@ private:
 
 	void sync_nodes(Shader *shader, BL::ShaderNodeTree b_ntree);
 	Mesh *sync_mesh(BL::Object b_ob, bool object_updated, bool hide_tris);
+	void sync_mesh_finish(BlenderMeshSync *msync);
+	void sync_mesh_tasks_finish();
 	void sync_curves(Mesh *mesh, BL::Mesh b_mesh, BL::Object b_ob, bool motion, int time_index = 0);
 	Object *sync_object(BL::Object b_parent, int persistent_id[OBJECT_PERSISTENT_ID_SIZE], BL::DupliObject b_dupli_ob,
 	                                 Transform& tfm, uint layer_flag, float motion_time, bool hide_tris, bool *use_portal);
@@ -116,6 +122,8 @@ private:
 	id_map<ParticleSystemKey, ParticleSystem> particle_system_map;
 	set<Mesh*> mesh_synced;
 	set<Mesh*> mesh_motion_synced;
+	vector<BlenderMeshSync*> mesh_sync_queue;
+	TaskPool mesh_task_pool;
 	std::set<float> motion_times;
 	void *world_map;
 	bool world_recalc;
@@ -124,6 +132,15 @@ private:
 	bool preview;
 	bool experimental;
 	bool is_cpu;
+	bool use_threaded_sync;
+
+	/* final renders keep objects of other render layers hidden in the scene
+	 * instead of deleting them, so that all render layers and views of a
+	 * frame share the same meshes, BVHs and images */
+	bool keep_hidden_objects;
+	/* objects synced for a render layer of the current frame, only these
+	 * are kept hidden, others are deleted as usual */
+	set<Object*> render_layer_objects;
 
 	struct RenderLayerInfo {
 		RenderLayerInfo()
@@ -477,6 +477,11 @@ public:
 		return (data) ? used_set.find(data) != used_set.end() : false;
 	}
 
+	bool is_used(T *data)
+	{
+		return used_set.find(data) != used_set.end();
+	}
+
 	void used(T *data)
 	{
 		/* tag data as still in use */
@@ -32,6 +32,8 @@
 #include "util_map.h"
 #include "util_progress.h"
 #include "util_system.h"
+#include "util_thread.h"
+#include "util_time.h"
 #include "util_types.h"
 #include "util_math.h"
 
@@ -72,22 +74,49 @@ BVH *BVH::create(const BVHParams& params, const vector<Object*>& objects)
 
 /* Cache */
 
-bool BVH::cache_read(CacheData& key)
+void BVH::cache_key(CacheData& key, bool topology_only)
 {
-	key.add(system_cpu_bits());
-	key.add(&params, sizeof(params));
+	/* build parameters, without the struct padding */
+	int key_params[] = {
+		system_cpu_bits(),
+		params.use_spatial_split,
+		__float_as_int(params.spatial_split_alpha),
+		__float_as_int(params.sah_node_cost),
+		__float_as_int(params.sah_primitive_cost),
+		params.min_leaf_size,
+		params.max_triangle_leaf_size,
+		params.max_curve_leaf_size,
+		params.top_level,
+		params.use_qbvh,
+		params.use_qbvh && params.use_qbvh_compressed,
+		/* curves store oriented bounds since version 1 of the packed layout */
+		1};
+
+	key.add(key_params, sizeof(key_params));
+
+	/* for topology only keys, sizes are used instead of positions so that
+	 * deformed meshes get the same key */
+	vector<size_t> sizes;
 
 	foreach(Object *ob, objects) {
 		Mesh *mesh = ob->mesh;
 
-		key.add(mesh->verts);
 		key.add(mesh->triangles);
-		key.add(mesh->curve_keys);
 		key.add(mesh->curves);
-		key.add(&ob->bounds, sizeof(ob->bounds));
 		key.add(&ob->visibility, sizeof(ob->visibility));
 		key.add(&mesh->transform_applied, sizeof(bool));
 
+		if(topology_only) {
+			sizes.push_back(mesh->verts.size());
+			sizes.push_back(mesh->curve_keys.size());
+			sizes.push_back((mesh->has_motion_blur())? mesh->motion_steps: 0);
+			continue;
+		}
+
+		key.add(mesh->verts);
+		key.add(mesh->curve_keys);
+		key.add(&ob->bounds, sizeof(ob->bounds));
+
 		if(mesh->use_motion_blur) {
 			Attribute *attr = mesh->attributes.find(ATTR_STD_MOTION_VERTEX_POSITION);
 			if(attr)
@@ -99,6 +128,14 @@ bool BVH::cache_read(CacheData& key)
 		}
 	}
 
+	key.add(sizes);
+
+	/* hash now, while the local buffers are still alive */
+	key.get_filename();
+}
+
+bool BVH::cache_read(CacheData& key)
+{
 	CacheData value;
 
 	if(Cache::global.lookup(key, value)) {
@@ -173,23 +210,232 @@ void BVH::clear_cache_except()
 	Cache::global.clear_except("bvh", except);
 }
 
+/* Memory Cache
+ *
+ * Packed mesh BVHs are kept in memory between scene updates, so meshes that
+ * did not change are not built again for every frame of an animation render.
+ * Entries are looked up by the same key as the disk cache, and those not used
+ * by the last built scene are freed when building its top level BVH. */
+
+static thread_mutex memory_cache_mutex;
+static map<string, PackedBVH> memory_cache;
+
+/* Refit Cache
+ *
+ * Build trees of mesh BVHs, looked up by a key of the mesh topology only. A
+ * mesh that was deformed but kept its topology refits the tree of the last
+ * build instead of building a new one. The SAH cost right after the full
+ * build is kept, to fall back to a rebuild once refitting degraded the tree
+ * too much. */
+
+struct BVHRefitEntry {
+	BVHNode *root;
+	vector<int> prim_type;
+	vector<int> prim_index;
+	vector<int> prim_object;
+	float build_SAH;
+};
+
+static map<string, BVHRefitEntry*> refit_cache;
+
+static void refit_cache_entry_free(BVHRefitEntry *entry)
+{
+	entry->root->deleteSubtree();
+	delete entry;
+}
+
+bool BVH::memory_cache_read(CacheData& key)
+{
+	thread_scoped_lock lock(memory_cache_mutex);
+	map<string, PackedBVH>::iterator it = memory_cache.find(key.get_filename());
+
+	if(it == memory_cache.end())
+		return false;
+
+	pack = it->second;
+	cache_filename = key.get_filename();
+
+	return true;
+}
+
+void BVH::memory_cache_write(CacheData& key)
+{
+	thread_scoped_lock lock(memory_cache_mutex);
+
+	if(memory_cache.find(key.get_filename()) == memory_cache.end())
+		memory_cache.insert(std::make_pair(key.get_filename(), pack));
+
+	cache_filename = key.get_filename();
+}
+
+void BVH::memory_cache_clear_except()
+{
+	set<string> except;
+
+	foreach(Object *ob, objects) {
+		BVH *bvh = ob->mesh->bvh;
+
+		if(bvh && !bvh->cache_filename.empty())
+			except.insert(bvh->cache_filename);
+		if(bvh && !bvh->refit_filename.empty())
+			except.insert(bvh->refit_filename);
+	}
+
+	thread_scoped_lock lock(memory_cache_mutex);
+	map<string, PackedBVH>::iterator it = memory_cache.begin();
+
+	while(it != memory_cache.end()) {
+		if(except.find(it->first) != except.end())
+			++it;
+		else
+			memory_cache.erase(it++);
+	}
+
+	map<string, BVHRefitEntry*>::iterator jt = refit_cache.begin();
+
+	while(jt != refit_cache.end()) {
+		if(except.find(jt->first) != except.end()) {
+			++jt;
+		}
+		else {
+			refit_cache_entry_free(jt->second);
+			refit_cache.erase(jt++);
+		}
+	}
+}
+
+void BVH::memory_cache_free()
+{
+	thread_scoped_lock lock(memory_cache_mutex);
+	memory_cache.clear();
+
+	for(map<string, BVHRefitEntry*>::iterator it = refit_cache.begin(); it != refit_cache.end(); it++)
+		refit_cache_entry_free(it->second);
+
+	refit_cache.clear();
+}
+
+bool BVH::refit_cache_read(CacheData& key, Progress& progress)
+{
+	BVHRefitEntry *entry;
+
+	refit_filename = key.get_filename();
+
+	/* take the entry out of the cache while refitting it */
+	{
+		thread_scoped_lock lock(memory_cache_mutex);
+		map<string, BVHRefitEntry*>::iterator it = refit_cache.find(refit_filename);
+
+		if(it == refit_cache.end())
+			return false;
+
+		entry = it->second;
+		refit_cache.erase(it);
+	}
+
+	progress.set_substatus("Refitting BVH");
+
+	BVHBuild bvh_build(objects, entry->prim_type, entry->prim_index, entry->prim_object, params, progress);
+	bvh_build.refit(entry->root);
+
+	if(progress.get_cancel()) {
+		refit_cache_entry_free(entry);
+		return false;
+	}
+
+	/* compare quality against the full build */
+	float SAH = entry->root->computeSubtreeSAHCost(params);
+	float cost_ratio = SAH / max(entry->build_SAH, 1e-6f);
+
+	if(!(cost_ratio <= params.refit_max_cost_ratio)) {
+		VLOG(1) << "Refitted BVH SAH cost is " << cost_ratio
+		        << " times the full build, rebuilding.";
+		refit_cache_entry_free(entry);
+		return false;
+	}
+
+	VLOG(1) << "BVH refitted, SAH cost is " << cost_ratio << " times the full build.";
+
+	pack.prim_type = entry->prim_type;
+	pack.prim_index = entry->prim_index;
+	pack.prim_object = entry->prim_object;
+	pack.SAH = SAH;
+
+	progress.set_substatus("Packing BVH triangles and strands");
+	pack_primitives();
+
+	progress.set_substatus("Packing BVH nodes");
+	pack_nodes(entry->root);
+
+	refit_cache_write(key, entry);
+
+	return true;
+}
+
+void BVH::refit_cache_write(CacheData& key, BVHRefitEntry *entry)
+{
+	thread_scoped_lock lock(memory_cache_mutex);
+	refit_filename = key.get_filename();
+
+	/* meshes with the same topology share an entry */
+	if(refit_cache.find(refit_filename) == refit_cache.end())
+		refit_cache[refit_filename] = entry;
+	else
+		refit_cache_entry_free(entry);
+}
+
 /* Building */
 
 void BVH::build(Progress& progress)
 {
 	progress.set_substatus("Building BVH");
 
+	/* mesh BVHs are kept in memory, the top level is always built */
+	bool use_memory_cache = params.use_memory_cache && !params.top_level;
+	bool use_refit = use_memory_cache && params.use_refit;
+
+	/* topology key, computed first so that the tree for refitting is kept
+	 * when the exact same mesh is found in the cache */
+	CacheData refit_key("bvh_refit");
+
+	if(use_refit) {
+		cache_key(refit_key, true);
+		refit_filename = refit_key.get_filename();
+	}
+
 	/* cache read */
+	double cache_time = time_dt();
 	CacheData key("bvh");
 
-	if(params.use_cache) {
+	if(params.use_cache || use_memory_cache) {
 		progress.set_substatus("Looking in BVH cache");
+		cache_key(key, false);
+
+		if(use_memory_cache && memory_cache_read(key)) {
+			VLOG(1) << "BVH found in memory cache.";
+			return;
+		}
 
-		if(cache_read(key))
+		if(params.use_cache && cache_read(key)) {
+			VLOG(1) << "BVH found in disk cache.";
+			if(use_memory_cache)
+				memory_cache_write(key);
 			return;
+		}
 	}
 
+	/* refit tree of a mesh with the same topology */
+	if(use_refit && refit_cache_read(refit_key, progress)) {
+		if(use_memory_cache)
+			memory_cache_write(key);
+		VLOG(1) << "BVH refit time: " << time_dt() - cache_time;
+		return;
+	}
+
+	cache_time = time_dt() - cache_time;
+
 	/* build nodes */
+	double build_time = time_dt();
 	vector<int> prim_type;
 	vector<int> prim_index;
 	vector<int> prim_object;
@@ -206,22 +452,33 @@ void BVH::build(Progress& progress)
 	pack.prim_type = prim_type;
 	pack.prim_index = prim_index;
 	pack.prim_object = prim_object;
-	prim_type.free_memory();
-	prim_index.free_memory();
-	prim_object.free_memory();
+
+	if(!use_refit) {
+		prim_type.free_memory();
+		prim_index.free_memory();
+		prim_object.free_memory();
+	}
+
+	build_time = time_dt() - build_time;
 
 	/* compute SAH */
+	double sah_time = time_dt();
+
 	if(!params.top_level)
 		pack.SAH = root->computeSubtreeSAHCost(params);
 
+	sah_time = time_dt() - sah_time;
+
 	if(progress.get_cancel()) {
 		root->deleteSubtree();
 		return;
 	}
 
 	/* pack triangles */
+	double pack_primitives_time = time_dt();
 	progress.set_substatus("Packing BVH triangles and strands");
 	pack_primitives();
+	pack_primitives_time = time_dt() - pack_primitives_time;
 
 	if(progress.get_cancel()) {
 		root->deleteSubtree();
@@ -229,15 +486,30 @@ void BVH::build(Progress& progress)
 	}
 
 	/* pack nodes */
+	double pack_nodes_time = time_dt();
 	progress.set_substatus("Packing BVH nodes");
 	pack_nodes(root);
-
-	/* free build nodes */
-	root->deleteSubtree();
+	pack_nodes_time = time_dt() - pack_nodes_time;
+
+	/* free build nodes, or keep them to refit in later updates */
+	if(use_refit && !progress.get_cancel()) {
+		BVHRefitEntry *entry = new BVHRefitEntry();
+		entry->root = root;
+		entry->prim_type.swap(prim_type);
+		entry->prim_index.swap(prim_index);
+		entry->prim_object.swap(prim_object);
+		entry->build_SAH = pack.SAH;
+
+		refit_cache_write(refit_key, entry);
+	}
+	else
+		root->deleteSubtree();
 
 	if(progress.get_cancel()) return;
 
 	/* cache write */
+	double cache_write_time = time_dt();
+
 	if(params.use_cache) {
 		progress.set_substatus("Writing BVH cache");
 		cache_write(key);
@@ -246,6 +518,27 @@ void BVH::build(Progress& progress)
 		if(params.top_level)
 			clear_cache_except();
 	}
+
+	if(use_memory_cache)
+		memory_cache_write(key);
+
+	/* free mesh BVHs no longer used by the scene */
+	if(params.top_level) {
+		if(params.use_memory_cache)
+			memory_cache_clear_except();
+		else
+			memory_cache_free();
+	}
+
+	cache_write_time = time_dt() - cache_write_time;
+
+	VLOG(1) << "BVH build phases:\n"
+	        << "  Cache lookup time: " << cache_time << "\n"
+	        << "  Node build time: " << build_time << "\n"
+	        << "  SAH time: " << sah_time << "\n"
+	        << "  Primitive packing time: " << pack_primitives_time << "\n"
+	        << "  Node packing time: " << pack_nodes_time << "\n"
+	        << "  Cache write time: " << cache_write_time << "\n";
 }
 
 /* Refitting */
@@ -281,7 +574,70 @@ void BVH::pack_triangle(int idx, float4 woop[3])
 	woop[2] = float3_to_float4(v2);
 }
 
-/* Curves*/
+/* Curves
+ *
+ * Curve segments are long and thin and mostly not axis aligned, so their
+ * bounding boxes are mostly empty space. The unused triangle storage of a
+ * curve segment holds a box oriented along the segment instead, which the
+ * kernel tests before the more expensive curve intersection. Packed as the
+ * X and Z axes of the box with the center in w, and the half size. */
+
+void BVH::pack_curve(int idx, float4 woop[3])
+{
+	int tob = pack.prim_object[idx];
+	assert(tob >= 0 && tob < objects.size());
+	const Mesh *mesh = objects[tob]->mesh;
+
+	int cidx = pack.prim_index[idx];
+	const Mesh::Curve& curve = mesh->curves[cidx];
+	int k = PRIMITIVE_UNPACK_SEGMENT(pack.prim_type[idx]);
+	const float4 *keys = &mesh->curve_keys[0];
+
+	/* align Z with the segment, degenerate segments keep the world axes */
+	float3 X = make_float3(1.0f, 0.0f, 0.0f);
+	float3 Y = make_float3(0.0f, 1.0f, 0.0f);
+	float3 Z = make_float3(0.0f, 0.0f, 1.0f);
+	float3 axis = float4_to_float3(keys[curve.first_key + k + 1]) - float4_to_float3(keys[curve.first_key + k]);
+	float length = len(axis);
+
+	if(length > 1e-8f) {
+		Z = axis/length;
+		X = normalize(cross(Z, (fabsf(Z.x) < 0.9f)? make_float3(1.0f, 0.0f, 0.0f): make_float3(0.0f, 1.0f, 0.0f)));
+		Y = cross(Z, X);
+	}
+
+	Transform aligned_space = make_transform(X.x, X.y, X.z, 0.0f,
+	                                         Y.x, Y.y, Y.z, 0.0f,
+	                                         Z.x, Z.y, Z.z, 0.0f,
+	                                         0.0f, 0.0f, 0.0f, 1.0f);
+
+	BoundBox bounds = BoundBox::empty;
+	curve.bounds_grow(k, keys, aligned_space, bounds);
+
+	/* motion curves */
+	if((pack.prim_type[idx] & PRIMITIVE_MOTION_CURVE) && mesh->use_motion_blur) {
+		const Attribute *attr = mesh->curve_attributes.find(ATTR_STD_MOTION_VERTEX_POSITION);
+
+		if(attr) {
+			size_t mesh_size = mesh->curve_keys.size();
+			size_t steps = mesh->motion_steps - 1;
+			const float4 *key_steps = attr->data_float4();
+
+			for(size_t i = 0; i < steps; i++)
+				curve.bounds_grow(k, key_steps + i*mesh_size, aligned_space, bounds);
+		}
+	}
+
+	/* pad for the precision of the kernel test and the curve intersection */
+	float3 half_size = bounds.size()*0.5f;
+	half_size += make_float3(1.0f, 1.0f, 1.0f)*(max(max(half_size.x, half_size.y), half_size.z)*1e-3f + 1e-7f);
+
+	float3 center = transform_direction_transposed(&aligned_space, bounds.center());
+
+	woop[0] = make_float4(X.x, X.y, X.z, center.x);
+	woop[1] = make_float4(Z.x, Z.y, Z.z, center.y);
+	woop[2] = make_float4(half_size.x, half_size.y, half_size.z, center.z);
+}
 
 void BVH::pack_primitives()
 {
@@ -300,6 +656,9 @@ void BVH::pack_primitives()
 			if(pack.prim_type[i] & PRIMITIVE_TRIANGLE) {
 				pack_triangle(i, woop);
 			}
+			else if(pack.prim_type[i] & PRIMITIVE_ALL_CURVE) {
+				pack_curve(i, woop);
+			}
 			else {
 				/* Avoid use of uninitialized memory. */
 				memset(&woop, 0, sizeof(woop));
@@ -329,7 +688,8 @@ void BVH::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
 	 * BVH's are stored in global arrays. This function merges them into the
 	 * top level BVH, adjusting indexes and offsets where appropriate. */
 	bool use_qbvh = params.use_qbvh;
-	size_t nsize = (use_qbvh)? BVH_QNODE_SIZE: BVH_NODE_SIZE;
+	bool use_qbvh_compressed = use_qbvh && params.use_qbvh_compressed;
+	size_t nsize = (use_qbvh_compressed)? BVH_QNODE_COMPRESSED_SIZE: (use_qbvh)? BVH_QNODE_SIZE: BVH_NODE_SIZE;
 	size_t nsize_leaf = (use_qbvh)? BVH_QNODE_LEAF_SIZE: BVH_NODE_LEAF_SIZE;
 
 	/* adjust primitive index to point to the triangle in the global array, for
@@ -475,9 +835,9 @@ void BVH::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
 
 		if(bvh->pack.nodes.size()) {
 			/* For QBVH we're packing a child bbox into 6 float4,
-			 * and for regular BVH they're packed into 3 float4.
+			 * compressed QBVH and regular BVH pack them into 3 float4.
 			 */
-			size_t nsize_bbox = (use_qbvh)? 6: 3;
+			size_t nsize_bbox = (use_qbvh && !use_qbvh_compressed)? 6: 3;
 			int4 *bvh_nodes = &bvh->pack.nodes[0];
 			size_t bvh_nodes_size = bvh->pack.nodes.size(); 
 
@@ -754,11 +1114,37 @@ void QBVH::pack_leaf(const BVHStackEntry& e, const LeafNode *leaf)
 
 void QBVH::pack_inner(const BVHStackEntry& e, const BVHStackEntry *en, int num)
 {
-	float4 data[BVH_QNODE_SIZE];
+	BoundBox bounds[4];
+	int child[4];
 
 	for(int i = 0; i < num; i++) {
-		float3 bb_min = en[i].node->m_bounds.min;
-		float3 bb_max = en[i].node->m_bounds.max;
+		bounds[i] = en[i].node->m_bounds;
+		child[i] = en[i].encodeIdx();
+	}
+
+	for(int i = num; i < 4; i++) {
+		/* We store BB which would never be recorded as intersection
+		 * so kernel might safely assume there are always 4 child nodes.
+		 */
+		bounds[i] = BoundBox::empty;
+		child[i] = 0;
+	}
+
+	pack_inner_bounds(e.idx, bounds, child);
+}
+
+void QBVH::pack_inner_bounds(int idx, const BoundBox bounds[4], const int child[4])
+{
+	if(params.use_qbvh_compressed) {
+		pack_compressed_inner_bounds(idx, bounds, child);
+		return;
+	}
+
+	float4 data[BVH_QNODE_SIZE];
+
+	for(int i = 0; i < 4; i++) {
+		float3 bb_min = bounds[i].min;
+		float3 bb_max = bounds[i].max;
 
 		data[0][i] = bb_min.x;
 		data[1][i] = bb_max.x;
@@ -767,26 +1153,106 @@ void QBVH::pack_inner(const BVHStackEntry& e, const BVHStackEntry *en, int num)
 		data[4][i] = bb_min.z;
 		data[5][i] = bb_max.z;
 
-		data[6][i] = __int_as_float(en[i].encodeIdx());
+		data[6][i] = __int_as_float(child[i]);
 	}
 
-	for(int i = num; i < 4; i++) {
-		/* We store BB which would never be recorded as intersection
-		 * so kernel might safely assume there are always 4 child nodes.
-		 */
-		data[0][i] = FLT_MAX;
-		data[1][i] = -FLT_MAX;
+	memcpy(&pack.nodes[idx * BVH_QNODE_SIZE], data, sizeof(float4)*BVH_QNODE_SIZE);
+}
 
-		data[2][i] = FLT_MAX;
-		data[3][i] = -FLT_MAX;
+/* Decode a quantized plane like the kernel does, with and without fused
+ * multiply-add since the kernels for different instruction sets differ. */
+static bool qbvh_quantized_contains(int q, float origin, float scale, float value, bool upper)
+{
+	volatile float product = q*scale;
+	float decoded = origin + product;
+	float decoded_fused = (float)((double)origin + (double)q*(double)scale);
 
-		data[4][i] = FLT_MAX;
-		data[5][i] = -FLT_MAX;
+	if(upper)
+		return decoded >= value && decoded_fused >= value;
+	else
+		return decoded <= value && decoded_fused <= value;
+}
 
-		data[6][i] = __int_as_float(0);
+static uint qbvh_quantize(float value, float origin, float scale, bool upper)
+{
+	float f = (value - origin)/scale;
+	int q = clamp((int)((upper)? ceilf(f): floorf(f)), 0, 255);
+
+	/* step outwards until float rounding can't make the bounds smaller */
+	if(upper) {
+		while(q < 255 && !qbvh_quantized_contains(q, origin, scale, value, true))
+			q++;
+	}
+	else {
+		while(q > 0 && !qbvh_quantized_contains(q, origin, scale, value, false))
+			q--;
 	}
 
-	memcpy(&pack.nodes[e.idx * BVH_QNODE_SIZE], data, sizeof(float4)*BVH_QNODE_SIZE);
+	return (uint)q;
+}
+
+void QBVH::pack_compressed_inner_bounds(int idx, const BoundBox bounds[4], const int child[4])
+{
+	BoundBox node_bounds = BoundBox::empty;
+
+	for(int i = 0; i < 4; i++)
+		if(child[i] != 0)
+			node_bounds.grow(bounds[i]);
+
+	float3 origin = node_bounds.min;
+	float3 scale;
+
+	for(int axis = 0; axis < 3; axis++) {
+		float lower = node_bounds.min[axis];
+		float upper = node_bounds.max[axis];
+
+		/* the cell size must be large enough for the grid to reach the upper
+		 * bound, and for a full grid to differ from the origin so that empty
+		 * children decode to inverted bounds */
+		float cell = max((upper - lower)/255.0f, max(fabsf(lower), fabsf(upper))*1e-6f);
+		cell = max(cell, 1e-30f);
+
+		while(!qbvh_quantized_contains(255, lower, cell, upper, true))
+			cell = nextafterf(cell, FLT_MAX);
+
+		scale[axis] = cell;
+	}
+
+	uint planes[6] = {0, 0, 0, 0, 0, 0};
+
+	for(int i = 0; i < 4; i++) {
+		for(int axis = 0; axis < 3; axis++) {
+			uint qmin, qmax;
+
+			if(child[i] == 0) {
+				qmin = 255;
+				qmax = 0;
+			}
+			else {
+				qmin = qbvh_quantize(bounds[i].min[axis], origin[axis], scale[axis], false);
+				qmax = qbvh_quantize(bounds[i].max[axis], origin[axis], scale[axis], true);
+			}
+
+			planes[axis*2 + 0] |= qmin << (i*8);
+			planes[axis*2 + 1] |= qmax << (i*8);
+		}
+	}
+
+	float4 data[BVH_QNODE_COMPRESSED_SIZE];
+
+	data[0] = make_float4(origin.x, origin.y, origin.z, __uint_as_float(planes[0]));
+	data[1] = make_float4(scale.x, scale.y, scale.z, __uint_as_float(planes[1]));
+	data[2] = make_float4(__uint_as_float(planes[2]), __uint_as_float(planes[3]),
+	                      __uint_as_float(planes[4]), __uint_as_float(planes[5]));
+	data[3] = make_float4(__int_as_float(child[0]), __int_as_float(child[1]),
+	                      __int_as_float(child[2]), __int_as_float(child[3]));
+
+	memcpy(&pack.nodes[idx * BVH_QNODE_COMPRESSED_SIZE], data, sizeof(float4)*BVH_QNODE_COMPRESSED_SIZE);
+}
+
+size_t QBVH::inner_node_size() const
+{
+	return (params.use_qbvh_compressed)? BVH_QNODE_COMPRESSED_SIZE: BVH_QNODE_SIZE;
 }
 
 /* Quad SIMD Nodes */
@@ -803,11 +1269,11 @@ void QBVH::pack_nodes(const BVHNode *root)
 
 	/* for top level BVH, first merge existing BVH's so we know the offsets */
 	if(params.top_level) {
-		pack_instances(node_size*BVH_QNODE_SIZE,
+		pack_instances(node_size*inner_node_size(),
 		               leaf_node_size*BVH_QNODE_LEAF_SIZE);
 	}
 	else {
-		pack.nodes.resize(node_size*BVH_QNODE_SIZE);
+		pack.nodes.resize(node_size*inner_node_size());
 		pack.leaf_nodes.resize(leaf_node_size*BVH_QNODE_LEAF_SIZE);
 	}
 
@@ -977,8 +1443,8 @@ void QBVH::refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility)
 		       sizeof(float4)*BVH_QNODE_LEAF_SIZE);
 	}
 	else {
-		int4 *data = &pack.nodes[idx*BVH_QNODE_SIZE];
-		int4 c = data[6];
+		size_t nsize = inner_node_size();
+		int4 c = pack.nodes[idx*nsize + nsize-1];
 		/* Refit inner node, set bbox from children. */
 		BoundBox child_bbox[4] = {BoundBox::empty,
 		                          BoundBox::empty,
@@ -997,21 +1463,8 @@ void QBVH::refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility)
 			}
 		}
 
-		float4 inner_data[BVH_QNODE_SIZE];
-		for(int i = 0; i < 4; ++i) {
-			float3 bb_min = child_bbox[i].min;
-			float3 bb_max = child_bbox[i].max;
-			inner_data[0][i] = bb_min.x;
-			inner_data[1][i] = bb_max.x;
-			inner_data[2][i] = bb_min.y;
-			inner_data[3][i] = bb_max.y;
-			inner_data[4][i] = bb_min.z;
-			inner_data[5][i] = bb_max.z;
-			inner_data[6][i] = __int_as_float(c[i]);
-		}
-		memcpy(&pack.nodes[idx * BVH_QNODE_SIZE],
-		       inner_data,
-		       sizeof(float4)*BVH_QNODE_SIZE);
+		int child[4] = {c.x, c.y, c.z, c.w};
+		pack_inner_bounds(idx, child_bbox, child);
 	}
 }
 
@@ -27,6 +27,7 @@
 CCL_NAMESPACE_BEGIN
 
 class BVHNode;
+struct BVHRefitEntry;
 struct BVHStackEntry;
 class BVHParams;
 class BoundBox;
@@ -38,6 +39,7 @@ class Progress;
 #define BVH_NODE_SIZE	4
 #define BVH_NODE_LEAF_SIZE	1
 #define BVH_QNODE_SIZE	7
+#define BVH_QNODE_COMPRESSED_SIZE	4
 #define BVH_QNODE_LEAF_SIZE	1
 #define BVH_ALIGN		4096
 #define TRI_NODE_SIZE	3
@@ -88,6 +90,7 @@ public:
 	BVHParams params;
 	vector<Object*> objects;
 	string cache_filename;
+	string refit_filename;
 
 	static BVH *create(const BVHParams& params, const vector<Object*>& objects);
 	virtual ~BVH() {}
@@ -97,16 +100,30 @@ public:
 
 	void clear_cache_except();
 
+	/* free all mesh BVHs kept in memory */
+	static void memory_cache_free();
+
 protected:
 	BVH(const BVHParams& params, const vector<Object*>& objects);
 
 	/* cache */
+	void cache_key(CacheData& key, bool topology_only);
 	bool cache_read(CacheData& key);
 	void cache_write(CacheData& key);
 
+	/* memory cache */
+	bool memory_cache_read(CacheData& key);
+	void memory_cache_write(CacheData& key);
+	void memory_cache_clear_except();
+
+	/* refit cache */
+	bool refit_cache_read(CacheData& key, Progress& progress);
+	void refit_cache_write(CacheData& key, BVHRefitEntry *entry);
+
 	/* triangles and strands*/
 	void pack_primitives();
 	void pack_triangle(int idx, float4 woop[3]);
+	void pack_curve(int idx, float4 woop[3]);
 
 	/* merge instance BVH's */
 	void pack_instances(size_t nodes_size, size_t leaf_nodes_size);
@@ -151,6 +168,11 @@ protected:
 	void pack_nodes(const BVHNode *root);
 	void pack_leaf(const BVHStackEntry& e, const LeafNode *leaf);
 	void pack_inner(const BVHStackEntry& e, const BVHStackEntry *en, int num);
+	void pack_inner_bounds(int idx, const BoundBox bounds[4], const int child[4]);
+	void pack_compressed_inner_bounds(int idx, const BoundBox bounds[4], const int child[4]);
+
+	/* number of float4 in an inner node */
+	size_t inner_node_size() const;
 
 	/* refit */
 	void refit_nodes();
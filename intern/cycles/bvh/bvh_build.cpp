@@ -26,6 +26,7 @@
 #include "scene.h"
 #include "curves.h"
 
+#include "util_atomic.h"
 #include "util_debug.h"
 #include "util_foreach.h"
 #include "util_logging.h"
@@ -62,6 +63,24 @@ public:
 	BVHObjectBinning range;
 };
 
+/* Spatial split build tasks copy their part of the references, since spatial
+ * splits insert duplicated references and subtrees are built in parallel. */
+
+class BVHSpatialSplitBuildTask : public Task {
+public:
+	BVHSpatialSplitBuildTask(BVHBuild *build, InnerNode *node, int child, const BVHRange& range_, const vector<BVHReference>& references_, int level)
+	: range(range_),
+	  references(references_.begin() + range_.start(), references_.begin() + range_.end())
+	{
+		range.set_start(0);
+		run = function_bind(&BVHBuild::thread_build_spatial_split_node, build, node, child, &range, &references, &storage, level);
+	}
+
+	BVHRange range;
+	vector<BVHReference> references;
+	BVHSpatialStorage storage;
+};
+
 /* Constructor / Destructor */
 
 BVHBuild::BVHBuild(const vector<Object*>& objects_,
@@ -235,8 +254,6 @@ BVHNode* BVHBuild::run()
 		params.use_spatial_split = false;
 
 	spatial_min_overlap = root.bounds().safe_area() * params.spatial_split_alpha;
-	spatial_right_bounds.clear();
-	spatial_right_bounds.resize(max(root.size(), (int)BVHParams::NUM_SPATIAL_BINS) - 1);
 
 	/* init progress updates */
 	double build_start_time;
@@ -245,19 +262,25 @@ BVHNode* BVHBuild::run()
 	progress_total = references.size();
 	progress_original_total = progress_total;
 
-	prim_type.resize(references.size());
-	prim_index.resize(references.size());
-	prim_object.resize(references.size());
-
 	/* build recursively */
 	BVHNode *rootnode;
 
 	if(params.use_spatial_split) {
-		/* singlethreaded spatial split build */
-		rootnode = build_node(root, 0);
+		/* multithreaded spatial split build, leaves append their primitives
+		 * since the number of references grows with duplicates */
+		prim_type.reserve(references.size());
+		prim_index.reserve(references.size());
+		prim_object.reserve(references.size());
+
+		rootnode = build_node(root, &references, &spatial_storage, 0);
+		task_pool.wait_work();
 	}
 	else {
 		/* multithreaded binning build */
+		prim_type.resize(references.size());
+		prim_index.resize(references.size());
+		prim_object.resize(references.size());
+
 		BVHObjectBinning rootbin(root, (references.size())? &references[0]: NULL);
 		rootnode = build_node(rootbin, 0);
 		task_pool.wait_work();
@@ -270,11 +293,14 @@ BVHNode* BVHBuild::run()
 			rootnode = NULL;
 			VLOG(1) << "BVH build cancelled.";
 		}
-		else if(!params.use_spatial_split) {
+		else {
 			/*rotate(rootnode, 4, 5);*/
 			rootnode->update_visibility();
 			VLOG(1) << "BVH build statistics:\n"
 			        << "  Build time: " << time_dt() - build_start_time << "\n"
+			        << "  Spatial splits: " << (params.use_spatial_split? "yes": "no") << "\n"
+			        << "  Duplicated references: "
+			        << progress_total - progress_original_total << "\n"
 			        << "  Total number of nodes: "
 			        << rootnode->getSubtreeSize(BVH_STAT_NODE_COUNT) << "\n"
 			        << "  Number of inner nodes: "
@@ -325,7 +351,27 @@ void BVHBuild::thread_build_node(InnerNode *inner, int child, BVHObjectBinning *
 	}
 }
 
-bool BVHBuild::range_within_max_leaf_size(const BVHRange& range)
+void BVHBuild::thread_build_spatial_split_node(InnerNode *inner, int child, BVHRange *range, vector<BVHReference> *references, BVHSpatialStorage *storage, int level)
+{
+	if(progress.get_cancel())
+		return;
+
+	/* build nodes */
+	BVHNode *node = build_node(*range, references, storage, level);
+
+	/* set child in inner node */
+	inner->children[child] = node;
+
+	/* update progress */
+	if(range->size() < THREAD_TASK_SIZE) {
+		thread_scoped_lock lock(build_mutex);
+
+		progress_count += range->size();
+		progress_update();
+	}
+}
+
+bool BVHBuild::range_within_max_leaf_size(const BVHRange& range, const vector<BVHReference>& references)
 {
 	size_t size = range.size();
 	size_t max_leaf_size = max(params.max_triangle_leaf_size, params.max_curve_leaf_size);
@@ -338,7 +384,7 @@ bool BVHBuild::range_within_max_leaf_size(const BVHRange& range)
 	size_t num_motion_curves = 0;
 
 	for(int i = 0; i < size; i++) {
-		BVHReference& ref = references[range.start() + i];
+		const BVHReference& ref = references[range.start() + i];
 
 		if(ref.prim_type() & PRIMITIVE_CURVE)
 			num_curves++;
@@ -364,8 +410,8 @@ BVHNode* BVHBuild::build_node(const BVHObjectBinning& range, int level)
 	 * visibility tests, since object instances do not check visibility flag */
 	if(!(range.size() > 0 && params.top_level && level == 0)) {
 		/* make leaf node when threshold reached or SAH tells us */
-		if(params.small_enough_for_leaf(size, level) || (range_within_max_leaf_size(range) && leafSAH < splitSAH))
-			return create_leaf_node(range);
+		if(params.small_enough_for_leaf(size, level) || (range_within_max_leaf_size(range, references) && leafSAH < splitSAH))
+			return create_leaf_node(range, references);
 	}
 
 	/* perform split */
@@ -393,48 +439,57 @@ BVHNode* BVHBuild::build_node(const BVHObjectBinning& range, int level)
 	return inner;
 }
 
-/* single threaded spatial split builder */
-BVHNode* BVHBuild::build_node(const BVHRange& range, int level)
+/* multithreaded spatial split builder */
+BVHNode* BVHBuild::build_node(const BVHRange& range, vector<BVHReference> *references, BVHSpatialStorage *storage, int level)
 {
-	/* progress update */
-	progress_update();
 	if(progress.get_cancel())
 		return NULL;
 
 	/* small enough or too deep => create leaf. */
 	if(!(range.size() > 0 && params.top_level && level == 0)) {
-		if(params.small_enough_for_leaf(range.size(), level)) {
-			progress_count += range.size();
-			return create_leaf_node(range);
-		}
+		if(params.small_enough_for_leaf(range.size(), level))
+			return create_leaf_node(range, *references);
 	}
 
 	/* splitting test */
-	BVHMixedSplit split(this, range, level);
+	BVHMixedSplit split(this, storage, *references, range, level);
 
 	if(!(range.size() > 0 && params.top_level && level == 0)) {
-		if(split.no_split) {
-			progress_count += range.size();
-			return create_leaf_node(range);
-		}
+		if(split.no_split)
+			return create_leaf_node(range, *references);
 	}
 	
 	/* do split */
 	BVHRange left, right;
-	split.split(this, left, right, range);
+	split.split(this, *references, left, right, range);
+
+	atomic_add_z(&progress_total, left.size() + right.size() - range.size());
+
+	/* create inner node. */
+	InnerNode *inner;
 
-	progress_total += left.size() + right.size() - range.size();
-	size_t total = progress_total;
+	if(range.size() < THREAD_TASK_SIZE) {
+		/* local build */
+		size_t num_references = references->size();
 
-	/* left node */
-	BVHNode *leftnode = build_node(left, level + 1);
+		/* left node */
+		BVHNode *leftnode = build_node(left, references, storage, level + 1);
+
+		/* right node (modify start for splits) */
+		right.set_start(right.start() + references->size() - num_references);
+		BVHNode *rightnode = build_node(right, references, storage, level + 1);
+
+		inner = new InnerNode(range.bounds(), leftnode, rightnode);
+	}
+	else {
+		/* threaded build */
+		inner = new InnerNode(range.bounds());
 
-	/* right node (modify start for splits) */
-	right.set_start(right.start() + progress_total - total);
-	BVHNode *rightnode = build_node(right, level + 1);
+		task_pool.push(new BVHSpatialSplitBuildTask(this, inner, 0, left, *references, level + 1), true);
+		task_pool.push(new BVHSpatialSplitBuildTask(this, inner, 1, right, *references, level + 1), true);
+	}
 
-	/* inner node */
-	return new InnerNode(range.bounds(), leftnode, rightnode);
+	return inner;
 }
 
 /* Create Nodes */
@@ -446,19 +501,6 @@ BVHNode *BVHBuild::create_object_leaf_nodes(const BVHReference *ref, int start,
 		return new LeafNode(bounds, 0, 0, 0);
 	}
 	else if(num == 1) {
-		if(start == prim_index.size()) {
-			assert(params.use_spatial_split);
-
-			prim_type.push_back(ref->prim_type());
-			prim_index.push_back(ref->prim_index());
-			prim_object.push_back(ref->prim_object());
-		}
-		else {
-			prim_type[start] = ref->prim_type();
-			prim_index[start] = ref->prim_index();
-			prim_object[start] = ref->prim_object();
-		}
-
 		uint visibility = objects[ref->prim_object()]->visibility;
 		return new LeafNode(ref->bounds(), visibility, start, start+1);
 	}
@@ -475,31 +517,29 @@ BVHNode *BVHBuild::create_object_leaf_nodes(const BVHReference *ref, int start,
 	}
 }
 
-BVHNode *BVHBuild::create_primitive_leaf_node(const int *p_type,
-                                              const int *p_index,
-                                              const int *p_object,
-                                              const BoundBox& bounds,
-                                              uint visibility,
-                                              int start,
-                                              int num)
+void BVHBuild::store_leaf_primitives(int start,
+                                     const vector<int> *p_type,
+                                     const vector<int> *p_index,
+                                     const vector<int> *p_object,
+                                     const vector<BVHReference>& object_references)
 {
-	for(int i = 0; i < num; ++i) {
-		if(start + i == prim_index.size()) {
-			assert(params.use_spatial_split);
-			prim_type.push_back(p_type[i]);
-			prim_index.push_back(p_index[i]);
-			prim_object.push_back(p_object[i]);
-		}
-		else {
-			prim_type[start + i] = p_type[i];
-			prim_index[start + i] = p_index[i];
-			prim_object[start + i] = p_object[i];
+	for(int i = 0; i < PRIMITIVE_NUM_TOTAL; ++i) {
+		for(size_t j = 0; j < p_type[i].size(); ++j, ++start) {
+			prim_type[start] = p_type[i][j];
+			prim_index[start] = p_index[i][j];
+			prim_object[start] = p_object[i][j];
 		}
 	}
-	return new LeafNode(bounds, visibility, start, start + num);
+
+	foreach(const BVHReference& ref, object_references) {
+		prim_type[start] = ref.prim_type();
+		prim_index[start] = ref.prim_index();
+		prim_object[start] = ref.prim_object();
+		++start;
+	}
 }
 
-BVHNode* BVHBuild::create_leaf_node(const BVHRange& range)
+BVHNode* BVHBuild::create_leaf_node(const BVHRange& range, const vector<BVHReference>& references)
 {
 	/* TODO(sergey): Consider writing own allocator which would
 	 * not do heap allocation if number of elements is relatively small.
@@ -513,11 +553,11 @@ BVHNode* BVHBuild::create_leaf_node(const BVHRange& range)
 	                                        BoundBox::empty,
 	                                        BoundBox::empty,
 	                                        BoundBox::empty};
-	int ob_num = 0;
+	vector<BVHReference> object_references;
 
 	/* Fill in per-type type/index array. */
 	for(int i = 0; i < range.size(); i++) {
-		BVHReference& ref = references[range.start() + i];
+		const BVHReference& ref = references[range.start() + i];
 		if(ref.prim_index() != -1) {
 			int type_index = bitscan(ref.prim_type() & PRIMITIVE_ALL);
 			p_type[type_index].push_back(ref.prim_type());
@@ -528,40 +568,51 @@ BVHNode* BVHBuild::create_leaf_node(const BVHRange& range)
 			visibility[type_index] |= objects[ref.prim_object()]->visibility;
 		}
 		else {
-			if(ob_num < i) {
-				references[range.start() + ob_num] = ref;
-			}
-			ob_num++;
+			object_references.push_back(ref);
 		}
 	}
 
+	/* Store primitives. With spatial splits, subtrees are built in parallel
+	 * from their own copies of the references, so leaves are appended. */
+	int start = range.start();
+	int num = range.size();
+
+	if(params.use_spatial_split) {
+		thread_scoped_lock lock(build_mutex);
+
+		start = prim_type.size();
+		prim_type.resize(start + num);
+		prim_index.resize(start + num);
+		prim_object.resize(start + num);
+
+		store_leaf_primitives(start, p_type, p_index, p_object, object_references);
+	}
+	else {
+		store_leaf_primitives(start, p_type, p_index, p_object, object_references);
+	}
+
 	/* Create leaf nodes for every existing primitive. */
 	BVHNode *leaves[PRIMITIVE_NUM_TOTAL + 1] = {NULL};
 	int num_leaves = 0;
-	int start = range.start();
 	for(int i = 0; i < PRIMITIVE_NUM_TOTAL; ++i) {
-		int num = (int)p_type[i].size();
-		if(num != 0) {
+		int num_type = (int)p_type[i].size();
+		if(num_type != 0) {
 			assert(p_type[i].size() == p_index[i].size());
 			assert(p_type[i].size() == p_object[i].size());
-			leaves[num_leaves] = create_primitive_leaf_node(&p_type[i][0],
-			                                                &p_index[i][0],
-			                                                &p_object[i][0],
-			                                                bounds[i],
-			                                                visibility[i],
-			                                                start,
-			                                                num);
+			leaves[num_leaves] = new LeafNode(bounds[i], visibility[i], start, start + num_type);
 			++num_leaves;
-			start += num;
+			start += num_type;
 		}
 	}
 
 	/* Create leaf node for object. */
+	int ob_num = (int)object_references.size();
+
 	if(num_leaves == 0 || ob_num) {
 		/* Only create object leaf nodes if there are objects or no other
 		 * nodes created.
 		 */
-		const BVHReference *ref = (ob_num)? &references[range.start()]: NULL;
+		const BVHReference *ref = (ob_num)? &object_references[0]: NULL;
 		leaves[num_leaves] = create_object_leaf_nodes(ref, start, ob_num);
 		++num_leaves;
 	}
@@ -596,6 +647,99 @@ BVHNode* BVHBuild::create_leaf_node(const BVHRange& range)
 	}
 }
 
+/* Refit */
+
+void BVHBuild::refit(BVHNode *root)
+{
+	progress.set_substatus("Refitting BVH nodes");
+	refit_node(root);
+
+	if(progress.get_cancel())
+		return;
+
+	/* rotations only ever lower the SAH cost */
+	progress.set_substatus("Rotating BVH nodes");
+	rotate(root, BVHParams::MAX_DEPTH, 2);
+}
+
+void BVHBuild::refit_node(BVHNode *node)
+{
+	if(node->is_leaf()) {
+		LeafNode *leaf = (LeafNode*)node;
+		BoundBox bounds = BoundBox::empty;
+
+		for(int prim = leaf->m_lo; prim < leaf->m_hi; prim++)
+			grow_primitive_bounds(prim, bounds);
+
+		leaf->m_bounds = bounds;
+	}
+	else {
+		InnerNode *inner = (InnerNode*)node;
+
+		refit_node(inner->children[0]);
+		refit_node(inner->children[1]);
+
+		inner->m_bounds = merge(inner->children[0]->m_bounds, inner->children[1]->m_bounds);
+	}
+}
+
+void BVHBuild::grow_primitive_bounds(int prim, BoundBox& bounds)
+{
+	Object *ob = objects[prim_object[prim]];
+	int pidx = prim_index[prim];
+	int type = prim_type[prim];
+
+	if(pidx == -1) {
+		/* object instance */
+		bounds.grow(ob->bounds);
+		return;
+	}
+
+	const Mesh *mesh = ob->mesh;
+
+	if(type & PRIMITIVE_ALL_CURVE) {
+		/* curves */
+		const Mesh::Curve& curve = mesh->curves[pidx];
+		int k = PRIMITIVE_UNPACK_SEGMENT(type);
+
+		curve.bounds_grow(k, &mesh->curve_keys[0], bounds);
+
+		/* motion curves */
+		if(type & PRIMITIVE_MOTION_CURVE) {
+			Attribute *attr = mesh->curve_attributes.find(ATTR_STD_MOTION_VERTEX_POSITION);
+
+			if(attr) {
+				size_t mesh_size = mesh->curve_keys.size();
+				size_t steps = mesh->motion_steps - 1;
+				float4 *key_steps = attr->data_float4();
+
+				for(size_t i = 0; i < steps; i++)
+					curve.bounds_grow(k, key_steps + i*mesh_size, bounds);
+			}
+		}
+	}
+	else {
+		/* triangles */
+		const Mesh::Triangle& triangle = mesh->triangles[pidx];
+
+		triangle.bounds_grow(&mesh->verts[0], bounds);
+
+		/* motion triangles */
+		if(type & PRIMITIVE_MOTION_TRIANGLE) {
+			Attribute *attr = mesh->attributes.find(ATTR_STD_MOTION_VERTEX_POSITION);
+
+			if(attr) {
+				size_t mesh_size = mesh->verts.size();
+				size_t steps = mesh->motion_steps - 1;
+				float3 *vert_steps = attr->data_float3();
+
+				for(size_t i = 0; i < steps; i++)
+					triangle.bounds_grow(vert_steps + i*mesh_size, bounds);
+			}
+		}
+	}
+}
+
 /* Tree Rotations */
 
 void BVHBuild::rotate(BVHNode *node, int max_depth, int iterations)
@@ -657,7 +801,7 @@ void BVHBuild::rotate(BVHNode *node, int max_depth)
 				best_target = 0;
 			}
 			else {
-				best_cost = cost0;
+				best_cost = cost1;
 				best_target = 1;
 			}
 		}
@@ -675,6 +819,7 @@ void BVHBuild::rotate(BVHNode *node, int max_depth)
 
 	swap(parent->children[best_other], child->children[best_target]);
 	child->m_bounds = merge(child->children[0]->m_bounds, child->children[1]->m_bounds);
+	child->m_visibility = child->children[0]->m_visibility|child->children[1]->m_visibility;
 }
 
 CCL_NAMESPACE_END
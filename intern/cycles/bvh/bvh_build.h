@@ -30,12 +30,25 @@
 CCL_NAMESPACE_BEGIN
 
 class BVHBuildTask;
+class BVHSpatialSplitBuildTask;
 class BVHParams;
 class InnerNode;
 class Mesh;
 class Object;
 class Progress;
 
+/* Spatial Split Storage
+ *
+ * Scratch memory of the split search. Each task building a subtree with
+ * spatial splits has its own, along with its own copy of the references. */
+
+class BVHSpatialStorage
+{
+public:
+	vector<BoundBox> right_bounds;
+	BVHSpatialBin bins[3][BVHParams::NUM_SPATIAL_BINS];
+};
+
 /* BVH Builder */
 
 class BVHBuild
@@ -53,11 +66,16 @@ public:
 
 	BVHNode *run();
 
+	/* refit a tree built earlier to the current primitive positions, and
+	 * rotate it to recover some of the lost quality */
+	void refit(BVHNode *root);
+
 protected:
 	friend class BVHMixedSplit;
 	friend class BVHObjectSplit;
 	friend class BVHSpatialSplit;
 	friend class BVHBuildTask;
+	friend class BVHSpatialSplitBuildTask;
 
 	/* adding references */
 	void add_reference_mesh(BoundBox& root, BoundBox& center, Mesh *mesh, int i);
@@ -65,30 +83,33 @@ protected:
 	void add_references(BVHRange& root);
 
 	/* building */
-	BVHNode *build_node(const BVHRange& range, int level);
+	BVHNode *build_node(const BVHRange& range, vector<BVHReference> *references, BVHSpatialStorage *storage, int level);
 	BVHNode *build_node(const BVHObjectBinning& range, int level);
-	BVHNode *create_leaf_node(const BVHRange& range);
+	BVHNode *create_leaf_node(const BVHRange& range, const vector<BVHReference>& references);
 	BVHNode *create_object_leaf_nodes(const BVHReference *ref, int start, int num);
 
-	/* Leaf node type splitting. */
-	BVHNode *create_primitive_leaf_node(const int *p_type,
-	                                    const int *p_index,
-	                                    const int *p_object,
-	                                    const BoundBox& bounds,
-	                                    uint visibility,
-	                                    int start,
-	                                    int nun);
+	/* Leaf primitives, grouped by type with object references last. */
+	void store_leaf_primitives(int start,
+	                           const vector<int> *p_type,
+	                           const vector<int> *p_index,
+	                           const vector<int> *p_object,
+	                           const vector<BVHReference>& object_references);
 
-	bool range_within_max_leaf_size(const BVHRange& range);
+	bool range_within_max_leaf_size(const BVHRange& range, const vector<BVHReference>& references);
 
 	/* threads */
 	enum { THREAD_TASK_SIZE = 4096 };
 	void thread_build_node(InnerNode *node, int child, BVHObjectBinning *range, int level);
+	void thread_build_spatial_split_node(InnerNode *node, int child, BVHRange *range, vector<BVHReference> *references, BVHSpatialStorage *storage, int level);
 	thread_mutex build_mutex;
 
 	/* progress */
 	void progress_update();
 
+	/* refit */
+	void refit_node(BVHNode *node);
+	void grow_primitive_bounds(int prim, BoundBox& bounds);
+
 	/* tree rotations */
 	void rotate(BVHNode *node, int max_depth);
 	void rotate(BVHNode *node, int max_depth, int iterations);
@@ -115,8 +136,7 @@ protected:
 
 	/* spatial splitting */
 	float spatial_min_overlap;
-	vector<BoundBox> spatial_right_bounds;
-	BVHSpatialBin spatial_bins[3][BVHParams::NUM_SPATIAL_BINS];
+	BVHSpatialStorage spatial_storage;
 
 	/* threads */
 	TaskPool task_pool;
@@ -46,9 +46,20 @@ public:
 	/* disk cache */
 	bool use_cache;
 
+	/* keep mesh BVHs in memory between scene updates */
+	bool use_memory_cache;
+
+	/* refit kept mesh BVHs when only vertices moved, up to a maximum ratio
+	 * of the SAH cost after refitting to the cost of the full build */
+	bool use_refit;
+	float refit_max_cost_ratio;
+
 	/* QBVH */
 	bool use_qbvh;
 
+	/* QBVH with child bounds quantized to 8 bits, for less memory bandwidth */
+	bool use_qbvh_compressed;
+
 	/* fixed parameters */
 	enum {
 		MAX_DEPTH = 64,
@@ -72,7 +83,11 @@ public:
 
 		top_level = false;
 		use_cache = false;
+		use_memory_cache = false;
+		use_refit = false;
+		refit_max_cost_ratio = 1.3f;
 		use_qbvh = false;
+		use_qbvh_compressed = false;
 	}
 
 	/* SAH costs */
@@ -28,22 +28,22 @@ CCL_NAMESPACE_BEGIN
 
 /* Object Split */
 
-BVHObjectSplit::BVHObjectSplit(BVHBuild *builder, const BVHRange& range, float nodeSAH)
+BVHObjectSplit::BVHObjectSplit(BVHBuild *builder, BVHSpatialStorage *storage, vector<BVHReference>& references, const BVHRange& range, float nodeSAH)
 : sah(FLT_MAX), dim(0), num_left(0), left_bounds(BoundBox::empty), right_bounds(BoundBox::empty)
 {
-	const BVHReference *ref_ptr = &builder->references[range.start()];
+	const BVHReference *ref_ptr = &references[range.start()];
 	float min_sah = FLT_MAX;
 
 	for(int dim = 0; dim < 3; dim++) {
 		/* sort references */
-		bvh_reference_sort(range.start(), range.end(), &builder->references[0], dim);
+		bvh_reference_sort(range.start(), range.end(), &references[0], dim);
 
 		/* sweep right to left and determine bounds. */
 		BoundBox right_bounds = BoundBox::empty;
 
 		for(int i = range.size() - 1; i > 0; i--) {
 			right_bounds.grow(ref_ptr[i].bounds());
-			builder->spatial_right_bounds[i - 1] = right_bounds;
+			storage->right_bounds[i - 1] = right_bounds;
 		}
 
 		/* sweep left to right and select lowest SAH. */
@@ -51,7 +51,7 @@ BVHObjectSplit::BVHObjectSplit(BVHBuild *builder, const BVHRange& range, float n
 
 		for(int i = 1; i < range.size(); i++) {
 			left_bounds.grow(ref_ptr[i - 1].bounds());
-			right_bounds = builder->spatial_right_bounds[i - 1];
+			right_bounds = storage->right_bounds[i - 1];
 
 			float sah = nodeSAH +
 				left_bounds.safe_area() * builder->params.primitive_cost(i) +
@@ -70,10 +70,10 @@ BVHObjectSplit::BVHObjectSplit(BVHBuild *builder, const BVHRange& range, float n
 	}
 }
 
-void BVHObjectSplit::split(BVHBuild *builder, BVHRange& left, BVHRange& right, const BVHRange& range)
+void BVHObjectSplit::split(vector<BVHReference>& references, BVHRange& left, BVHRange& right, const BVHRange& range)
 {
 	/* sort references according to split */
-	bvh_reference_sort(range.start(), range.end(), &builder->references[0], this->dim);
+	bvh_reference_sort(range.start(), range.end(), &references[0], this->dim);
 
 	/* split node ranges */
 	left = BVHRange(this->left_bounds, range.start(), this->num_left);
@@ -83,7 +83,7 @@ void BVHObjectSplit::split(BVHBuild *builder, BVHRange& left, BVHRange& right, c
 
 /* Spatial Split */
 
-BVHSpatialSplit::BVHSpatialSplit(BVHBuild *builder, const BVHRange& range, float nodeSAH)
+BVHSpatialSplit::BVHSpatialSplit(BVHBuild *builder, BVHSpatialStorage *storage, const vector<BVHReference>& references, const BVHRange& range, float nodeSAH)
 : sah(FLT_MAX), dim(0), pos(0.0f)
 {
 	/* initialize bins. */
@@ -93,7 +93,7 @@ BVHSpatialSplit::BVHSpatialSplit(BVHBuild *builder, const BVHRange& range, float
 
 	for(int dim = 0; dim < 3; dim++) {
 		for(int i = 0; i < BVHParams::NUM_SPATIAL_BINS; i++) {
-			BVHSpatialBin& bin = builder->spatial_bins[dim][i];
+			BVHSpatialBin& bin = storage->bins[dim][i];
 
 			bin.bounds = BoundBox::empty;
 			bin.enter = 0;
@@ -103,7 +103,7 @@ BVHSpatialSplit::BVHSpatialSplit(BVHBuild *builder, const BVHRange& range, float
 
 	/* chop references into bins. */
 	for(unsigned int refIdx = range.start(); refIdx < range.end(); refIdx++) {
-		const BVHReference& ref = builder->references[refIdx];
+		const BVHReference& ref = references[refIdx];
 		float3 firstBinf = (ref.bounds().min - origin) * invBinSize;
 		float3 lastBinf = (ref.bounds().max - origin) * invBinSize;
 		int3 firstBin = make_int3((int)firstBinf.x, (int)firstBinf.y, (int)firstBinf.z);
@@ -119,13 +119,13 @@ BVHSpatialSplit::BVHSpatialSplit(BVHBuild *builder, const BVHRange& range, float
 				BVHReference leftRef, rightRef;
 
 				split_reference(builder, leftRef, rightRef, currRef, dim, origin[dim] + binSize[dim] * (float)(i + 1));
-				builder->spatial_bins[dim][i].bounds.grow(leftRef.bounds());
+				storage->bins[dim][i].bounds.grow(leftRef.bounds());
 				currRef = rightRef;
 			}
 
-			builder->spatial_bins[dim][lastBin[dim]].bounds.grow(currRef.bounds());
-			builder->spatial_bins[dim][firstBin[dim]].enter++;
-			builder->spatial_bins[dim][lastBin[dim]].exit++;
+			storage->bins[dim][lastBin[dim]].bounds.grow(currRef.bounds());
+			storage->bins[dim][firstBin[dim]].enter++;
+			storage->bins[dim][lastBin[dim]].exit++;
 		}
 	}
 
@@ -135,8 +135,8 @@ BVHSpatialSplit::BVHSpatialSplit(BVHBuild *builder, const BVHRange& range, float
 		BoundBox right_bounds = BoundBox::empty;
 
 		for(int i = BVHParams::NUM_SPATIAL_BINS - 1; i > 0; i--) {
-			right_bounds.grow(builder->spatial_bins[dim][i].bounds);
-			builder->spatial_right_bounds[i - 1] = right_bounds;
+			right_bounds.grow(storage->bins[dim][i].bounds);
+			storage->right_bounds[i - 1] = right_bounds;
 		}
 
 		/* sweep left to right and select lowest SAH. */
@@ -145,13 +145,13 @@ BVHSpatialSplit::BVHSpatialSplit(BVHBuild *builder, const BVHRange& range, float
 		int rightNum = range.size();
 
 		for(int i = 1; i < BVHParams::NUM_SPATIAL_BINS; i++) {
-			left_bounds.grow(builder->spatial_bins[dim][i - 1].bounds);
-			leftNum += builder->spatial_bins[dim][i - 1].enter;
-			rightNum -= builder->spatial_bins[dim][i - 1].exit;
+			left_bounds.grow(storage->bins[dim][i - 1].bounds);
+			leftNum += storage->bins[dim][i - 1].enter;
+			rightNum -= storage->bins[dim][i - 1].exit;
 
 			float sah = nodeSAH +
 				left_bounds.safe_area() * builder->params.primitive_cost(leftNum) +
-				builder->spatial_right_bounds[i - 1].safe_area() * builder->params.primitive_cost(rightNum);
+				storage->right_bounds[i - 1].safe_area() * builder->params.primitive_cost(rightNum);
 
 			if(sah < this->sah) {
 				this->sah = sah;
@@ -162,7 +162,7 @@ BVHSpatialSplit::BVHSpatialSplit(BVHBuild *builder, const BVHRange& range, float
 	}
 }
 
-void BVHSpatialSplit::split(BVHBuild *builder, BVHRange& left, BVHRange& right, const BVHRange& range)
+void BVHSpatialSplit::split(BVHBuild *builder, vector<BVHReference>& references, BVHRange& left, BVHRange& right, const BVHRange& range)
 {
 	/* Categorize references and compute bounds.
 	 *
@@ -170,7 +170,7 @@ void BVHSpatialSplit::split(BVHBuild *builder, BVHRange& left, BVHRange& right,
 	 * Uncategorized/split:		[left_end, right_start[
 	 * Right-hand side:			[right_start, refs.size()[ */
 
-	vector<BVHReference>& refs = builder->references;
+	vector<BVHReference>& refs = references;
 	int left_start = range.start();
 	int left_end = left_start;
 	int right_start = range.end();
@@ -281,36 +281,12 @@ void BVHSpatialSplit::split_reference(BVHBuild *builder, BVHReference& left, BVH
 		}
 	}
 	else {
-		/* curve split: NOTE - Currently ignores curve width and needs to be fixed.*/
-		const int k0 = mesh->curves[ref.prim_index()].first_key + PRIMITIVE_UNPACK_SEGMENT(ref.prim_type());
-		const int k1 = k0 + 1;
-		const float4 key0 = mesh->curve_keys[k0];
-		const float4 key1 = mesh->curve_keys[k1];
-		const float3 v0 = float4_to_float3(key0);
-		const float3 v1 = float4_to_float3(key1);
-
-		float v0p = v0[dim];
-		float v1p = v1[dim];
-
-		/* insert vertex to the boxes it belongs to. */
-		if(v0p <= pos)
-			left_bounds.grow(v0);
-
-		if(v0p >= pos)
-			right_bounds.grow(v0);
-
-		if(v1p <= pos)
-			left_bounds.grow(v1);
-
-		if(v1p >= pos)
-			right_bounds.grow(v1);
-
-		/* edge intersects the plane => insert intersection to both boxes. */
-		if((v0p < pos && v1p > pos) || (v0p > pos && v1p < pos)) {
-			float3 t = lerp(v0, v1, clamp((pos - v0p) / (v1p - v0p), 0.0f, 1.0f));
-			left_bounds.grow(t);
-			right_bounds.grow(t);
-		}
+		/* curve split: the segment is a cubic with a radius, so the keys and
+		 * the chord between them don't bound it. Clipping the bounds of the
+		 * whole segment is conservative, the kernel then culls with the box
+		 * oriented along the segment. */
+		left_bounds = ref.bounds();
+		right_bounds = ref.bounds();
 	}
 
 	/* intersect with original bounds. */
@@ -176,6 +176,9 @@ public:
 	/* open shading language, only for CPU device */
 	virtual void *osl_memory() { return NULL; }
 
+	/* on demand image textures, only for CPU device */
+	virtual void *texture_cache_memory() { return NULL; }
+
 	/* load/compile kernels, must be called before adding tasks */ 
 	virtual bool load_kernels(
 	        const DeviceRequestedFeatures& /*requested_features*/)
@@ -194,7 +197,7 @@ public:
 
 #ifdef WITH_NETWORK
 	/* networking */
-	void server_run();
+	void server_run(int port, int tiles_in_flight);
 #endif
 
 	/* multi device */
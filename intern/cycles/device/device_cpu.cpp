@@ -39,6 +39,8 @@
 #include "kernel_types.h"
 #include "kernel_globals.h"
 
+#include "kernel_texture_cache.h"
+
 #include "osl_shader.h"
 #include "osl_globals.h"
 
@@ -52,6 +54,7 @@
 #include "util_progress.h"
 #include "util_system.h"
 #include "util_thread.h"
+#include "util_time.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -64,10 +67,14 @@ public:
 #ifdef WITH_OSL
 	OSLGlobals osl_globals;
 #endif
+	TextureCacheGlobals texture_cache_globals;
 	
 	CPUDevice(DeviceInfo& info, Stats &stats, bool background)
 	: Device(info, stats, background)
 	{
+		/* image slots without data must read as empty */
+		memset(&kernel_globals, 0, sizeof(kernel_globals));
+
 #ifdef WITH_OSL
 		kernel_globals.osl = &osl_globals;
 #endif
@@ -78,11 +85,15 @@ public:
 		system_cpu_support_sse41();
 		system_cpu_support_avx();
 		system_cpu_support_avx2();
+#ifdef __KERNEL_STATS__
+		time_ticks_per_second();
+#endif
 	}
 
 	~CPUDevice()
 	{
 		task_pool.stop();
+		kernel_tex_free(&kernel_globals);
 	}
 
 	void mem_alloc(device_memory& mem, MemoryType /*type*/)
@@ -150,6 +161,22 @@ public:
 #endif
 	}
 
+	void *texture_cache_memory()
+	{
+		return &texture_cache_globals;
+	}
+
+	void texture_cache_update_stats()
+	{
+		OIIO::TextureSystem *ts = texture_cache_globals.ts;
+		long long tile_calls = 0, tile_misses = 0;
+
+		ts->getattribute("stat:find_tile_calls", OIIO::TypeDesc::INT64, &tile_calls);
+		ts->getattribute("stat:find_tile_cache_misses", OIIO::TypeDesc::INT64, &tile_misses);
+
+		stats.texture_cache_update(tile_calls - tile_misses, tile_misses);
+	}
+
 	void thread_run(DeviceTask *task)
 	{
 		if(task->type == DeviceTask::PATH_TRACE)
@@ -169,6 +196,73 @@ public:
 		}
 	};
 
+	/* Adaptive sampling: pixels are marked as converged in the auxiliary pass
+	 * once the estimated noise in their neighborhood drops below the threshold,
+	 * after which no more samples are taken for them. */
+	bool adaptive_pixel_converged(RenderTile& tile, int x, int y)
+	{
+		const KernelFilm& kfilm = kernel_globals.__data.film;
+		float *buffer = (float*)tile.buffer + (tile.offset + x + y*tile.stride)*kfilm.pass_stride;
+
+		return buffer[kfilm.pass_adaptive_aux_buffer + 1] != 0.0f;
+	}
+
+	bool adaptive_sampling_update(RenderTile& tile, float threshold)
+	{
+		const KernelFilm& kfilm = kernel_globals.__data.film;
+		float *render_buffer = (float*)tile.buffer;
+		vector<float> error(tile.w*tile.h);
+
+		/* standard error of the pixel luminance, relative to the square root of
+		 * the luminance since noise is less visible in bright areas */
+		for(int y = 0; y < tile.h; y++) {
+			for(int x = 0; x < tile.w; x++) {
+				int index = tile.offset + tile.x + x + (tile.y + y)*tile.stride;
+				float *buffer = render_buffer + index*kfilm.pass_stride;
+				float *aux = buffer + kfilm.pass_adaptive_aux_buffer;
+				float *combined = buffer + kfilm.pass_combined;
+				float num_samples = buffer[kfilm.pass_sample_count];
+
+				if(aux[1] != 0.0f) {
+					error[x + y*tile.w] = 0.0f;
+					continue;
+				}
+
+				float mean = linear_rgb_to_gray(make_float3(combined[0], combined[1], combined[2]))/num_samples;
+				float variance = max(aux[0]/num_samples - mean*mean, 0.0f);
+
+				error[x + y*tile.w] = sqrtf(variance/num_samples)/sqrtf(max(mean, 1e-4f));
+			}
+		}
+
+		/* a pixel only converges along with its neighbors, so that isolated pixels
+		 * with a low noise estimate by chance keep sampling */
+		bool tile_converged = true;
+
+		for(int y = 0; y < tile.h; y++) {
+			for(int x = 0; x < tile.w; x++) {
+				int index = tile.offset + tile.x + x + (tile.y + y)*tile.stride;
+				float *aux = render_buffer + index*kfilm.pass_stride + kfilm.pass_adaptive_aux_buffer;
+
+				if(aux[1] != 0.0f)
+					continue;
+
+				float max_error = 0.0f;
+
+				for(int dy = max(y - 1, 0); dy <= min(y + 1, tile.h - 1); dy++)
+					for(int dx = max(x - 1, 0); dx <= min(x + 1, tile.w - 1); dx++)
+						max_error = max(max_error, error[dx + dy*tile.w]);
+
+				if(max_error < threshold)
+					aux[1] = 1.0f;
+				else
+					tile_converged = false;
+			}
+		}
+
+		return tile_converged;
+	}
+
 	void thread_path_trace(DeviceTask& task)
 	{
 		if(task_pool.canceled()) {
@@ -181,38 +275,69 @@ public:
 #ifdef WITH_OSL
 		OSLShader::thread_init(&kg, &kernel_globals, &osl_globals);
 #endif
+		kernel_texture_cache_thread_init(&kg, &texture_cache_globals);
+
+#ifdef __KERNEL_STATS__
+		RayStats ray_stats;
+
+		if(task.use_ray_stats) {
+			kg.ray_stats = &ray_stats;
+			kg.ray_stats_ms_per_tick = (float)(1000.0/time_ticks_per_second());
+		}
+#endif
 
 		RenderTile tile;
 
 		void(*path_trace_kernel)(KernelGlobals*, float*, unsigned int*, int, int, int, int, int);
+		void(*path_trace_stream_kernel)(KernelGlobals*, float*, unsigned int*, int, const int*, int, int, int, int);
 
 #ifdef WITH_CYCLES_OPTIMIZED_KERNEL_AVX2
-		if(system_cpu_support_avx2())
+		if(system_cpu_support_avx2()) {
 			path_trace_kernel = kernel_cpu_avx2_path_trace;
+			path_trace_stream_kernel = kernel_cpu_avx2_path_trace_stream;
+		}
 		else
 #endif
 #ifdef WITH_CYCLES_OPTIMIZED_KERNEL_AVX
-		if(system_cpu_support_avx())
+		if(system_cpu_support_avx()) {
 			path_trace_kernel = kernel_cpu_avx_path_trace;
+			path_trace_stream_kernel = kernel_cpu_avx_path_trace_stream;
+		}
 		else
 #endif
 #ifdef WITH_CYCLES_OPTIMIZED_KERNEL_SSE41
-		if(system_cpu_support_sse41())
+		if(system_cpu_support_sse41()) {
 			path_trace_kernel = kernel_cpu_sse41_path_trace;
+			path_trace_stream_kernel = kernel_cpu_sse41_path_trace_stream;
+		}
 		else
 #endif
 #ifdef WITH_CYCLES_OPTIMIZED_KERNEL_SSE3
-		if(system_cpu_support_sse3())
+		if(system_cpu_support_sse3()) {
 			path_trace_kernel = kernel_cpu_sse3_path_trace;
+			path_trace_stream_kernel = kernel_cpu_sse3_path_trace_stream;
+		}
 		else
 #endif
 #ifdef WITH_CYCLES_OPTIMIZED_KERNEL_SSE2
-		if(system_cpu_support_sse2())
+		if(system_cpu_support_sse2()) {
 			path_trace_kernel = kernel_cpu_sse2_path_trace;
+			path_trace_stream_kernel = kernel_cpu_sse2_path_trace_stream;
+		}
 		else
 #endif
+		{
 			path_trace_kernel = kernel_cpu_path_trace;
+			path_trace_stream_kernel = kernel_cpu_path_trace_stream;
+		}
 		
+		/* number of samples between convergence tests */
+		const int adaptive_sampling_step = 4;
+		const KernelFilm& kfilm = kernel_globals.__data.film;
+		bool use_adaptive_sampling = (task.adaptive_threshold > 0.0f) &&
+		                             (kfilm.pass_flag & PASS_ADAPTIVE_AUX_BUFFER);
+		vector<int> row_x;
+
 		while(task.acquire_tile(this, tile)) {
 			float *render_buffer = (float*)tile.buffer;
 			uint *rng_state = (uint*)tile.rng_state;
@@ -226,7 +351,24 @@ public:
 				}
 
 				for(int y = tile.y; y < tile.y + tile.h; y++) {
+					if(task.use_ray_stream) {
+						/* trace all pixels of the row that need samples together */
+						row_x.clear();
+
+						for(int x = tile.x; x < tile.x + tile.w; x++)
+							if(!(use_adaptive_sampling && adaptive_pixel_converged(tile, x, y)))
+								row_x.push_back(x);
+
+						if(row_x.size())
+							path_trace_stream_kernel(&kg, render_buffer, rng_state, sample,
+							                         &row_x[0], row_x.size(), y, tile.offset, tile.stride);
+						continue;
+					}
+
 					for(int x = tile.x; x < tile.x + tile.w; x++) {
+						if(use_adaptive_sampling && adaptive_pixel_converged(tile, x, y))
+							continue;
+
 						path_trace_kernel(&kg, render_buffer, rng_state,
 						                  sample, x, y, tile.offset, tile.stride);
 					}
@@ -234,9 +376,22 @@ public:
 
 				tile.sample = sample + 1;
 
+				if(use_adaptive_sampling &&
+				   tile.sample >= task.adaptive_min_samples &&
+				   tile.sample % adaptive_sampling_step == 0)
+				{
+					tile.converged = adaptive_sampling_update(tile, task.adaptive_threshold);
+				}
+
 				task.update_progress(&tile);
+
+				if(tile.converged)
+					break;
 			}
 
+			if(kg.texture_cache)
+				texture_cache_update_stats();
+
 			task.release_tile(tile);
 
 			if(task_pool.canceled()) {
@@ -245,9 +400,15 @@ public:
 			}
 		}
 
+#ifdef __KERNEL_STATS__
+		if(kg.ray_stats)
+			stats.ray_stats_add(ray_stats);
+#endif
+
 #ifdef WITH_OSL
 		OSLShader::thread_free(&kg);
 #endif
+		kernel_texture_cache_thread_free(&kg);
 	}
 
 	void thread_film_convert(DeviceTask& task)
@@ -333,6 +494,7 @@ public:
 #ifdef WITH_OSL
 		OSLShader::thread_init(&kg, &kernel_globals, &osl_globals);
 #endif
+		kernel_texture_cache_thread_init(&kg, &texture_cache_globals);
 		void(*shader_kernel)(KernelGlobals*, uint4*, float4*, int, int, int, int);
 
 #ifdef WITH_CYCLES_OPTIMIZED_KERNEL_AVX2
@@ -377,6 +539,7 @@ public:
 #ifdef WITH_OSL
 		OSLShader::thread_free(&kg);
 #endif
+		kernel_texture_cache_thread_free(&kg);
 	}
 
 	int get_split_task_count(DeviceTask& task)
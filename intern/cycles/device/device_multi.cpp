@@ -449,6 +449,20 @@ void device_multi_info(vector<DeviceInfo>& devices)
 		device_multi_add(devices, DEVICE_OPENCL, false, false, "OPENCL_MULTI_%d", num++);
 	if(!device_multi_add(devices, DEVICE_OPENCL, true, true, "OPENCL_MULTI_%d", num++))
 		device_multi_add(devices, DEVICE_OPENCL, true, false, "OPENCL_MULTI_%d", num++);
+
+#ifdef WITH_NETWORK
+	/* render servers found on the network only */
+	DeviceInfo info;
+
+	info.type = DEVICE_MULTI;
+	info.description = "Network Render Servers";
+	info.id = "NETWORK_MULTI";
+	info.num = 0;
+	info.advanced_shading = true; /* todo: get this info from device */
+	info.pack_images = false;
+
+	devices.push_back(info);
+#endif
 }
 
 CCL_NAMESPACE_END
@@ -18,8 +18,12 @@
 #include "device_intern.h"
 #include "device_network.h"
 
+#include "util_compress.h"
 #include "util_foreach.h"
 #include "util_logging.h"
+#include "util_md5.h"
+#include "util_set.h"
+#include "util_task.h"
 
 #if defined(WITH_NETWORK)
 
@@ -41,6 +45,16 @@ static TileList::iterator tile_list_find(TileList& tile_list, RenderTile& tile)
 	return tile_list.end();
 }
 
+/* texture as last sent to the server, identified by name and content hash */
+struct NetworkTexture {
+	string name;
+	string hash;
+	size_t size;
+};
+
+/* textures smaller than this are sent again rather than hashed */
+#define NETWORK_TEXTURE_CACHE_MIN_SIZE (64*1024)
+
 class NetworkDevice : public Device
 {
 public:
@@ -48,18 +62,38 @@ public:
 	tcp::socket socket;
 	device_ptr mem_counter;
 	DeviceTask the_task; /* todo: handle multiple tasks */
+	thread *task_thread;
 
 	thread_mutex rpc_lock;
 
-	NetworkDevice(DeviceInfo& info, Stats &stats, const char *address)
-	: Device(info, stats, true), socket(io_service)
+	/* allocated textures, and freed textures the server still keeps around */
+	map<device_ptr, NetworkTexture> textures;
+	map<string, NetworkTexture> server_textures;
+
+	/* tile buffers that the server pushed along with the tile release */
+	thread_mutex pushed_mutex;
+	set<device_ptr> pushed_buffers;
+
+	NetworkStats network_stats;
+	string address;
+
+	NetworkDevice(DeviceInfo& info, Stats &stats, const char *address_)
+	: Device(info, stats, true), socket(io_service), task_thread(NULL), address(address_)
 	{
 		error_func = NetworkError();
-		stringstream portstr;
-		portstr << SERVER_PORT;
+
+		/* address with optional port */
+		string host = address;
+		string port = string_printf("%d", SERVER_PORT);
+		size_t colon = host.rfind(':');
+
+		if(colon != string::npos) {
+			port = host.substr(colon + 1);
+			host = host.substr(0, colon);
+		}
 
 		tcp::resolver resolver(io_service);
-		tcp::resolver::query query(address, portstr.str());
+		tcp::resolver::query query(host, port);
 		tcp::resolver::iterator endpoint_iterator = resolver.resolve(query);
 		tcp::resolver::iterator end;
 
@@ -73,13 +107,26 @@ public:
 		if(error)
 			error_func.network_error(error.message());
 
+		/* tiles and small calls are latency bound */
+		socket.set_option(tcp::no_delay(true), error);
+
 		mem_counter = 0;
 	}
 
 	~NetworkDevice()
 	{
-		RPCSend snd(socket, &error_func, "stop");
+		task_wait();
+
+		RPCSend snd(socket, &error_func, "stop", &network_stats);
 		snd.write();
+
+		VLOG(1) << "Network device " << address << ": " << network_stats.report();
+	}
+
+	void pushed_buffer_clear(device_ptr ptr)
+	{
+		thread_scoped_lock pushed_lock(pushed_mutex);
+		pushed_buffers.erase(ptr);
 	}
 
 	void mem_alloc(device_memory& mem, MemoryType type)
@@ -88,7 +135,7 @@ public:
 
 		mem.device_pointer = ++mem_counter;
 
-		RPCSend snd(socket, &error_func, "mem_alloc");
+		RPCSend snd(socket, &error_func, "mem_alloc", &network_stats);
 
 		snd.add(mem);
 		snd.add(type);
@@ -97,22 +144,35 @@ public:
 
 	void mem_copy_to(device_memory& mem)
 	{
+		pushed_buffer_clear(mem.device_pointer);
+
 		thread_scoped_lock lock(rpc_lock);
 
-		RPCSend snd(socket, &error_func, "mem_copy_to");
+		RPCSend snd(socket, &error_func, "mem_copy_to", &network_stats);
 
 		snd.add(mem);
+		snd.add_buffer((void*)mem.data_pointer, mem.memory_size());
 		snd.write();
-		snd.write_buffer((void*)mem.data_pointer, mem.memory_size());
 	}
 
 	void mem_copy_from(device_memory& mem, int y, int w, int h, int elem)
 	{
+		/* result already received with the tile release */
+		{
+			thread_scoped_lock pushed_lock(pushed_mutex);
+			set<device_ptr>::iterator it = pushed_buffers.find(mem.device_pointer);
+
+			if(it != pushed_buffers.end()) {
+				pushed_buffers.erase(it);
+				return;
+			}
+		}
+
 		thread_scoped_lock lock(rpc_lock);
 
 		size_t data_size = mem.memory_size();
 
-		RPCSend snd(socket, &error_func, "mem_copy_from");
+		RPCSend snd(socket, &error_func, "mem_copy_from", &network_stats);
 
 		snd.add(mem);
 		snd.add(y);
@@ -121,15 +181,17 @@ public:
 		snd.add(elem);
 		snd.write();
 
-		RPCReceive rcv(socket, &error_func);
+		RPCReceive rcv(socket, &error_func, &network_stats);
 		rcv.read_buffer((void*)mem.data_pointer, data_size);
 	}
 
 	void mem_zero(device_memory& mem)
 	{
+		pushed_buffer_clear(mem.device_pointer);
+
 		thread_scoped_lock lock(rpc_lock);
 
-		RPCSend snd(socket, &error_func, "mem_zero");
+		RPCSend snd(socket, &error_func, "mem_zero", &network_stats);
 
 		snd.add(mem);
 		snd.write();
@@ -138,9 +200,11 @@ public:
 	void mem_free(device_memory& mem)
 	{
 		if(mem.device_pointer) {
+			pushed_buffer_clear(mem.device_pointer);
+
 			thread_scoped_lock lock(rpc_lock);
 
-			RPCSend snd(socket, &error_func, "mem_free");
+			RPCSend snd(socket, &error_func, "mem_free", &network_stats);
 
 			snd.add(mem);
 			snd.write();
@@ -153,14 +217,33 @@ public:
 	{
 		thread_scoped_lock lock(rpc_lock);
 
-		RPCSend snd(socket, &error_func, "const_copy_to");
+		RPCSend snd(socket, &error_func, "const_copy_to", &network_stats);
 
 		string name_string(name);
 
 		snd.add(name_string);
 		snd.add(size);
+		snd.add_buffer(host, size);
 		snd.write();
-		snd.write_buffer(host, size);
+	}
+
+	string tex_hash(device_memory& mem)
+	{
+		size_t size = mem.memory_size();
+
+		if(size < NETWORK_TEXTURE_CACHE_MIN_SIZE)
+			return "";
+
+		MD5Hash md5;
+		const uint8_t *data = (const uint8_t*)mem.data_pointer;
+		const size_t chunk_size = 1 << 30;
+
+		for(size_t offset = 0; offset < size; offset += chunk_size) {
+			size_t chunk = (size - offset < chunk_size)? size - offset: chunk_size;
+			md5.append(data + offset, (int)chunk);
+		}
+
+		return md5.get_hex();
 	}
 
 	void tex_alloc(const char *name, device_memory& mem, InterpolationType interpolation, bool periodic)
@@ -171,16 +254,39 @@ public:
 
 		mem.device_pointer = ++mem_counter;
 
-		RPCSend snd(socket, &error_func, "tex_alloc");
+		NetworkTexture texture;
+		texture.name = name;
+		texture.hash = tex_hash(mem);
+		texture.size = mem.memory_size();
 
-		string name_string(name);
+		/* the server keeps freed textures, skip sending data it already has */
+		bool cached = false;
+		map<string, NetworkTexture>::iterator it = server_textures.find(texture.name);
 
-		snd.add(name_string);
+		if(it != server_textures.end()) {
+			cached = (!texture.hash.empty() &&
+			          it->second.hash == texture.hash &&
+			          it->second.size == texture.size);
+			server_textures.erase(it);
+		}
+
+		textures[mem.device_pointer] = texture;
+
+		RPCSend snd(socket, &error_func, (cached)? "tex_alloc_cached": "tex_alloc", &network_stats);
+
+		snd.add(texture.name);
 		snd.add(mem);
 		snd.add(interpolation);
 		snd.add(periodic);
+		snd.add(texture.hash);
+		if(!cached)
+			snd.add_buffer((void*)mem.data_pointer, texture.size);
 		snd.write();
-		snd.write_buffer((void*)mem.data_pointer, mem.memory_size());
+
+		if(cached) {
+			network_stats.num_textures_reused++;
+			network_stats.texture_bytes_reused += texture.size;
+		}
 	}
 
 	void tex_free(device_memory& mem)
@@ -188,7 +294,19 @@ public:
 		if(mem.device_pointer) {
 			thread_scoped_lock lock(rpc_lock);
 
-			RPCSend snd(socket, &error_func, "tex_free");
+			map<device_ptr, NetworkTexture>::iterator it = textures.find(mem.device_pointer);
+
+			if(it != textures.end()) {
+				/* server keeps hashed textures until allocated again */
+				if(it->second.hash.empty())
+					server_textures.erase(it->second.name);
+				else
+					server_textures[it->second.name] = it->second;
+
+				textures.erase(it);
+			}
+
+			RPCSend snd(socket, &error_func, "tex_free", &network_stats);
 
 			snd.add(mem);
 			snd.write();
@@ -204,7 +322,7 @@ public:
 
 		thread_scoped_lock lock(rpc_lock);
 
-		RPCSend snd(socket, &error_func, "load_kernels");
+		RPCSend snd(socket, &error_func, "load_kernels", &network_stats);
 		snd.add(requested_features.experimental);
 		snd.add(requested_features.max_closure);
 		snd.add(requested_features.max_nodes_group);
@@ -212,7 +330,7 @@ public:
 		snd.write();
 
 		bool result;
-		RPCReceive rcv(socket, &error_func);
+		RPCReceive rcv(socket, &error_func, &network_stats);
 		rcv.read(result);
 
 		return result;
@@ -220,27 +338,32 @@ public:
 
 	void task_add(DeviceTask& task)
 	{
+		/* one task at a time */
+		task_wait();
+
 		thread_scoped_lock lock(rpc_lock);
 
 		the_task = task;
 
-		RPCSend snd(socket, &error_func, "task_add");
+		RPCSend snd(socket, &error_func, "task_add", &network_stats);
 		snd.add(task);
 		snd.write();
+
+		/* start waiting right away and handle tile requests in a thread, so
+		 * that multiple network devices render at the same time */
+		RPCSend snd_wait(socket, &error_func, "task_wait", &network_stats);
+		snd_wait.write();
+
+		task_thread = new thread(function_bind(&NetworkDevice::task_run, this));
 	}
 
-	void task_wait()
+	void task_run()
 	{
 		thread_scoped_lock lock(rpc_lock);
-
-		RPCSend snd(socket, &error_func, "task_wait");
-		snd.write();
-
 		lock.unlock();
 
 		TileList the_tiles;
 
-		/* todo: run this threaded for connecting to multiple clients */
 		for(;;) {
 			if(error_func.have_error())
 				break;
@@ -248,30 +371,50 @@ public:
 			RenderTile tile;
 
 			lock.lock();
-			RPCReceive rcv(socket, &error_func);
+			RPCReceive rcv(socket, &error_func, &network_stats);
 
 			if(rcv.name == "acquire_tile") {
 				lock.unlock();
 
 				/* todo: watch out for recursive calls! */
 				if(the_task.acquire_tile(this, tile)) { /* write return as bool */
+					/* when the tile has its own buffers the result can be
+					 * pushed back with the release, instead of copied after */
+					bool push = (tile.buffers &&
+					             tile.buffers->params.width == tile.w &&
+					             tile.buffers->params.height == tile.h);
+
 					the_tiles.push_back(tile);
 
 					lock.lock();
-					RPCSend snd(socket, &error_func, "acquire_tile");
+					RPCSend snd(socket, &error_func, "acquire_tile", &network_stats);
 					snd.add(tile);
+					snd.add(push);
 					snd.write();
 					lock.unlock();
 				}
 				else {
 					lock.lock();
-					RPCSend snd(socket, &error_func, "acquire_tile_none");
+					RPCSend snd(socket, &error_func, "acquire_tile_none", &network_stats);
 					snd.write();
 					lock.unlock();
 				}
 			}
 			else if(rcv.name == "release_tile") {
+				bool pushed;
+				size_t compressed_size = 0;
+				DataVector compressed;
+
 				rcv.read(tile);
+				rcv.read(pushed);
+
+				if(pushed) {
+					rcv.read(compressed_size);
+					compressed.resize(compressed_size);
+					if(compressed_size)
+						rcv.read_buffer(&compressed[0], compressed_size);
+				}
+
 				lock.unlock();
 
 				TileList::iterator it = tile_list_find(the_tiles, tile);
@@ -282,12 +425,23 @@ public:
 
 				assert(tile.buffers != NULL);
 
-				the_task.release_tile(tile);
+				if(pushed && compressed_size) {
+					device_vector<float>& buffer = tile.buffers->buffer;
+					size_t size = buffer.memory_size();
 
-				lock.lock();
-				RPCSend snd(socket, &error_func, "release_tile");
-				snd.write();
-				lock.unlock();
+					if(util_decompress_buffer(&compressed[0], compressed_size, (void*)buffer.data_pointer, size)) {
+						thread_scoped_lock pushed_lock(pushed_mutex);
+						pushed_buffers.insert(buffer.device_pointer);
+
+						network_stats.num_tiles++;
+						network_stats.tile_bytes += size;
+						network_stats.tile_bytes_compressed += compressed_size;
+					}
+					else
+						error_func.network_error("Network receive error: invalid tile data");
+				}
+
+				the_task.release_tile(tile);
 			}
 			else if(rcv.name == "task_wait_done") {
 				lock.unlock();
@@ -298,10 +452,19 @@ public:
 		}
 	}
 
+	void task_wait()
+	{
+		if(task_thread) {
+			task_thread->join();
+			delete task_thread;
+			task_thread = NULL;
+		}
+	}
+
 	void task_cancel()
 	{
 		thread_scoped_lock lock(rpc_lock);
-		RPCSend snd(socket, &error_func, "task_cancel");
+		RPCSend snd(socket, &error_func, "task_cancel", &network_stats);
 		snd.write();
 	}
 
@@ -333,6 +496,12 @@ void device_network_info(vector<DeviceInfo>& devices)
 	devices.push_back(info);
 }
 
+/* texture kept by the server after it was freed, see NetworkDevice */
+struct ServerTexture {
+	string hash;
+	DataVector data;
+};
+
 class DeviceServer {
 public:
 	thread_mutex rpc_lock;
@@ -343,10 +512,13 @@ public:
 
 	bool have_error() { return error_func.have_error(); }
 
-	DeviceServer(Device *device_, tcp::socket& socket_)
-	: device(device_), socket(socket_), stop(false), blocked_waiting(false)
+	DeviceServer(Device *device_, tcp::socket& socket_, int tiles_in_flight_)
+	: device(device_), socket(socket_), tiles_in_flight(max(tiles_in_flight_, 1)),
+	  stop(false), blocked_waiting(false)
 	{
 		error_func = NetworkError();
+		tiles_requested = 0;
+		tiles_done = false;
 	}
 
 	void listen()
@@ -355,19 +527,26 @@ public:
 		for(;;) {
 			listen_step();
 
-			if(stop)
+			if(stop || have_error())
 				break;
 		}
 	}
 
+	NetworkStats stats;
+
 protected:
 	void listen_step()
 	{
 		thread_scoped_lock lock(rpc_lock);
-		RPCReceive rcv(socket, &error_func);
+		RPCReceive rcv(socket, &error_func, &stats);
 
-		if(rcv.name == "stop")
+		if(rcv.name == "stop") {
 			stop = true;
+			lock.unlock();
+
+			thread_scoped_lock tile_lock(tile_mutex);
+			tile_cond.notify_all();
+		}
 		else
 			process(rcv, lock);
 	}
@@ -375,6 +554,8 @@ protected:
 	/* create a memory buffer for a device buffer and insert it into mem_data */
 	DataVector &data_vector_insert(device_ptr client_pointer, size_t data_size)
 	{
+		thread_scoped_lock tile_lock(tile_mutex);
+
 		/* create a new DataVector and insert it into mem_data */
 		pair<DataMap::iterator,bool> data_ins = mem_data.insert(
 		        DataMap::value_type(client_pointer, DataVector()));
@@ -401,6 +582,7 @@ protected:
 	/* setup mapping and reverse mapping of client_pointer<->real_pointer */
 	void pointer_mapping_insert(device_ptr client_pointer, device_ptr real_pointer)
 	{
+		thread_scoped_lock tile_lock(tile_mutex);
 		pair<PtrMap::iterator,bool> mapins;
 
 		/* insert mapping from client pointer to our real device pointer */
@@ -421,6 +603,8 @@ protected:
 
 	device_ptr device_ptr_from_client_pointer_erase(device_ptr client_pointer)
 	{
+		thread_scoped_lock tile_lock(tile_mutex);
+
 		PtrMap::iterator i = ptr_map.find(client_pointer);
 		assert(i != ptr_map.end());
 
@@ -521,9 +705,11 @@ protected:
 
 			size_t data_size = mem.memory_size();
 
-			RPCSend snd(socket, &error_func, "mem_copy_from");
+			thread_scoped_lock send_lock(send_mutex);
+			RPCSend snd(socket, &error_func, "mem_copy_from", &stats);
+			snd.add_buffer((uint8_t*)mem.data_pointer, data_size);
 			snd.write();
-			snd.write_buffer((uint8_t*)mem.data_pointer, data_size);
+			send_lock.unlock();
 			lock.unlock();
 		}
 		else if(rcv.name == "mem_zero") {
@@ -567,9 +753,10 @@ protected:
 
 			device->const_copy_to(name_string.c_str(), &host_vector[0], size);
 		}
-		else if(rcv.name == "tex_alloc") {
+		else if(rcv.name == "tex_alloc" || rcv.name == "tex_alloc_cached") {
 			network_device_memory mem;
 			string name;
+			string hash;
 			InterpolationType interpolation;
 			bool periodic;
 			device_ptr client_pointer;
@@ -578,7 +765,7 @@ protected:
 			rcv.read(mem);
 			rcv.read(interpolation);
 			rcv.read(periodic);
-			lock.unlock();
+			rcv.read(hash);
 
 			client_pointer = mem.device_pointer;
 
@@ -586,12 +773,29 @@ protected:
 
 			DataVector &data_v = data_vector_insert(client_pointer, data_size);
 
+			/* take the data from the texture cache, or read it */
+			map<string, ServerTexture>::iterator it = texture_cache.find(name);
+
+			if(rcv.name == "tex_alloc_cached") {
+				if(it != texture_cache.end() && it->second.hash == hash && it->second.data.size() == data_size)
+					data_v.swap(it->second.data);
+				else
+					network_error("Texture cache mismatch for " + name);
+			}
+			else if(data_size)
+				rcv.read_buffer(&data_v[0], data_size);
+
+			if(it != texture_cache.end())
+				texture_cache.erase(it);
+
+			lock.unlock();
+
 			if(data_size)
 				mem.data_pointer = (device_ptr)&(data_v[0]);
 			else
 				mem.data_pointer = 0;
 
-			rcv.read_buffer((uint8_t*)mem.data_pointer, data_size);
+			tex_names[client_pointer] = make_pair(name, hash);
 
 			device->tex_alloc(name.c_str(), mem, interpolation, periodic);
 
@@ -606,6 +810,25 @@ protected:
 
 			client_pointer = mem.device_pointer;
 
+			/* keep the data around in case the client allocates it again */
+			map<device_ptr, pair<string, string> >::iterator it = tex_names.find(client_pointer);
+
+			if(it != tex_names.end()) {
+				const string& name = it->second.first;
+				const string& hash = it->second.second;
+
+				if(hash.empty()) {
+					texture_cache.erase(name);
+				}
+				else {
+					ServerTexture& texture = texture_cache[name];
+					texture.hash = hash;
+					texture.data.swap(data_vector_find(client_pointer));
+				}
+
+				tex_names.erase(it);
+			}
+
 			mem.device_pointer = device_ptr_from_client_pointer_erase(client_pointer);
 
 			device->tex_free(mem);
@@ -619,9 +842,12 @@ protected:
 
 			bool result;
 			result = device->load_kernels(requested_features);
-			RPCSend snd(socket, &error_func, "load_kernels");
+
+			thread_scoped_lock send_lock(send_mutex);
+			RPCSend snd(socket, &error_func, "load_kernels", &stats);
 			snd.add(result);
 			snd.write();
+			send_lock.unlock();
 			lock.unlock();
 		}
 		else if(rcv.name == "task_add") {
@@ -645,6 +871,14 @@ protected:
 			if(task.shader_output)
 				task.shader_output = device_ptr_from_client_pointer(task.shader_output);
 
+			/* reset tile pipeline */
+			{
+				thread_scoped_lock tile_lock(tile_mutex);
+				tile_queue.clear();
+				push_buffers.clear();
+				tiles_requested = 0;
+				tiles_done = false;
+			}
 
 			task.acquire_tile = function_bind(&DeviceServer::task_acquire_tile, this, _1, _2);
 			task.release_tile = function_bind(&DeviceServer::task_release_tile, this, _1);
@@ -657,37 +891,55 @@ protected:
 		else if(rcv.name == "task_wait") {
 			lock.unlock();
 
-			blocked_waiting = true;
+			/* render threads receive tile replies themselves from now on */
+			{
+				thread_scoped_lock tile_lock(tile_mutex);
+				blocked_waiting = true;
+				tile_cond.notify_all();
+			}
+
 			device->task_wait();
-			blocked_waiting = false;
 
-			lock.lock();
-			RPCSend snd(socket, &error_func, "task_wait_done");
+			{
+				thread_scoped_lock tile_lock(tile_mutex);
+				blocked_waiting = false;
+			}
+
+			thread_scoped_lock send_lock(send_mutex);
+			RPCSend snd(socket, &error_func, "task_wait_done", &stats);
 			snd.write();
-			lock.unlock();
 		}
 		else if(rcv.name == "task_cancel") {
 			lock.unlock();
 			device->task_cancel();
 		}
 		else if(rcv.name == "acquire_tile") {
-			AcquireEntry entry;
-			entry.name = rcv.name;
-			rcv.read(entry.tile);
-			acquire_queue.push_back(entry);
+			RenderTile tile;
+			bool push;
+
+			rcv.read(tile);
+			rcv.read(push);
 			lock.unlock();
+
+			thread_scoped_lock tile_lock(tile_mutex);
+
+			if(tile.buffer) tile.buffer = ptr_map[tile.buffer];
+			if(tile.rng_state) tile.rng_state = ptr_map[tile.rng_state];
+
+			if(push)
+				push_buffers.insert(tile.buffer);
+
+			tile_queue.push_back(tile);
+			tiles_requested--;
+			tile_cond.notify_all();
 		}
 		else if(rcv.name == "acquire_tile_none") {
-			AcquireEntry entry;
-			entry.name = rcv.name;
-			acquire_queue.push_back(entry);
-			lock.unlock();
-		}
-		else if(rcv.name == "release_tile") {
-			AcquireEntry entry;
-			entry.name = rcv.name;
-			acquire_queue.push_back(entry);
 			lock.unlock();
+
+			thread_scoped_lock tile_lock(tile_mutex);
+			tiles_done = true;
+			tiles_requested--;
+			tile_cond.notify_all();
 		}
 		else {
 			cout << "Error: unexpected RPC receive call \"" + rcv.name + "\"\n";
@@ -695,45 +947,51 @@ protected:
 		}
 	}
 
-	bool task_acquire_tile(Device *device, RenderTile& tile)
+	/* keep requesting tiles ahead, so the next ones are already on their way
+	 * while rendering. Must be called with tile_mutex locked */
+	void task_request_tiles()
 	{
-		thread_scoped_lock acquire_lock(acquire_mutex);
-
-		bool result = false;
+		while(!tiles_done && tile_queue.size() + tiles_requested < tiles_in_flight) {
+			thread_scoped_lock send_lock(send_mutex);
+			RPCSend snd(socket, &error_func, "acquire_tile", &stats);
+			snd.write();
 
-		RPCSend snd(socket, &error_func, "acquire_tile");
-		snd.write();
+			tiles_requested++;
+		}
+	}
 
-		do {
-			if(blocked_waiting)
-				listen_step();
+	bool task_acquire_tile(Device *device, RenderTile& tile)
+	{
+		thread_scoped_lock acquire_lock(acquire_mutex);
 
-			/* todo: avoid busy wait loop */
-			thread_scoped_lock lock(rpc_lock);
+		for(;;) {
+			thread_scoped_lock tile_lock(tile_mutex);
+			bool result = false;
 
-			if(!acquire_queue.empty()) {
-				AcquireEntry entry = acquire_queue.front();
-				acquire_queue.pop_front();
+			if(!tile_queue.empty()) {
+				tile = tile_queue.front();
+				tile_queue.pop_front();
+				result = true;
+			}
 
-				if(entry.name == "acquire_tile") {
-					tile = entry.tile;
+			if(!stop && !have_error())
+				task_request_tiles();
 
-					if(tile.buffer) tile.buffer = ptr_map[tile.buffer];
-					if(tile.rng_state) tile.rng_state = ptr_map[tile.rng_state];
+			if(result)
+				return true;
+			if(tiles_requested == 0 || stop || have_error())
+				return false;
 
-					result = true;
-					break;
-				}
-				else if(entry.name == "acquire_tile_none") {
-					break;
-				}
-				else {
-					cout << "Error: unexpected acquire RPC receive call \"" + entry.name + "\"\n";
-				}
+			if(!blocked_waiting) {
+				/* replies are received by the main thread */
+				tile_cond.wait(tile_lock);
+				continue;
 			}
-		} while(acquire_queue.empty() && !stop && !have_error());
 
-		return result;
+			/* main thread is waiting for the task, receive replies here */
+			tile_lock.unlock();
+			listen_step();
+		}
 	}
 
 	void task_update_progress_sample()
@@ -748,39 +1006,66 @@ protected:
 
 	void task_release_tile(RenderTile& tile)
 	{
-		thread_scoped_lock acquire_lock(acquire_mutex);
-
-		if(tile.buffer) tile.buffer = ptr_imap[tile.buffer];
-		if(tile.rng_state) tile.rng_state = ptr_imap[tile.rng_state];
+		device_ptr buffer = tile.buffer;
+		uint8_t *data = NULL;
+		size_t data_size = 0;
+		bool push = false;
 
 		{
-			thread_scoped_lock lock(rpc_lock);
-			RPCSend snd(socket, &error_func, "release_tile");
-			snd.add(tile);
-			snd.write();
-			lock.unlock();
-		}
+			thread_scoped_lock tile_lock(tile_mutex);
 
-		do {
-			if(blocked_waiting)
-				listen_step();
+			if(tile.buffer) tile.buffer = ptr_imap[tile.buffer];
+			if(tile.rng_state) tile.rng_state = ptr_imap[tile.rng_state];
 
-			/* todo: avoid busy wait loop */
-			thread_scoped_lock lock(rpc_lock);
+			set<device_ptr>::iterator it = push_buffers.find(buffer);
 
-			if(!acquire_queue.empty()) {
-				AcquireEntry entry = acquire_queue.front();
-				acquire_queue.pop_front();
+			if(it != push_buffers.end()) {
+				DataVector &data_v = data_vector_find(tile.buffer);
 
-				if(entry.name == "release_tile") {
-					lock.unlock();
-					break;
-				}
-				else {
-					cout << "Error: unexpected release RPC receive call \"" + entry.name + "\"\n";
-				}
+				data = &data_v[0];
+				data_size = data_v.size();
+				push = (data_size != 0);
+
+				push_buffers.erase(it);
 			}
-		} while(acquire_queue.empty() && !stop);
+		}
+
+		/* push the result with the release, compressed */
+		DataVector compressed;
+
+		if(push) {
+			network_device_memory mem;
+			mem.data_type = TYPE_UCHAR;
+			mem.data_elements = 1;
+			mem.data_width = data_size;
+			mem.data_height = 0;
+			mem.data_depth = 0;
+			mem.data_size = data_size;
+			mem.device_size = data_size;
+			mem.data_pointer = (device_ptr)data;
+			mem.device_pointer = buffer;
+
+			device->mem_copy_from(mem, 0, data_size, 1, 1);
+			util_compress_buffer(data, data_size, compressed);
+		}
+
+		thread_scoped_lock send_lock(send_mutex);
+
+		RPCSend snd(socket, &error_func, "release_tile", &stats);
+		snd.add(tile);
+		snd.add(push);
+
+		if(push) {
+			size_t compressed_size = compressed.size();
+			snd.add(compressed_size);
+			snd.add_buffer(&compressed[0], compressed_size);
+
+			stats.num_tiles++;
+			stats.tile_bytes += data_size;
+			stats.tile_bytes_compressed += compressed_size;
+		}
+
+		snd.write();
 	}
 
 	bool task_get_cancel()
@@ -797,13 +1082,23 @@ protected:
 	PtrMap ptr_imap;
 	DataMap mem_data;
 
-	struct AcquireEntry {
-		string name;
-		RenderTile tile;
-	};
+	/* texture names and hashes, and freed textures by name */
+	map<device_ptr, pair<string, string> > tex_names;
+	map<string, ServerTexture> texture_cache;
 
+	/* serializes sending, replies from render threads and the main thread */
+	thread_mutex send_mutex;
+
+	/* tiles received ahead of rendering. The mutex also guards changes to
+	 * the pointer maps, since render threads access them */
 	thread_mutex acquire_mutex;
-	list<AcquireEntry> acquire_queue;
+	thread_mutex tile_mutex;
+	thread_condition_variable tile_cond;
+	list<RenderTile> tile_queue;
+	set<device_ptr> push_buffers;
+	size_t tiles_in_flight;
+	size_t tiles_requested;
+	bool tiles_done;
 
 	bool stop;
 	bool blocked_waiting;
@@ -814,27 +1109,32 @@ private:
 
 };
 
-void Device::server_run()
+void Device::server_run(int port, int tiles_in_flight)
 {
+	/* enough tiles in flight to keep all threads busy */
+	if(tiles_in_flight <= 0)
+		tiles_in_flight = (info.type == DEVICE_CPU)? TaskScheduler::num_threads() + 1: 2;
+
 	try {
 		/* starts thread that responds to discovery requests */
-		ServerDiscovery discovery;
+		ServerDiscovery discovery(false, port);
 
 		for(;;) {
 			/* accept connection */
 			boost::asio::io_service io_service;
-			tcp::acceptor acceptor(io_service, tcp::endpoint(tcp::v4(), SERVER_PORT));
+			tcp::acceptor acceptor(io_service, tcp::endpoint(tcp::v4(), port));
 
 			tcp::socket socket(io_service);
 			acceptor.accept(socket);
+			socket.set_option(tcp::no_delay(true));
 
 			string remote_address = socket.remote_endpoint().address().to_string();
 			printf("Connected to remote client at: %s\n", remote_address.c_str());
 
-			DeviceServer server(this, socket);
+			DeviceServer server(this, socket, tiles_in_flight);
 			server.listen();
 
-			printf("Disconnected.\n");
+			printf("Disconnected, %s\n", server.stats.report().c_str());
 		}
 	}
 	catch(exception& e) {
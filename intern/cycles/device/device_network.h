@@ -39,6 +39,7 @@
 #include "util_list.h"
 #include "util_map.h"
 #include "util_string.h"
+#include "util_time.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -98,13 +99,57 @@ private:
 	int error_count;
 };
 
+/* Statistics of a connection, for measuring network throughput */
+class NetworkStats {
+public:
+	NetworkStats()
+	{
+		start_time = time_dt();
+		bytes_sent = 0;
+		bytes_received = 0;
+		num_sent = 0;
+		num_received = 0;
+		num_tiles = 0;
+		tile_bytes = 0;
+		tile_bytes_compressed = 0;
+		num_textures_reused = 0;
+		texture_bytes_reused = 0;
+	}
+
+	string report()
+	{
+		double time = time_dt() - start_time;
+		double mb = 1024.0*1024.0;
+
+		return string_printf(
+			"sent %.2f MB in %d calls, received %.2f MB in %d calls, %.2f MB/s total over %.2f sec\n"
+			"tiles %d, %.2f MB compressed to %.2f MB\n"
+			"textures reused %d, %.2f MB not sent",
+			bytes_sent/mb, num_sent, bytes_received/mb, num_received,
+			(time > 0.0)? (bytes_sent + bytes_received)/mb/time: 0.0, time,
+			num_tiles, tile_bytes/mb, tile_bytes_compressed/mb,
+			num_textures_reused, texture_bytes_reused/mb);
+	}
+
+	double start_time;
+	size_t bytes_sent;
+	size_t bytes_received;
+	int num_sent;
+	int num_received;
+	int num_tiles;
+	size_t tile_bytes;
+	size_t tile_bytes_compressed;
+	int num_textures_reused;
+	size_t texture_bytes_reused;
+};
+
 
 /* Remote procedure call Send */
 
 class RPCSend {
 public:
-	RPCSend(tcp::socket& socket_, NetworkError* e, const string& name_ = "")
-	: name(name_), socket(socket_), archive(archive_stream), sent(false)
+	RPCSend(tcp::socket& socket_, NetworkError* e, const string& name_ = "", NetworkStats *stats_ = NULL)
+	: name(name_), socket(socket_), archive(archive_stream), sent(false), stats(stats_)
 	{
 		archive & name_;
 		error_func = e;
@@ -143,6 +188,13 @@ public:
 		archive & tile.start_sample & tile.num_samples & tile.sample;
 		archive & tile.resolution & tile.offset & tile.stride;
 		archive & tile.buffer & tile.rng_state;
+		archive & tile.tile_index & tile.converged;
+	}
+
+	/* raw data sent after the archive, the buffer must stay valid until write */
+	void add_buffer(const void *buffer, size_t size)
+	{
+		buffers.push_back(boost::asio::buffer(buffer, size));
 	}
 
 	void write()
@@ -152,39 +204,26 @@ public:
 		/* get string from stream */
 		string archive_str = archive_stream.str();
 
-		/* first send fixed size header with size of following data */
+		/* fixed size header with size of following data */
 		ostringstream header_stream;
 		header_stream << setw(8) << hex << archive_str.size();
 		string header_str = header_stream.str();
 
-		boost::asio::write(socket,
-			boost::asio::buffer(header_str),
-			boost::asio::transfer_all(), error);
+		/* send header, archive and buffers at once */
+		buffers.insert(buffers.begin(), boost::asio::buffer(archive_str));
+		buffers.insert(buffers.begin(), boost::asio::buffer(header_str));
 
-		if(error.value())
-			error_func->network_error(error.message());
+		size_t len = boost::asio::write(socket, buffers, boost::asio::transfer_all(), error);
 
-		/* then send actual data */
-		boost::asio::write(socket,
-			boost::asio::buffer(archive_str),
-			boost::asio::transfer_all(), error);
-		
 		if(error.value())
 			error_func->network_error(error.message());
 
-		sent = true;
-	}
-
-	void write_buffer(void *buffer, size_t size)
-	{
-		boost::system::error_code error;
+		if(stats) {
+			stats->bytes_sent += len;
+			stats->num_sent++;
+		}
 
-		boost::asio::write(socket,
-			boost::asio::buffer(buffer, size),
-			boost::asio::transfer_all(), error);
-		
-		if(error.value())
-			error_func->network_error(error.message());
+		sent = true;
 	}
 
 protected:
@@ -192,16 +231,18 @@ protected:
 	tcp::socket& socket;
 	ostringstream archive_stream;
 	o_archive archive;
+	vector<boost::asio::const_buffer> buffers;
 	bool sent;
 	NetworkError *error_func;
+	NetworkStats *stats;
 };
 
 /* Remote procedure call Receive */
 
 class RPCReceive {
 public:
-	RPCReceive(tcp::socket& socket_, NetworkError* e )
-	: socket(socket_), archive_stream(NULL), archive(NULL)
+	RPCReceive(tcp::socket& socket_, NetworkError* e, NetworkStats *stats_ = NULL)
+	: socket(socket_), archive_stream(NULL), archive(NULL), stats(stats_)
 	{
 		error_func = e;
 		/* read head with fixed size */
@@ -238,6 +279,11 @@ public:
 
 					*archive & name;
 					fprintf(stderr, "rpc receive %s\n", name.c_str());
+
+					if(stats) {
+						stats->bytes_received += header.size() + data_size;
+						stats->num_received++;
+					}
 				}
 				else {
 					error_func->network_error("Network receive error: data size doesn't match header");
@@ -282,6 +328,9 @@ public:
 
 		if(len != size)
 			cout << "Network receive error: buffer size doesn't match expected size\n";
+
+		if(stats)
+			stats->bytes_received += len;
 	}
 
 	void read(DeviceTask& task)
@@ -304,6 +353,7 @@ public:
 		*archive & tile.start_sample & tile.num_samples & tile.sample;
 		*archive & tile.resolution & tile.offset & tile.stride;
 		*archive & tile.buffer & tile.rng_state;
+		*archive & tile.tile_index & tile.converged;
 
 		tile.buffers = NULL;
 	}
@@ -316,14 +366,15 @@ protected:
 	istringstream *archive_stream;
 	i_archive *archive;
 	NetworkError *error_func;
+	NetworkStats *stats;
 };
 
 /* Server auto discovery */
 
 class ServerDiscovery {
 public:
-	ServerDiscovery(bool discover = false)
-	: listen_socket(io_service), collect_servers(false)
+	ServerDiscovery(bool discover = false, int server_port_ = SERVER_PORT)
+	: listen_socket(io_service), collect_servers(false), server_port(server_port_)
 	{
 		/* setup listen socket */
 		listen_endpoint.address(boost::asio::ip::address_v4::any());
@@ -384,8 +435,16 @@ private:
 
 			/* handle incoming message */
 			if(collect_servers) {
-				if(msg == DISCOVER_REPLY_MSG) {
+				if(msg.compare(0, DISCOVER_REPLY_MSG.size(), DISCOVER_REPLY_MSG) == 0) {
+					/* reply includes the port, to support multiple servers
+					 * on the same host */
 					string address = receive_endpoint.address().to_string();
+					string port = msg.substr(DISCOVER_REPLY_MSG.size());
+
+					if(port.empty())
+						address += string_printf(":%d", SERVER_PORT);
+					else
+						address += port;
 
 					mutex.lock();
 
@@ -402,7 +461,7 @@ private:
 			else {
 				/* reply to request */
 				if(msg == DISCOVER_REQUEST_MSG)
-					broadcast_message(DISCOVER_REPLY_MSG);
+					broadcast_message(DISCOVER_REPLY_MSG + string_printf(":%d", server_port));
 			}
 		}
 
@@ -459,9 +518,12 @@ private:
 		string host_addr;
 	};
 
-	/* collection of server addresses in list */
+	/* collection of server addresses in list, as address:port */
 	bool collect_servers;
 	vector<string> servers;
+
+	/* port of the server we're replying for */
+	int server_port;
 };
 
 CCL_NAMESPACE_END
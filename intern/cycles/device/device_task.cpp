@@ -30,7 +30,9 @@ DeviceTask::DeviceTask(Type type_)
 : type(type_), x(0), y(0), w(0), h(0), rgba_byte(0), rgba_half(0), buffer(0),
   sample(0), num_samples(1),
   shader_input(0), shader_output(0),
-  shader_eval_type(0), shader_x(0), shader_w(0)
+  shader_eval_type(0), shader_x(0), shader_w(0),
+  adaptive_threshold(0.0f), adaptive_min_samples(0),
+  use_ray_stream(false), use_ray_stats(false)
 {
 	last_update_time = time_dt();
 }
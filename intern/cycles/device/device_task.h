@@ -66,6 +66,16 @@ public:
 	bool need_finish_queue;
 	bool integrator_branched;
 	int2 requested_tile_size;
+
+	/* adaptive sampling, disabled when the threshold is zero */
+	float adaptive_threshold;
+	int adaptive_min_samples;
+
+	/* trace camera rays in batches and shade them sorted by shader (CPU only) */
+	bool use_ray_stream;
+
+	/* collect ray and shading statistics, in debug builds (CPU only) */
+	bool use_ray_stats;
 protected:
 	double last_update_time;
 };
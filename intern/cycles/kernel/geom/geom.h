@@ -24,6 +24,7 @@
 #define BVH_NODE_SIZE 4
 #define BVH_NODE_LEAF_SIZE 1
 #define BVH_QNODE_SIZE 7
+#define BVH_QNODE_COMPRESSED_SIZE 4
 #define BVH_QNODE_LEAF_SIZE 1
 #define TRI_NODE_SIZE 3
 
@@ -213,6 +213,46 @@ ccl_device_inline void curvebounds(float *lower, float *upper, float *extremta,
 	}
 }
 
+/* Test against the box oriented along the curve segment, packed by the BVH
+ * in place of the triangle vertices. Minimum width makes curves up to extmax
+ * wider, so the box grows by that much to keep the same hits. */
+
+ccl_device_inline bool curve_oriented_bounds_slab(float o, float d, float h, float *tnear, float *tfar)
+{
+	if(fabsf(d) < 1e-20f) {
+		/* parallel to the slab */
+		return fabsf(o) <= h;
+	}
+
+	float t0 = (-h - o)/d;
+	float t1 = (h - o)/d;
+
+	*tnear = max(*tnear, min(t0, t1));
+	*tfar = min(*tfar, max(t0, t1));
+
+	return *tnear <= *tfar;
+}
+
+ccl_device_inline bool curve_oriented_bounds_intersect(KernelGlobals *kg, float3 P, float3 dir,
+	int curveAddr, float tmax, float difl, float extmax)
+{
+	const float4 obb_x = kernel_tex_fetch(__tri_woop, curveAddr*TRI_NODE_SIZE+0);
+	const float4 obb_z = kernel_tex_fetch(__tri_woop, curveAddr*TRI_NODE_SIZE+1);
+	const float4 obb_size = kernel_tex_fetch(__tri_woop, curveAddr*TRI_NODE_SIZE+2);
+
+	const float3 X = float4_to_float3(obb_x);
+	const float3 Z = float4_to_float3(obb_z);
+	const float3 Y = cross(Z, X);
+	const float3 D = P - make_float3(obb_x.w, obb_z.w, obb_size.w);
+	const float margin = (difl != 0.0f)? extmax: 0.0f;
+
+	float tnear = 0.0f, tfar = tmax;
+
+	return curve_oriented_bounds_slab(dot(Z, D), dot(Z, dir), obb_size.z + margin, &tnear, &tfar) &&
+	       curve_oriented_bounds_slab(dot(X, D), dot(X, dir), obb_size.x + margin, &tnear, &tfar) &&
+	       curve_oriented_bounds_slab(dot(Y, D), dot(Y, dir), obb_size.y + margin, &tnear, &tfar);
+}
+
 #ifdef __KERNEL_SSE2__
 ccl_device_inline ssef transform_point_T3(const ssef t[3], const ssef &a)
 {
@@ -229,6 +269,9 @@ ccl_device_inline bool bvh_cardinal_curve_intersect(KernelGlobals *kg, Intersect
 	float3 P, float3 dir, uint visibility, int object, int curveAddr, float time,int type, uint *lcg_state, float difl, float extmax)
 #endif
 {
+	if(!curve_oriented_bounds_intersect(kg, P, dir, curveAddr, isect->t, difl, extmax))
+		return false;
+
 	int segment = PRIMITIVE_UNPACK_SEGMENT(type);
 	float epsilon = 0.0f;
 	float r_st, r_en;
@@ -631,6 +674,9 @@ ccl_device_inline bool bvh_curve_intersect(KernelGlobals *kg, Intersection *isec
 #define dot3(x, y) dot(x, y)
 #endif
 
+	if(!curve_oriented_bounds_intersect(kg, P, direction, curveAddr, isect->t, difl, extmax))
+		return false;
+
 	int segment = PRIMITIVE_UNPACK_SEGMENT(type);
 	/* curve Intersection check */
 	int flags = kernel_data.curve.curveflags;
@@ -51,6 +51,75 @@ ccl_device_inline void qbvh_stack_sort(QBVHStackItem *__restrict s1,
 	if(s3->dist < s2->dist) { qbvh_item_swap(s3, s2); }
 }
 
+/* Compressed QBVH nodes store the child bounds quantized to 8 bits on a grid
+ * over the bounds of the node, in one cache line:
+ *
+ * 0: grid origin, child min x
+ * 1: grid cell size, child max x
+ * 2: child min y, max y, min z, max z
+ * 3: child node indices
+ *
+ * Each child plane is a uint with one byte per child. Quantization rounds
+ * outwards so the decoded bounds always contain the child. */
+
+ccl_device_inline ssef qbvh_dequantize(uint quantized, float origin, float scale)
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i q = _mm_cvtsi32_si128((int)quantized);
+	q = _mm_unpacklo_epi16(_mm_unpacklo_epi8(q, zero), zero);
+
+	return madd(ssef(q), ssef(scale), ssef(origin));
+}
+
+/* Child bounds of a node on the near and far side of the ray */
+ccl_device_inline void qbvh_node_bounds(KernelGlobals *__restrict kg,
+                                        const int near_x,
+                                        const int near_y,
+                                        const int near_z,
+                                        const int far_x,
+                                        const int far_y,
+                                        const int far_z,
+                                        const int nodeAddr,
+                                        sse3f *__restrict bnear,
+                                        sse3f *__restrict bfar)
+{
+	if(kernel_data.bvh.use_qbvh_compressed) {
+		const int offset = nodeAddr*BVH_QNODE_COMPRESSED_SIZE;
+		const float4 node0 = kernel_tex_fetch(__bvh_nodes, offset+0);
+		const float4 node1 = kernel_tex_fetch(__bvh_nodes, offset+1);
+		const float4 node2 = kernel_tex_fetch(__bvh_nodes, offset+2);
+		const uint planes[6] = {__float_as_uint(node0.w), __float_as_uint(node1.w),
+		                        __float_as_uint(node2.x), __float_as_uint(node2.y),
+		                        __float_as_uint(node2.z), __float_as_uint(node2.w)};
+
+		bnear->x = qbvh_dequantize(planes[near_x], node0.x, node1.x);
+		bnear->y = qbvh_dequantize(planes[near_y], node0.y, node1.y);
+		bnear->z = qbvh_dequantize(planes[near_z], node0.z, node1.z);
+		bfar->x = qbvh_dequantize(planes[far_x], node0.x, node1.x);
+		bfar->y = qbvh_dequantize(planes[far_y], node0.y, node1.y);
+		bfar->z = qbvh_dequantize(planes[far_z], node0.z, node1.z);
+	}
+	else {
+		const int offset = nodeAddr*BVH_QNODE_SIZE;
+
+		bnear->x = kernel_tex_fetch_ssef(__bvh_nodes, offset+near_x);
+		bnear->y = kernel_tex_fetch_ssef(__bvh_nodes, offset+near_y);
+		bnear->z = kernel_tex_fetch_ssef(__bvh_nodes, offset+near_z);
+		bfar->x = kernel_tex_fetch_ssef(__bvh_nodes, offset+far_x);
+		bfar->y = kernel_tex_fetch_ssef(__bvh_nodes, offset+far_y);
+		bfar->z = kernel_tex_fetch_ssef(__bvh_nodes, offset+far_z);
+	}
+}
+
+/* Child node indices of a node */
+ccl_device_inline float4 qbvh_node_children(KernelGlobals *__restrict kg, const int nodeAddr)
+{
+	if(kernel_data.bvh.use_qbvh_compressed)
+		return kernel_tex_fetch(__bvh_nodes, nodeAddr*BVH_QNODE_COMPRESSED_SIZE+3);
+	else
+		return kernel_tex_fetch(__bvh_nodes, nodeAddr*BVH_QNODE_SIZE+6);
+}
+
 ccl_device_inline int qbvh_node_intersect(KernelGlobals *__restrict kg,
                                           const ssef& tnear,
                                           const ssef& tfar,
@@ -69,21 +138,22 @@ ccl_device_inline int qbvh_node_intersect(KernelGlobals *__restrict kg,
                                           const int nodeAddr,
                                           ssef *__restrict dist)
 {
-	const int offset = nodeAddr*BVH_QNODE_SIZE;
+	sse3f bnear, bfar;
+	qbvh_node_bounds(kg, near_x, near_y, near_z, far_x, far_y, far_z, nodeAddr, &bnear, &bfar);
 #ifdef __KERNEL_AVX2__
-	const ssef tnear_x = msub(kernel_tex_fetch_ssef(__bvh_nodes, offset+near_x), idir.x, org_idir.x);
-	const ssef tnear_y = msub(kernel_tex_fetch_ssef(__bvh_nodes, offset+near_y), idir.y, org_idir.y);
-	const ssef tnear_z = msub(kernel_tex_fetch_ssef(__bvh_nodes, offset+near_z), idir.z, org_idir.z);
-	const ssef tfar_x = msub(kernel_tex_fetch_ssef(__bvh_nodes, offset+far_x), idir.x, org_idir.x);
-	const ssef tfar_y = msub(kernel_tex_fetch_ssef(__bvh_nodes, offset+far_y), idir.y, org_idir.y);
-	const ssef tfar_z = msub(kernel_tex_fetch_ssef(__bvh_nodes, offset+far_z), idir.z, org_idir.z);
+	const ssef tnear_x = msub(bnear.x, idir.x, org_idir.x);
+	const ssef tnear_y = msub(bnear.y, idir.y, org_idir.y);
+	const ssef tnear_z = msub(bnear.z, idir.z, org_idir.z);
+	const ssef tfar_x = msub(bfar.x, idir.x, org_idir.x);
+	const ssef tfar_y = msub(bfar.y, idir.y, org_idir.y);
+	const ssef tfar_z = msub(bfar.z, idir.z, org_idir.z);
 #else
-	const ssef tnear_x = (kernel_tex_fetch_ssef(__bvh_nodes, offset+near_x) - org.x) * idir.x;
-	const ssef tnear_y = (kernel_tex_fetch_ssef(__bvh_nodes, offset+near_y) - org.y) * idir.y;
-	const ssef tnear_z = (kernel_tex_fetch_ssef(__bvh_nodes, offset+near_z) - org.z) * idir.z;
-	const ssef tfar_x = (kernel_tex_fetch_ssef(__bvh_nodes, offset+far_x) - org.x) * idir.x;
-	const ssef tfar_y = (kernel_tex_fetch_ssef(__bvh_nodes, offset+far_y) - org.y) * idir.y;
-	const ssef tfar_z = (kernel_tex_fetch_ssef(__bvh_nodes, offset+far_z) - org.z) * idir.z;
+	const ssef tnear_x = (bnear.x - org.x) * idir.x;
+	const ssef tnear_y = (bnear.y - org.y) * idir.y;
+	const ssef tnear_z = (bnear.z - org.z) * idir.z;
+	const ssef tfar_x = (bfar.x - org.x) * idir.x;
+	const ssef tfar_y = (bfar.y - org.y) * idir.y;
+	const ssef tfar_z = (bfar.z - org.z) * idir.z;
 #endif
 
 #ifdef __KERNEL_SSE41__
@@ -120,21 +190,22 @@ ccl_device_inline int qbvh_node_intersect_robust(KernelGlobals *__restrict kg,
                                                  const float difl,
                                                  ssef *__restrict dist)
 {
-	const int offset = nodeAddr*BVH_QNODE_SIZE;
+	sse3f bnear, bfar;
+	qbvh_node_bounds(kg, near_x, near_y, near_z, far_x, far_y, far_z, nodeAddr, &bnear, &bfar);
 #ifdef __KERNEL_AVX2__
-	const ssef tnear_x = msub(kernel_tex_fetch_ssef(__bvh_nodes, offset+near_x), idir.x, P_idir.x);
-	const ssef tnear_y = msub(kernel_tex_fetch_ssef(__bvh_nodes, offset+near_y), idir.y, P_idir.y);
-	const ssef tnear_z = msub(kernel_tex_fetch_ssef(__bvh_nodes, offset+near_z), idir.z, P_idir.z);
-	const ssef tfar_x = msub(kernel_tex_fetch_ssef(__bvh_nodes, offset+far_x), idir.x, P_idir.x);
-	const ssef tfar_y = msub(kernel_tex_fetch_ssef(__bvh_nodes, offset+far_y), idir.y, P_idir.y);
-	const ssef tfar_z = msub(kernel_tex_fetch_ssef(__bvh_nodes, offset+far_z), idir.z, P_idir.z);
+	const ssef tnear_x = msub(bnear.x, idir.x, P_idir.x);
+	const ssef tnear_y = msub(bnear.y, idir.y, P_idir.y);
+	const ssef tnear_z = msub(bnear.z, idir.z, P_idir.z);
+	const ssef tfar_x = msub(bfar.x, idir.x, P_idir.x);
+	const ssef tfar_y = msub(bfar.y, idir.y, P_idir.y);
+	const ssef tfar_z = msub(bfar.z, idir.z, P_idir.z);
 #else
-	const ssef tnear_x = (kernel_tex_fetch_ssef(__bvh_nodes, offset+near_x) - P.x) * idir.x;
-	const ssef tnear_y = (kernel_tex_fetch_ssef(__bvh_nodes, offset+near_y) - P.y) * idir.y;
-	const ssef tnear_z = (kernel_tex_fetch_ssef(__bvh_nodes, offset+near_z) - P.z) * idir.z;
-	const ssef tfar_x = (kernel_tex_fetch_ssef(__bvh_nodes, offset+far_x) - P.x) * idir.x;
-	const ssef tfar_y = (kernel_tex_fetch_ssef(__bvh_nodes, offset+far_y) - P.y) * idir.y;
-	const ssef tfar_z = (kernel_tex_fetch_ssef(__bvh_nodes, offset+far_z) - P.z) * idir.z;
+	const ssef tnear_x = (bnear.x - P.x) * idir.x;
+	const ssef tnear_y = (bnear.y - P.y) * idir.y;
+	const ssef tnear_z = (bnear.z - P.z) * idir.z;
+	const ssef tfar_x = (bfar.x - P.x) * idir.x;
+	const ssef tfar_y = (bfar.y - P.y) * idir.y;
+	const ssef tfar_z = (bfar.z - P.z) * idir.z;
 #endif
 
 	const float round_down = 1.0f - difl;
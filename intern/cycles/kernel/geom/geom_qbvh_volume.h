@@ -115,7 +115,7 @@ ccl_device bool BVH_FUNCTION_FULL_NAME(QBVH)(KernelGlobals *kg,
 				                                        &dist);
 
 				if(traverseChild != 0) {
-					float4 cnodes = kernel_tex_fetch(__bvh_nodes, nodeAddr*BVH_QNODE_SIZE+6);
+					float4 cnodes = qbvh_node_children(kg, nodeAddr);
 
 					/* One child is hit, continue with that child. */
 					int r = __bscf(traverseChild);
@@ -33,9 +33,12 @@ bool kernel_osl_use(KernelGlobals *kg);
 
 void kernel_const_copy(KernelGlobals *kg, const char *name, void *host, size_t size);
 void kernel_tex_copy(KernelGlobals *kg, const char *name, device_ptr mem, size_t width, size_t height, size_t depth, InterpolationType interpolation=INTERPOLATION_LINEAR);
+void kernel_tex_free(KernelGlobals *kg);
 
 void kernel_cpu_path_trace(KernelGlobals *kg, float *buffer, unsigned int *rng_state,
 	int sample, int x, int y, int offset, int stride);
+void kernel_cpu_path_trace_stream(KernelGlobals *kg, float *buffer, unsigned int *rng_state,
+	int sample, const int *x, int num, int y, int offset, int stride);
 void kernel_cpu_convert_to_byte(KernelGlobals *kg, uchar4 *rgba, float *buffer,
 	float sample_scale, int x, int y, int offset, int stride);
 void kernel_cpu_convert_to_half_float(KernelGlobals *kg, uchar4 *rgba, float *buffer,
@@ -46,6 +49,8 @@ void kernel_cpu_shader(KernelGlobals *kg, uint4 *input, float4 *output,
 #ifdef WITH_CYCLES_OPTIMIZED_KERNEL_SSE2
 void kernel_cpu_sse2_path_trace(KernelGlobals *kg, float *buffer, unsigned int *rng_state,
 	int sample, int x, int y, int offset, int stride);
+void kernel_cpu_sse2_path_trace_stream(KernelGlobals *kg, float *buffer, unsigned int *rng_state,
+	int sample, const int *x, int num, int y, int offset, int stride);
 void kernel_cpu_sse2_convert_to_byte(KernelGlobals *kg, uchar4 *rgba, float *buffer,
 	float sample_scale, int x, int y, int offset, int stride);
 void kernel_cpu_sse2_convert_to_half_float(KernelGlobals *kg, uchar4 *rgba, float *buffer,
@@ -57,6 +62,8 @@ void kernel_cpu_sse2_shader(KernelGlobals *kg, uint4 *input, float4 *output,
 #ifdef WITH_CYCLES_OPTIMIZED_KERNEL_SSE3
 void kernel_cpu_sse3_path_trace(KernelGlobals *kg, float *buffer, unsigned int *rng_state,
 	int sample, int x, int y, int offset, int stride);
+void kernel_cpu_sse3_path_trace_stream(KernelGlobals *kg, float *buffer, unsigned int *rng_state,
+	int sample, const int *x, int num, int y, int offset, int stride);
 void kernel_cpu_sse3_convert_to_byte(KernelGlobals *kg, uchar4 *rgba, float *buffer,
 	float sample_scale, int x, int y, int offset, int stride);
 void kernel_cpu_sse3_convert_to_half_float(KernelGlobals *kg, uchar4 *rgba, float *buffer,
@@ -68,6 +75,8 @@ void kernel_cpu_sse3_shader(KernelGlobals *kg, uint4 *input, float4 *output,
 #ifdef WITH_CYCLES_OPTIMIZED_KERNEL_SSE41
 void kernel_cpu_sse41_path_trace(KernelGlobals *kg, float *buffer, unsigned int *rng_state,
 	int sample, int x, int y, int offset, int stride);
+void kernel_cpu_sse41_path_trace_stream(KernelGlobals *kg, float *buffer, unsigned int *rng_state,
+	int sample, const int *x, int num, int y, int offset, int stride);
 void kernel_cpu_sse41_convert_to_byte(KernelGlobals *kg, uchar4 *rgba, float *buffer,
 	float sample_scale, int x, int y, int offset, int stride);
 void kernel_cpu_sse41_convert_to_half_float(KernelGlobals *kg, uchar4 *rgba, float *buffer,
@@ -79,6 +88,8 @@ void kernel_cpu_sse41_shader(KernelGlobals *kg, uint4 *input, float4 *output,
 #ifdef WITH_CYCLES_OPTIMIZED_KERNEL_AVX
 void kernel_cpu_avx_path_trace(KernelGlobals *kg, float *buffer, unsigned int *rng_state,
 	int sample, int x, int y, int offset, int stride);
+void kernel_cpu_avx_path_trace_stream(KernelGlobals *kg, float *buffer, unsigned int *rng_state,
+	int sample, const int *x, int num, int y, int offset, int stride);
 void kernel_cpu_avx_convert_to_byte(KernelGlobals *kg, uchar4 *rgba, float *buffer,
 	float sample_scale, int x, int y, int offset, int stride);
 void kernel_cpu_avx_convert_to_half_float(KernelGlobals *kg, uchar4 *rgba, float *buffer,
@@ -90,6 +101,8 @@ void kernel_cpu_avx_shader(KernelGlobals *kg, uint4 *input, float4 *output,
 #ifdef WITH_CYCLES_OPTIMIZED_KERNEL_AVX2
 void kernel_cpu_avx2_path_trace(KernelGlobals *kg, float *buffer, unsigned int *rng_state,
 	int sample, int x, int y, int offset, int stride);
+void kernel_cpu_avx2_path_trace_stream(KernelGlobals *kg, float *buffer, unsigned int *rng_state,
+	int sample, const int *x, int num, int y, int offset, int stride);
 void kernel_cpu_avx2_convert_to_byte(KernelGlobals *kg, uchar4 *rgba, float *buffer,
 	float sample_scale, int x, int y, int offset, int stride);
 void kernel_cpu_avx2_convert_to_half_float(KernelGlobals *kg, uchar4 *rgba, float *buffer,
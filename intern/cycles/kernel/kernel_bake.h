@@ -439,6 +439,49 @@ ccl_device void kernel_shader_evaluate(KernelGlobals *kg, ccl_global uint4 *inpu
 		shader_eval_displacement(kg, &sd, SHADER_CONTEXT_MAIN);
 		out = sd.P - P;
 	}
+#ifdef __VOLUME__
+	else if(type == SHADER_EVAL_VOLUME) {
+		/* two inputs per point, position in world space and object, shader */
+		uint4 in_shader = input[i*2 + 1];
+		in = input[i*2];
+
+		/* setup ray */
+		Ray ray;
+
+		ray.P = make_float3(__uint_as_float(in.x), __uint_as_float(in.y), __uint_as_float(in.z));
+		ray.D = make_float3(0.0f, 0.0f, 1.0f);
+		ray.t = 0.0f;
+#ifdef __CAMERA_MOTION__
+		ray.time = 0.5f;
+#endif
+
+#ifdef __RAY_DIFFERENTIALS__
+		ray.dD = differential3_zero();
+		ray.dP = differential3_zero();
+#endif
+
+		/* setup shader data */
+		VolumeStack stack[2];
+
+		stack[0].object = in.w;
+		stack[0].shader = in_shader.x;
+		stack[1].shader = SHADER_NONE;
+
+		shader_setup_from_volume(kg, &sd, &ray, 0, 0);
+
+		/* evaluate extinction */
+		shader_eval_volume(kg, &sd, stack, PATH_RAY_SHADOW, SHADER_CONTEXT_SHADOW);
+
+		out = make_float3(0.0f, 0.0f, 0.0f);
+
+		for(int j = 0; j < sd.num_closure; j++) {
+			const ShaderClosure *sc = &sd.closure[j];
+
+			if(CLOSURE_IS_VOLUME(sc->type))
+				out += sc->weight;
+		}
+	}
+#endif
 	else { // SHADER_EVAL_BACKGROUND
 		/* setup ray */
 		Ray ray;
@@ -35,4 +35,27 @@ ccl_device_inline void kernel_write_debug_passes(KernelGlobals *kg,
 	}
 }
 
+#ifdef __KERNEL_STATS__
+/* Time spent on the path of a pixel since start_ticks in milliseconds,
+ * accumulated over samples, and added to the path stage statistics. Only
+ * measured while collecting statistics. */
+ccl_device_inline void kernel_write_debug_render_time(KernelGlobals *kg,
+                                                      ccl_global float *buffer,
+                                                      int sample,
+                                                      uint64_t start_ticks)
+{
+	if(!kg->ray_stats)
+		return;
+
+	uint64_t ticks = time_ticks() - start_ticks;
+	kg->ray_stats->stage_ticks[RAY_STATS_STAGE_PATH] += ticks;
+
+	if(kernel_data.film.pass_flag & PASS_RENDER_TIME) {
+		kernel_write_pass_float(buffer + kernel_data.film.pass_render_time,
+		                        sample,
+		                        ticks*kg->ray_stats_ms_per_tick);
+	}
+}
+#endif
+
 CCL_NAMESPACE_END
@@ -181,6 +181,15 @@ ccl_device_noinline float3 indirect_primitive_emission(KernelGlobals *kg, Shader
 		/* multiple importance sampling, get triangle light pdf,
 		 * and compute weight with respect to BSDF pdf */
 		float pdf = triangle_light_pdf(kg, ccl_fetch(sd, Ng), ccl_fetch(sd, I), t);
+
+#ifdef __LIGHT_TREE__
+		if(kernel_data.integrator.use_light_tree) {
+			/* selection probability depends on the ray origin */
+			float3 ray_P = ccl_fetch(sd, P) + ccl_fetch(sd, I)*t;
+			pdf *= light_tree_triangle_pdf_scale(kg, ray_P, ccl_fetch(sd, object), ccl_fetch(sd, prim));
+		}
+#endif
+
 		float mis_weight = power_heuristic(bsdf_pdf, pdf);
 
 		return L*mis_weight;
@@ -45,6 +45,17 @@ ccl_device uchar4 film_float_to_byte(float4 color)
 	return result;
 }
 
+/* With adaptive sampling pixels stop at different numbers of samples. */
+ccl_device_inline float film_get_sample_scale(KernelGlobals *kg, ccl_global float *buffer, float sample_scale)
+{
+	if(kernel_data.film.pass_flag & PASS_SAMPLE_COUNT) {
+		float sample_count = buffer[kernel_data.film.pass_sample_count];
+		return (sample_count > 0.0f)? 1.0f/sample_count: 0.0f;
+	}
+
+	return sample_scale;
+}
+
 ccl_device void kernel_film_convert_to_byte(KernelGlobals *kg,
 	ccl_global uchar4 *rgba, ccl_global float *buffer,
 	float sample_scale, int x, int y, int offset, int stride)
@@ -57,7 +68,7 @@ ccl_device void kernel_film_convert_to_byte(KernelGlobals *kg,
 
 	/* map colors */
 	float4 irradiance = *((ccl_global float4*)buffer);
-	float4 float_result = film_map(kg, irradiance, sample_scale);
+	float4 float_result = film_map(kg, irradiance, film_get_sample_scale(kg, buffer, sample_scale));
 	uchar4 byte_result = film_float_to_byte(float_result);
 
 	*rgba = byte_result;
@@ -70,7 +81,9 @@ ccl_device void kernel_film_convert_to_half_float(KernelGlobals *kg,
 	/* buffer offset */
 	int index = offset + x + y*stride;
 
-	ccl_global float4 *in = (ccl_global float4*)(buffer + index*kernel_data.film.pass_stride);
+	buffer += index*kernel_data.film.pass_stride;
+
+	ccl_global float4 *in = (ccl_global float4*)buffer;
 	ccl_global half *out = (ccl_global half*)rgba + index*4;
 
 	float exposure = kernel_data.film.exposure;
@@ -83,7 +96,7 @@ ccl_device void kernel_film_convert_to_half_float(KernelGlobals *kg,
 		rgba_in.z *= exposure;
 	}
 
-	float4_store_half(out, rgba_in, sample_scale);
+	float4_store_half(out, rgba_in, film_get_sample_scale(kg, buffer, sample_scale));
 }
 
 CCL_NAMESPACE_END
@@ -31,13 +31,35 @@ struct OSLThreadData;
 struct OSLShadingSystem;
 #endif
 
+#ifdef __TEXTURE_CACHE__
+struct TextureCacheGlobals;
+struct TextureCacheThreadData;
+#endif
+
+#ifdef __KERNEL_STATS__
+class RayStats;
+#endif
+
 #define MAX_BYTE_IMAGES   1024
 #define MAX_FLOAT_IMAGES  1024
 
+/* Compact storage for the image slots, a slot only has data in one of its
+ * textures. Half float and single channel float images use float slots,
+ * single channel byte images use byte slots. */
+typedef struct KernelCompactImages {
+	texture_image_half4 texture_half_images[MAX_FLOAT_IMAGES];
+	texture_image_float texture_float1_images[MAX_FLOAT_IMAGES];
+	texture_image_uchar texture_byte1_images[MAX_BYTE_IMAGES];
+} KernelCompactImages;
+
 typedef struct KernelGlobals {
 	texture_image_uchar4 texture_byte_images[MAX_BYTE_IMAGES];
 	texture_image_float4 texture_float_images[MAX_FLOAT_IMAGES];
 
+	/* allocated when the first compact image is loaded, and shared by the
+	 * copies of the globals made for each thread */
+	KernelCompactImages *compact_images;
+
 #define KERNEL_TEX(type, ttype, name) ttype name;
 #define KERNEL_IMAGE_TEX(type, ttype, name)
 #include "kernel_textures.h"
@@ -52,8 +74,86 @@ typedef struct KernelGlobals {
 	OSLThreadData *osl_tdata;
 #endif
 
+#ifdef __TEXTURE_CACHE__
+	/* Image slots that are read on demand from files through the texture
+	 * cache instead of being loaded into the texture arrays above. */
+	TextureCacheGlobals *texture_cache;
+	TextureCacheThreadData *texture_cache_tdata;
+#endif
+
+#ifdef __KERNEL_STATS__
+	/* statistics of the render thread, NULL when not collected */
+	RayStats *ray_stats;
+	float ray_stats_ms_per_tick;
+#endif
+
 } KernelGlobals;
 
+/* Image texture lookups, picking the texture of the slot that has data */
+
+ccl_device_inline float4 kernel_tex_image_interp_cpu(KernelGlobals *kg, int tex, float x, float y)
+{
+	KernelCompactImages *compact = kg->compact_images;
+
+	if(tex < MAX_FLOAT_IMAGES) {
+		if(compact && compact->texture_half_images[tex].data)
+			return compact->texture_half_images[tex].interp(x, y);
+		else if(compact && compact->texture_float1_images[tex].data)
+			return compact->texture_float1_images[tex].interp(x, y);
+		return kg->texture_float_images[tex].interp(x, y);
+	}
+
+	tex -= MAX_FLOAT_IMAGES;
+
+	if(compact && compact->texture_byte1_images[tex].data)
+		return compact->texture_byte1_images[tex].interp(x, y);
+	return kg->texture_byte_images[tex].interp(x, y);
+}
+
+ccl_device_inline float4 kernel_tex_image_interp_3d_ex_cpu(KernelGlobals *kg, int tex, float x, float y, float z, int interpolation)
+{
+	KernelCompactImages *compact = kg->compact_images;
+
+	if(tex < MAX_FLOAT_IMAGES) {
+		if(compact && compact->texture_half_images[tex].data)
+			return compact->texture_half_images[tex].interp_3d_ex(x, y, z, interpolation);
+		else if(compact && compact->texture_float1_images[tex].data)
+			return compact->texture_float1_images[tex].interp_3d_ex(x, y, z, interpolation);
+		return kg->texture_float_images[tex].interp_3d_ex(x, y, z, interpolation);
+	}
+
+	tex -= MAX_FLOAT_IMAGES;
+
+	if(compact && compact->texture_byte1_images[tex].data)
+		return compact->texture_byte1_images[tex].interp_3d_ex(x, y, z, interpolation);
+	return kg->texture_byte_images[tex].interp_3d_ex(x, y, z, interpolation);
+}
+
+ccl_device_inline float4 kernel_tex_image_interp_3d_cpu(KernelGlobals *kg, int tex, float x, float y, float z)
+{
+	KernelCompactImages *compact = kg->compact_images;
+
+	if(tex < MAX_FLOAT_IMAGES) {
+		if(compact && compact->texture_half_images[tex].data)
+			return compact->texture_half_images[tex].interp_3d(x, y, z);
+		else if(compact && compact->texture_float1_images[tex].data)
+			return compact->texture_float1_images[tex].interp_3d(x, y, z);
+		return kg->texture_float_images[tex].interp_3d(x, y, z);
+	}
+
+	tex -= MAX_FLOAT_IMAGES;
+
+	if(compact && compact->texture_byte1_images[tex].data)
+		return compact->texture_byte1_images[tex].interp_3d(x, y, z);
+	return kg->texture_byte_images[tex].interp_3d(x, y, z);
+}
+
+#ifdef __TEXTURE_CACHE__
+bool kernel_texture_cache_lookup(KernelGlobals *kg, int slot,
+                                 float x, float y, float2 dx, float2 dy,
+                                 float4 *result);
+#endif
+
 #endif
 
 /* For CUDA, constant memory textures must be globals, so we can't put them
@@ -126,3 +226,5 @@ ccl_device float lookup_table_read_2D(KernelGlobals *kg, float x, float y, int o
 
 CCL_NAMESPACE_END
 
+#include "kernel_stats.h"
+
@@ -832,6 +832,234 @@ ccl_device int light_distribution_sample(KernelGlobals *kg, float randt)
 	return clamp(first-1, 0, kernel_data.integrator.num_distribution-1);
 }
 
+#ifdef __LIGHT_TREE__
+
+/* Light Tree
+ *
+ * Emissive triangles and local lamps are organized in two trees built by the
+ * LightTree on the host. A light is selected by traversing a tree top-down,
+ * picking each child proportional to an estimate of its contribution to the
+ * shading point, and then an emitter in the leaf proportional to its area as
+ * in the flat distribution. The choice between triangles, local lamps and
+ * distant lamps is kept the same as with the flat distribution. */
+
+ccl_device float light_distribution_energy(KernelGlobals *kg, int index)
+{
+	return kernel_tex_fetch(__light_distribution, index + 1).x - kernel_tex_fetch(__light_distribution, index).x;
+}
+
+ccl_device float light_tree_node_importance(KernelGlobals *kg, float3 P, int node)
+{
+	float4 data0 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 0);
+	float4 data1 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 1);
+
+	float3 bbox_min = make_float3(data0.x, data0.y, data0.z);
+	float3 bbox_max = make_float3(data1.x, data1.y, data1.z);
+	float energy = data0.w;
+	float theta_o = data1.w;
+
+	/* distance to the center, clamped to the bounding sphere so the estimate
+	 * does not blow up for points inside or close to the node */
+	float3 D = P - 0.5f*(bbox_min + bbox_max);
+	float dist_sq = len_squared(D);
+	float radius_sq = 0.25f*len_squared(bbox_max - bbox_min);
+
+	float importance = energy/max(dist_sq, radius_sq);
+
+	/* orientation bound, emitters facing away from P contribute nothing */
+	if(theta_o < M_PI_F && dist_sq > radius_sq) {
+		float4 data2 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 2);
+		float4 data3 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 3);
+		float3 axis = make_float3(data2.x, data2.y, data2.z);
+		float theta_e = data3.z;
+
+		float dist = sqrtf(dist_sq);
+		float theta = safe_acosf(dot(axis, D)/dist);
+		float theta_u = safe_asinf(sqrtf(radius_sq)/dist);
+		float theta_min = max(theta - theta_o - theta_u, 0.0f);
+
+		importance *= (theta_min <= theta_e)? cosf(min(theta_min, M_PI_2_F)): 0.0f;
+	}
+
+	return importance;
+}
+
+/* probability of picking the first child */
+ccl_device float light_tree_child_probability(KernelGlobals *kg, float3 P, int child0, int child1)
+{
+	float importance0 = light_tree_node_importance(kg, P, child0);
+	float importance1 = light_tree_node_importance(kg, P, child1);
+
+	if(importance0 + importance1 == 0.0f) {
+		/* no emitter is facing P, fall back to energy to keep a valid distribution */
+		importance0 = kernel_tex_fetch(__light_tree_nodes, child0*LIGHT_TREE_NODE_SIZE).w;
+		importance1 = kernel_tex_fetch(__light_tree_nodes, child1*LIGHT_TREE_NODE_SIZE).w;
+
+		if(importance0 + importance1 == 0.0f)
+			return 0.5f;
+	}
+
+	return importance0/(importance0 + importance1);
+}
+
+/* pick an emitter from the tree at the given root node, returns its index
+ * in the light distribution and the probability of picking it */
+ccl_device int light_tree_sample(KernelGlobals *kg, float3 P, int node, float randt, float *pdf)
+{
+	*pdf = 1.0f;
+
+	while(true) {
+		float4 data3 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 3);
+		int child0 = __float_as_int(data3.x);
+		int child1 = __float_as_int(data3.y);
+
+		if(child0 < 0)
+			break;
+
+		float prob0 = light_tree_child_probability(kg, P, child0, child1);
+
+		if(randt < prob0) {
+			randt = randt/prob0;
+			*pdf *= prob0;
+			node = child0;
+		}
+		else {
+			randt = (randt - prob0)/(1.0f - prob0);
+			*pdf *= 1.0f - prob0;
+			node = child1;
+		}
+	}
+
+	/* pick emitter in leaf proportional to area */
+	float4 data3 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 3);
+	int first = ~__float_as_int(data3.x);
+	int num = __float_as_int(data3.y);
+	float total = 0.0f;
+
+	for(int i = 0; i < num; i++)
+		total += light_distribution_energy(kg, kernel_tex_fetch(__light_tree_index, first + i));
+
+	float target = randt*total;
+	int index = kernel_tex_fetch(__light_tree_index, first + num - 1);
+	float energy = light_distribution_energy(kg, index);
+
+	for(int i = 0; i < num - 1; i++) {
+		int emitter = kernel_tex_fetch(__light_tree_index, first + i);
+		float emitter_energy = light_distribution_energy(kg, emitter);
+
+		if(target < emitter_energy) {
+			index = emitter;
+			energy = emitter_energy;
+			break;
+		}
+
+		target -= emitter_energy;
+	}
+
+	*pdf *= (total > 0.0f)? energy/total: 0.0f;
+
+	return index;
+}
+
+/* probability of picking the emitter with the given light distribution index,
+ * following the same steps as light_tree_sample from leaf to root */
+ccl_device float light_tree_pdf(KernelGlobals *kg, float3 P, int index)
+{
+	int node = kernel_tex_fetch(__light_tree_index, kernel_data.integrator.light_tree_leaf_offset + index);
+
+	float4 data3 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 3);
+	int first = ~__float_as_int(data3.x);
+	int num = __float_as_int(data3.y);
+	float total = 0.0f;
+
+	for(int i = 0; i < num; i++)
+		total += light_distribution_energy(kg, kernel_tex_fetch(__light_tree_index, first + i));
+
+	if(total == 0.0f)
+		return 0.0f;
+
+	float pdf = light_distribution_energy(kg, index)/total;
+
+	while(true) {
+		float4 data2 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 2);
+		int parent = __float_as_int(data2.w);
+
+		if(parent < 0)
+			break;
+
+		float4 parent_data3 = kernel_tex_fetch(__light_tree_nodes, parent*LIGHT_TREE_NODE_SIZE + 3);
+		int child0 = __float_as_int(parent_data3.x);
+		int child1 = __float_as_int(parent_data3.y);
+		float prob0 = light_tree_child_probability(kg, P, child0, child1);
+
+		pdf *= (node == child0)? prob0: 1.0f - prob0;
+		node = parent;
+	}
+
+	return pdf;
+}
+
+/* pick an emitter like light_distribution_sample, also returning the ratio
+ * of the tree and flat distribution probabilities for it */
+ccl_device int light_tree_distribution_sample(KernelGlobals *kg, float3 P, float randt, float *pdf_scale)
+{
+	int num_triangles = kernel_data.integrator.light_tree_num_triangles;
+	int num_lamps = kernel_data.integrator.light_tree_num_lamps;
+	float triangles_cdf = kernel_tex_fetch(__light_distribution, num_triangles).x;
+	float lamps_cdf = kernel_tex_fetch(__light_distribution, num_triangles + num_lamps).x;
+	float group_pdf;
+	int root;
+
+	if(randt < triangles_cdf && num_triangles > 0) {
+		group_pdf = triangles_cdf;
+		randt = randt/group_pdf;
+		root = 0;
+	}
+	else if(randt < lamps_cdf && num_lamps > 0) {
+		group_pdf = lamps_cdf - triangles_cdf;
+		randt = (randt - triangles_cdf)/group_pdf;
+		root = kernel_data.integrator.light_tree_lamp_root;
+	}
+	else {
+		/* distant and background lamps */
+		*pdf_scale = 1.0f;
+		return light_distribution_sample(kg, randt);
+	}
+
+	float pdf;
+	int index = light_tree_sample(kg, P, root, randt, &pdf);
+	float energy = light_distribution_energy(kg, index);
+
+	*pdf_scale = (energy > 0.0f)? group_pdf*pdf/energy: 0.0f;
+
+	return index;
+}
+
+/* ratio of the tree and flat distribution probabilities for a triangle hit
+ * from P, for multiple importance sampling */
+ccl_device float light_tree_triangle_pdf_scale(KernelGlobals *kg, float3 P, int object, int prim)
+{
+	uint object_offset = kernel_tex_fetch(__light_tree_index, kernel_data.integrator.light_tree_object_offset + object);
+	uint prim_offset = kernel_tex_fetch(__light_tree_index, kernel_data.integrator.light_tree_prim_offset + prim);
+
+	/* not in the light distribution */
+	if(object_offset == ~0u || prim_offset == ~0u)
+		return 1.0f;
+
+	int index = object_offset + prim_offset;
+	float energy = light_distribution_energy(kg, index);
+
+	if(energy == 0.0f)
+		return 0.0f;
+
+	int num_triangles = kernel_data.integrator.light_tree_num_triangles;
+	float triangles_cdf = kernel_tex_fetch(__light_distribution, num_triangles).x;
+
+	return triangles_cdf*light_tree_pdf(kg, P, index)/energy;
+}
+
+#endif  /* __LIGHT_TREE__ */
+
 /* Generic Light */
 
 ccl_device bool light_select_reached_max_bounces(KernelGlobals *kg, int index, int bounce)
@@ -843,7 +1071,19 @@ ccl_device bool light_select_reached_max_bounces(KernelGlobals *kg, int index, i
 ccl_device void light_sample(KernelGlobals *kg, float randt, float randu, float randv, float time, float3 P, int bounce, LightSample *ls)
 {
 	/* sample index */
+#ifdef __LIGHT_TREE__
+	float pdf_scale = 1.0f;
+	int index = (kernel_data.integrator.use_light_tree)?
+		light_tree_distribution_sample(kg, P, randt, &pdf_scale):
+		light_distribution_sample(kg, randt);
+
+	if(pdf_scale == 0.0f) {
+		ls->pdf = 0.0f;
+		return;
+	}
+#else
 	int index = light_distribution_sample(kg, randt);
+#endif
 
 	/* fetch light data */
 	float4 l = kernel_tex_fetch(__light_distribution, index);
@@ -859,6 +1099,10 @@ ccl_device void light_sample(KernelGlobals *kg, float randt, float randu, float
 		ls->D = normalize_len(ls->P - P, &ls->t);
 		ls->pdf = triangle_light_pdf(kg, ls->Ng, -ls->D, ls->t);
 		ls->shader |= shader_flag;
+
+#ifdef __LIGHT_TREE__
+		ls->pdf *= pdf_scale;
+#endif
 	}
 	else {
 		int lamp = -prim-1;
@@ -869,6 +1113,11 @@ ccl_device void light_sample(KernelGlobals *kg, float randt, float randu, float
 		}
 
 		lamp_light_sample(kg, lamp, randu, randv, P, ls);
+
+#ifdef __LIGHT_TREE__
+		/* lamp selection probability is accounted for in eval_fac */
+		ls->eval_fac /= pdf_scale;
+#endif
 	}
 }
 
@@ -108,6 +108,17 @@ ccl_device_inline void kernel_write_data_passes(KernelGlobals *kg, ccl_global fl
 				kernel_write_pass_float4(buffer + kernel_data.film.pass_motion, sample, speed);
 				kernel_write_pass_float(buffer + kernel_data.film.pass_motion_weight, sample, 1.0f);
 			}
+			if(flag & PASS_DENOISING) {
+				/* features of the first hit, averaged over all samples */
+				ccl_global float *denoising = buffer + kernel_data.film.pass_denoising;
+				float3 albedo = shader_bsdf_diffuse(kg, sd) + shader_bsdf_glossy(kg, sd) +
+				                shader_bsdf_transmission(kg, sd) + shader_bsdf_subsurface(kg, sd);
+				float depth = camera_distance(kg, ccl_fetch(sd, P));
+
+				kernel_write_pass_float3(denoising, sample, ccl_fetch(sd, N));
+				kernel_write_pass_float3(denoising + 3, sample, albedo);
+				kernel_write_pass_float(denoising + 6, sample, depth);
+			}
 
 			state->flag |= PATH_RAY_SINGLE_PASS_DONE;
 		}
@@ -199,5 +210,36 @@ ccl_device_inline void kernel_write_light_passes(KernelGlobals *kg, ccl_global f
 #endif
 }
 
+/* Adaptive sampling: count samples per pixel, since converged pixels are
+ * skipped, and accumulate the squared luminance for the noise estimate. */
+ccl_device_inline void kernel_write_adaptive_passes(KernelGlobals *kg, ccl_global float *buffer, int sample, float4 L)
+{
+	int flag = kernel_data.film.pass_flag;
+
+	if(flag & PASS_SAMPLE_COUNT)
+		kernel_write_pass_float(buffer + kernel_data.film.pass_sample_count, sample, 1.0f);
+
+	if(flag & PASS_ADAPTIVE_AUX_BUFFER) {
+		ccl_global float *aux = buffer + kernel_data.film.pass_adaptive_aux_buffer;
+		float luminance = linear_rgb_to_gray(make_float3(L.x, L.y, L.z));
+
+		kernel_write_pass_float(aux, sample, luminance*luminance);
+
+		/* the convergence flag is set from the host, cleared on restart */
+		if(sample == 0)
+			aux[1] = 0.0f;
+	}
+}
+
+/* Denoising: accumulate the squared luminance, for the variance of the pixel
+ * that sets the strength of the filter. */
+ccl_device_inline void kernel_write_denoising_passes(KernelGlobals *kg, ccl_global float *buffer, int sample, float4 L)
+{
+	if(kernel_data.film.pass_flag & PASS_DENOISING) {
+		float luminance = linear_rgb_to_gray(make_float3(L.x, L.y, L.z));
+		kernel_write_pass_float(buffer + kernel_data.film.pass_denoising + 7, sample, luminance*luminance);
+	}
+}
+
 CCL_NAMESPACE_END
 
@@ -60,7 +60,13 @@ ccl_device void kernel_path_indirect(KernelGlobals *kg, RNG *rng, Ray ray,
 		/* intersect scene */
 		Intersection isect;
 		uint visibility = path_state_ray_visibility(kg, &state);
+#ifdef __KERNEL_STATS__
+		uint64_t stats_ticks = kernel_stats_ticks(kg);
+#endif
 		bool hit = scene_intersect(kg, &ray, visibility, &isect, NULL, 0.0f, 0.0f);
+#ifdef __KERNEL_STATS__
+		kernel_stats_intersect(kg, &state, &isect, stats_ticks);
+#endif
 
 #ifdef __LAMP_MIS__
 		if(kernel_data.integrator.use_lamp_mis && !(state.flag & PATH_RAY_CAMERA)) {
@@ -365,6 +371,10 @@ ccl_device void kernel_branched_path_ao(KernelGlobals *kg, ShaderData *sd, PathR
 
 ccl_device bool kernel_path_subsurface_scatter(KernelGlobals *kg, ShaderData *sd, PathRadiance *L, PathState *state, RNG *rng, Ray *ray, float3 *throughput)
 {
+#ifdef __KERNEL_STATS__
+	KernelStatsTimer stats_timer(kg, RAY_STATS_STAGE_SUBSURFACE);
+#endif
+
 	float bssrdf_probability;
 	ShaderClosure *sc = subsurface_scatter_pick_closure(kg, sd, &bssrdf_probability);
 
@@ -430,7 +440,51 @@ ccl_device bool kernel_path_subsurface_scatter(KernelGlobals *kg, ShaderData *sd
 }
 #endif
 
-ccl_device float4 kernel_path_integrate(KernelGlobals *kg, RNG *rng, int sample, Ray ray, ccl_global float *buffer)
+/* Intersect the scene with the next ray of a path */
+
+ccl_device_inline bool kernel_path_scene_intersect(KernelGlobals *kg, PathState *state, RNG *rng, Ray *ray, Intersection *isect)
+{
+	uint visibility = path_state_ray_visibility(kg, state);
+	bool hit;
+
+#ifdef __KERNEL_STATS__
+	uint64_t stats_ticks = kernel_stats_ticks(kg);
+#endif
+
+#ifdef __HAIR__
+	float difl = 0.0f, extmax = 0.0f;
+	uint lcg_state = 0;
+
+	if(kernel_data.bvh.have_curves) {
+		if((kernel_data.cam.resolution == 1) && (state->flag & PATH_RAY_CAMERA)) {	
+			float3 pixdiff = ray->dD.dx + ray->dD.dy;
+			/*pixdiff = pixdiff - dot(pixdiff, ray->D)*ray->D;*/
+			difl = kernel_data.curve.minimum_width * len(pixdiff) * 0.5f;
+		}
+
+		extmax = kernel_data.curve.maximum_width;
+		lcg_state = lcg_state_init(rng, state, 0x51633e2d);
+	}
+
+	hit = scene_intersect(kg, ray, visibility, isect, &lcg_state, difl, extmax);
+#else
+	hit = scene_intersect(kg, ray, visibility, isect, NULL, 0.0f, 0.0f);
+#endif
+
+#ifdef __KERNEL_STATS__
+	kernel_stats_intersect(kg, state, isect, stats_ticks);
+#endif
+
+	return hit;
+}
+
+/* Integrate a path from its camera ray. The path state must be initialized,
+ * and the camera ray may already be intersected and its hit shaded, by the
+ * CPU ray stream. */
+
+ccl_device float4 kernel_path_integrate(KernelGlobals *kg, RNG *rng, int sample, Ray ray,
+	PathState state, const Intersection *camera_isect, const ShaderData *camera_sd,
+	ccl_global float *buffer)
 {
 	/* initialize */
 	PathRadiance L;
@@ -439,9 +493,6 @@ ccl_device float4 kernel_path_integrate(KernelGlobals *kg, RNG *rng, int sample,
 
 	path_radiance_init(&L, kernel_data.film.use_light_pass);
 
-	PathState state;
-	path_state_init(kg, &state, rng, sample, &ray);
-
 #ifdef __KERNEL_DEBUG__
 	DebugData debug_data;
 	debug_data_init(&debug_data);
@@ -451,27 +502,17 @@ ccl_device float4 kernel_path_integrate(KernelGlobals *kg, RNG *rng, int sample,
 	for(;;) {
 		/* intersect scene */
 		Intersection isect;
-		uint visibility = path_state_ray_visibility(kg, &state);
+		bool hit;
 
-#ifdef __HAIR__
-		float difl = 0.0f, extmax = 0.0f;
-		uint lcg_state = 0;
-
-		if(kernel_data.bvh.have_curves) {
-			if((kernel_data.cam.resolution == 1) && (state.flag & PATH_RAY_CAMERA)) {	
-				float3 pixdiff = ray.dD.dx + ray.dD.dy;
-				/*pixdiff = pixdiff - dot(pixdiff, ray.D)*ray.D;*/
-				difl = kernel_data.curve.minimum_width * len(pixdiff) * 0.5f;
-			}
-
-			extmax = kernel_data.curve.maximum_width;
-			lcg_state = lcg_state_init(rng, &state, 0x51633e2d);
+		if(camera_isect) {
+			isect = *camera_isect;
+			hit = (isect.prim != PRIM_NONE);
+			camera_isect = NULL;
+		}
+		else {
+			hit = kernel_path_scene_intersect(kg, &state, rng, &ray, &isect);
+			camera_sd = NULL;
 		}
-
-		bool hit = scene_intersect(kg, &ray, visibility, &isect, &lcg_state, difl, extmax);
-#else
-		bool hit = scene_intersect(kg, &ray, visibility, &isect, NULL, 0.0f, 0.0f);
-#endif
 
 #ifdef __KERNEL_DEBUG__
 		if(state.flag & PATH_RAY_CAMERA) {
@@ -607,9 +648,16 @@ ccl_device float4 kernel_path_integrate(KernelGlobals *kg, RNG *rng, int sample,
 
 		/* setup shading */
 		ShaderData sd;
-		shader_setup_from_ray(kg, &sd, &isect, &ray, state.bounce, state.transparent_bounce);
-		float rbsdf = path_state_rng_1D_for_decision(kg, rng, &state, PRNG_BSDF);
-		shader_eval_surface(kg, &sd, rbsdf, state.flag, SHADER_CONTEXT_MAIN);
+
+		if(camera_sd) {
+			sd = *camera_sd;
+			camera_sd = NULL;
+		}
+		else {
+			shader_setup_from_ray(kg, &sd, &isect, &ray, state.bounce, state.transparent_bounce);
+			float rbsdf = path_state_rng_1D_for_decision(kg, rng, &state, PRNG_BSDF);
+			shader_eval_surface(kg, &sd, rbsdf, state.flag, SHADER_CONTEXT_MAIN);
+		}
 
 		/* holdout */
 #ifdef __HOLDOUT__
@@ -765,6 +813,10 @@ ccl_device void kernel_branched_path_subsurface_scatter(KernelGlobals *kg,
                                                         Ray *ray,
                                                         float3 throughput)
 {
+#ifdef __KERNEL_STATS__
+	KernelStatsTimer stats_timer(kg, RAY_STATS_STAGE_SUBSURFACE);
+#endif
+
 	for(int i = 0; i< ccl_fetch(sd, num_closure); i++) {
 		ShaderClosure *sc = &ccl_fetch(sd, closure)[i];
 
@@ -852,27 +904,7 @@ ccl_device float4 kernel_branched_path_integrate(KernelGlobals *kg, RNG *rng, in
 	for(;;) {
 		/* intersect scene */
 		Intersection isect;
-		uint visibility = path_state_ray_visibility(kg, &state);
-
-#ifdef __HAIR__
-		float difl = 0.0f, extmax = 0.0f;
-		uint lcg_state = 0;
-
-		if(kernel_data.bvh.have_curves) {
-			if((kernel_data.cam.resolution == 1) && (state.flag & PATH_RAY_CAMERA)) {	
-				float3 pixdiff = ray.dD.dx + ray.dD.dy;
-				/*pixdiff = pixdiff - dot(pixdiff, ray.D)*ray.D;*/
-				difl = kernel_data.curve.minimum_width * len(pixdiff) * 0.5f;
-			}
-
-			extmax = kernel_data.curve.maximum_width;
-			lcg_state = lcg_state_init(rng, &state, 0x51633e2d);
-		}
-
-		bool hit = scene_intersect(kg, &ray, visibility, &isect, &lcg_state, difl, extmax);
-#else
-		bool hit = scene_intersect(kg, &ray, visibility, &isect, NULL, 0.0f, 0.0f);
-#endif
+		bool hit = kernel_path_scene_intersect(kg, &state, rng, &ray, &isect);
 
 #ifdef __KERNEL_DEBUG__
 		if(state.flag & PATH_RAY_CAMERA) {
@@ -1159,18 +1191,32 @@ ccl_device void kernel_path_trace(KernelGlobals *kg,
 	RNG rng;
 	Ray ray;
 
+#ifdef __KERNEL_STATS__
+	uint64_t stats_ticks = kernel_stats_ticks(kg);
+#endif
+
 	kernel_path_trace_setup(kg, rng_state, sample, x, y, &rng, &ray);
 
 	/* integrate */
 	float4 L;
 
-	if(ray.t != 0.0f)
-		L = kernel_path_integrate(kg, &rng, sample, ray, buffer);
+	if(ray.t != 0.0f) {
+		PathState state;
+		path_state_init(kg, &state, &rng, sample, &ray);
+
+		L = kernel_path_integrate(kg, &rng, sample, ray, state, NULL, NULL, buffer);
+	}
 	else
 		L = make_float4(0.0f, 0.0f, 0.0f, 0.0f);
 
+#ifdef __KERNEL_STATS__
+	kernel_write_debug_render_time(kg, buffer, sample, stats_ticks);
+#endif
+
 	/* accumulate result in output buffer */
 	kernel_write_pass_float4(buffer, sample, L);
+	kernel_write_adaptive_passes(kg, buffer, sample, L);
+	kernel_write_denoising_passes(kg, buffer, sample, L);
 
 	path_rng_end(kg, rng_state, rng);
 }
@@ -1191,6 +1237,10 @@ ccl_device void kernel_branched_path_trace(KernelGlobals *kg,
 	RNG rng;
 	Ray ray;
 
+#ifdef __KERNEL_STATS__
+	uint64_t stats_ticks = kernel_stats_ticks(kg);
+#endif
+
 	kernel_path_trace_setup(kg, rng_state, sample, x, y, &rng, &ray);
 
 	/* integrate */
@@ -1201,8 +1251,14 @@ ccl_device void kernel_branched_path_trace(KernelGlobals *kg,
 	else
 		L = make_float4(0.0f, 0.0f, 0.0f, 0.0f);
 
+#ifdef __KERNEL_STATS__
+	kernel_write_debug_render_time(kg, buffer, sample, stats_ticks);
+#endif
+
 	/* accumulate result in output buffer */
 	kernel_write_pass_float4(buffer, sample, L);
+	kernel_write_adaptive_passes(kg, buffer, sample, L);
+	kernel_write_denoising_passes(kg, buffer, sample, L);
 
 	path_rng_end(kg, rng_state, rng);
 }
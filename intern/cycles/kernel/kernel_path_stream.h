@@ -0,0 +1,167 @@
+/*
+ * Copyright 2011-2015 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+CCL_NAMESPACE_BEGIN
+
+/* Ray Stream
+ *
+ * CPU path tracing of a row of pixels in batches: the camera rays of a batch
+ * are generated and traced together, then the paths are integrated in order
+ * of the shader they hit first. Neighbouring camera rays traverse the same
+ * BVH nodes and paths hitting the same shader run the same SVM nodes, so
+ * both stay warm in the caches. Camera hits of the same shader are shaded
+ * together by the batched SVM interpreter. Results are identical to
+ * kernel_path_trace. */
+
+#define PATH_STREAM_SIZE 64
+#define PATH_STREAM_SHADE_SIZE SVM_BATCH_SIZE
+
+/* Can the camera hit be shaded before integrating the path? Not when the
+ * camera is inside a volume, the volume may scatter the ray first. */
+ccl_device_inline bool kernel_path_stream_shade_first(PathState *state)
+{
+#ifdef __VOLUME__
+	return (state->volume_stack[0].shader == SHADER_NONE);
+#else
+	return true;
+#endif
+}
+
+/* Setup and evaluate the camera hits of paths with the same shader */
+ccl_device void kernel_path_stream_shade(KernelGlobals *kg, RNG *rng, Ray *ray,
+	PathState *state, Intersection *isect, const int *index, int num, ShaderData *sd)
+{
+	ShaderData *batch_sd[PATH_STREAM_SHADE_SIZE];
+	float randb[PATH_STREAM_SHADE_SIZE];
+
+	for(int j = 0; j < num; j++) {
+		int i = index[j];
+
+		shader_setup_from_ray(kg, &sd[j], &isect[i], &ray[i], state[i].bounce, state[i].transparent_bounce);
+		randb[j] = path_state_rng_1D_for_decision(kg, &rng[i], &state[i], PRNG_BSDF);
+		batch_sd[j] = &sd[j];
+	}
+
+	shader_eval_surface_batch(kg, batch_sd, randb, num, state[index[0]].flag, SHADER_CONTEXT_MAIN);
+}
+
+ccl_device void kernel_path_trace_stream(KernelGlobals *kg,
+	ccl_global float *buffer, ccl_global uint *rng_state,
+	int sample, const int *x, int num, int y, int offset, int stride)
+{
+	int pass_stride = kernel_data.film.pass_stride;
+
+	RNG rng[PATH_STREAM_SIZE];
+	Ray ray[PATH_STREAM_SIZE];
+	PathState state[PATH_STREAM_SIZE];
+	Intersection isect[PATH_STREAM_SIZE];
+	int key[PATH_STREAM_SIZE];
+	int order[PATH_STREAM_SIZE];
+	ShaderData sd[PATH_STREAM_SHADE_SIZE];
+
+	for(int start = 0; start < num; start += PATH_STREAM_SIZE) {
+		int size = min(num - start, PATH_STREAM_SIZE);
+
+		/* generate and trace camera rays */
+		for(int i = 0; i < size; i++) {
+			int index = offset + x[start + i] + y*stride;
+
+			kernel_path_trace_setup(kg, rng_state + index, sample, x[start + i], y, &rng[i], &ray[i]);
+
+			if(ray[i].t != 0.0f) {
+				path_state_init(kg, &state[i], &rng[i], sample, &ray[i]);
+
+				if(kernel_path_scene_intersect(kg, &state[i], &rng[i], &ray[i], &isect[i]))
+					key[i] = intersection_get_shader(kg, &isect[i]);
+				else
+					key[i] = -1;
+			}
+			else
+				key[i] = -1;
+		}
+
+		/* sort by shader, batches are small so insertion sort will do */
+		for(int i = 0; i < size; i++) {
+			int j = i;
+
+			for(; j > 0 && key[order[j-1]] > key[i]; j--)
+				order[j] = order[j-1];
+
+			order[j] = i;
+		}
+
+		/* integrate and accumulate result in output buffer */
+		for(int k = 0; k < size;) {
+			/* gather camera hits with the same shader to shade together */
+			int group[PATH_STREAM_SHADE_SIZE];
+			int num_group = 0;
+			bool shaded = false;
+
+			while(k < size && num_group < PATH_STREAM_SHADE_SIZE) {
+				int i = order[k];
+				bool shade = (key[i] != -1 && kernel_path_stream_shade_first(&state[i]));
+
+				if(num_group == 0)
+					shaded = shade;
+				else if(!shade || key[i] != key[group[0]] || state[i].flag != state[group[0]].flag)
+					break;
+
+				group[num_group++] = i;
+				k++;
+
+				/* misses and paths starting in a volume are integrated alone */
+				if(!shaded)
+					break;
+			}
+
+			if(shaded)
+				kernel_path_stream_shade(kg, rng, ray, state, isect, group, num_group, sd);
+
+			for(int j = 0; j < num_group; j++) {
+				int i = group[j];
+
+				int index = offset + x[start + i] + y*stride;
+				ccl_global float *pixel_buffer = buffer + index*pass_stride;
+				float4 L;
+
+#ifdef __KERNEL_STATS__
+				/* camera rays of the batch are not included */
+				uint64_t stats_ticks = kernel_stats_ticks(kg);
+#endif
+
+				if(ray[i].t != 0.0f) {
+					L = kernel_path_integrate(kg, &rng[i], sample, ray[i], state[i], &isect[i],
+						(shaded)? &sd[j]: NULL, pixel_buffer);
+				}
+				else
+					L = make_float4(0.0f, 0.0f, 0.0f, 0.0f);
+
+#ifdef __KERNEL_STATS__
+				kernel_write_debug_render_time(kg, pixel_buffer, sample, stats_ticks);
+#endif
+
+				kernel_write_pass_float4(pixel_buffer, sample, L);
+				kernel_write_adaptive_passes(kg, pixel_buffer, sample, L);
+				kernel_write_denoising_passes(kg, pixel_buffer, sample, L);
+
+				path_rng_end(kg, rng_state + index, rng[i]);
+			}
+		}
+	}
+}
+
+CCL_NAMESPACE_END
+
@@ -27,6 +27,10 @@ ccl_device void kernel_branched_path_surface_connect_light(KernelGlobals *kg, RN
 	if(!(ccl_fetch(sd, flag) & SD_BSDF_HAS_EVAL))
 		return;
 
+#ifdef __KERNEL_STATS__
+	KernelStatsTimer stats_timer(kg, RAY_STATS_STAGE_LIGHT);
+#endif
+
 	Ray light_ray;
 	BsdfEval L_light;
 	bool is_lamp;
@@ -190,6 +194,10 @@ ccl_device_inline void kernel_path_surface_connect_light(KernelGlobals *kg, ccl_
 	if(!(kernel_data.integrator.use_direct_light && (ccl_fetch(sd, flag) & SD_BSDF_HAS_EVAL)))
 		return;
 
+#ifdef __KERNEL_STATS__
+	KernelStatsTimer stats_timer(kg, RAY_STATS_STAGE_LIGHT);
+#endif
+
 	/* sample illumination from lights to find path contribution */
 	float light_t = path_state_rng_1D(kg, rng, state, PRNG_LIGHT);
 	float light_u, light_v;
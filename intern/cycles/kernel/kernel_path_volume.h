@@ -25,6 +25,10 @@ ccl_device void kernel_path_volume_connect_light(KernelGlobals *kg, RNG *rng,
 	if(!kernel_data.integrator.use_direct_light)
 		return;
 
+#ifdef __KERNEL_STATS__
+	KernelStatsTimer stats_timer(kg, RAY_STATS_STAGE_LIGHT);
+#endif
+
 	/* sample illumination from lights to find path contribution */
 	float light_t = path_state_rng_1D(kg, rng, state, PRNG_LIGHT);
 	float light_u, light_v;
@@ -113,6 +117,10 @@ ccl_device void kernel_branched_path_volume_connect_light(KernelGlobals *kg, RNG
 	if(!kernel_data.integrator.use_direct_light)
 		return;
 
+#ifdef __KERNEL_STATS__
+	KernelStatsTimer stats_timer(kg, RAY_STATS_STAGE_LIGHT);
+#endif
+
 	Ray light_ray;
 	BsdfEval L_light;
 	bool is_lamp;
@@ -787,6 +787,10 @@ ccl_device float3 shader_holdout_eval(KernelGlobals *kg, ShaderData *sd)
 ccl_device void shader_eval_surface(KernelGlobals *kg, ShaderData *sd,
 	float randb, int path_flag, ShaderContext ctx)
 {
+#ifdef __KERNEL_STATS__
+	KernelStatsShaderTimer stats_timer(kg, sd->shader, 1);
+#endif
+
 	ccl_fetch(sd, num_closure) = 0;
 	ccl_fetch(sd, randb_closure) = randb;
 
@@ -808,6 +812,35 @@ ccl_device void shader_eval_surface(KernelGlobals *kg, ShaderData *sd,
 	}
 }
 
+#ifdef __KERNEL_CPU__
+/* Surface evaluation of shading points with the same shader and path flag */
+ccl_device void shader_eval_surface_batch(KernelGlobals *kg, ShaderData **sd,
+	const float *randb, int num, int path_flag, ShaderContext ctx)
+{
+#ifdef __SVM__
+#  ifdef __OSL__
+	if(!kg->osl)
+#  endif
+	{
+#ifdef __KERNEL_STATS__
+		KernelStatsShaderTimer stats_timer(kg, sd[0]->shader, num);
+#endif
+
+		for(int i = 0; i < num; i++) {
+			sd[i]->num_closure = 0;
+			sd[i]->randb_closure = randb[i];
+		}
+
+		svm_eval_nodes_batch(kg, sd, num, SHADER_TYPE_SURFACE, path_flag);
+		return;
+	}
+#endif
+
+	for(int i = 0; i < num; i++)
+		shader_eval_surface(kg, sd[i], randb[i], path_flag, ctx);
+}
+#endif
+
 /* Background Evaluation */
 
 ccl_device float3 shader_eval_background(KernelGlobals *kg, ShaderData *sd, int path_flag, ShaderContext ctx)
@@ -1018,10 +1051,9 @@ ccl_device void shader_eval_displacement(KernelGlobals *kg, ShaderData *sd, Shad
 #endif
 }
 
-/* Transparent Shadows */
+/* Shader of the primitive hit by a ray, without setting up shader data */
 
-#ifdef __TRANSPARENT_SHADOWS__
-ccl_device bool shader_transparent_shadow(KernelGlobals *kg, Intersection *isect)
+ccl_device_inline int intersection_get_shader(KernelGlobals *kg, const Intersection *isect)
 {
 	int prim = kernel_tex_fetch(__prim_index, isect->prim);
 	int shader = 0;
@@ -1037,7 +1069,17 @@ ccl_device bool shader_transparent_shadow(KernelGlobals *kg, Intersection *isect
 		shader = __float_as_int(str.z);
 	}
 #endif
-	int flag = kernel_tex_fetch(__shader_flag, (shader & SHADER_MASK)*2);
+
+	return shader & SHADER_MASK;
+}
+
+/* Transparent Shadows */
+
+#ifdef __TRANSPARENT_SHADOWS__
+ccl_device bool shader_transparent_shadow(KernelGlobals *kg, Intersection *isect)
+{
+	int shader = intersection_get_shader(kg, isect);
+	int flag = kernel_tex_fetch(__shader_flag, shader*2);
 
 	return (flag & SD_HAS_TRANSPARENT_SHADOW) != 0;
 }
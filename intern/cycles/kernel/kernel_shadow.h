@@ -47,6 +47,11 @@ ccl_device_inline bool shadow_blocked(KernelGlobals *kg, PathState *state, Ray *
 
 	if(ray->t == 0.0f)
 		return false;
+
+#ifdef __KERNEL_STATS__
+	KernelStatsTimer stats_timer(kg, RAY_STATS_STAGE_SHADOW);
+	kernel_stats_ray(kg, RAY_STATS_SHADOW);
+#endif
 	
 	bool blocked;
 
@@ -191,6 +196,11 @@ ccl_device_inline bool shadow_blocked(KernelGlobals *kg, ccl_addr_space PathStat
 	if(ray_input->t == 0.0f)
 		return false;
 
+#ifdef __KERNEL_STATS__
+	KernelStatsTimer stats_timer(kg, RAY_STATS_STAGE_SHADOW);
+	kernel_stats_ray(kg, RAY_STATS_SHADOW);
+#endif
+
 #ifdef __SPLIT_KERNEL__
 	Ray private_ray = *ray_input;
 	Ray *ray = &private_ray;
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2011-2015 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifdef __KERNEL_STATS__
+
+#include "util_stats.h"
+#include "util_time.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Ray and Shading Statistics
+ *
+ * Counters of the render thread, only collected when the device sets
+ * kg->ray_stats, otherwise all that's left is a pointer test. */
+
+ccl_device_inline uint64_t kernel_stats_ticks(KernelGlobals *kg)
+{
+	return (kg->ray_stats)? time_ticks(): 0;
+}
+
+ccl_device_inline void kernel_stats_ray(KernelGlobals *kg, RayStatsRay type)
+{
+	if(kg->ray_stats)
+		kg->ray_stats->rays[type]++;
+}
+
+/* Camera or bounce ray of a path, traced since start_ticks */
+ccl_device_inline void kernel_stats_intersect(KernelGlobals *kg, PathState *state,
+                                              Intersection *isect, uint64_t start_ticks)
+{
+	RayStats *ray_stats = kg->ray_stats;
+
+	if(ray_stats) {
+		ray_stats->stage_ticks[RAY_STATS_STAGE_INTERSECT] += time_ticks() - start_ticks;
+		ray_stats->rays[(state->flag & PATH_RAY_CAMERA)? RAY_STATS_CAMERA: RAY_STATS_BOUNCE]++;
+		ray_stats->bvh_traversal_steps += isect->num_traversal_steps;
+	}
+}
+
+/* Time a stage until the end of the scope */
+class KernelStatsTimer {
+public:
+	KernelStatsTimer(KernelGlobals *kg, RayStatsStage stage_)
+	: ray_stats(kg->ray_stats), stage(stage_)
+	{
+		start_ticks = (ray_stats)? time_ticks(): 0;
+	}
+
+	~KernelStatsTimer()
+	{
+		if(ray_stats)
+			ray_stats->stage_ticks[stage] += time_ticks() - start_ticks;
+	}
+
+protected:
+	RayStats *ray_stats;
+	RayStatsStage stage;
+	uint64_t start_ticks;
+};
+
+/* Time surface shader evaluation of num shading points until the end of
+ * the scope, both for the stage and the shader */
+class KernelStatsShaderTimer {
+public:
+	KernelStatsShaderTimer(KernelGlobals *kg, int shader_, int num_)
+	: ray_stats(kg->ray_stats), shader(shader_), num(num_)
+	{
+		start_ticks = (ray_stats)? time_ticks(): 0;
+	}
+
+	~KernelStatsShaderTimer()
+	{
+		if(ray_stats) {
+			uint64_t ticks = time_ticks() - start_ticks;
+
+			ray_stats->stage_ticks[RAY_STATS_STAGE_SURFACE] += ticks;
+			/* two kernel shaders per scene shader, see get_shader_id() */
+			ray_stats->add_shader((shader & SHADER_MASK)/2, ticks, num);
+		}
+	}
+
+protected:
+	RayStats *ray_stats;
+	int shader;
+	int num;
+	uint64_t start_ticks;
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __KERNEL_STATS__ */
+
@@ -271,6 +271,9 @@ ccl_device int subsurface_scatter_multi_step(KernelGlobals *kg, ShaderData *sd,
 	 * will use at most BSSRDF_MAX_HITS hits, a random subset of all hits */
 	Intersection isect[BSSRDF_MAX_HITS];
 	uint num_hits = scene_intersect_subsurface(kg, &ray, isect, sd->object, lcg_state, BSSRDF_MAX_HITS);
+#ifdef __KERNEL_STATS__
+	kernel_stats_ray(kg, RAY_STATS_SUBSURFACE);
+#endif
 
 	/* evaluate bssrdf */
 	float3 eval = make_float3(0.0f, 0.0f, 0.0f);
@@ -370,6 +373,9 @@ ccl_device void subsurface_scatter_step(KernelGlobals *kg, ShaderData *sd,
 	 * found it will randomly pick one of them */
 	Intersection isect;
 	num_hits = scene_intersect_subsurface(kg, &ray, &isect, sd->object, lcg_state, 1);
+#ifdef __KERNEL_STATS__
+	kernel_stats_ray(kg, RAY_STATS_SUBSURFACE);
+#endif
 
 	/* evaluate bssrdf */
 	if(num_hits > 0) {
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2011-2015 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __KERNEL_TEXTURE_CACHE_H__
+#define __KERNEL_TEXTURE_CACHE_H__
+
+#include <OpenImageIO/texture.h>
+
+#include "util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+struct KernelGlobals;
+
+/* Texture Cache
+ *
+ * On the CPU, image textures can be read on demand from their files through
+ * an OpenImageIO texture system instead of being loaded fully into memory.
+ * Only the tiles and MIP levels that are accessed are kept, up to a memory
+ * budget, so tiled and MIP-mapped files render with a fraction of their size.
+ * The image manager fills in the slots, the kernel falls back to the regular
+ * image textures for slots without a handle. */
+
+struct TextureCacheGlobals {
+	TextureCacheGlobals()
+	{
+		ts = NULL;
+	}
+
+	struct Slot {
+		Slot()
+		{
+			handle = NULL;
+			use_alpha = true;
+		}
+
+		OIIO::TextureSystem::TextureHandle *handle;
+		OIIO::TextureOpt options;
+		bool use_alpha;
+	};
+
+	OIIO::TextureSystem *ts;
+
+	/* indexed by image slot */
+	vector<Slot> slots;
+};
+
+struct TextureCacheThreadData {
+	OIIO::TextureSystem::Perthread *thread_info;
+};
+
+void kernel_texture_cache_thread_init(KernelGlobals *kg, TextureCacheGlobals *texture_cache);
+void kernel_texture_cache_thread_free(KernelGlobals *kg);
+
+CCL_NAMESPACE_END
+
+#endif /* __KERNEL_TEXTURE_CACHE_H__ */
+
@@ -57,6 +57,8 @@ KERNEL_TEX(float4, texture_float4, __light_distribution)
 KERNEL_TEX(float4, texture_float4, __light_data)
 KERNEL_TEX(float2, texture_float2, __light_background_marginal_cdf)
 KERNEL_TEX(float2, texture_float2, __light_background_conditional_cdf)
+KERNEL_TEX(float4, texture_float4, __light_tree_nodes)
+KERNEL_TEX(uint, texture_uint, __light_tree_index)
 
 /* particles */
 KERNEL_TEX(float4, texture_float4, __particles)
@@ -66,6 +68,10 @@ KERNEL_TEX(uint4, texture_uint4, __svm_nodes)
 KERNEL_TEX(uint, texture_uint, __shader_flag)
 KERNEL_TEX(uint, texture_uint, __object_flag)
 
+/* volume majorant grids */
+KERNEL_TEX(float4, texture_float4, __volume_majorant_objects)
+KERNEL_TEX(float, texture_float, __volume_majorant)
+
 /* lookup tables */
 KERNEL_TEX(float, texture_float, __lookup_table)
 
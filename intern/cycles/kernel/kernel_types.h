@@ -37,6 +37,8 @@ CCL_NAMESPACE_BEGIN
 #define OBJECT_SIZE 		11
 #define OBJECT_VECTOR_SIZE	6
 #define LIGHT_SIZE			5
+#define LIGHT_TREE_NODE_SIZE	4
+#define VOLUME_MAJORANT_OBJECT_SIZE	2
 #define FILTER_TABLE_SIZE	256
 #define RAMP_TABLE_SIZE		256
 #define PARTICLE_SIZE 		5
@@ -74,6 +76,8 @@ CCL_NAMESPACE_BEGIN
 #define __VOLUME_SCATTER__
 #define __SHADOW_RECORD_ALL__
 #define __VOLUME_RECORD_ALL__
+#define __LIGHT_TREE__
+#define __TEXTURE_CACHE__
 #endif
 
 #ifdef __KERNEL_CUDA__
@@ -170,6 +174,11 @@ CCL_NAMESPACE_BEGIN
 #  define __KERNEL_DEBUG__
 #endif
 
+/* Ray and shading statistics, collected in per thread counters */
+#if defined(__KERNEL_DEBUG__) && defined(__KERNEL_CPU__)
+#  define __KERNEL_STATS__
+#endif
+
 /* Scene-based selective featrues compilation/ */
 #ifdef __NO_CAMERA_MOTION__
 #  undef __CAMERA_MOTION__
@@ -190,6 +199,7 @@ typedef uint RNG;
 typedef enum ShaderEvalType {
 	SHADER_EVAL_DISPLACE,
 	SHADER_EVAL_BACKGROUND,
+	SHADER_EVAL_VOLUME,
 	/* bake types */
 	SHADER_EVAL_BAKE, /* no real shade, it's used in the code to
 	                   * differentiate the type of shader eval from the above
@@ -338,6 +348,12 @@ typedef enum PassType {
 #ifdef __KERNEL_DEBUG__
 	PASS_BVH_TRAVERSAL_STEPS = (1 << 26),
 #endif
+	PASS_SAMPLE_COUNT = (1 << 27), /* per pixel number of samples, for adaptive sampling */
+	PASS_ADAPTIVE_AUX_BUFFER = (1 << 28), /* luminance second moment and convergence flag */
+#ifdef __KERNEL_DEBUG__
+	PASS_RENDER_TIME = (1 << 29),
+#endif
+	PASS_DENOISING = (1 << 30), /* normal, albedo, depth and luminance second moment */
 } PassType;
 
 #define PASS_ALL (~0)
@@ -846,9 +862,15 @@ typedef struct KernelFilm {
 	float mist_inv_depth;
 	float mist_falloff;
 
+	int pass_sample_count;
+	int pass_adaptive_aux_buffer;
+	int pass_denoising;
+	int pass_pad7;
+
 #ifdef __KERNEL_DEBUG__
 	int pass_bvh_traversal_steps;
-	int pass_pad3, pass_pad4, pass_pad5;
+	int pass_render_time;
+	int pass_pad4, pass_pad5;
 #endif
 } KernelFilm;
 
@@ -881,6 +903,15 @@ typedef struct KernelIntegrator {
 	int num_portals;
 	int portal_offset;
 
+	/* light tree, triangles and local lamps come first in the distribution */
+	int use_light_tree;
+	int light_tree_num_triangles;
+	int light_tree_num_lamps;
+	int light_tree_lamp_root;
+	int light_tree_leaf_offset;
+	int light_tree_object_offset;
+	int light_tree_prim_offset;
+
 	/* bounces */
 	int min_bounce;
 	int max_bounce;
@@ -933,8 +964,9 @@ typedef struct KernelIntegrator {
 	int volume_max_steps;
 	float volume_step_size;
 	int volume_samples;
+	int use_volume_majorant;
 
-	int pad;
+	int pad1;
 } KernelIntegrator;
 
 typedef struct KernelBVH {
@@ -945,7 +977,8 @@ typedef struct KernelBVH {
 	int have_curves;
 	int have_instancing;
 	int use_qbvh;
-	int pad1, pad2;
+	int use_qbvh_compressed;
+	int pad1;
 } KernelBVH;
 
 typedef enum CurveFlag {
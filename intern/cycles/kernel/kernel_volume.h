@@ -146,6 +146,153 @@ ccl_device int volume_stack_sampling_method(KernelGlobals *kg, VolumeStack *stac
 	return method;
 }
 
+/* Majorant Grid
+ *
+ * Coarse grid over the bounds of a volume object, storing for every cell an
+ * upper bound of the extinction coefficient. It is used for empty space
+ * skipping and as the majorant for delta and ratio tracking, see:
+ * "Residual Ratio Tracking for Estimating Attenuation in Participating Media"
+ *
+ * Each object has VOLUME_MAJORANT_OBJECT_SIZE float4 in the object table:
+ *
+ * 0: grid bounds min, offset of the cells or -1 for objects without grid
+ * 1: cells per unit length on each axis, resolution packed as 3x 8 bits
+ *
+ * Cells are visited in order along the ray with a 3D DDA. */
+
+typedef struct VolumeMajorantDDA {
+	int offset;
+	int res[3];
+	int cell[3];
+	int step[3];
+	float t_next[3];
+	float t_delta[3];
+	float t;
+	float t_end;
+} VolumeMajorantDDA;
+
+/* setup traversal for the ray segment, returns false if there is no grid to
+ * use for the volumes in the stack. the grid is only used for single objects,
+ * overlapping volumes and the world volume use ray marching */
+ccl_device bool volume_majorant_dda_init(KernelGlobals *kg, VolumeStack *stack, Ray *ray, VolumeMajorantDDA *dda)
+{
+	if(!kernel_data.integrator.use_volume_majorant)
+		return false;
+	if(stack[0].shader == SHADER_NONE || stack[1].shader != SHADER_NONE)
+		return false;
+	if(stack[0].object == OBJECT_NONE)
+		return false;
+
+	int index = stack[0].object*VOLUME_MAJORANT_OBJECT_SIZE;
+	float4 data0 = kernel_tex_fetch(__volume_majorant_objects, index + 0);
+
+	dda->offset = __float_as_int(data0.w);
+
+	if(dda->offset == -1)
+		return false;
+
+	float4 data1 = kernel_tex_fetch(__volume_majorant_objects, index + 1);
+	int res = __float_as_int(data1.w);
+
+	dda->res[0] = res & 0xff;
+	dda->res[1] = (res >> 8) & 0xff;
+	dda->res[2] = (res >> 16) & 0xff;
+
+	/* ray in grid space, distances along it are the same as in world space */
+	float3 P = (ray->P - float4_to_float3(data0))*float4_to_float3(data1);
+	float3 D = ray->D*float4_to_float3(data1);
+	float Pa[3] = {P.x, P.y, P.z};
+	float Da[3] = {D.x, D.y, D.z};
+
+	/* clip segment to grid bounds */
+	float t = 0.0f;
+	float t_end = ray->t;
+
+	for(int i = 0; i < 3; i++) {
+		if(Da[i] != 0.0f) {
+			float inv_D = 1.0f/Da[i];
+			float t0 = -Pa[i]*inv_D;
+			float t1 = (dda->res[i] - Pa[i])*inv_D;
+
+			t = max(t, min(t0, t1));
+			t_end = min(t_end, max(t0, t1));
+		}
+		else if(Pa[i] < 0.0f || Pa[i] > dda->res[i])
+			t_end = 0.0f;
+	}
+
+	dda->t = t;
+	dda->t_end = t_end;
+
+	/* first cell and distances to cell boundaries */
+	for(int i = 0; i < 3; i++) {
+		float p = Pa[i] + Da[i]*t;
+
+		dda->cell[i] = clamp((int)floorf(p), 0, dda->res[i] - 1);
+
+		if(Da[i] != 0.0f) {
+			int boundary = (Da[i] > 0.0f)? dda->cell[i] + 1: dda->cell[i];
+
+			dda->step[i] = (Da[i] > 0.0f)? 1: -1;
+			dda->t_next[i] = (boundary - Pa[i])/Da[i];
+			dda->t_delta[i] = fabsf(1.0f/Da[i]);
+		}
+		else {
+			dda->step[i] = 0;
+			dda->t_next[i] = FLT_MAX;
+			dda->t_delta[i] = FLT_MAX;
+		}
+	}
+
+	return true;
+}
+
+/* get the next cell along the ray, with the segment [t0, t1] inside it */
+ccl_device bool volume_majorant_dda_step(KernelGlobals *kg, VolumeMajorantDDA *dda, float *t0, float *t1, float *majorant)
+{
+	if(dda->t >= dda->t_end)
+		return false;
+
+	int axis = (dda->t_next[0] < dda->t_next[1])?
+		((dda->t_next[0] < dda->t_next[2])? 0: 2):
+		((dda->t_next[1] < dda->t_next[2])? 1: 2);
+	int index = dda->cell[0] + dda->res[0]*(dda->cell[1] + dda->res[1]*dda->cell[2]);
+
+	*t0 = dda->t;
+	*t1 = clamp(dda->t_next[axis], dda->t, dda->t_end);
+	*majorant = kernel_tex_fetch(__volume_majorant, dda->offset + index);
+
+	/* advance to next cell, stop when leaving the grid */
+	dda->t = *t1;
+	dda->cell[axis] += dda->step[axis];
+	dda->t_next[axis] += dda->t_delta[axis];
+
+	if(dda->cell[axis] < 0 || dda->cell[axis] >= dda->res[axis])
+		dda->t = dda->t_end;
+
+	return true;
+}
+
+/* russian roulette on the tracking weight relative to the throughput at the
+ * start of the segment, returns false if the path was terminated */
+ccl_device_inline bool kernel_volume_tracking_roulette(PathState *state, float3 *tp, float3 throughput)
+{
+	float3 abs_tp = fabs(*tp);
+	float weight = max(max(abs_tp.x, abs_tp.y), abs_tp.z);
+	float reference = max(max(throughput.x, throughput.y), throughput.z);
+
+	if(weight >= 0.1f*reference)
+		return true;
+
+	float probability = (reference > 0.0f)? weight/(0.1f*reference): 0.0f;
+
+	if(lcg_step_float(&state->rng_congruential) >= probability)
+		return false;
+
+	*tp /= probability;
+	return true;
+}
+
 /* Volume Shadows
  *
  * These functions are used to attenuate shadow rays to lights. Both absorption
@@ -217,6 +364,55 @@ ccl_device void kernel_volume_shadow_heterogeneous(KernelGlobals *kg, PathState
 	*throughput = tp;
 }
 
+/* heterogeneous volume with majorant grid: unbiased ratio tracking through
+ * the cells, skipping cells that are empty */
+ccl_device void kernel_volume_shadow_ratio_tracking(KernelGlobals *kg, PathState *state, Ray *ray, ShaderData *sd, VolumeMajorantDDA *dda, float3 *throughput)
+{
+	float3 tp = *throughput;
+	int max_steps = kernel_data.integrator.volume_max_steps;
+	int steps = 0;
+	float t0, t1, majorant;
+
+	while(volume_majorant_dda_step(kg, dda, &t0, &t1, &majorant)) {
+		if(majorant == 0.0f)
+			continue;
+
+		/* tentative collisions with the majorant as extinction */
+		float t = t0;
+
+		for(;;) {
+			t -= logf(1.0f - lcg_step_float(&state->rng_congruential))/majorant;
+
+			if(t >= t1)
+				break;
+
+			float3 sigma_t;
+
+			if(volume_shader_extinction_sample(kg, sd, state, ray->P + ray->D*t, &sigma_t))
+				tp *= make_float3(1.0f, 1.0f, 1.0f) - sigma_t/majorant;
+
+			if(!kernel_volume_tracking_roulette(state, &tp, *throughput)) {
+				*throughput = make_float3(0.0f, 0.0f, 0.0f);
+				return;
+			}
+
+			if(++steps == max_steps) {
+				/* out of steps, ray march the rest of the volume, returning
+				 * here would leave out its attenuation */
+				Ray segment = *ray;
+				segment.P = ray->P + ray->D*t;
+				segment.t = ray->t - t;
+
+				kernel_volume_shadow_heterogeneous(kg, state, &segment, sd, &tp);
+				*throughput = tp;
+				return;
+			}
+		}
+	}
+
+	*throughput = tp;
+}
+
 /* get the volume attenuation over line segment defined by ray, with the
  * assumption that there are no surfaces blocking light between the endpoints */
 ccl_device_noinline void kernel_volume_shadow(KernelGlobals *kg, PathState *state, Ray *ray, float3 *throughput)
@@ -224,7 +420,11 @@ ccl_device_noinline void kernel_volume_shadow(KernelGlobals *kg, PathState *stat
 	ShaderData sd;
 	shader_setup_from_volume(kg, &sd, ray, state->bounce, state->transparent_bounce);
 
-	if(volume_stack_is_heterogeneous(kg, state->volume_stack))
+	VolumeMajorantDDA dda;
+
+	if(volume_majorant_dda_init(kg, state->volume_stack, ray, &dda))
+		kernel_volume_shadow_ratio_tracking(kg, state, ray, &sd, &dda, throughput);
+	else if(volume_stack_is_heterogeneous(kg, state->volume_stack))
 		kernel_volume_shadow_heterogeneous(kg, state, ray, &sd, throughput);
 	else
 		kernel_volume_shadow_homogeneous(kg, state, ray, &sd, throughput);
@@ -555,6 +755,103 @@ ccl_device VolumeIntegrateResult kernel_volume_integrate_heterogeneous_distance(
 	return VOLUME_PATH_ATTENUATED;
 }
 
+/* heterogeneous volume with majorant grid: weighted delta tracking through
+ * the cells, skipping cells that are empty. at every tentative collision we
+ * pick between scattering and a null collision, absorption is accounted for
+ * in the weights. emission is accumulated at every tentative collision. */
+ccl_device VolumeIntegrateResult kernel_volume_integrate_delta_tracking(KernelGlobals *kg,
+	PathState *state, Ray *ray, ShaderData *sd, PathRadiance *L, float3 *throughput,
+	RNG *rng, VolumeMajorantDDA *dda)
+{
+	float3 tp = *throughput;
+	int max_steps = kernel_data.integrator.volume_max_steps;
+	int steps = 0;
+	float t0, t1, majorant;
+
+	/* random number for picking the phase closure on scatter */
+	sd->randb_closure = path_state_rng_1D_for_decision(kg, rng, state, PRNG_PHASE);
+
+	/* first free flight uses the stratified sample */
+	float xi = path_state_rng_1D_for_decision(kg, rng, state, PRNG_SCATTER_DISTANCE);
+
+	while(volume_majorant_dda_step(kg, dda, &t0, &t1, &majorant)) {
+		if(majorant == 0.0f)
+			continue;
+
+		float t = t0;
+
+		for(;;) {
+			t -= logf(1.0f - xi)/majorant;
+			xi = lcg_step_float(&state->rng_congruential);
+
+			if(t >= t1)
+				break;
+
+			float3 P = ray->P + ray->D*t;
+			VolumeShaderCoefficients coeff;
+
+			if(volume_shader_sample(kg, sd, state, P, &coeff)) {
+				int closure_flag = sd->flag;
+
+				/* emission, weighted by the tentative collision density */
+				if(L && (closure_flag & SD_EMISSION))
+					path_radiance_accum_emission(L, tp, coeff.emission/majorant, state->bounce);
+
+				float3 sigma_t = coeff.sigma_a + coeff.sigma_s;
+				float3 sigma_n = make_float3(majorant, majorant, majorant) - sigma_t;
+				float scatter_weight = 0.0f;
+
+#ifdef __VOLUME_SCATTER__
+				if(closure_flag & SD_SCATTER)
+					scatter_weight = average(coeff.sigma_s);
+#endif
+
+				float null_weight = average(fabs(sigma_n));
+				float total_weight = scatter_weight + null_weight;
+
+				/* pure absorption at the majorant, path ends here */
+				if(total_weight == 0.0f) {
+					*throughput = make_float3(0.0f, 0.0f, 0.0f);
+					return VOLUME_PATH_ATTENUATED;
+				}
+
+				float scatter_probability = scatter_weight/total_weight;
+
+				if(lcg_step_float(&state->rng_congruential) < scatter_probability) {
+					/* real collision, scatter to new direction */
+					sd->P = P;
+					*throughput = tp*coeff.sigma_s/(majorant*scatter_probability);
+
+					return VOLUME_PATH_SCATTERED;
+				}
+
+				/* null collision, continue */
+				tp *= sigma_n/(majorant*(1.0f - scatter_probability));
+			}
+
+			if(!kernel_volume_tracking_roulette(state, &tp, *throughput)) {
+				*throughput = make_float3(0.0f, 0.0f, 0.0f);
+				return VOLUME_PATH_ATTENUATED;
+			}
+
+			if(++steps == max_steps) {
+				/* out of steps, the rest of the volume is integrated by ray
+				 * marching, returning here would leave out its attenuation */
+				Ray segment = *ray;
+				segment.P = ray->P + ray->D*t;
+				segment.t = ray->t - t;
+
+				*throughput = tp;
+				return kernel_volume_integrate_heterogeneous_distance(kg, state, &segment, sd, L, throughput, rng);
+			}
+		}
+	}
+
+	*throughput = tp;
+
+	return VOLUME_PATH_ATTENUATED;
+}
+
 /* get the volume attenuation and emission over line segment defined by
  * ray, with the assumption that there are no surfaces blocking light
  * between the endpoints. distance sampling is used to decide if we will
@@ -562,6 +859,11 @@ ccl_device VolumeIntegrateResult kernel_volume_integrate_heterogeneous_distance(
 ccl_device_noinline VolumeIntegrateResult kernel_volume_integrate(KernelGlobals *kg,
 	PathState *state, ShaderData *sd, Ray *ray, PathRadiance *L, float3 *throughput, RNG *rng, bool heterogeneous)
 {
+#ifdef __KERNEL_STATS__
+	KernelStatsTimer stats_timer(kg, RAY_STATS_STAGE_VOLUME);
+	kernel_stats_ray(kg, RAY_STATS_VOLUME);
+#endif
+
 	/* workaround to fix correlation bug in T38710, can find better solution
 	 * in random number generator later, for now this is done here to not impact
 	 * performance of rendering without volumes */
@@ -569,7 +871,11 @@ ccl_device_noinline VolumeIntegrateResult kernel_volume_integrate(KernelGlobals
 
 	shader_setup_from_volume(kg, sd, ray, state->bounce, state->transparent_bounce);
 
-	if(heterogeneous)
+	VolumeMajorantDDA dda;
+
+	if(volume_majorant_dda_init(kg, state->volume_stack, ray, &dda))
+		return kernel_volume_integrate_delta_tracking(kg, state, ray, sd, L, throughput, &tmp_rng, &dda);
+	else if(heterogeneous)
 		return kernel_volume_integrate_heterogeneous_distance(kg, state, ray, sd, L, throughput, &tmp_rng);
 	else
 		return kernel_volume_integrate_homogeneous(kg, state, ray, sd, L, throughput, &tmp_rng, true);
@@ -616,6 +922,11 @@ typedef struct VolumeSegment {
 ccl_device void kernel_volume_decoupled_record(KernelGlobals *kg, PathState *state,
 	Ray *ray, ShaderData *sd, VolumeSegment *segment, bool heterogeneous)
 {
+#ifdef __KERNEL_STATS__
+	KernelStatsTimer stats_timer(kg, RAY_STATS_STAGE_VOLUME);
+	kernel_stats_ray(kg, RAY_STATS_VOLUME);
+#endif
+
 	const float tp_eps = 1e-6f; /* todo: this is likely not the right value */
 
 	/* prepare for volume stepping */
@@ -758,6 +1069,10 @@ ccl_device VolumeIntegrateResult kernel_volume_decoupled_scatter(
 	float3 *throughput, float rphase, float rscatter,
 	const VolumeSegment *segment, const float3 *light_P, bool probalistic_scatter)
 {
+#ifdef __KERNEL_STATS__
+	KernelStatsTimer stats_timer(kg, RAY_STATS_STAGE_VOLUME);
+#endif
+
 	kernel_assert(segment->closure_flag & SD_SCATTER);
 
 	/* pick random color channel, we use the Veach one-sample
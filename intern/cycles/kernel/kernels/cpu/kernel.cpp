@@ -23,6 +23,7 @@
 #include "kernel_globals.h"
 #include "kernel_film.h"
 #include "kernel_path.h"
+#include "kernel_path_stream.h"
 #include "kernel_bake.h"
 
 CCL_NAMESPACE_BEGIN
@@ -37,8 +38,28 @@ void kernel_const_copy(KernelGlobals *kg, const char *name, void *host, size_t s
 		assert(0);
 }
 
+template<typename T>
+static void kernel_tex_image_set(texture_image<T> *tex, T *data, size_t width, size_t height, size_t depth, InterpolationType interpolation)
+{
+	tex->data = data;
+	tex->dimensions_set(width, height, depth);
+	tex->interpolation = interpolation;
+}
+
+static KernelCompactImages *kernel_compact_images(KernelGlobals *kg)
+{
+	if(!kg->compact_images) {
+		kg->compact_images = new KernelCompactImages();
+		memset(kg->compact_images, 0, sizeof(KernelCompactImages));
+	}
+
+	return kg->compact_images;
+}
+
 void kernel_tex_copy(KernelGlobals *kg, const char *name, device_ptr mem, size_t width, size_t height, size_t depth, InterpolationType interpolation)
 {
+	KernelCompactImages *compact = kg->compact_images;
+
 	if(0) {
 	}
 
@@ -50,40 +71,69 @@ void kernel_tex_copy(KernelGlobals *kg, const char *name, device_ptr mem, size_t
 #define KERNEL_IMAGE_TEX(type, ttype, tname)
 #include "kernel_textures.h"
 
-	else if(strstr(name, "__tex_image_float")) {
-		texture_image_float4 *tex = NULL;
-		int id = atoi(name + strlen("__tex_image_float_"));
-		int array_index = id;
+	/* an image slot only has data in one of its storage formats, the kernel
+	 * picks the one that is set, so clear the others of the slot */
+	else if(strstr(name, "__tex_image_half4")) {
+		int id = atoi(name + strlen("__tex_image_half4_"));
 
-		if(array_index >= 0 && array_index < MAX_FLOAT_IMAGES) {
-			tex = &kg->texture_float_images[array_index];
+		if(id >= 0 && id < MAX_FLOAT_IMAGES) {
+			compact = kernel_compact_images(kg);
+			kernel_tex_image_set(&compact->texture_half_images[id], (half4*)mem, width, height, depth, interpolation);
+			kg->texture_float_images[id].data = NULL;
+			compact->texture_float1_images[id].data = NULL;
+		}
+	}
+	else if(strstr(name, "__tex_image_float1")) {
+		int id = atoi(name + strlen("__tex_image_float1_"));
+
+		if(id >= 0 && id < MAX_FLOAT_IMAGES) {
+			compact = kernel_compact_images(kg);
+			kernel_tex_image_set(&compact->texture_float1_images[id], (float*)mem, width, height, depth, interpolation);
+			kg->texture_float_images[id].data = NULL;
+			compact->texture_half_images[id].data = NULL;
 		}
+	}
+	else if(strstr(name, "__tex_image_byte1")) {
+		int id = atoi(name + strlen("__tex_image_byte1_"));
+		int array_index = id - MAX_FLOAT_IMAGES;
 
-		if(tex) {
-			tex->data = (float4*)mem;
-			tex->dimensions_set(width, height, depth);
-			tex->interpolation = interpolation;
+		if(array_index >= 0 && array_index < MAX_BYTE_IMAGES) {
+			compact = kernel_compact_images(kg);
+			kernel_tex_image_set(&compact->texture_byte1_images[array_index], (uchar*)mem, width, height, depth, interpolation);
+			kg->texture_byte_images[array_index].data = NULL;
+		}
+	}
+	else if(strstr(name, "__tex_image_float")) {
+		int id = atoi(name + strlen("__tex_image_float_"));
+
+		if(id >= 0 && id < MAX_FLOAT_IMAGES) {
+			kernel_tex_image_set(&kg->texture_float_images[id], (float4*)mem, width, height, depth, interpolation);
+			if(compact) {
+				compact->texture_half_images[id].data = NULL;
+				compact->texture_float1_images[id].data = NULL;
+			}
 		}
 	}
 	else if(strstr(name, "__tex_image")) {
-		texture_image_uchar4 *tex = NULL;
 		int id = atoi(name + strlen("__tex_image_"));
 		int array_index = id - MAX_FLOAT_IMAGES;
 
 		if(array_index >= 0 && array_index < MAX_BYTE_IMAGES) {
-			tex = &kg->texture_byte_images[array_index];
-		}
-
-		if(tex) {
-			tex->data = (uchar4*)mem;
-			tex->dimensions_set(width, height, depth);
-			tex->interpolation = interpolation;
+			kernel_tex_image_set(&kg->texture_byte_images[array_index], (uchar4*)mem, width, height, depth, interpolation);
+			if(compact)
+				compact->texture_byte1_images[array_index].data = NULL;
 		}
 	}
 	else
 		assert(0);
 }
 
+void kernel_tex_free(KernelGlobals *kg)
+{
+	delete kg->compact_images;
+	kg->compact_images = NULL;
+}
+
 /* On x86-64, we can assume SSE2, so avoid the extra kernel and compile this one with SSE2 intrinsics */
 #if defined(__x86_64__) || defined(_M_X64)
 #define __KERNEL_SSE2__
@@ -106,6 +156,18 @@ void kernel_cpu_path_trace(KernelGlobals *kg, float *buffer, unsigned int *rng_s
 		kernel_path_trace(kg, buffer, rng_state, sample, x, y, offset, stride);
 }
 
+void kernel_cpu_path_trace_stream(KernelGlobals *kg, float *buffer, unsigned int *rng_state, int sample, const int *x, int num, int y, int offset, int stride)
+{
+#ifdef __BRANCHED_PATH__
+	if(kernel_data.integrator.branched) {
+		for(int i = 0; i < num; i++)
+			kernel_branched_path_trace(kg, buffer, rng_state, sample, x[i], y, offset, stride);
+	}
+	else
+#endif
+		kernel_path_trace_stream(kg, buffer, rng_state, sample, x, num, y, offset, stride);
+}
+
 /* Film */
 
 void kernel_cpu_convert_to_byte(KernelGlobals *kg, uchar4 *rgba, float *buffer, float sample_scale, int x, int y, int offset, int stride)
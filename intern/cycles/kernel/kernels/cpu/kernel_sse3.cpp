@@ -36,6 +36,7 @@
 #include "kernel_globals.h"
 #include "kernel_film.h"
 #include "kernel_path.h"
+#include "kernel_path_stream.h"
 #include "kernel_bake.h"
 
 CCL_NAMESPACE_BEGIN
@@ -52,6 +53,18 @@ void kernel_cpu_sse3_path_trace(KernelGlobals *kg, float *buffer, unsigned int *
 		kernel_path_trace(kg, buffer, rng_state, sample, x, y, offset, stride);
 }
 
+void kernel_cpu_sse3_path_trace_stream(KernelGlobals *kg, float *buffer, unsigned int *rng_state, int sample, const int *x, int num, int y, int offset, int stride)
+{
+#ifdef __BRANCHED_PATH__
+	if(kernel_data.integrator.branched) {
+		for(int i = 0; i < num; i++)
+			kernel_branched_path_trace(kg, buffer, rng_state, sample, x[i], y, offset, stride);
+	}
+	else
+#endif
+		kernel_path_trace_stream(kg, buffer, rng_state, sample, x, num, y, offset, stride);
+}
+
 /* Film */
 
 void kernel_cpu_sse3_convert_to_byte(KernelGlobals *kg, uchar4 *rgba, float *buffer, float sample_scale, int x, int y, int offset, int stride)
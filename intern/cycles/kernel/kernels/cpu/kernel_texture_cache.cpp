@@ -0,0 +1,103 @@
+/*
+ * Copyright 2011-2015 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* CPU texture cache lookups, compiled once and shared by all kernel
+ * instruction sets */
+
+#include "kernel_compat_cpu.h"
+#include "kernel_math.h"
+#include "kernel_types.h"
+#include "kernel_globals.h"
+#include "kernel_texture_cache.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Threads */
+
+void kernel_texture_cache_thread_init(KernelGlobals *kg, TextureCacheGlobals *texture_cache)
+{
+	/* no images read through the cache? */
+	if(!texture_cache->ts) {
+		kg->texture_cache = NULL;
+		kg->texture_cache_tdata = NULL;
+		return;
+	}
+
+	TextureCacheThreadData *tdata = new TextureCacheThreadData();
+	tdata->thread_info = texture_cache->ts->get_perthread_info();
+
+	kg->texture_cache = texture_cache;
+	kg->texture_cache_tdata = tdata;
+}
+
+void kernel_texture_cache_thread_free(KernelGlobals *kg)
+{
+	if(!kg->texture_cache)
+		return;
+
+	delete kg->texture_cache_tdata;
+
+	kg->texture_cache = NULL;
+	kg->texture_cache_tdata = NULL;
+}
+
+/* Lookup */
+
+bool kernel_texture_cache_lookup(KernelGlobals *kg, int slot,
+                                 float x, float y, float2 dx, float2 dy,
+                                 float4 *result)
+{
+	TextureCacheGlobals *texture_cache = kg->texture_cache;
+
+	if(!texture_cache || slot >= (int)texture_cache->slots.size())
+		return false;
+
+	const TextureCacheGlobals::Slot& tex = texture_cache->slots[slot];
+
+	if(!tex.handle)
+		return false;
+
+	OIIO::TextureSystem *ts = texture_cache->ts;
+	OIIO::TextureSystem::Perthread *thread_info = kg->texture_cache_tdata->thread_info;
+	OIIO::TextureOpt options = tex.options;
+	float rgba[4];
+
+	/* image rows are stored bottom to top, texture lookups go top to bottom */
+#if OIIO_VERSION < 10500
+	bool status = ts->texture(tex.handle, thread_info, options,
+	                          x, 1.0f - y, dx.x, -dx.y, dy.x, -dy.y,
+	                          rgba);
+#else
+	bool status = ts->texture(tex.handle, thread_info, options,
+	                          x, 1.0f - y, dx.x, -dx.y, dy.x, -dy.y,
+	                          4, rgba);
+#endif
+
+	if(!status) {
+		/* same pink as images that failed to load */
+		*result = make_float4(1.0f, 0.0f, 1.0f, 1.0f);
+		return true;
+	}
+
+	if(!tex.use_alpha)
+		rgba[3] = 1.0f;
+
+	*result = make_float4(rgba[0], rgba[1], rgba[2], rgba[3]);
+	return true;
+}
+
+CCL_NAMESPACE_END
+
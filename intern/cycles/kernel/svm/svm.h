@@ -185,277 +185,349 @@ CCL_NAMESPACE_BEGIN
 #define NODES_GROUP(group) ((group) <= __NODES_MAX_GROUP__)
 #define NODES_FEATURE(feature) ((__NODES_FEATURES__ & (feature)) != 0)
 
-/* Main Interpreter Loop */
-ccl_device_noinline void svm_eval_nodes(KernelGlobals *kg, ShaderData *sd, ShaderType type, int path_flag)
+/* Evaluate a single node, returns false when the end of the shader is reached */
+ccl_device_inline bool svm_eval_node(KernelGlobals *kg, ShaderData *sd, float *stack,
+	ShaderType type, int path_flag, uint4 node, int *node_offset)
 {
-	float stack[SVM_STACK_SIZE];
-	int offset = ccl_fetch(sd, shader) & SHADER_MASK;
+	int offset = *node_offset;
 
-	while(1) {
-		uint4 node = read_node(kg, &offset);
-
-		switch(node.x) {
+	switch(node.x) {
 #if NODES_GROUP(NODE_GROUP_LEVEL_0)
-			case NODE_SHADER_JUMP: {
-				if(type == SHADER_TYPE_SURFACE) offset = node.y;
-				else if(type == SHADER_TYPE_VOLUME) offset = node.z;
-				else if(type == SHADER_TYPE_DISPLACEMENT) offset = node.w;
-				else return;
-				break;
-			}
-			case NODE_CLOSURE_BSDF:
-				svm_node_closure_bsdf(kg, sd, stack, node, path_flag, &offset);
-				break;
-			case NODE_CLOSURE_EMISSION:
-				svm_node_closure_emission(sd, stack, node);
-				break;
-			case NODE_CLOSURE_BACKGROUND:
-				svm_node_closure_background(sd, stack, node);
-				break;
-			case NODE_CLOSURE_SET_WEIGHT:
-				svm_node_closure_set_weight(sd, node.y, node.z, node.w);
-				break;
-			case NODE_CLOSURE_WEIGHT:
-				svm_node_closure_weight(sd, stack, node.y);
-				break;
-			case NODE_EMISSION_WEIGHT:
-				svm_node_emission_weight(kg, sd, stack, node);
-				break;
-			case NODE_MIX_CLOSURE:
-				svm_node_mix_closure(sd, stack, node);
-				break;
-			case NODE_JUMP_IF_ZERO:
-				if(stack_load_float(stack, node.z) == 0.0f)
-					offset += node.y;
-				break;
-			case NODE_JUMP_IF_ONE:
-				if(stack_load_float(stack, node.z) == 1.0f)
-					offset += node.y;
-				break;
-			case NODE_GEOMETRY:
-				svm_node_geometry(kg, sd, stack, node.y, node.z);
-				break;
-			case NODE_CONVERT:
-				svm_node_convert(sd, stack, node.y, node.z, node.w);
-				break;
-			case NODE_TEX_COORD:
-				svm_node_tex_coord(kg, sd, path_flag, stack, node, &offset);
-				break;
-			case NODE_VALUE_F:
-				svm_node_value_f(kg, sd, stack, node.y, node.z);
-				break;
-			case NODE_VALUE_V:
-				svm_node_value_v(kg, sd, stack, node.y, &offset);
-				break;
-			case NODE_ATTR:
-				svm_node_attr(kg, sd, stack, node);
-				break;
+		case NODE_SHADER_JUMP: {
+			if(type == SHADER_TYPE_SURFACE) offset = node.y;
+			else if(type == SHADER_TYPE_VOLUME) offset = node.z;
+			else if(type == SHADER_TYPE_DISPLACEMENT) offset = node.w;
+			else return false;
+			break;
+		}
+		case NODE_CLOSURE_BSDF:
+			svm_node_closure_bsdf(kg, sd, stack, node, path_flag, &offset);
+			break;
+		case NODE_CLOSURE_EMISSION:
+			svm_node_closure_emission(sd, stack, node);
+			break;
+		case NODE_CLOSURE_BACKGROUND:
+			svm_node_closure_background(sd, stack, node);
+			break;
+		case NODE_CLOSURE_SET_WEIGHT:
+			svm_node_closure_set_weight(sd, node.y, node.z, node.w);
+			break;
+		case NODE_CLOSURE_WEIGHT:
+			svm_node_closure_weight(sd, stack, node.y);
+			break;
+		case NODE_EMISSION_WEIGHT:
+			svm_node_emission_weight(kg, sd, stack, node);
+			break;
+		case NODE_MIX_CLOSURE:
+			svm_node_mix_closure(sd, stack, node);
+			break;
+		case NODE_JUMP_IF_ZERO:
+			if(stack_load_float(stack, node.z) == 0.0f)
+				offset += node.y;
+			break;
+		case NODE_JUMP_IF_ONE:
+			if(stack_load_float(stack, node.z) == 1.0f)
+				offset += node.y;
+			break;
+		case NODE_GEOMETRY:
+			svm_node_geometry(kg, sd, stack, node.y, node.z);
+			break;
+		case NODE_CONVERT:
+			svm_node_convert(sd, stack, node.y, node.z, node.w);
+			break;
+		case NODE_TEX_COORD:
+			svm_node_tex_coord(kg, sd, path_flag, stack, node, &offset);
+			break;
+		case NODE_VALUE_F:
+			svm_node_value_f(kg, sd, stack, node.y, node.z);
+			break;
+		case NODE_VALUE_V:
+			svm_node_value_v(kg, sd, stack, node.y, &offset);
+			break;
+		case NODE_ATTR:
+			svm_node_attr(kg, sd, stack, node);
+			break;
 #  if NODES_FEATURE(NODE_FEATURE_BUMP)
-			case NODE_GEOMETRY_BUMP_DX:
-				svm_node_geometry_bump_dx(kg, sd, stack, node.y, node.z);
-				break;
-			case NODE_GEOMETRY_BUMP_DY:
-				svm_node_geometry_bump_dy(kg, sd, stack, node.y, node.z);
-				break;
-			case NODE_SET_DISPLACEMENT:
-				svm_node_set_displacement(sd, stack, node.y);
-				break;
+		case NODE_GEOMETRY_BUMP_DX:
+			svm_node_geometry_bump_dx(kg, sd, stack, node.y, node.z);
+			break;
+		case NODE_GEOMETRY_BUMP_DY:
+			svm_node_geometry_bump_dy(kg, sd, stack, node.y, node.z);
+			break;
+		case NODE_SET_DISPLACEMENT:
+			svm_node_set_displacement(sd, stack, node.y);
+			break;
 #  endif  /* NODES_FEATURE(NODE_FEATURE_BUMP) */
 #  ifdef __TEXTURES__
-			case NODE_TEX_IMAGE:
-				svm_node_tex_image(kg, sd, stack, node);
-				break;
-			case NODE_TEX_IMAGE_BOX:
-				svm_node_tex_image_box(kg, sd, stack, node);
-				break;
-			case NODE_TEX_NOISE:
-				svm_node_tex_noise(kg, sd, stack, node, &offset);
-				break;
+		case NODE_TEX_IMAGE:
+			svm_node_tex_image(kg, sd, stack, node);
+			break;
+		case NODE_TEX_IMAGE_BOX:
+			svm_node_tex_image_box(kg, sd, stack, node);
+			break;
+		case NODE_TEX_NOISE:
+			svm_node_tex_noise(kg, sd, stack, node, &offset);
+			break;
 #  endif  /* __TEXTURES__ */
 #  ifdef __EXTRA_NODES__
 #    if NODES_FEATURE(NODE_FEATURE_BUMP)
-			case NODE_SET_BUMP:
-				svm_node_set_bump(kg, sd, stack, node);
-				break;
-			case NODE_ATTR_BUMP_DX:
-				svm_node_attr_bump_dx(kg, sd, stack, node);
-				break;
-			case NODE_ATTR_BUMP_DY:
-				svm_node_attr_bump_dy(kg, sd, stack, node);
-				break;
-			case NODE_TEX_COORD_BUMP_DX:
-				svm_node_tex_coord_bump_dx(kg, sd, path_flag, stack, node, &offset);
-				break;
-			case NODE_TEX_COORD_BUMP_DY:
-				svm_node_tex_coord_bump_dy(kg, sd, path_flag, stack, node, &offset);
-				break;
-			case NODE_CLOSURE_SET_NORMAL:
-				svm_node_set_normal(kg, sd, stack, node.y, node.z);
-				break;
+		case NODE_SET_BUMP:
+			svm_node_set_bump(kg, sd, stack, node);
+			break;
+		case NODE_ATTR_BUMP_DX:
+			svm_node_attr_bump_dx(kg, sd, stack, node);
+			break;
+		case NODE_ATTR_BUMP_DY:
+			svm_node_attr_bump_dy(kg, sd, stack, node);
+			break;
+		case NODE_TEX_COORD_BUMP_DX:
+			svm_node_tex_coord_bump_dx(kg, sd, path_flag, stack, node, &offset);
+			break;
+		case NODE_TEX_COORD_BUMP_DY:
+			svm_node_tex_coord_bump_dy(kg, sd, path_flag, stack, node, &offset);
+			break;
+		case NODE_CLOSURE_SET_NORMAL:
+			svm_node_set_normal(kg, sd, stack, node.y, node.z);
+			break;
 #    endif  /* NODES_FEATURE(NODE_FEATURE_BUMP) */
-			case NODE_HSV:
-				svm_node_hsv(kg, sd, stack, node.y, node.z, node.w, &offset);
-				break;
+		case NODE_HSV:
+			svm_node_hsv(kg, sd, stack, node.y, node.z, node.w, &offset);
+			break;
 #  endif  /* __EXTRA_NODES__ */
 #endif  /* NODES_GROUP(NODE_GROUP_LEVEL_0) */
 
 #if NODES_GROUP(NODE_GROUP_LEVEL_1)
-			case NODE_CLOSURE_HOLDOUT:
-				svm_node_closure_holdout(sd, stack, node);
-				break;
-			case NODE_CLOSURE_AMBIENT_OCCLUSION:
-				svm_node_closure_ambient_occlusion(sd, stack, node);
-				break;
-			case NODE_FRESNEL:
-				svm_node_fresnel(sd, stack, node.y, node.z, node.w);
-				break;
-			case NODE_LAYER_WEIGHT:
-				svm_node_layer_weight(sd, stack, node);
-				break;
+		case NODE_CLOSURE_HOLDOUT:
+			svm_node_closure_holdout(sd, stack, node);
+			break;
+		case NODE_CLOSURE_AMBIENT_OCCLUSION:
+			svm_node_closure_ambient_occlusion(sd, stack, node);
+			break;
+		case NODE_FRESNEL:
+			svm_node_fresnel(sd, stack, node.y, node.z, node.w);
+			break;
+		case NODE_LAYER_WEIGHT:
+			svm_node_layer_weight(sd, stack, node);
+			break;
 #  if NODES_FEATURE(NODE_FEATURE_VOLUME)
-			case NODE_CLOSURE_VOLUME:
-				svm_node_closure_volume(kg, sd, stack, node, path_flag);
-				break;
+		case NODE_CLOSURE_VOLUME:
+			svm_node_closure_volume(kg, sd, stack, node, path_flag);
+			break;
 #  endif  /* NODES_FEATURE(NODE_FEATURE_VOLUME) */
 #  ifdef __EXTRA_NODES__
-			case NODE_MATH:
-				svm_node_math(kg, sd, stack, node.y, node.z, node.w, &offset);
-				break;
-			case NODE_VECTOR_MATH:
-				svm_node_vector_math(kg, sd, stack, node.y, node.z, node.w, &offset);
-				break;
-			case NODE_RGB_RAMP:
-				svm_node_rgb_ramp(kg, sd, stack, node, &offset);
-				break;
-			case NODE_GAMMA:
-				svm_node_gamma(sd, stack, node.y, node.z, node.w);
-				break;
-			case NODE_BRIGHTCONTRAST:
-				svm_node_brightness(sd, stack, node.y, node.z, node.w);
-				break;
-			case NODE_LIGHT_PATH:
-				svm_node_light_path(sd, stack, node.y, node.z, path_flag);
-				break;
-			case NODE_OBJECT_INFO:
-				svm_node_object_info(kg, sd, stack, node.y, node.z);
-				break;
-			case NODE_PARTICLE_INFO:
-				svm_node_particle_info(kg, sd, stack, node.y, node.z);
-				break;
+		case NODE_MATH:
+			svm_node_math(kg, sd, stack, node.y, node.z, node.w, &offset);
+			break;
+		case NODE_VECTOR_MATH:
+			svm_node_vector_math(kg, sd, stack, node.y, node.z, node.w, &offset);
+			break;
+		case NODE_RGB_RAMP:
+			svm_node_rgb_ramp(kg, sd, stack, node, &offset);
+			break;
+		case NODE_GAMMA:
+			svm_node_gamma(sd, stack, node.y, node.z, node.w);
+			break;
+		case NODE_BRIGHTCONTRAST:
+			svm_node_brightness(sd, stack, node.y, node.z, node.w);
+			break;
+		case NODE_LIGHT_PATH:
+			svm_node_light_path(sd, stack, node.y, node.z, path_flag);
+			break;
+		case NODE_OBJECT_INFO:
+			svm_node_object_info(kg, sd, stack, node.y, node.z);
+			break;
+		case NODE_PARTICLE_INFO:
+			svm_node_particle_info(kg, sd, stack, node.y, node.z);
+			break;
 #    ifdef __HAIR__
 #      if NODES_FEATURE(NODE_FEATURE_HAIR)
-			case NODE_HAIR_INFO:
-				svm_node_hair_info(kg, sd, stack, node.y, node.z);
-				break;
+		case NODE_HAIR_INFO:
+			svm_node_hair_info(kg, sd, stack, node.y, node.z);
+			break;
 #      endif  /* NODES_FEATURE(NODE_FEATURE_HAIR) */
 #    endif  /* __HAIR__ */
 #  endif  /* __EXTRA_NODES__ */
 #endif  /* NODES_GROUP(NODE_GROUP_LEVEL_1) */
 
 #if NODES_GROUP(NODE_GROUP_LEVEL_2)
-			case NODE_MAPPING:
-				svm_node_mapping(kg, sd, stack, node.y, node.z, &offset);
-				break;
-			case NODE_MIN_MAX:
-				svm_node_min_max(kg, sd, stack, node.y, node.z, &offset);
-				break;
-			case NODE_CAMERA:
-				svm_node_camera(kg, sd, stack, node.y, node.z, node.w);
-				break;
+		case NODE_MAPPING:
+			svm_node_mapping(kg, sd, stack, node.y, node.z, &offset);
+			break;
+		case NODE_MIN_MAX:
+			svm_node_min_max(kg, sd, stack, node.y, node.z, &offset);
+			break;
+		case NODE_CAMERA:
+			svm_node_camera(kg, sd, stack, node.y, node.z, node.w);
+			break;
 #  ifdef __TEXTURES__
-			case NODE_TEX_ENVIRONMENT:
-				svm_node_tex_environment(kg, sd, stack, node);
-				break;
-			case NODE_TEX_SKY:
-				svm_node_tex_sky(kg, sd, stack, node, &offset);
-				break;
-			case NODE_TEX_GRADIENT:
-				svm_node_tex_gradient(sd, stack, node);
-				break;
-			case NODE_TEX_VORONOI:
-				svm_node_tex_voronoi(kg, sd, stack, node, &offset);
-				break;
-			case NODE_TEX_MUSGRAVE:
-				svm_node_tex_musgrave(kg, sd, stack, node, &offset);
-				break;
-			case NODE_TEX_WAVE:
-				svm_node_tex_wave(kg, sd, stack, node, &offset);
-				break;
-			case NODE_TEX_MAGIC:
-				svm_node_tex_magic(kg, sd, stack, node, &offset);
-				break;
-			case NODE_TEX_CHECKER:
-				svm_node_tex_checker(kg, sd, stack, node);
-				break;
-			case NODE_TEX_BRICK:
-				svm_node_tex_brick(kg, sd, stack, node, &offset);
-				break;
+		case NODE_TEX_ENVIRONMENT:
+			svm_node_tex_environment(kg, sd, stack, node);
+			break;
+		case NODE_TEX_SKY:
+			svm_node_tex_sky(kg, sd, stack, node, &offset);
+			break;
+		case NODE_TEX_GRADIENT:
+			svm_node_tex_gradient(sd, stack, node);
+			break;
+		case NODE_TEX_VORONOI:
+			svm_node_tex_voronoi(kg, sd, stack, node, &offset);
+			break;
+		case NODE_TEX_MUSGRAVE:
+			svm_node_tex_musgrave(kg, sd, stack, node, &offset);
+			break;
+		case NODE_TEX_WAVE:
+			svm_node_tex_wave(kg, sd, stack, node, &offset);
+			break;
+		case NODE_TEX_MAGIC:
+			svm_node_tex_magic(kg, sd, stack, node, &offset);
+			break;
+		case NODE_TEX_CHECKER:
+			svm_node_tex_checker(kg, sd, stack, node);
+			break;
+		case NODE_TEX_BRICK:
+			svm_node_tex_brick(kg, sd, stack, node, &offset);
+			break;
 #  endif  /* __TEXTURES__ */
 #  ifdef __EXTRA_NODES__
-			case NODE_NORMAL:
-				svm_node_normal(kg, sd, stack, node.y, node.z, node.w, &offset);
-				break;
-			case NODE_LIGHT_FALLOFF:
-				svm_node_light_falloff(sd, stack, node);
-				break;
+		case NODE_NORMAL:
+			svm_node_normal(kg, sd, stack, node.y, node.z, node.w, &offset);
+			break;
+		case NODE_LIGHT_FALLOFF:
+			svm_node_light_falloff(sd, stack, node);
+			break;
 #  endif  /* __EXTRA_NODES__ */
 #endif  /* NODES_GROUP(NODE_GROUP_LEVEL_2) */
 
 #if NODES_GROUP(NODE_GROUP_LEVEL_3)
-			case NODE_RGB_CURVES:
-				svm_node_rgb_curves(kg, sd, stack, node, &offset);
-				break;
-			case NODE_VECTOR_CURVES:
-				svm_node_vector_curves(kg, sd, stack, node, &offset);
-				break;
-			case NODE_TANGENT:
-				svm_node_tangent(kg, sd, stack, node);
-				break;
-			case NODE_NORMAL_MAP:
-				svm_node_normal_map(kg, sd, stack, node);
-				break;
+		case NODE_RGB_CURVES:
+			svm_node_rgb_curves(kg, sd, stack, node, &offset);
+			break;
+		case NODE_VECTOR_CURVES:
+			svm_node_vector_curves(kg, sd, stack, node, &offset);
+			break;
+		case NODE_TANGENT:
+			svm_node_tangent(kg, sd, stack, node);
+			break;
+		case NODE_NORMAL_MAP:
+			svm_node_normal_map(kg, sd, stack, node);
+			break;
 #  ifdef __EXTRA_NODES__
-			case NODE_INVERT:
-				svm_node_invert(sd, stack, node.y, node.z, node.w);
-				break;
-			case NODE_MIX:
-				svm_node_mix(kg, sd, stack, node.y, node.z, node.w, &offset);
-				break;
-			case NODE_SEPARATE_VECTOR:
-				svm_node_separate_vector(sd, stack, node.y, node.z, node.w);
-				break;
-			case NODE_COMBINE_VECTOR:
-				svm_node_combine_vector(sd, stack, node.y, node.z, node.w);
-				break;
-			case NODE_SEPARATE_HSV:
-				svm_node_separate_hsv(kg, sd, stack, node.y, node.z, node.w, &offset);
-				break;
-			case NODE_COMBINE_HSV:
-				svm_node_combine_hsv(kg, sd, stack, node.y, node.z, node.w, &offset);
-				break;
-			case NODE_VECTOR_TRANSFORM:
-				svm_node_vector_transform(kg, sd, stack, node);
-				break;
-			case NODE_WIREFRAME:
-				svm_node_wireframe(kg, sd, stack, node);
-				break;
-			case NODE_WAVELENGTH:
-				svm_node_wavelength(sd, stack, node.y, node.z);
-				break;
-			case NODE_BLACKBODY:
-				svm_node_blackbody(kg, sd, stack, node.y, node.z);
-				break;
+		case NODE_INVERT:
+			svm_node_invert(sd, stack, node.y, node.z, node.w);
+			break;
+		case NODE_MIX:
+			svm_node_mix(kg, sd, stack, node.y, node.z, node.w, &offset);
+			break;
+		case NODE_SEPARATE_VECTOR:
+			svm_node_separate_vector(sd, stack, node.y, node.z, node.w);
+			break;
+		case NODE_COMBINE_VECTOR:
+			svm_node_combine_vector(sd, stack, node.y, node.z, node.w);
+			break;
+		case NODE_SEPARATE_HSV:
+			svm_node_separate_hsv(kg, sd, stack, node.y, node.z, node.w, &offset);
+			break;
+		case NODE_COMBINE_HSV:
+			svm_node_combine_hsv(kg, sd, stack, node.y, node.z, node.w, &offset);
+			break;
+		case NODE_VECTOR_TRANSFORM:
+			svm_node_vector_transform(kg, sd, stack, node);
+			break;
+		case NODE_WIREFRAME:
+			svm_node_wireframe(kg, sd, stack, node);
+			break;
+		case NODE_WAVELENGTH:
+			svm_node_wavelength(sd, stack, node.y, node.z);
+			break;
+		case NODE_BLACKBODY:
+			svm_node_blackbody(kg, sd, stack, node.y, node.z);
+			break;
 #  endif  /* __EXTRA_NODES__ */
 #endif  /* NODES_GROUP(NODE_GROUP_LEVEL_3) */
-			case NODE_END:
-				return;
-			default:
-				kernel_assert(!"Unknown node type was passed to the SVM machine");
-				return;
+		case NODE_END:
+			return false;
+		default:
+			kernel_assert(!"Unknown node type was passed to the SVM machine");
+			return false;
+	}
+
+	*node_offset = offset;
+	return true;
+}
+
+/* Main Interpreter Loop */
+ccl_device_noinline void svm_eval_nodes(KernelGlobals *kg, ShaderData *sd, ShaderType type, int path_flag)
+{
+	float stack[SVM_STACK_SIZE];
+	int offset = ccl_fetch(sd, shader) & SHADER_MASK;
+
+	while(1) {
+		uint4 node = read_node(kg, &offset);
+
+		if(!svm_eval_node(kg, sd, stack, type, path_flag, node, &offset))
+			break;
+	}
+}
+
+#ifdef __KERNEL_CPU__
+
+/* Batched Interpreter Loop
+ *
+ * Evaluates shading points of the same shader and path flag in lockstep: each
+ * node is fetched and decoded once and then executed for all points, so the
+ * node dispatch is shared and perfectly predicted across the batch. Points
+ * only diverge on jumps taken differently, those finish one by one. */
+
+#define SVM_BATCH_SIZE 8
+
+ccl_device void svm_eval_nodes_batch(KernelGlobals *kg, ShaderData **sd, int num, ShaderType type, int path_flag)
+{
+	float stack[SVM_BATCH_SIZE][SVM_STACK_SIZE];
+	int point_offset[SVM_BATCH_SIZE];
+
+	for(int start = 0; start < num; start += SVM_BATCH_SIZE) {
+		ShaderData **batch_sd = sd + start;
+		int size = min(num - start, SVM_BATCH_SIZE);
+		int offset = ccl_fetch(batch_sd[0], shader) & SHADER_MASK;
+		bool diverged = false;
+
+		while(1) {
+			uint4 node = read_node(kg, &offset);
+
+			for(int i = 0; i < size; i++) {
+				point_offset[i] = offset;
+
+				if(!svm_eval_node(kg, batch_sd[i], stack[i], type, path_flag, node, &point_offset[i]))
+					point_offset[i] = -1;
+
+				diverged |= (point_offset[i] != point_offset[0]);
+			}
+
+			if(diverged || point_offset[0] == -1)
+				break;
+
+			offset = point_offset[0];
+		}
+
+		if(!diverged)
+			continue;
+
+		/* finish each point on its own */
+		for(int i = 0; i < size; i++) {
+			offset = point_offset[i];
+
+			while(offset != -1) {
+				uint4 node = read_node(kg, &offset);
+
+				if(!svm_eval_node(kg, batch_sd[i], stack[i], type, path_flag, node, &offset))
+					break;
+			}
 		}
 	}
 }
 
+#endif  /* __KERNEL_CPU__ */
+
 #undef NODES_GROUP
 #undef NODES_FEATURE
 
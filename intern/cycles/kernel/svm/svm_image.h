@@ -48,7 +48,7 @@ ccl_device_inline float svm_image_texture_frac(float x, int *ix)
 	return x - (float)i;
 }
 
-ccl_device float4 svm_image_texture(KernelGlobals *kg, int id, float x, float y, uint srgb, uint use_alpha)
+ccl_device float4 svm_image_texture(KernelGlobals *kg, int id, float x, float y, float2 dx, float2 dy, uint srgb, uint use_alpha)
 {
 	/* first slots are used by float textures, which are not supported here */
 	if(id < TEX_NUM_FLOAT_IMAGES)
@@ -130,16 +130,19 @@ ccl_device float4 svm_image_texture(KernelGlobals *kg, int id, float x, float y,
 
 #else
 
-ccl_device float4 svm_image_texture(KernelGlobals *kg, int id, float x, float y, uint srgb, uint use_alpha)
+ccl_device float4 svm_image_texture(KernelGlobals *kg, int id, float x, float y, float2 dx, float2 dy, uint srgb, uint use_alpha)
 {
 #ifdef __KERNEL_CPU__
 #ifdef __KERNEL_SSE2__
 	ssef r_ssef;
 	float4 &r = (float4 &)r_ssef;
-	r = kernel_tex_image_interp(id, x, y);
 #else
-	float4 r = kernel_tex_image_interp(id, x, y);
+	float4 r;
+#endif
+#ifdef __TEXTURE_CACHE__
+	if(!kernel_texture_cache_lookup(kg, id, x, y, dx, dy, &r))
 #endif
+		r = kernel_tex_image_interp(id, x, y);
 #else
 	float4 r;
 
@@ -360,6 +363,31 @@ ccl_device_inline float3 texco_remap_square(float3 co)
 	return (co - make_float3(0.5f, 0.5f, 0.5f)) * 2.0f;
 }
 
+/* Differentials of the image coordinate, used by the texture cache to pick
+ * a MIP level. The node does not know how its coordinate was computed, so the
+ * footprint is estimated from the default UV map. */
+ccl_device void svm_image_texture_uv_differentials(KernelGlobals *kg, ShaderData *sd, float2 *dx, float2 *dy)
+{
+	*dx = make_float2(0.0f, 0.0f);
+	*dy = make_float2(0.0f, 0.0f);
+
+#ifdef __TEXTURE_CACHE__
+	if(!kg->texture_cache)
+		return;
+
+	AttributeElement elem;
+	int offset = find_attribute(kg, sd, ATTR_STD_UV, &elem);
+
+	if(offset != ATTR_STD_NOT_FOUND) {
+		float3 uv_dx, uv_dy;
+		primitive_attribute_float3(kg, sd, elem, offset, &uv_dx, &uv_dy);
+
+		*dx = make_float2(uv_dx.x, uv_dx.y);
+		*dy = make_float2(uv_dy.x, uv_dy.y);
+	}
+#endif
+}
+
 ccl_device void svm_node_tex_image(KernelGlobals *kg, ShaderData *sd, float *stack, uint4 node)
 {
 	uint id = node.y;
@@ -368,20 +396,23 @@ ccl_device void svm_node_tex_image(KernelGlobals *kg, ShaderData *sd, float *sta
 	decode_node_uchar4(node.z, &co_offset, &out_offset, &alpha_offset, &srgb);
 
 	float3 co = stack_load_float3(stack, co_offset);
-	float2 tex_co;
+	float2 tex_co, tex_dx, tex_dy;
 	uint use_alpha = stack_valid(alpha_offset);
 	if(node.w == NODE_IMAGE_PROJ_SPHERE) {
 		co = texco_remap_square(co);
 		tex_co = map_to_sphere(co);
+		tex_dx = tex_dy = make_float2(0.0f, 0.0f);
 	}
 	else if(node.w == NODE_IMAGE_PROJ_TUBE) {
 		co = texco_remap_square(co);
 		tex_co = map_to_tube(co);
+		tex_dx = tex_dy = make_float2(0.0f, 0.0f);
 	}
 	else {
 		tex_co = make_float2(co.x, co.y);
+		svm_image_texture_uv_differentials(kg, sd, &tex_dx, &tex_dy);
 	}
-	float4 f = svm_image_texture(kg, id, tex_co.x, tex_co.y, srgb, use_alpha);
+	float4 f = svm_image_texture(kg, id, tex_co.x, tex_co.y, tex_dx, tex_dy, srgb, use_alpha);
 
 	if(stack_valid(out_offset))
 		stack_store_float3(stack, out_offset, make_float3(f.x, f.y, f.z));
@@ -466,14 +497,15 @@ ccl_device void svm_node_tex_image_box(KernelGlobals *kg, ShaderData *sd, float
 	uint id = node.y;
 
 	float4 f = make_float4(0.0f, 0.0f, 0.0f, 0.0f);
+	float2 d = make_float2(0.0f, 0.0f);
 	uint use_alpha = stack_valid(alpha_offset);
 
 	if(weight.x > 0.0f)
-		f += weight.x*svm_image_texture(kg, id, co.y, co.z, srgb, use_alpha);
+		f += weight.x*svm_image_texture(kg, id, co.y, co.z, d, d, srgb, use_alpha);
 	if(weight.y > 0.0f)
-		f += weight.y*svm_image_texture(kg, id, co.x, co.z, srgb, use_alpha);
+		f += weight.y*svm_image_texture(kg, id, co.x, co.z, d, d, srgb, use_alpha);
 	if(weight.z > 0.0f)
-		f += weight.z*svm_image_texture(kg, id, co.y, co.x, srgb, use_alpha);
+		f += weight.z*svm_image_texture(kg, id, co.y, co.x, d, d, srgb, use_alpha);
 
 	if(stack_valid(out_offset))
 		stack_store_float3(stack, out_offset, make_float3(f.x, f.y, f.z));
@@ -500,7 +532,8 @@ ccl_device void svm_node_tex_environment(KernelGlobals *kg, ShaderData *sd, floa
 		uv = direction_to_mirrorball(co);
 
 	uint use_alpha = stack_valid(alpha_offset);
-	float4 f = svm_image_texture(kg, id, uv.x, uv.y, srgb, use_alpha);
+	float2 d = make_float2(0.0f, 0.0f);
+	float4 f = svm_image_texture(kg, id, uv.x, uv.y, d, d, srgb, use_alpha);
 
 	if(stack_valid(out_offset))
 		stack_store_float3(stack, out_offset, make_float3(f.x, f.y, f.z));
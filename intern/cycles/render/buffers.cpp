@@ -89,6 +89,9 @@ RenderTile::RenderTile()
 	offset = 0;
 	stride = 0;
 
+	tile_index = 0;
+	converged = false;
+
 	buffer = 0;
 	rng_state = 0;
 
@@ -156,6 +159,52 @@ bool RenderBuffers::copy_from_device()
 	return true;
 }
 
+bool RenderBuffers::copy_to_device()
+{
+	if(!buffer.device_pointer)
+		return false;
+
+	device->mem_copy_to(buffer);
+
+	return true;
+}
+
+bool RenderBuffers::copy_rng_state_from_device()
+{
+	if(!rng_state.device_pointer)
+		return false;
+
+	/* the state only changes on the device without sobol */
+	device->mem_copy_from(rng_state, 0, params.width, params.height, sizeof(uint));
+
+	return true;
+}
+
+float *RenderBuffers::get_pass_pointer(PassType type)
+{
+	int pass_offset = 0;
+
+	foreach(Pass& pass, params.passes) {
+		if(pass.type == type)
+			return (float*)buffer.data_pointer + pass_offset;
+
+		pass_offset += pass.components;
+	}
+
+	return NULL;
+}
+
+/* per pixel sample scale, pixels that converged early with adaptive sampling
+ * have fewer samples than the tile */
+static float pass_sample_scale(const float *in_count, int i, int pass_stride, float scale)
+{
+	if(!in_count)
+		return scale;
+
+	float count = in_count[i*pass_stride];
+	return (count > 0.0f)? 1.0f/count: scale;
+}
+
 bool RenderBuffers::get_pass_rect(PassType type, float exposure, int sample, int components, float *pixels)
 {
 	int pass_offset = 0;
@@ -174,6 +223,11 @@ bool RenderBuffers::get_pass_rect(PassType type, float exposure, int sample, int
 
 		int size = params.width*params.height;
 
+		/* with adaptive sampling pixels stop at different sample counts, so
+		 * filtered passes are normalized by the number of samples per pixel */
+		float *in_count = (pass.filter)? get_pass_pointer(PASS_SAMPLE_COUNT): NULL;
+		float exposure_factor = (pass.exposure)? exposure: 1.0f;
+
 		if(components == 1) {
 			assert(pass.components == components);
 
@@ -187,11 +241,12 @@ bool RenderBuffers::get_pass_rect(PassType type, float exposure, int sample, int
 			else if(type == PASS_MIST) {
 				for(int i = 0; i < size; i++, in += pass_stride, pixels++) {
 					float f = *in;
-					pixels[0] = saturate(f*scale_exposure);
+					float pixel_scale = pass_sample_scale(in_count, i, pass_stride, scale)*exposure_factor;
+					pixels[0] = saturate(f*pixel_scale);
 				}
 			}
 #ifdef WITH_CYCLES_DEBUG
-			else if(type == PASS_BVH_TRAVERSAL_STEPS) {
+			else if(type == PASS_BVH_TRAVERSAL_STEPS || type == PASS_RENDER_TIME) {
 				for(int i = 0; i < size; i++, in += pass_stride, pixels++) {
 					float f = *in;
 					pixels[0] = f;
@@ -201,7 +256,8 @@ bool RenderBuffers::get_pass_rect(PassType type, float exposure, int sample, int
 			else {
 				for(int i = 0; i < size; i++, in += pass_stride, pixels++) {
 					float f = *in;
-					pixels[0] = f*scale_exposure;
+					float pixel_scale = pass_sample_scale(in_count, i, pass_stride, scale)*exposure_factor;
+					pixels[0] = f*pixel_scale;
 				}
 			}
 		}
@@ -245,10 +301,11 @@ bool RenderBuffers::get_pass_rect(PassType type, float exposure, int sample, int
 				/* RGB/vector */
 				for(int i = 0; i < size; i++, in += pass_stride, pixels += 3) {
 					float3 f = make_float3(in[0], in[1], in[2]);
+					float pixel_scale = pass_sample_scale(in_count, i, pass_stride, scale)*exposure_factor;
 
-					pixels[0] = f.x*scale_exposure;
-					pixels[1] = f.y*scale_exposure;
-					pixels[2] = f.z*scale_exposure;
+					pixels[0] = f.x*pixel_scale;
+					pixels[1] = f.y*pixel_scale;
+					pixels[2] = f.z*pixel_scale;
 				}
 			}
 		}
@@ -292,13 +349,15 @@ bool RenderBuffers::get_pass_rect(PassType type, float exposure, int sample, int
 			else {
 				for(int i = 0; i < size; i++, in += pass_stride, pixels += 4) {
 					float4 f = make_float4(in[0], in[1], in[2], in[3]);
+					float sample_scale = pass_sample_scale(in_count, i, pass_stride, scale);
+					float pixel_scale = sample_scale*exposure_factor;
 
-					pixels[0] = f.x*scale_exposure;
-					pixels[1] = f.y*scale_exposure;
-					pixels[2] = f.z*scale_exposure;
+					pixels[0] = f.x*pixel_scale;
+					pixels[1] = f.y*pixel_scale;
+					pixels[2] = f.z*pixel_scale;
 
 					/* clamp since alpha might be > 1.0 due to russian roulette */
-					pixels[3] = saturate(f.w*scale);
+					pixels[3] = saturate(f.w*sample_scale);
 				}
 			}
 		}
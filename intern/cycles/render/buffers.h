@@ -79,7 +79,10 @@ public:
 	void reset(Device *device, BufferParams& params);
 
 	bool copy_from_device();
+	bool copy_to_device();
+	bool copy_rng_state_from_device();
 	bool get_pass_rect(PassType type, float exposure, int sample, int components, float *pixels);
+	float *get_pass_pointer(PassType type);
 
 protected:
 	void device_free();
@@ -139,6 +142,11 @@ public:
 	int offset;
 	int stride;
 
+	/* index in the tile manager and whether all pixels converged,
+	 * used by adaptive sampling to skip finished tiles */
+	int tile_index;
+	bool converged;
+
 	device_ptr buffer;
 	device_ptr rng_state;
 
@@ -0,0 +1,744 @@
+/*
+ * Copyright 2011-2015 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "buffers.h"
+#include "camera.h"
+#include "checkpoint.h"
+#include "device.h"
+#include "graph.h"
+#include "light.h"
+#include "mesh.h"
+#include "object.h"
+#include "scene.h"
+#include "shader.h"
+
+#include "util_compress.h"
+#include "util_foreach.h"
+#include "util_logging.h"
+#include "util_map.h"
+#include "util_md5.h"
+#include "util_path.h"
+#include "util_time.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* File Format
+ *
+ * Native endian, so checkpoints are only meant to be resumed on the same
+ * type of machine.
+ *
+ * - Magic and version.
+ * - Parameters: buffer size and offset, pass types, number of samples, tile
+ *   size, progressive, seed, scene file modification time and scene hash.
+ * - Number of samples rendered in progressive mode.
+ * - Tiles: index, position, size, number of samples and finished flag,
+ *   followed by the compressed buffer and random number generator state. */
+
+#define CHECKPOINT_MAGIC "CYCLESCP"
+#define CHECKPOINT_VERSION 2
+
+static bool checkpoint_write(FILE *f, const void *data, size_t size)
+{
+	return (size == 0) || (fwrite(data, size, 1, f) == 1);
+}
+
+static bool checkpoint_write_int(FILE *f, int value)
+{
+	return checkpoint_write(f, &value, sizeof(value));
+}
+
+static bool checkpoint_write_data(FILE *f, const vector<uint8_t>& data)
+{
+	uint64_t size = data.size();
+
+	return checkpoint_write(f, &size, sizeof(size)) &&
+	       checkpoint_write(f, (data.size())? &data[0]: NULL, data.size());
+}
+
+static bool checkpoint_write_string(FILE *f, const string& str)
+{
+	uint64_t size = str.size();
+
+	return checkpoint_write(f, &size, sizeof(size)) &&
+	       checkpoint_write(f, str.data(), str.size());
+}
+
+static bool checkpoint_read(FILE *f, void *data, size_t size)
+{
+	return (size == 0) || (fread(data, size, 1, f) == 1);
+}
+
+static bool checkpoint_read_int(FILE *f, int& value)
+{
+	return checkpoint_read(f, &value, sizeof(value));
+}
+
+static bool checkpoint_read_data(FILE *f, vector<uint8_t>& data)
+{
+	uint64_t size;
+
+	if(!checkpoint_read(f, &size, sizeof(size)))
+		return false;
+
+	/* guard against allocating garbage sizes from a damaged file */
+	long pos = ftell(f);
+	fseek(f, 0, SEEK_END);
+	long end = ftell(f);
+	fseek(f, pos, SEEK_SET);
+
+	if(pos < 0 || end < pos || size > (uint64_t)(end - pos))
+		return false;
+
+	data.resize(size);
+	return checkpoint_read(f, (size)? &data[0]: NULL, size);
+}
+
+static bool checkpoint_read_string(FILE *f, string& str)
+{
+	uint64_t size;
+
+	/* only short strings are written, anything else is a corrupt file */
+	if(!checkpoint_read(f, &size, sizeof(size)) || size > 1024)
+		return false;
+
+	vector<char> data(size);
+
+	if(!checkpoint_read(f, (size)? &data[0]: NULL, size))
+		return false;
+
+	str = string(data.begin(), data.end());
+	return true;
+}
+
+static bool checkpoint_write_params(FILE *f, const CheckpointParams& params)
+{
+	const BufferParams& buffer = params.buffer;
+	bool ok = true;
+
+	ok = ok && checkpoint_write_int(f, buffer.width);
+	ok = ok && checkpoint_write_int(f, buffer.height);
+	ok = ok && checkpoint_write_int(f, buffer.full_x);
+	ok = ok && checkpoint_write_int(f, buffer.full_y);
+	ok = ok && checkpoint_write_int(f, buffer.full_width);
+	ok = ok && checkpoint_write_int(f, buffer.full_height);
+
+	ok = ok && checkpoint_write_int(f, buffer.passes.size());
+	foreach(const Pass& pass, buffer.passes)
+		ok = ok && checkpoint_write_int(f, pass.type);
+
+	ok = ok && checkpoint_write_int(f, params.num_samples);
+	ok = ok && checkpoint_write_int(f, params.tile_size.x);
+	ok = ok && checkpoint_write_int(f, params.tile_size.y);
+	ok = ok && checkpoint_write_int(f, params.progressive);
+	ok = ok && checkpoint_write_int(f, params.seed);
+	ok = ok && checkpoint_write(f, &params.scene_time, sizeof(params.scene_time));
+	ok = ok && checkpoint_write_string(f, params.scene_hash);
+
+	return ok;
+}
+
+static bool checkpoint_read_params(FILE *f, CheckpointParams& params)
+{
+	BufferParams& buffer = params.buffer;
+	int num_passes, progressive, seed;
+
+	if(!(checkpoint_read_int(f, buffer.width) &&
+	     checkpoint_read_int(f, buffer.height) &&
+	     checkpoint_read_int(f, buffer.full_x) &&
+	     checkpoint_read_int(f, buffer.full_y) &&
+	     checkpoint_read_int(f, buffer.full_width) &&
+	     checkpoint_read_int(f, buffer.full_height) &&
+	     checkpoint_read_int(f, num_passes)))
+	{
+		return false;
+	}
+
+	/* pass types are bit flags, so there can't be more than bits in an int */
+	if(num_passes < 0 || num_passes > (int)(sizeof(int)*8))
+		return false;
+
+	buffer.passes.clear();
+
+	for(int i = 0; i < num_passes; i++) {
+		int type;
+
+		if(!checkpoint_read_int(f, type))
+			return false;
+
+		Pass::add((PassType)type, buffer.passes);
+	}
+
+	if(!(checkpoint_read_int(f, params.num_samples) &&
+	     checkpoint_read_int(f, params.tile_size.x) &&
+	     checkpoint_read_int(f, params.tile_size.y) &&
+	     checkpoint_read_int(f, progressive) &&
+	     checkpoint_read_int(f, seed) &&
+	     checkpoint_read(f, &params.scene_time, sizeof(params.scene_time)) &&
+	     checkpoint_read_string(f, params.scene_hash)))
+	{
+		return false;
+	}
+
+	params.progressive = (progressive != 0);
+	params.seed = (uint)seed;
+
+	return true;
+}
+
+/* Checkpoint Parameters */
+
+CheckpointParams::CheckpointParams()
+{
+	num_samples = 0;
+	tile_size = make_int2(0, 0);
+	progressive = false;
+	seed = 0;
+	scene_time = 0;
+}
+
+template<typename T>
+static void hash_append(MD5Hash& md5, const T& value)
+{
+	md5.append((const uint8_t*)&value, sizeof(value));
+}
+
+template<typename T>
+static void hash_append(MD5Hash& md5, const vector<T>& data)
+{
+	const uint8_t *bytes = (data.size())? (const uint8_t*)&data[0]: NULL;
+	size_t size = data.size()*sizeof(T);
+
+	hash_append(md5, data.size());
+
+	/* append takes an int size */
+	for(size_t offset = 0; offset < size; offset += (1 << 30)) {
+		size_t chunk = size - offset;
+		md5.append(bytes + offset, (chunk > (1 << 30))? (1 << 30): (int)chunk);
+	}
+}
+
+static void hash_append(MD5Hash& md5, const float3& value)
+{
+	/* the fourth component is padding */
+	hash_append(md5, value.x);
+	hash_append(md5, value.y);
+	hash_append(md5, value.z);
+}
+
+static void hash_append(MD5Hash& md5, const string& str)
+{
+	hash_append(md5, str.size());
+	md5.append((const uint8_t*)str.data(), str.size());
+}
+
+static void hash_append(MD5Hash& md5, const ustring& str)
+{
+	hash_append(md5, str.string());
+}
+
+void CheckpointParams::hash_scene(Scene *scene)
+{
+	MD5Hash md5;
+
+	/* camera, the settings that affect the image */
+	Camera *cam = scene->camera;
+
+	hash_append(md5, cam->matrix);
+	hash_append(md5, cam->motion);
+	hash_append(md5, cam->use_motion);
+	hash_append(md5, cam->shuttertime);
+	hash_append(md5, cam->focaldistance);
+	hash_append(md5, cam->aperturesize);
+	hash_append(md5, cam->blades);
+	hash_append(md5, cam->bladesrotation);
+	hash_append(md5, cam->aperture_ratio);
+	hash_append(md5, (int)cam->type);
+	hash_append(md5, cam->fov);
+	hash_append(md5, (int)cam->panorama_type);
+	hash_append(md5, cam->fisheye_fov);
+	hash_append(md5, cam->fisheye_lens);
+	hash_append(md5, cam->latitude_min);
+	hash_append(md5, cam->latitude_max);
+	hash_append(md5, cam->longitude_min);
+	hash_append(md5, cam->longitude_max);
+	hash_append(md5, cam->sensorwidth);
+	hash_append(md5, cam->sensorheight);
+	hash_append(md5, cam->nearclip);
+	hash_append(md5, cam->farclip);
+	hash_append(md5, cam->viewplane);
+	hash_append(md5, cam->border);
+
+	/* geometry, meshes are referenced by index from objects */
+	map<Mesh*, int> mesh_index;
+
+	hash_append(md5, scene->meshes.size());
+
+	foreach(Mesh *mesh, scene->meshes) {
+		int index = mesh_index.size();
+		mesh_index[mesh] = index;
+
+		hash_append(md5, mesh->verts);
+		hash_append(md5, mesh->triangles);
+		hash_append(md5, mesh->shader);
+		hash_append(md5, mesh->smooth.size());
+		for(size_t i = 0; i < mesh->smooth.size(); i++)
+			hash_append(md5, (bool)mesh->smooth[i]);
+		hash_append(md5, mesh->curve_keys);
+		hash_append(md5, mesh->curves);
+		hash_append(md5, mesh->used_shaders);
+		hash_append(md5, (int)mesh->displacement_method);
+		hash_append(md5, mesh->motion_steps);
+		hash_append(md5, mesh->use_motion_blur);
+	}
+
+	/* objects */
+	hash_append(md5, scene->objects.size());
+
+	foreach(Object *object, scene->objects) {
+		hash_append(md5, object->name);
+		map<Mesh*, int>::iterator it = mesh_index.find(object->mesh);
+		hash_append(md5, (it != mesh_index.end())? it->second: -1);
+		hash_append(md5, object->tfm);
+		hash_append(md5, object->motion);
+		hash_append(md5, object->use_motion);
+		hash_append(md5, object->visibility);
+		hash_append(md5, object->pass_id);
+		hash_append(md5, object->use_holdout);
+		hash_append(md5, object->particle_index);
+		hash_append(md5, object->dupli_generated);
+		hash_append(md5, object->dupli_uv);
+	}
+
+	/* lights */
+	hash_append(md5, scene->lights.size());
+
+	foreach(Light *light, scene->lights) {
+		hash_append(md5, (int)light->type);
+		hash_append(md5, light->co);
+		hash_append(md5, light->dir);
+		hash_append(md5, light->size);
+		hash_append(md5, light->axisu);
+		hash_append(md5, light->sizeu);
+		hash_append(md5, light->axisv);
+		hash_append(md5, light->sizev);
+		hash_append(md5, light->map_resolution);
+		hash_append(md5, light->spot_angle);
+		hash_append(md5, light->spot_smooth);
+		hash_append(md5, light->cast_shadow);
+		hash_append(md5, light->use_mis);
+		hash_append(md5, light->use_diffuse);
+		hash_append(md5, light->use_glossy);
+		hash_append(md5, light->use_transmission);
+		hash_append(md5, light->use_scatter);
+		hash_append(md5, light->is_portal);
+		hash_append(md5, light->shader);
+		hash_append(md5, light->samples);
+		hash_append(md5, light->max_bounces);
+	}
+
+	/* shader nodes and their socket values and links, node settings that
+	 * are not sockets are only covered by the scene file time */
+	hash_append(md5, scene->shaders.size());
+
+	foreach(Shader *shader, scene->shaders) {
+		hash_append(md5, shader->name);
+		hash_append(md5, shader->pass_id);
+		hash_append(md5, shader->use_mis);
+		hash_append(md5, shader->use_transparent_shadow);
+		hash_append(md5, shader->heterogeneous_volume);
+		hash_append(md5, (int)shader->volume_sampling_method);
+		hash_append(md5, shader->volume_interpolation_method);
+
+		if(!shader->graph)
+			continue;
+
+		hash_append(md5, shader->graph->nodes.size());
+
+		foreach(ShaderNode *node, shader->graph->nodes) {
+			hash_append(md5, node->name);
+			hash_append(md5, node->id);
+
+			foreach(ShaderInput *input, node->inputs) {
+				hash_append(md5, string(input->name));
+				hash_append(md5, input->value);
+				hash_append(md5, input->value_string);
+
+				if(input->link) {
+					hash_append(md5, input->link->parent->id);
+					hash_append(md5, string(input->link->name));
+				}
+				else
+					hash_append(md5, -1);
+			}
+		}
+	}
+
+	scene_hash = md5.get_hex();
+}
+
+bool CheckpointParams::modified(const CheckpointParams& params)
+{
+	return !(!buffer.modified(params.buffer)
+		&& num_samples == params.num_samples
+		&& tile_size == params.tile_size
+		&& progressive == params.progressive
+		&& seed == params.seed
+		&& scene_time == params.scene_time
+		&& scene_hash == params.scene_hash);
+}
+
+/* Checkpoint Tile */
+
+CheckpointTile::CheckpointTile()
+{
+	index = 0;
+	x = 0;
+	y = 0;
+	w = 0;
+	h = 0;
+	sample = 0;
+	finished = false;
+}
+
+/* Checkpoint */
+
+Checkpoint::Checkpoint(const string& filepath_, double interval_, const CheckpointParams& params_)
+: filepath(filepath_), interval(interval_), params(params_)
+{
+	last_write_time = time_dt();
+
+	resume_valid = false;
+	resume_state_sample = 0;
+
+	write_requested = false;
+	write_sample = 0;
+	writer_stop = false;
+
+	if(path_exists(filepath)) {
+		resume_valid = read();
+
+		if(!resume_valid) {
+			resume_state_sample = 0;
+			resume_tile_map.clear();
+		}
+	}
+
+	writer_thread = new thread(function_bind(&Checkpoint::writer_run, this));
+}
+
+Checkpoint::~Checkpoint()
+{
+	finish(false);
+}
+
+bool Checkpoint::read()
+{
+	double time_start = time_dt();
+	FILE *f = path_fopen(filepath, "rb");
+
+	if(!f)
+		return false;
+
+	char magic[8];
+	int version;
+	CheckpointParams file_params;
+	bool ok = checkpoint_read(f, magic, sizeof(magic)) &&
+	          memcmp(magic, CHECKPOINT_MAGIC, sizeof(magic)) == 0 &&
+	          checkpoint_read_int(f, version) &&
+	          version == CHECKPOINT_VERSION &&
+	          checkpoint_read_params(f, file_params);
+
+	if(!ok) {
+		fclose(f);
+		VLOG(1) << "Ignoring invalid checkpoint " << filepath << ".";
+		return false;
+	}
+
+	if(params.modified(file_params)) {
+		fclose(f);
+		VLOG(1) << "Ignoring checkpoint " << filepath << ", written for different render settings or a modified scene.";
+		return false;
+	}
+
+	int num_tiles;
+	ok = checkpoint_read_int(f, resume_state_sample) &&
+	     checkpoint_read_int(f, num_tiles);
+
+	for(int i = 0; ok && i < num_tiles; i++) {
+		CheckpointTile tile;
+		int finished;
+
+		ok = checkpoint_read_int(f, tile.index) &&
+		     checkpoint_read_int(f, tile.x) &&
+		     checkpoint_read_int(f, tile.y) &&
+		     checkpoint_read_int(f, tile.w) &&
+		     checkpoint_read_int(f, tile.h) &&
+		     checkpoint_read_int(f, tile.sample) &&
+		     checkpoint_read_int(f, finished);
+
+		if(ok) {
+			tile.finished = (finished != 0);
+
+			/* read buffers directly into the map to avoid copying them */
+			CheckpointTile& rtile = resume_tile_map[tile.index];
+			rtile = tile;
+
+			ok = checkpoint_read_data(f, rtile.buffer) &&
+			     checkpoint_read_data(f, rtile.rng_state);
+		}
+	}
+
+	fclose(f);
+
+	if(!ok) {
+		VLOG(1) << "Ignoring damaged checkpoint " << filepath << ".";
+		return false;
+	}
+
+	VLOG(1) << "Resuming from checkpoint " << filepath << " with "
+	        << resume_tile_map.size() << " tiles, read in "
+	        << time_dt() - time_start << " seconds.";
+
+	return true;
+}
+
+const CheckpointTile *Checkpoint::resume_tile(int index) const
+{
+	map<int, CheckpointTile>::const_iterator it = resume_tile_map.find(index);
+	return (it != resume_tile_map.end())? &it->second: NULL;
+}
+
+bool Checkpoint::restore_tile(const CheckpointTile& tile, Device *device, RenderBuffers *buffers) const
+{
+	BufferParams& buffer_params = buffers->params;
+
+	if(buffer_params.width != tile.w || buffer_params.height != tile.h ||
+	   tile.buffer.empty() || tile.rng_state.empty())
+	{
+		return false;
+	}
+
+	size_t num_pixels = (size_t)tile.w*tile.h;
+	size_t buffer_size = num_pixels*buffer_params.get_passes_size()*sizeof(float);
+	size_t rng_state_size = num_pixels*sizeof(uint);
+
+	if(buffers->buffer.size()*sizeof(float) != buffer_size ||
+	   buffers->rng_state.size()*sizeof(uint) != rng_state_size)
+	{
+		return false;
+	}
+
+	if(!util_decompress_buffer(&tile.buffer[0], tile.buffer.size(),
+	                           (void*)buffers->buffer.data_pointer, buffer_size) ||
+	   !util_decompress_buffer(&tile.rng_state[0], tile.rng_state.size(),
+	                           (void*)buffers->rng_state.data_pointer, rng_state_size))
+	{
+		return false;
+	}
+
+	device->mem_copy_to(buffers->buffer);
+	device->mem_copy_to(buffers->rng_state);
+
+	return true;
+}
+
+void Checkpoint::add_tile(int index, int sample, bool finished, RenderBuffers *buffers)
+{
+	PendingTile *tile = new PendingTile();
+	BufferParams& buffer_params = buffers->params;
+
+	tile->index = index;
+	tile->x = buffer_params.full_x;
+	tile->y = buffer_params.full_y;
+	tile->w = buffer_params.width;
+	tile->h = buffer_params.height;
+	tile->sample = sample;
+	tile->finished = finished;
+
+	/* only copy here, compression is left to the writer thread */
+	const float *buffer = (const float*)buffers->buffer.data_pointer;
+	const uint *rng_state = (const uint*)buffers->rng_state.data_pointer;
+
+	tile->buffer.assign(buffer, buffer + buffers->buffer.size());
+	tile->rng_state.assign(rng_state, rng_state + buffers->rng_state.size());
+
+	thread_scoped_lock lock(writer_mutex);
+	pending_tiles.push_back(tile);
+	writer_cond.notify_all();
+}
+
+bool Checkpoint::need_write()
+{
+	return time_dt() - last_write_time >= interval;
+}
+
+void Checkpoint::write(int sample)
+{
+	thread_scoped_lock lock(writer_mutex);
+
+	write_requested = true;
+	write_sample = sample;
+	last_write_time = time_dt();
+
+	writer_cond.notify_all();
+}
+
+void Checkpoint::finish(bool completed)
+{
+	if(writer_thread) {
+		{
+			thread_scoped_lock lock(writer_mutex);
+			writer_stop = true;
+			writer_cond.notify_all();
+		}
+
+		writer_thread->join();
+		delete writer_thread;
+		writer_thread = NULL;
+	}
+
+	/* completed renders have no use for the checkpoint anymore */
+	if(completed && path_exists(filepath)) {
+		remove(filepath.c_str());
+		VLOG(1) << "Removed checkpoint " << filepath << ".";
+	}
+}
+
+void Checkpoint::writer_run()
+{
+	thread_scoped_lock lock(writer_mutex);
+
+	while(true) {
+		if(!pending_tiles.empty()) {
+			PendingTile *pending = pending_tiles.front();
+			pending_tiles.pop_front();
+
+			lock.unlock();
+
+			CheckpointTile& tile = tiles[pending->index];
+			tile.index = pending->index;
+			tile.x = pending->x;
+			tile.y = pending->y;
+			tile.w = pending->w;
+			tile.h = pending->h;
+			tile.sample = pending->sample;
+			tile.finished = pending->finished;
+
+			util_compress_buffer((pending->buffer.size())? &pending->buffer[0]: NULL,
+			                     pending->buffer.size()*sizeof(float), tile.buffer);
+			util_compress_buffer((pending->rng_state.size())? &pending->rng_state[0]: NULL,
+			                     pending->rng_state.size()*sizeof(uint), tile.rng_state);
+
+			delete pending;
+
+			lock.lock();
+		}
+		else if(write_requested) {
+			int sample = write_sample;
+			write_requested = false;
+
+			lock.unlock();
+			write_file(sample);
+			lock.lock();
+		}
+		else if(writer_stop) {
+			break;
+		}
+		else {
+			writer_cond.wait(lock);
+		}
+	}
+}
+
+bool Checkpoint::write_file(int sample)
+{
+	double time_start = time_dt();
+	string tmp_filepath = filepath + ".tmp";
+
+	path_create_directories(filepath);
+
+	FILE *f = path_fopen(tmp_filepath, "wb");
+
+	if(!f) {
+		VLOG(1) << "Failed to open checkpoint " << tmp_filepath << " for writing.";
+		return false;
+	}
+
+	/* tiles added during this render, and those from the resumed
+	 * checkpoint that were not rendered again */
+	vector<const CheckpointTile*> write_tiles;
+	map<int, CheckpointTile>::const_iterator it;
+
+	for(it = tiles.begin(); it != tiles.end(); it++)
+		write_tiles.push_back(&it->second);
+
+	for(it = resume_tile_map.begin(); it != resume_tile_map.end(); it++)
+		if(tiles.find(it->first) == tiles.end())
+			write_tiles.push_back(&it->second);
+
+	bool ok = checkpoint_write(f, CHECKPOINT_MAGIC, 8) &&
+	          checkpoint_write_int(f, CHECKPOINT_VERSION) &&
+	          checkpoint_write_params(f, params) &&
+	          checkpoint_write_int(f, sample) &&
+	          checkpoint_write_int(f, write_tiles.size());
+
+	size_t size = 0;
+
+	foreach(const CheckpointTile *tile, write_tiles) {
+		ok = ok && checkpoint_write_int(f, tile->index);
+		ok = ok && checkpoint_write_int(f, tile->x);
+		ok = ok && checkpoint_write_int(f, tile->y);
+		ok = ok && checkpoint_write_int(f, tile->w);
+		ok = ok && checkpoint_write_int(f, tile->h);
+		ok = ok && checkpoint_write_int(f, tile->sample);
+		ok = ok && checkpoint_write_int(f, tile->finished);
+		ok = ok && checkpoint_write_data(f, tile->buffer);
+		ok = ok && checkpoint_write_data(f, tile->rng_state);
+
+		size += tile->buffer.size() + tile->rng_state.size();
+	}
+
+	ok = (fclose(f) == 0) && ok;
+
+	if(!ok) {
+		VLOG(1) << "Failed to write checkpoint " << tmp_filepath << ".";
+		remove(tmp_filepath.c_str());
+		return false;
+	}
+
+	/* replace previous checkpoint only once the new one is complete */
+#ifdef _WIN32
+	remove(filepath.c_str());
+#endif
+
+	if(rename(tmp_filepath.c_str(), filepath.c_str()) != 0) {
+		VLOG(1) << "Failed to rename checkpoint " << tmp_filepath << ".";
+		remove(tmp_filepath.c_str());
+		return false;
+	}
+
+	VLOG(1) << "Wrote checkpoint " << filepath << " with " << write_tiles.size()
+	        << " tiles, " << size/(1024*1024) << " MB, in "
+	        << time_dt() - time_start << " seconds.";
+
+	return true;
+}
+
+CCL_NAMESPACE_END
+
@@ -0,0 +1,156 @@
+/*
+ * Copyright 2011-2015 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __CHECKPOINT_H__
+#define __CHECKPOINT_H__
+
+#include "buffers.h"
+
+#include "util_list.h"
+#include "util_map.h"
+#include "util_string.h"
+#include "util_thread.h"
+#include "util_types.h"
+#include "util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+class Device;
+class RenderBuffers;
+class Scene;
+
+/* Checkpoint Parameters
+ *
+ * Render settings and scene a checkpoint was written for, it is only resumed
+ * by a render with identical settings of an unmodified scene. */
+
+class CheckpointParams {
+public:
+	BufferParams buffer;
+	int num_samples;
+	int2 tile_size;
+	bool progressive;
+	uint seed;
+
+	/* modification time of the file the scene was loaded from, zero if
+	 * there is none */
+	uint64_t scene_time;
+	/* hash of the synced scene */
+	string scene_hash;
+
+	CheckpointParams();
+
+	/* hash geometry, objects, lights, camera and shader nodes, so that
+	 * edits not saved to the scene file are detected as well */
+	void hash_scene(Scene *scene);
+
+	bool modified(const CheckpointParams& params);
+};
+
+/* Checkpoint Tile
+ *
+ * Compressed render buffer and random number generator state of a tile, with
+ * the number of samples rendered so far. Progressive rendering into a single
+ * buffer uses one tile for the whole buffer, with index -1. */
+
+class CheckpointTile {
+public:
+	int index;
+	int x, y, w, h;
+	int sample;
+	bool finished;
+
+	vector<uint8_t> buffer;
+	vector<uint8_t> rng_state;
+
+	CheckpointTile();
+};
+
+/* Checkpoint
+ *
+ * Periodically writes render buffers to a file, so that a render that was
+ * interrupted can continue where it left off. Tiles are copied when added,
+ * compression and writing the file happen in a separate thread so rendering
+ * does not wait for it. The file is first written under a temporary name
+ * and then renamed, so that an interrupted write leaves the previous
+ * checkpoint intact. */
+
+class Checkpoint {
+public:
+	Checkpoint(const string& filepath, double interval, const CheckpointParams& params);
+	~Checkpoint();
+
+	/* state read from an existing checkpoint file, only for the
+	 * same render parameters */
+	bool resumed() const { return resume_valid; }
+	int resume_sample() const { return resume_state_sample; }
+	const map<int, CheckpointTile>& resume_tiles() const { return resume_tile_map; }
+	const CheckpointTile *resume_tile(int index) const;
+
+	bool restore_tile(const CheckpointTile& tile, Device *device, RenderBuffers *buffers) const;
+
+	/* add tile buffers, which must have been copied from the device */
+	void add_tile(int index, int sample, bool finished, RenderBuffers *buffers);
+
+	/* write the file with the tiles added so far, along with the number of
+	 * samples rendered in progressive mode */
+	bool need_write();
+	void write(int sample);
+
+	/* stop writing, and remove the file once the render completed */
+	void finish(bool completed);
+
+protected:
+	struct PendingTile {
+		int index;
+		int x, y, w, h;
+		int sample;
+		bool finished;
+		vector<float> buffer;
+		vector<uint> rng_state;
+	};
+
+	bool read();
+	bool write_file(int sample);
+	void writer_run();
+
+	string filepath;
+	double interval;
+	double last_write_time;
+	CheckpointParams params;
+
+	/* resume state, not modified after construction */
+	bool resume_valid;
+	int resume_state_sample;
+	map<int, CheckpointTile> resume_tile_map;
+
+	/* compressed tiles, only accessed from the writer thread */
+	map<int, CheckpointTile> tiles;
+
+	/* writer thread */
+	thread *writer_thread;
+	thread_mutex writer_mutex;
+	thread_condition_variable writer_cond;
+	list<PendingTile*> pending_tiles;
+	bool write_requested;
+	int write_sample;
+	bool writer_stop;
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __CHECKPOINT_H__ */
+
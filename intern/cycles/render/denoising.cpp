@@ -0,0 +1,246 @@
+/*
+ * Copyright 2011-2015 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "buffers.h"
+#include "denoising.h"
+
+#include "util_color.h"
+#include "util_foreach.h"
+#include "util_math.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* patches of 3x3 pixels are compared */
+#define DENOISE_PATCH_RADIUS 1
+
+/* tolerated feature differences at a feature strength of one, depth is
+ * relative to the depth of the filtered pixel */
+#define DENOISE_NORMAL_TOLERANCE 0.25f
+#define DENOISE_ALBEDO_TOLERANCE 0.1f
+#define DENOISE_DEPTH_TOLERANCE 0.05f
+
+Denoiser::Denoiser(const DenoiseParams& params_)
+: params(params_)
+{
+}
+
+void Denoiser::add_buffers(RenderBuffers *buffers, int sample)
+{
+	Source source;
+	source.buffers = buffers;
+	source.sample = sample;
+	sources.push_back(source);
+}
+
+/* Read mean color, features and variance of the rect from all sources, pixels
+ * not covered by any of them are left invalid. */
+void Denoiser::gather(int x, int y, int w, int h, vector<Pixel>& pixels) const
+{
+	pixels.clear();
+	pixels.resize(w*h);
+
+	foreach(Pixel& pixel, pixels)
+		pixel.valid = false;
+
+	foreach(const Source& source, sources) {
+		RenderBuffers *buffers = source.buffers;
+		BufferParams& bparams = buffers->params;
+
+		float *combined = buffers->get_pass_pointer(PASS_COMBINED);
+		float *denoising = buffers->get_pass_pointer(PASS_DENOISING);
+		float *count = buffers->get_pass_pointer(PASS_SAMPLE_COUNT);
+		int pass_stride = bparams.get_passes_size();
+
+		if(!combined || !denoising)
+			continue;
+
+		int x0 = max(x, bparams.full_x), x1 = min(x + w, bparams.full_x + bparams.width);
+		int y0 = max(y, bparams.full_y), y1 = min(y + h, bparams.full_y + bparams.height);
+
+		for(int py = y0; py < y1; py++) {
+			for(int px = x0; px < x1; px++) {
+				int index = (px - bparams.full_x) + (py - bparams.full_y)*bparams.width;
+				float num_samples = (count)? count[index*pass_stride]: (float)source.sample;
+
+				if(num_samples <= 0.0f)
+					continue;
+
+				const float *c = combined + index*pass_stride;
+				const float *d = denoising + index*pass_stride;
+				float inv_num_samples = 1.0f/num_samples;
+				Pixel& pixel = pixels[(px - x) + (py - y)*w];
+
+				pixel.color = make_float3(c[0], c[1], c[2])*inv_num_samples;
+				pixel.normal = make_float3(d[0], d[1], d[2])*inv_num_samples;
+				pixel.albedo = make_float3(d[3], d[4], d[5])*inv_num_samples;
+				pixel.depth = d[6]*inv_num_samples;
+
+				/* variance of the mean, from the luminance of the samples */
+				float luminance = linear_rgb_to_gray(pixel.color);
+				float second_moment = d[7]*inv_num_samples;
+				pixel.variance = max(second_moment - luminance*luminance, 0.0f)*inv_num_samples;
+				pixel.valid = true;
+			}
+		}
+	}
+}
+
+void Denoiser::filter(int x, int y, int w, int h, vector<float3>& result) const
+{
+	const int radius = params.radius;
+	const int patch_radius = DENOISE_PATCH_RADIUS;
+	const int border = radius + patch_radius;
+
+	/* pixels of the rect, with the search window and patches around it */
+	const int gw = w + 2*border;
+	const int gh = h + 2*border;
+	vector<Pixel> pixels;
+
+	gather(x - border, y - border, gw, gh, pixels);
+
+	/* pixel distances are computed once per offset for the rect and the
+	 * patches around it, and then summed for each patch */
+	const int ew = w + 2*patch_radius;
+	const int eh = h + 2*patch_radius;
+	vector<float> distance(ew*eh);
+	vector<float> distance_count(ew*eh);
+
+	vector<float3> color_sum(w*h, make_float3(0.0f, 0.0f, 0.0f));
+	vector<float> weight_sum(w*h, 0.0f);
+
+	const float k2 = params.strength*params.strength;
+	const float epsilon = 1e-8f;
+	const float fs = max(params.feature_strength, 1e-4f);
+	const float inv_normal2 = 1.0f/(DENOISE_NORMAL_TOLERANCE*DENOISE_NORMAL_TOLERANCE*fs*fs);
+	const float inv_albedo2 = 1.0f/(DENOISE_ALBEDO_TOLERANCE*DENOISE_ALBEDO_TOLERANCE*fs*fs);
+	const float inv_depth = 1.0f/(DENOISE_DEPTH_TOLERANCE*fs);
+
+	for(int dy = -radius; dy <= radius; dy++) {
+		for(int dx = -radius; dx <= radius; dx++) {
+			/* color distance relative to the variance, with the expected
+			 * difference due to noise removed */
+			for(int j = 0; j < eh; j++) {
+				for(int i = 0; i < ew; i++) {
+					const Pixel& p = pixels[(radius + i) + (radius + j)*gw];
+					const Pixel& q = pixels[(radius + i + dx) + (radius + j + dy)*gw];
+					int e = i + j*ew;
+
+					if(!(p.valid && q.valid)) {
+						distance[e] = 0.0f;
+						distance_count[e] = 0.0f;
+						continue;
+					}
+
+					float3 diff = p.color - q.color;
+					float variance = p.variance + min(p.variance, q.variance);
+					float scale = 1.0f/(epsilon + k2*(p.variance + q.variance));
+					float3 d = (diff*diff - make_float3(variance, variance, variance))*scale;
+
+					distance[e] = (d.x + d.y + d.z)*(1.0f/3.0f);
+					distance_count[e] = 1.0f;
+				}
+			}
+
+			for(int j = 0; j < h; j++) {
+				for(int i = 0; i < w; i++) {
+					const Pixel& p = pixels[(border + i) + (border + j)*gw];
+					const Pixel& q = pixels[(border + i + dx) + (border + j + dy)*gw];
+
+					if(!(p.valid && q.valid))
+						continue;
+
+					/* patch distance */
+					float patch_distance = 0.0f, patch_count = 0.0f;
+
+					for(int pj = j; pj <= j + 2*patch_radius; pj++) {
+						for(int pi = i; pi <= i + 2*patch_radius; pi++) {
+							patch_distance += distance[pi + pj*ew];
+							patch_count += distance_count[pi + pj*ew];
+						}
+					}
+
+					if(patch_count > 0.0f)
+						patch_distance /= patch_count;
+
+					float color_weight = expf(-max(patch_distance, 0.0f));
+
+					/* feature distance */
+					float depth_diff = (p.depth - q.depth)*inv_depth/max(p.depth, 1e-4f);
+					float feature_distance = len_squared(p.normal - q.normal)*inv_normal2 +
+					                         len_squared(p.albedo - q.albedo)*inv_albedo2 +
+					                         depth_diff*depth_diff;
+					float feature_weight = expf(-feature_distance);
+
+					/* both color and features must be similar */
+					float weight = min(color_weight, feature_weight);
+
+					color_sum[i + j*w] += q.color*weight;
+					weight_sum[i + j*w] += weight;
+				}
+			}
+		}
+	}
+
+	result.resize(w*h);
+
+	for(int j = 0; j < h; j++) {
+		for(int i = 0; i < w; i++) {
+			const Pixel& p = pixels[(border + i) + (border + j)*gw];
+			float weight = weight_sum[i + j*w];
+
+			if(p.valid && weight > 0.0f)
+				result[i + j*w] = color_sum[i + j*w]/weight;
+			else
+				result[i + j*w] = make_float3(0.0f, 0.0f, 0.0f);
+		}
+	}
+}
+
+void Denoiser::write(RenderBuffers *buffers, int sample, int x, int y, int w, int h,
+                     const vector<float3>& result) const
+{
+	BufferParams& bparams = buffers->params;
+	float *combined = buffers->get_pass_pointer(PASS_COMBINED);
+	float *count = buffers->get_pass_pointer(PASS_SAMPLE_COUNT);
+	int pass_stride = bparams.get_passes_size();
+
+	if(!combined)
+		return;
+
+	int x0 = max(x, bparams.full_x), x1 = min(x + w, bparams.full_x + bparams.width);
+	int y0 = max(y, bparams.full_y), y1 = min(y + h, bparams.full_y + bparams.height);
+
+	for(int py = y0; py < y1; py++) {
+		for(int px = x0; px < x1; px++) {
+			int index = (px - bparams.full_x) + (py - bparams.full_y)*bparams.width;
+			float num_samples = (count)? count[index*pass_stride]: (float)sample;
+
+			if(num_samples <= 0.0f)
+				continue;
+
+			/* buffers hold the sum of all samples */
+			float3 color = result[(px - x) + (py - y)*w]*num_samples;
+			float *c = combined + index*pass_stride;
+
+			c[0] = color.x;
+			c[1] = color.y;
+			c[2] = color.z;
+		}
+	}
+}
+
+CCL_NAMESPACE_END
+
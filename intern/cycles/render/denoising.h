@@ -0,0 +1,102 @@
+/*
+ * Copyright 2011-2015 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __DENOISING_H__
+#define __DENOISING_H__
+
+#include "util_types.h"
+#include "util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+class RenderBuffers;
+
+/* Denoising Parameters */
+
+class DenoiseParams {
+public:
+	/* half size of the search window in pixels */
+	int radius;
+	/* scale of the color difference relative to the noise, larger values
+	 * filter more */
+	float strength;
+	/* scale of the tolerated normal, albedo and depth differences, larger
+	 * values filter more across feature edges */
+	float feature_strength;
+
+	DenoiseParams()
+	: radius(8), strength(0.5f), feature_strength(1.0f) {}
+
+	bool modified(const DenoiseParams& params) const
+	{ return !(radius == params.radius &&
+	           strength == params.strength &&
+	           feature_strength == params.feature_strength); }
+};
+
+/* Denoiser
+ *
+ * Non-local means filter of the combined pass, guided by the features of the
+ * first hit written to the denoising pass: normal, albedo and depth. Color
+ * differences are measured over small patches, relative to the variance of
+ * the pixels estimated from the luminance second moment, so noisy pixels are
+ * filtered more than converged ones.
+ *
+ * Pixels are read from any number of render buffers, so a tile can be
+ * filtered with the pixels of the tiles around it. Buffers must have been
+ * copied from the device, and must stay unmodified while filtering. */
+
+class Denoiser {
+public:
+	explicit Denoiser(const DenoiseParams& params);
+
+	/* buffers with the denoising pass, and the number of samples rendered
+	 * for pixels without a sample count pass */
+	void add_buffers(RenderBuffers *buffers, int sample);
+
+	/* filter the combined color of the rect in full image coordinates,
+	 * using pixels of all buffers within the search window */
+	void filter(int x, int y, int w, int h, vector<float3>& result) const;
+
+	/* replace the combined color of the rect in buffers by the result,
+	 * keeping alpha and the number of samples */
+	void write(RenderBuffers *buffers, int sample, int x, int y, int w, int h,
+	           const vector<float3>& result) const;
+
+protected:
+	struct Source {
+		RenderBuffers *buffers;
+		int sample;
+	};
+
+	struct Pixel {
+		float3 color;
+		float3 normal;
+		float3 albedo;
+		float depth;
+		float variance;
+		bool valid;
+	};
+
+	void gather(int x, int y, int w, int h, vector<Pixel>& pixels) const;
+
+	DenoiseParams params;
+	vector<Source> sources;
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __DENOISING_H__ */
+
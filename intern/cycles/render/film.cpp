@@ -33,6 +33,9 @@ CCL_NAMESPACE_BEGIN
 
 static bool compare_pass_order(const Pass& a, const Pass& b)
 {
+	/* the kernel writes the combined pass at the start of the pixel */
+	if(a.type == PASS_COMBINED || b.type == PASS_COMBINED)
+		return (a.type == PASS_COMBINED && b.type != PASS_COMBINED);
 	if(a.components == b.components)
 		return (a.type < b.type);
 	return (a.components > b.components);
@@ -146,11 +149,28 @@ void Pass::add(PassType type, vector<Pass>& passes)
 		case PASS_LIGHT:
 			/* ignores */
 			break;
+		case PASS_SAMPLE_COUNT:
+			pass.components = 1;
+			pass.filter = false;
+			break;
+		case PASS_ADAPTIVE_AUX_BUFFER:
+			pass.components = 2;
+			pass.filter = false;
+			break;
+		case PASS_DENOISING:
+			pass.components = 8;
+			pass.filter = false;
+			pass.exposure = false;
+			break;
 #ifdef WITH_CYCLES_DEBUG
 		case PASS_BVH_TRAVERSAL_STEPS:
 			pass.components = 1;
 			pass.exposure = false;
 			break;
+		case PASS_RENDER_TIME:
+			pass.components = 1;
+			pass.exposure = false;
+			break;
 #endif
 	}
 
@@ -395,10 +415,23 @@ void Film::device_update(Device *device, DeviceScene *dscene, Scene *scene)
 				kfilm->use_light_pass = 1;
 				break;
 
+			case PASS_SAMPLE_COUNT:
+				kfilm->pass_sample_count = kfilm->pass_stride;
+				break;
+			case PASS_ADAPTIVE_AUX_BUFFER:
+				kfilm->pass_adaptive_aux_buffer = kfilm->pass_stride;
+				break;
+			case PASS_DENOISING:
+				kfilm->pass_denoising = kfilm->pass_stride;
+				break;
+
 #ifdef WITH_CYCLES_DEBUG
 			case PASS_BVH_TRAVERSAL_STEPS:
 				kfilm->pass_bvh_traversal_steps = kfilm->pass_stride;
 				break;
+			case PASS_RENDER_TIME:
+				kfilm->pass_render_time = kfilm->pass_stride;
+				break;
 #endif
 
 			case PASS_NONE:
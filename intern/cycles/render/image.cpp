@@ -18,8 +18,11 @@
 #include "image.h"
 #include "scene.h"
 
+#include "kernel_texture_cache.h"
+
 #include "util_foreach.h"
 #include "util_image.h"
+#include "util_logging.h"
 #include "util_path.h"
 #include "util_progress.h"
 
@@ -33,7 +36,11 @@ ImageManager::ImageManager()
 {
 	need_update = true;
 	pack_images = false;
+	compact_images = false;
 	osl_texture_system = NULL;
+	use_texture_cache = false;
+	texture_cache_size = 1024;
+	texture_cache = NULL;
 	animation_frame = 0;
 
 	tex_num_images = TEX_NUM_IMAGES;
@@ -59,12 +66,21 @@ void ImageManager::set_osl_texture_system(void *texture_system)
 	osl_texture_system = texture_system;
 }
 
+void ImageManager::set_texture_cache(bool use_texture_cache_, int texture_cache_size_)
+{
+	use_texture_cache = use_texture_cache_;
+	texture_cache_size = texture_cache_size_;
+}
+
 void ImageManager::set_extended_image_limits(const DeviceInfo& info)
 {
 	if(info.type == DEVICE_CPU) {
 		tex_num_images = TEX_EXTENDED_NUM_IMAGES_CPU;
 		tex_num_float_images = TEX_EXTENDED_NUM_FLOAT_IMAGES;
 		tex_image_byte_start = TEX_EXTENDED_IMAGE_BYTE_START;
+
+		/* the CPU kernel can also read half float and single channel images */
+		compact_images = true;
 	}
 	else if((info.type == DEVICE_CUDA || info.type == DEVICE_MULTI) && info.extended_images) {
 		tex_num_images = TEX_EXTENDED_NUM_IMAGES_GPU;
@@ -89,13 +105,24 @@ bool ImageManager::set_animation_frame_update(int frame)
 }
 
 bool ImageManager::is_float_image(const string& filename, void *builtin_data, bool& is_linear)
+{
+	int channels;
+	bool is_half;
+
+	return is_float_image(filename, builtin_data, is_linear, channels, is_half);
+}
+
+bool ImageManager::is_float_image(const string& filename, void *builtin_data, bool& is_linear,
+                                  int& channels, bool& is_half)
 {
 	bool is_float = false;
 	is_linear = false;
+	channels = 0;
+	is_half = false;
 
 	if(builtin_data) {
 		if(builtin_image_info_cb) {
-			int width, height, depth, channels;
+			int width, height, depth;
 			builtin_image_info_cb(filename, builtin_data, is_float, width, height, depth, channels);
 		}
 
@@ -125,6 +152,17 @@ bool ImageManager::is_float_image(const string& filename, void *builtin_data, bo
 				}
 			}
 
+			channels = spec.nchannels;
+
+			/* only half float files are stored as half, other float
+			 * formats would lose precision */
+			is_half = (spec.format == TypeDesc::HALF);
+
+			for(size_t channel = 0; channel < spec.channelformats.size(); channel++) {
+				if(spec.channelformats[channel] != TypeDesc::HALF)
+					is_half = false;
+			}
+
 			/* basic color space detection, not great but better than nothing
 			 * before we do OpenColorIO integration */
 			if(is_float) {
@@ -163,9 +201,11 @@ int ImageManager::add_image(const string& filename, void *builtin_data, bool ani
 {
 	Image *img;
 	size_t slot;
+	int channels = 0;
+	bool is_half = false;
 
 	/* load image info and find out if we need a float texture */
-	is_float = (pack_images)? false: is_float_image(filename, builtin_data, is_linear);
+	is_float = (pack_images)? false: is_float_image(filename, builtin_data, is_linear, channels, is_half);
 
 	if(is_float) {
 		/* find existing image */
@@ -180,6 +220,8 @@ int ImageManager::add_image(const string& filename, void *builtin_data, bool ani
 					img->use_alpha = use_alpha;
 					img->need_load = true;
 				}
+				img->channels = channels;
+				img->is_half = is_half;
 				img->users++;
 				return slot;
 			}
@@ -210,6 +252,8 @@ int ImageManager::add_image(const string& filename, void *builtin_data, bool ani
 		img->animated = animated;
 		img->frame = frame;
 		img->interpolation = interpolation;
+		img->channels = channels;
+		img->is_half = is_half;
 		img->users = 1;
 		img->use_alpha = use_alpha;
 
@@ -227,6 +271,8 @@ int ImageManager::add_image(const string& filename, void *builtin_data, bool ani
 					img->use_alpha = use_alpha;
 					img->need_load = true;
 				}
+				img->channels = channels;
+				img->is_half = is_half;
 				img->users++;
 				return slot+tex_image_byte_start;
 			}
@@ -257,6 +303,8 @@ int ImageManager::add_image(const string& filename, void *builtin_data, bool ani
 		img->animated = animated;
 		img->frame = frame;
 		img->interpolation = interpolation;
+		img->channels = channels;
+		img->is_half = is_half;
 		img->users = 1;
 		img->use_alpha = use_alpha;
 
@@ -348,132 +396,49 @@ void ImageManager::tag_reload_image(const string& filename, void *builtin_data,
 	}
 }
 
-bool ImageManager::file_load_image(Image *img, device_vector<uchar4>& tex_img)
+ImageManager::ImageDataType ImageManager::get_image_data_type(Image *img, bool is_float)
 {
-	if(img->filename == "")
-		return false;
-
-	ImageInput *in = NULL;
-	int width, height, depth, components;
-
-	if(!img->builtin_data) {
-		/* load image from file through OIIO */
-		in = ImageInput::create(img->filename);
-
-		if(!in)
-			return false;
+	ImageDataType type = (is_float)? IMAGE_DATA_TYPE_FLOAT4: IMAGE_DATA_TYPE_BYTE4;
 
-		ImageSpec spec = ImageSpec();
-		ImageSpec config = ImageSpec();
-
-		if(img->use_alpha == false)
-			config.attribute("oiio:UnassociatedAlpha", 1);
-
-		if(!in->open(img->filename, spec, config)) {
-			delete in;
-			return false;
-		}
-
-		width = spec.width;
-		height = spec.height;
-		depth = spec.depth;
-		components = spec.nchannels;
-	}
-	else {
-		/* load image using builtin images callbacks */
-		if(!builtin_image_info_cb || !builtin_image_pixels_cb)
-			return false;
-
-		bool is_float;
-		builtin_image_info_cb(img->filename, img->builtin_data, is_float, width, height, depth, components);
-	}
-
-	/* we only handle certain number of components */
-	if(!(components >= 1 && components <= 4)) {
-		if(in) {
-			in->close();
-			delete in;
-		}
+	if(!compact_images)
+		return type;
 
-		return false;
-	}
+	/* format was read when the image was added, no need to open it again */
+	if(img->channels == 1)
+		type = (is_float)? IMAGE_DATA_TYPE_FLOAT: IMAGE_DATA_TYPE_BYTE;
+	else if(is_float && img->is_half)
+		type = IMAGE_DATA_TYPE_HALF4;
 
-	/* read RGBA pixels */
-	uchar *pixels = (uchar*)tex_img.resize(width, height, depth);
-	bool cmyk = false;
+	return type;
+}
 
-	if(in) {
-		if(depth <= 1) {
-			int scanlinesize = width*components*sizeof(uchar);
+/* Pixel formats used for image storage on the device */
 
-			in->read_image(TypeDesc::UINT8,
-				(uchar*)pixels + (((size_t)height)-1)*scanlinesize,
-				AutoStride,
-				-scanlinesize,
-				AutoStride);
-		}
-		else {
-			in->read_image(TypeDesc::UINT8, (uchar*)pixels);
-		}
+template<typename T> struct ImageStorage;
 
-		cmyk = strcmp(in->format_name(), "jpeg") == 0 && components == 4;
+template<> struct ImageStorage<uchar> {
+	static TypeDesc format() { return TypeDesc::UINT8; }
+	static uchar one() { return 255; }
+};
 
-		in->close();
-		delete in;
-	}
-	else {
-		builtin_image_pixels_cb(img->filename, img->builtin_data, pixels);
-	}
+template<> struct ImageStorage<float> {
+	static TypeDesc format() { return TypeDesc::FLOAT; }
+	static float one() { return 1.0f; }
+};
 
-	size_t num_pixels = ((size_t)width) * height * depth;
-	if(cmyk) {
-		/* CMYK */
-		for(size_t i = num_pixels-1, pixel = 0; pixel < num_pixels; pixel++, i--) {
-			pixels[i*4+2] = (pixels[i*4+2]*pixels[i*4+3])/255;
-			pixels[i*4+1] = (pixels[i*4+1]*pixels[i*4+3])/255;
-			pixels[i*4+0] = (pixels[i*4+0]*pixels[i*4+3])/255;
-			pixels[i*4+3] = 255;
-		}
-	}
-	else if(components == 2) {
-		/* grayscale + alpha */
-		for(size_t i = num_pixels-1, pixel = 0; pixel < num_pixels; pixel++, i--) {
-			pixels[i*4+3] = pixels[i*2+1];
-			pixels[i*4+2] = pixels[i*2+0];
-			pixels[i*4+1] = pixels[i*2+0];
-			pixels[i*4+0] = pixels[i*2+0];
-		}
-	}
-	else if(components == 3) {
-		/* RGB */
-		for(size_t i = num_pixels-1, pixel = 0; pixel < num_pixels; pixel++, i--) {
-			pixels[i*4+3] = 255;
-			pixels[i*4+2] = pixels[i*3+2];
-			pixels[i*4+1] = pixels[i*3+1];
-			pixels[i*4+0] = pixels[i*3+0];
-		}
-	}
-	else if(components == 1) {
-		/* grayscale */
-		for(size_t i = num_pixels-1, pixel = 0; pixel < num_pixels; pixel++, i--) {
-			pixels[i*4+3] = 255;
-			pixels[i*4+2] = pixels[i];
-			pixels[i*4+1] = pixels[i];
-			pixels[i*4+0] = pixels[i];
-		}
-	}
+template<> struct ImageStorage<half> {
+	static TypeDesc format() { return TypeDesc::HALF; }
+	static half one() { return 0x3C00; }
+};
 
-	if(img->use_alpha == false) {
-		for(size_t i = num_pixels-1, pixel = 0; pixel < num_pixels; pixel++, i--) {
-			pixels[i*4+3] = 255;
-		}
-	}
-
-	return true;
-}
-
-bool ImageManager::file_load_float_image(Image *img, device_vector<float4>& tex_img)
+template<typename StorageType, typename DeviceType>
+bool ImageManager::file_load_image(Image *img, device_vector<DeviceType>& tex_img)
 {
+	/* images are stored either as RGBA or as a single grayscale channel */
+	const int channels = sizeof(DeviceType)/sizeof(StorageType);
+	const TypeDesc format = ImageStorage<StorageType>::format();
+	const StorageType one = ImageStorage<StorageType>::one();
+
 	if(img->filename == "")
 		return false;
 
@@ -491,29 +456,35 @@ bool ImageManager::file_load_float_image(Image *img, device_vector<float4>& tex_
 		ImageSpec config = ImageSpec();
 
 		if(img->use_alpha == false)
-			config.attribute("oiio:UnassociatedAlpha",1);
+			config.attribute("oiio:UnassociatedAlpha", 1);
 
 		if(!in->open(img->filename, spec, config)) {
 			delete in;
 			return false;
 		}
 
-		/* we only handle certain number of components */
 		width = spec.width;
 		height = spec.height;
 		depth = spec.depth;
 		components = spec.nchannels;
 	}
 	else {
-		/* load image using builtin images callbacks */
-		if(!builtin_image_info_cb || !builtin_image_float_pixels_cb)
+		/* load image using builtin images callbacks, these have no half floats */
+		if(!builtin_image_info_cb)
+			return false;
+		if(format == TypeDesc::FLOAT && !builtin_image_float_pixels_cb)
+			return false;
+		if(format == TypeDesc::UINT8 && !builtin_image_pixels_cb)
+			return false;
+		if(format == TypeDesc::HALF)
 			return false;
 
 		bool is_float;
 		builtin_image_info_cb(img->filename, img->builtin_data, is_float, width, height, depth, components);
 	}
 
-	if(components < 1 || width == 0 || height == 0) {
+	/* we only handle certain number of components */
+	if(components < 1 || width == 0 || height == 0 || (channels == 1 && components != 1)) {
 		if(in) {
 			in->close();
 			delete in;
@@ -521,35 +492,35 @@ bool ImageManager::file_load_float_image(Image *img, device_vector<float4>& tex_
 		return false;
 	}
 
-	/* read RGBA pixels */
-	float *pixels = (float*)tex_img.resize(width, height, depth);
+	/* read pixels */
+	StorageType *pixels = (StorageType*)tex_img.resize(width, height, depth);
+	size_t num_pixels = ((size_t)width) * height * depth;
 	bool cmyk = false;
 
 	if(in) {
-		float *readpixels = pixels;
-		vector<float> tmppixels;
+		StorageType *readpixels = pixels;
+		vector<StorageType> tmppixels;
 
-		if(components > 4) {
-			tmppixels.resize(((size_t)width)*height*components);
+		if(components > channels) {
+			tmppixels.resize(num_pixels*components);
 			readpixels = &tmppixels[0];
 		}
 
 		if(depth <= 1) {
-			int scanlinesize = width*components*sizeof(float);
+			int scanlinesize = width*components*sizeof(StorageType);
 
-			in->read_image(TypeDesc::FLOAT,
-				(uchar*)readpixels + (height-1)*scanlinesize,
+			in->read_image(format,
+				(uchar*)readpixels + (((size_t)height)-1)*scanlinesize,
 				AutoStride,
 				-scanlinesize,
 				AutoStride);
 		}
 		else {
-			in->read_image(TypeDesc::FLOAT, (uchar*)readpixels);
+			in->read_image(format, (uchar*)readpixels);
 		}
 
-		if(components > 4) {
-			size_t dimensions = ((size_t)width)*height;
-			for(size_t i = dimensions-1, pixel = 0; pixel < dimensions; pixel++, i--) {
+		if(components > channels) {
+			for(size_t i = num_pixels-1, pixel = 0; pixel < num_pixels; pixel++, i--) {
 				pixels[i*4+3] = tmppixels[i*components+3];
 				pixels[i*4+2] = tmppixels[i*components+2];
 				pixels[i*4+1] = tmppixels[i*components+1];
@@ -559,23 +530,29 @@ bool ImageManager::file_load_float_image(Image *img, device_vector<float4>& tex_
 			tmppixels.clear();
 		}
 
-		cmyk = strcmp(in->format_name(), "jpeg") == 0 && components == 4;
+		cmyk = format == TypeDesc::UINT8 && strcmp(in->format_name(), "jpeg") == 0 && components == 4;
 
 		in->close();
 		delete in;
 	}
+	else if(format == TypeDesc::FLOAT) {
+		builtin_image_float_pixels_cb(img->filename, img->builtin_data, (float*)pixels);
+	}
 	else {
-		builtin_image_float_pixels_cb(img->filename, img->builtin_data, pixels);
+		builtin_image_pixels_cb(img->filename, img->builtin_data, (uchar*)pixels);
 	}
 
-	size_t num_pixels = ((size_t)width) * height * depth;
+	/* single channel storage is used as is */
+	if(channels == 1)
+		return true;
+
 	if(cmyk) {
 		/* CMYK */
 		for(size_t i = num_pixels-1, pixel = 0; pixel < num_pixels; pixel++, i--) {
-			pixels[i*4+3] = 255;
-			pixels[i*4+2] = (pixels[i*4+2]*pixels[i*4+3])/255;
-			pixels[i*4+1] = (pixels[i*4+1]*pixels[i*4+3])/255;
-			pixels[i*4+0] = (pixels[i*4+0]*pixels[i*4+3])/255;
+			pixels[i*4+2] = (pixels[i*4+2]*pixels[i*4+3])/one;
+			pixels[i*4+1] = (pixels[i*4+1]*pixels[i*4+3])/one;
+			pixels[i*4+0] = (pixels[i*4+0]*pixels[i*4+3])/one;
+			pixels[i*4+3] = one;
 		}
 	}
 	else if(components == 2) {
@@ -590,7 +567,7 @@ bool ImageManager::file_load_float_image(Image *img, device_vector<float4>& tex_
 	else if(components == 3) {
 		/* RGB */
 		for(size_t i = num_pixels-1, pixel = 0; pixel < num_pixels; pixel++, i--) {
-			pixels[i*4+3] = 1.0f;
+			pixels[i*4+3] = one;
 			pixels[i*4+2] = pixels[i*3+2];
 			pixels[i*4+1] = pixels[i*3+1];
 			pixels[i*4+0] = pixels[i*3+0];
@@ -599,7 +576,7 @@ bool ImageManager::file_load_float_image(Image *img, device_vector<float4>& tex_
 	else if(components == 1) {
 		/* grayscale */
 		for(size_t i = num_pixels-1, pixel = 0; pixel < num_pixels; pixel++, i--) {
-			pixels[i*4+3] = 1.0f;
+			pixels[i*4+3] = one;
 			pixels[i*4+2] = pixels[i];
 			pixels[i*4+1] = pixels[i];
 			pixels[i*4+0] = pixels[i];
@@ -608,13 +585,36 @@ bool ImageManager::file_load_float_image(Image *img, device_vector<float4>& tex_
 
 	if(img->use_alpha == false) {
 		for(size_t i = num_pixels-1, pixel = 0; pixel < num_pixels; pixel++, i--) {
-			pixels[i*4+3] = 1.0f;
+			pixels[i*4+3] = one;
 		}
 	}
 
 	return true;
 }
 
+template<typename T>
+void ImageManager::device_alloc_image(Device *device, device_vector<T>& tex_img, const char *name, int slot, InterpolationType interpolation)
+{
+	if(pack_images)
+		return;
+
+	string tex_name = string_printf("%s_%03d", name, slot);
+
+	thread_scoped_lock device_lock(device_mutex);
+	device->tex_alloc(tex_name.c_str(), tex_img, interpolation, true);
+}
+
+template<typename T>
+void ImageManager::device_free_image(Device *device, device_vector<T>& tex_img)
+{
+	if(tex_img.device_pointer) {
+		thread_scoped_lock device_lock(device_mutex);
+		device->tex_free(tex_img);
+	}
+
+	tex_img.clear();
+}
+
 void ImageManager::device_load_image(Device *device, DeviceScene *dscene, int slot, Progress *progress)
 {
 	if(progress->get_cancel())
@@ -622,9 +622,10 @@ void ImageManager::device_load_image(Device *device, DeviceScene *dscene, int sl
 	
 	Image *img;
 	bool is_float;
+	int byte_slot = slot - tex_image_byte_start;
 
 	if(slot >= tex_image_byte_start) {
-		img = images[slot - tex_image_byte_start];
+		img = images[byte_slot];
 		is_float = false;
 	}
 	else {
@@ -635,68 +636,84 @@ void ImageManager::device_load_image(Device *device, DeviceScene *dscene, int sl
 	if(osl_texture_system && !img->builtin_data)
 		return;
 
+	if(texture_cache && !img->builtin_data) {
+		texture_cache_load_image(img, slot);
+		img->need_load = false;
+		return;
+	}
+
+	string filename = path_filename(img->filename);
+	progress->set_status("Updating Images", "Loading " + filename);
+
+	/* free previous pixels of the slot, they may be stored in another format */
 	if(is_float) {
-		string filename = path_filename(float_images[slot]->filename);
-		progress->set_status("Updating Images", "Loading " + filename);
+		device_free_image(device, dscene->tex_float_image[slot]);
+		device_free_image(device, dscene->tex_half_image[slot]);
+		device_free_image(device, dscene->tex_float1_image[slot]);
+	}
+	else {
+		device_free_image(device, dscene->tex_image[byte_slot]);
+		device_free_image(device, dscene->tex_byte1_image[byte_slot]);
+	}
 
-		device_vector<float4>& tex_img = dscene->tex_float_image[slot];
+	bool loaded = false;
 
-		if(tex_img.device_pointer) {
-			thread_scoped_lock device_lock(device_mutex);
-			device->tex_free(tex_img);
+	switch(get_image_data_type(img, is_float)) {
+		case IMAGE_DATA_TYPE_FLOAT4: {
+			device_vector<float4>& tex_img = dscene->tex_float_image[slot];
+			if((loaded = file_load_image<float>(img, tex_img)))
+				device_alloc_image(device, tex_img, "__tex_image_float", slot, img->interpolation);
+			break;
 		}
+		case IMAGE_DATA_TYPE_BYTE4: {
+			device_vector<uchar4>& tex_img = dscene->tex_image[byte_slot];
+			if((loaded = file_load_image<uchar>(img, tex_img)))
+				device_alloc_image(device, tex_img, "__tex_image", slot, img->interpolation);
+			break;
+		}
+		case IMAGE_DATA_TYPE_HALF4: {
+			device_vector<half4>& tex_img = dscene->tex_half_image[slot];
+			if((loaded = file_load_image<half>(img, tex_img)))
+				device_alloc_image(device, tex_img, "__tex_image_half4", slot, img->interpolation);
+			break;
+		}
+		case IMAGE_DATA_TYPE_FLOAT: {
+			device_vector<float>& tex_img = dscene->tex_float1_image[slot];
+			if((loaded = file_load_image<float>(img, tex_img)))
+				device_alloc_image(device, tex_img, "__tex_image_float1", slot, img->interpolation);
+			break;
+		}
+		case IMAGE_DATA_TYPE_BYTE: {
+			device_vector<uchar>& tex_img = dscene->tex_byte1_image[byte_slot];
+			if((loaded = file_load_image<uchar>(img, tex_img)))
+				device_alloc_image(device, tex_img, "__tex_image_byte1", slot, img->interpolation);
+			break;
+		}
+	}
 
-		if(!file_load_float_image(img, tex_img)) {
-			/* on failure to load, we set a 1x1 pixels pink image */
+	if(!loaded) {
+		/* on failure to load, we set a 1x1 pixels pink image */
+		if(is_float) {
+			device_vector<float4>& tex_img = dscene->tex_float_image[slot];
 			float *pixels = (float*)tex_img.resize(1, 1);
 
 			pixels[0] = TEX_IMAGE_MISSING_R;
 			pixels[1] = TEX_IMAGE_MISSING_G;
 			pixels[2] = TEX_IMAGE_MISSING_B;
 			pixels[3] = TEX_IMAGE_MISSING_A;
-		}
-
-		string name;
-
-		if(slot >= 100) name = string_printf("__tex_image_float_%d", slot);
-		else if(slot >= 10) name = string_printf("__tex_image_float_0%d", slot);
-		else name = string_printf("__tex_image_float_00%d", slot);
 
-		if(!pack_images) {
-			thread_scoped_lock device_lock(device_mutex);
-			device->tex_alloc(name.c_str(), tex_img, img->interpolation, true);
-		}
-	}
-	else {
-		string filename = path_filename(images[slot - tex_image_byte_start]->filename);
-		progress->set_status("Updating Images", "Loading " + filename);
-
-		device_vector<uchar4>& tex_img = dscene->tex_image[slot - tex_image_byte_start];
-
-		if(tex_img.device_pointer) {
-			thread_scoped_lock device_lock(device_mutex);
-			device->tex_free(tex_img);
+			device_alloc_image(device, tex_img, "__tex_image_float", slot, img->interpolation);
 		}
-
-		if(!file_load_image(img, tex_img)) {
-			/* on failure to load, we set a 1x1 pixels pink image */
+		else {
+			device_vector<uchar4>& tex_img = dscene->tex_image[byte_slot];
 			uchar *pixels = (uchar*)tex_img.resize(1, 1);
 
 			pixels[0] = (TEX_IMAGE_MISSING_R * 255);
 			pixels[1] = (TEX_IMAGE_MISSING_G * 255);
 			pixels[2] = (TEX_IMAGE_MISSING_B * 255);
 			pixels[3] = (TEX_IMAGE_MISSING_A * 255);
-		}
 
-		string name;
-
-		if(slot >= 100) name = string_printf("__tex_image_%d", slot);
-		else if(slot >= 10) name = string_printf("__tex_image_0%d", slot);
-		else name = string_printf("__tex_image_00%d", slot);
-
-		if(!pack_images) {
-			thread_scoped_lock device_lock(device_mutex);
-			device->tex_alloc(name.c_str(), tex_img, img->interpolation, true);
+			device_alloc_image(device, tex_img, "__tex_image", slot, img->interpolation);
 		}
 	}
 
@@ -724,28 +741,30 @@ void ImageManager::device_free_image(Device *device, DeviceScene *dscene, int sl
 			((OSL::TextureSystem*)osl_texture_system)->invalidate(filename);
 #endif
 		}
-		else if(is_float) {
-			device_vector<float4>& tex_img = dscene->tex_float_image[slot];
+		else if(texture_cache && !img->builtin_data) {
+			texture_cache->ts->invalidate(ustring(img->filename));
+			texture_cache->slots[slot] = TextureCacheGlobals::Slot();
 
-			if(tex_img.device_pointer) {
-				thread_scoped_lock device_lock(device_mutex);
-				device->tex_free(tex_img);
+			if(is_float) {
+				delete float_images[slot];
+				float_images[slot] = NULL;
 			}
-
-			tex_img.clear();
+			else {
+				delete images[slot - tex_image_byte_start];
+				images[slot - tex_image_byte_start] = NULL;
+			}
+		}
+		else if(is_float) {
+			device_free_image(device, dscene->tex_float_image[slot]);
+			device_free_image(device, dscene->tex_half_image[slot]);
+			device_free_image(device, dscene->tex_float1_image[slot]);
 
 			delete float_images[slot];
 			float_images[slot] = NULL;
 		}
 		else {
-			device_vector<uchar4>& tex_img = dscene->tex_image[slot - tex_image_byte_start];
-
-			if(tex_img.device_pointer) {
-				thread_scoped_lock device_lock(device_mutex);
-				device->tex_free(tex_img);
-			}
-
-			tex_img.clear();
+			device_free_image(device, dscene->tex_image[slot - tex_image_byte_start]);
+			device_free_image(device, dscene->tex_byte1_image[slot - tex_image_byte_start]);
 
 			delete images[slot - tex_image_byte_start];
 			images[slot - tex_image_byte_start] = NULL;
@@ -758,6 +777,9 @@ void ImageManager::device_update(Device *device, DeviceScene *dscene, Progress&
 	if(!need_update)
 		return;
 
+	if(use_texture_cache && !osl_texture_system && !texture_cache)
+		texture_cache_init(device);
+
 	TaskPool pool;
 
 	for(size_t slot = 0; slot < images.size(); slot++) {
@@ -902,6 +924,77 @@ void ImageManager::device_free(Device *device, DeviceScene *dscene)
 
 	images.clear();
 	float_images.clear();
+
+	texture_cache_free();
+}
+
+void ImageManager::texture_cache_init(Device *device)
+{
+	texture_cache = (TextureCacheGlobals*)device->texture_cache_memory();
+
+	/* not supported by the device, images are loaded into memory */
+	if(!texture_cache)
+		return;
+
+	OIIO::TextureSystem *ts = OIIO::TextureSystem::create(false);
+
+	/* files that are not tiled or MIP-mapped already are tiled on the fly,
+	 * only tiled files avoid reading the full image though */
+	ts->attribute("automip", 1);
+	ts->attribute("autotile", 64);
+	ts->attribute("gray_to_rgb", 1);
+	ts->attribute("max_memory_MB", (float)texture_cache_size);
+
+	texture_cache->ts = ts;
+	texture_cache->slots.resize(tex_image_byte_start + tex_num_images);
+
+	VLOG(1) << "Texture cache enabled, " << texture_cache_size << " MB.";
+}
+
+void ImageManager::texture_cache_free()
+{
+	if(!texture_cache)
+		return;
+
+	if(texture_cache->ts) {
+		VLOG(2) << texture_cache->ts->getstats();
+		OIIO::TextureSystem::destroy(texture_cache->ts);
+	}
+
+	texture_cache->ts = NULL;
+	texture_cache->slots.clear();
+	texture_cache = NULL;
+}
+
+void ImageManager::texture_cache_load_image(Image *img, int slot)
+{
+	OIIO::TextureSystem *ts = texture_cache->ts;
+	ustring filename(img->filename);
+
+	/* pick up changes to the file when reloading */
+	ts->invalidate(filename);
+
+	TextureCacheGlobals::Slot& tex = texture_cache->slots[slot];
+	OIIO::TextureOpt& options = tex.options;
+
+	tex.handle = ts->get_texture_handle(filename);
+	tex.use_alpha = img->use_alpha;
+
+	/* images in memory are periodic as well */
+	options.swrap = OIIO::TextureOpt::WrapPeriodic;
+	options.twrap = OIIO::TextureOpt::WrapPeriodic;
+	/* alpha of images without an alpha channel */
+	options.fill = 1.0f;
+#if OIIO_VERSION < 10500
+	options.nchannels = 4;
+#endif
+
+	if(img->interpolation == INTERPOLATION_CLOSEST)
+		options.interpmode = OIIO::TextureOpt::InterpClosest;
+	else if(img->interpolation == INTERPOLATION_CUBIC || img->interpolation == INTERPOLATION_SMART)
+		options.interpmode = OIIO::TextureOpt::InterpSmartBicubic;
+	else
+		options.interpmode = OIIO::TextureOpt::InterpBilinear;
 }
 
 CCL_NAMESPACE_END
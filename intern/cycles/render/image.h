@@ -49,6 +49,7 @@ CCL_NAMESPACE_BEGIN
 class Device;
 class DeviceScene;
 class Progress;
+struct TextureCacheGlobals;
 
 class ImageManager {
 public:
@@ -68,6 +69,7 @@ public:
 	void device_free_builtin(Device *device, DeviceScene *dscene);
 
 	void set_osl_texture_system(void *texture_system);
+	void set_texture_cache(bool use_texture_cache, int texture_cache_size);
 	void set_pack_images(bool pack_images_);
 	void set_extended_image_limits(const DeviceInfo& info);
 	bool set_animation_frame_update(int frame);
@@ -88,6 +90,10 @@ public:
 		float frame;
 		InterpolationType interpolation;
 
+		/* file format, read when the image is added */
+		int channels;
+		bool is_half;
+
 		int users;
 	};
 
@@ -103,12 +109,43 @@ private:
 	void *osl_texture_system;
 	bool pack_images;
 
-	bool file_load_image(Image *img, device_vector<uchar4>& tex_img);
-	bool file_load_float_image(Image *img, device_vector<float4>& tex_img);
+	/* read file images on demand on devices that support it, size in MB */
+	bool use_texture_cache;
+	int texture_cache_size;
+	TextureCacheGlobals *texture_cache;
+
+	/* Pixel storage of an image on the device. Half float and single
+	 * channel images are only stored compact on devices that support it,
+	 * others get 4 channel bytes or floats. */
+	enum ImageDataType {
+		IMAGE_DATA_TYPE_FLOAT4,
+		IMAGE_DATA_TYPE_BYTE4,
+		IMAGE_DATA_TYPE_HALF4,
+		IMAGE_DATA_TYPE_FLOAT,
+		IMAGE_DATA_TYPE_BYTE,
+	};
+
+	bool compact_images;
+
+	bool is_float_image(const string& filename, void *builtin_data, bool& is_linear,
+	                    int& channels, bool& is_half);
+	ImageDataType get_image_data_type(Image *img, bool is_float);
+
+	template<typename StorageType, typename DeviceType>
+	bool file_load_image(Image *img, device_vector<DeviceType>& tex_img);
+
+	template<typename T>
+	void device_alloc_image(Device *device, device_vector<T>& tex_img, const char *name, int slot, InterpolationType interpolation);
+	template<typename T>
+	void device_free_image(Device *device, device_vector<T>& tex_img);
 
 	void device_load_image(Device *device, DeviceScene *dscene, int slot, Progress *progess);
 	void device_free_image(Device *device, DeviceScene *dscene, int slot);
 
+	void texture_cache_init(Device *device);
+	void texture_cache_free();
+	void texture_cache_load_image(Image *img, int slot);
+
 	void device_pack_images(Device *device, DeviceScene *dscene, Progress& progess);
 };
 
@@ -41,6 +41,7 @@ Integrator::Integrator()
 
 	volume_max_steps = 1024;
 	volume_step_size = 0.1f;
+	use_volume_majorant = false;
 
 	caustics_reflective = true;
 	caustics_refractive = true;
@@ -63,6 +64,8 @@ Integrator::Integrator()
 	sample_all_lights_direct = true;
 	sample_all_lights_indirect = true;
 
+	use_light_tree = true;
+
 	method = PATH;
 
 	sampling_pattern = SAMPLING_PATTERN_SOBOL;
@@ -194,6 +197,7 @@ bool Integrator::modified(const Integrator& integrator)
 		transparent_shadows == integrator.transparent_shadows &&
 		volume_max_steps == integrator.volume_max_steps &&
 		volume_step_size == integrator.volume_step_size &&
+		use_volume_majorant == integrator.use_volume_majorant &&
 		caustics_reflective == integrator.caustics_reflective &&
 		caustics_refractive == integrator.caustics_refractive &&
 		filter_glossy == integrator.filter_glossy &&
@@ -213,7 +217,8 @@ bool Integrator::modified(const Integrator& integrator)
 		motion_blur == integrator.motion_blur &&
 		sampling_pattern == integrator.sampling_pattern &&
 		sample_all_lights_direct == integrator.sample_all_lights_direct &&
-		sample_all_lights_indirect == integrator.sample_all_lights_indirect);
+		sample_all_lights_indirect == integrator.sample_all_lights_indirect &&
+		use_light_tree == integrator.use_light_tree);
 }
 
 void Integrator::tag_update(Scene * /*scene*/)
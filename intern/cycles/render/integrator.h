@@ -41,6 +41,7 @@ public:
 
 	int volume_max_steps;
 	float volume_step_size;
+	bool use_volume_majorant;
 
 	bool caustics_reflective;
 	bool caustics_refractive;
@@ -64,6 +65,9 @@ public:
 	bool sample_all_lights_direct;
 	bool sample_all_lights_indirect;
 
+	/* select lights with the light tree instead of the flat distribution */
+	bool use_light_tree;
+
 	enum Method {
 		BRANCHED_PATH = 0,
 		PATH = 1
@@ -18,12 +18,16 @@
 #include "device.h"
 #include "integrator.h"
 #include "film.h"
+#include "graph.h"
 #include "light.h"
+#include "light_tree.h"
 #include "mesh.h"
+#include "nodes.h"
 #include "object.h"
 #include "scene.h"
 #include "shader.h"
 
+#include "util_algorithm.h"
 #include "util_foreach.h"
 #include "util_progress.h"
 #include "util_logging.h"
@@ -150,6 +154,98 @@ LightManager::~LightManager()
 {
 }
 
+static LightTreePrimitive light_tree_lamp_primitive(Light *light, int index)
+{
+	LightTreePrimitive prim;
+
+	/* emission strength is defined by the shader, so all lamps are weighted
+	 * equally as in the flat distribution */
+	prim.energy = 1.0f;
+	prim.index = index;
+
+	if(light->type == LIGHT_AREA) {
+		float3 axisu = light->axisu*(0.5f*light->sizeu*light->size);
+		float3 axisv = light->axisv*(0.5f*light->sizev*light->size);
+
+		prim.bounds.grow(light->co - axisu - axisv);
+		prim.bounds.grow(light->co - axisu + axisv);
+		prim.bounds.grow(light->co + axisu - axisv);
+		prim.bounds.grow(light->co + axisu + axisv);
+
+		/* one sided */
+		prim.axis = safe_normalize(light->dir);
+		prim.theta_o = 0.0f;
+		prim.theta_e = M_PI_2_F;
+	}
+	else {
+		prim.bounds.grow(light->co, light->size);
+
+		if(light->type == LIGHT_SPOT) {
+			prim.axis = safe_normalize(light->dir);
+			prim.theta_o = 0.5f*light->spot_angle;
+			prim.theta_e = 0.0f;
+		}
+	}
+
+	return prim;
+}
+
+/* constant emission of the closure feeding into the input, or a negative
+ * value when it depends on textures or anything else known only at render
+ * time. only emission, mix and add closure nodes are followed */
+static float light_tree_closure_emission(ShaderInput *input)
+{
+	if(!input->link)
+		return 0.0f;
+
+	ShaderNode *node = input->link->parent;
+
+	if(node->special_type == SHADER_SPECIAL_TYPE_EMISSION) {
+		ShaderInput *color_in = node->input("Color");
+		ShaderInput *strength_in = node->input("Strength");
+		ShaderInput *weight_in = node->input("SurfaceMixWeight");
+
+		if(color_in->link || strength_in->link || (weight_in && weight_in->link))
+			return -1.0f;
+
+		return fabsf(average(color_in->value)*strength_in->value.x);
+	}
+	else if(node->name == ustring("mix_closure") || node->name == ustring("add_closure")) {
+		ShaderInput *fin = node->input("Fac");
+		float emission1 = light_tree_closure_emission(node->input("Closure1"));
+		float emission2 = light_tree_closure_emission(node->input("Closure2"));
+
+		if(emission1 < 0.0f || emission2 < 0.0f || (fin && fin->link))
+			return -1.0f;
+
+		if(fin) {
+			float fac = clamp(fin->value.x, 0.0f, 1.0f);
+			return (1.0f - fac)*emission1 + fac*emission2;
+		}
+
+		return emission1 + emission2;
+	}
+	else if(node->has_surface_emission() || node->special_type != SHADER_SPECIAL_TYPE_CLOSURE) {
+		/* other emitters, groups and converter nodes are not evaluated */
+		return -1.0f;
+	}
+
+	/* BSDFs and other closures without emission */
+	return 0.0f;
+}
+
+/* light tree weight of a triangle per unit area, the constant emission of
+ * the shader where the graph allows, otherwise one to weight by area only */
+static float light_tree_shader_emission(Shader *shader)
+{
+	if(!shader->graph)
+		return 1.0f;
+
+	float emission = light_tree_closure_emission(shader->graph->output()->input("Surface"));
+
+	return (emission >= 0.0f)? emission: 1.0f;
+}
+
 void LightManager::device_update_distribution(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress)
 {
 	progress.set_status("Updating Lights", "Computing distribution");
@@ -205,6 +301,24 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 	float4 *distribution = dscene->light_distribution.resize(num_distribution + 1);
 	float totarea = 0.0f;
 
+	/* light tree, with the position of every emissive triangle in the
+	 * distribution given by its object offset and index within the mesh */
+	bool use_light_tree = scene->integrator->use_light_tree && num_distribution > 0;
+	vector<LightTreePrimitive> tree_triangles;
+	vector<LightTreePrimitive> tree_lamps;
+	vector<uint> tree_object_offset;
+	vector<uint> tree_prim_offset;
+	vector<float> tree_shader_emission;
+
+	if(use_light_tree) {
+		tree_triangles.reserve(num_triangles);
+		tree_object_offset.resize(scene->objects.size(), ~0u);
+		tree_prim_offset.resize(dscene->tri_shader.size(), ~0u);
+
+		foreach(Shader *shader, scene->shaders)
+			tree_shader_emission.push_back(light_tree_shader_emission(shader));
+	}
+
 	/* triangles */
 	size_t offset = 0;
 	int j = 0;
@@ -262,6 +376,9 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 				use_light_visibility = true;
 			}
 
+			if(use_light_tree)
+				tree_object_offset[j] = offset;
+
 			for(size_t i = 0; i < mesh->triangles.size(); i++) {
 				Shader *shader = scene->shaders[mesh->shader[i]];
 
@@ -270,7 +387,6 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 					distribution[offset].y = __int_as_float(i + mesh->tri_offset);
 					distribution[offset].z = __int_as_float(shader_flag);
 					distribution[offset].w = __int_as_float(object_id);
-					offset++;
 
 					Mesh::Triangle t = mesh->triangles[i];
 					float3 p1 = mesh->verts[t.v[0]];
@@ -283,7 +399,23 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 						p3 = transform_point(&tfm, p3);
 					}
 
-					totarea += triangle_area(p1, p2, p3);
+					float area = triangle_area(p1, p2, p3);
+
+					if(use_light_tree) {
+						/* emission is two sided, so no orientation bound */
+						LightTreePrimitive prim;
+						prim.bounds.grow(p1);
+						prim.bounds.grow(p2);
+						prim.bounds.grow(p3);
+						prim.energy = area*tree_shader_emission[mesh->shader[i]];
+						prim.index = offset;
+						tree_triangles.push_back(prim);
+
+						tree_prim_offset[i + mesh->tri_offset] = offset - tree_object_offset[j];
+					}
+
+					totarea += area;
+					offset++;
 				}
 			}
 		}
@@ -299,28 +431,52 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 	float lightarea = (totarea > 0.0f) ? totarea / num_lights : 1.0f;
 	bool use_lamp_mis = false;
 
+	/* with the light tree, local lamps come first and distant lamps after
+	 * them, so the tree covers a contiguous part of the distribution */
+	size_t num_tree_lamps = 0;
 	int light_index = 0;
-	foreach(Light *light, scene->lights) {
-		if(light->is_portal)
-			continue;
 
-		distribution[offset].x = totarea;
-		distribution[offset].y = __int_as_float(~light_index);
-		distribution[offset].z = 1.0f;
-		distribution[offset].w = light->size;
-		totarea += lightarea;
+	for(int pass = 0; pass < 2; pass++) {
+		light_index = 0;
 
-		if(light->size > 0.0f && light->use_mis)
-			use_lamp_mis = true;
-		if(light->type == LIGHT_BACKGROUND) {
-			num_background_lights++;
-			background_mis = light->use_mis;
-		}
+		foreach(Light *light, scene->lights) {
+			if(light->is_portal)
+				continue;
 
-		light_index++;
-		offset++;
+			bool is_distant = (light->type == LIGHT_DISTANT || light->type == LIGHT_BACKGROUND);
+
+			if(use_light_tree? (is_distant != (pass == 1)): (pass == 1)) {
+				light_index++;
+				continue;
+			}
+
+			distribution[offset].x = totarea;
+			distribution[offset].y = __int_as_float(~light_index);
+			distribution[offset].z = 1.0f;
+			distribution[offset].w = light->size;
+			totarea += lightarea;
+
+			if(use_light_tree && !is_distant) {
+				tree_lamps.push_back(light_tree_lamp_primitive(light, offset));
+				num_tree_lamps++;
+			}
+
+			if(light->size > 0.0f && light->use_mis)
+				use_lamp_mis = true;
+			if(light->type == LIGHT_BACKGROUND) {
+				num_background_lights++;
+				background_mis = light->use_mis;
+			}
+
+			light_index++;
+			offset++;
+		}
 	}
 
+	/* only distant lamps, nothing to build a tree for */
+	if(tree_triangles.empty() && tree_lamps.empty())
+		use_light_tree = false;
+
 	/* normalize cumulative distribution functions */
 	distribution[num_distribution].x = totarea;
 	distribution[num_distribution].y = 0.0f;
@@ -381,6 +537,50 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 		/* CDF */
 		device->tex_alloc("__light_distribution", dscene->light_distribution);
 
+		/* light tree */
+		kintegrator->use_light_tree = use_light_tree;
+
+		if(use_light_tree) {
+			LightTree tree;
+
+			int triangle_root = tree.build(tree_triangles, num_distribution);
+			int lamp_root = tree.build(tree_lamps, num_distribution);
+
+			assert(triangle_root <= 0);
+
+			kintegrator->light_tree_num_triangles = num_triangles;
+			kintegrator->light_tree_num_lamps = num_tree_lamps;
+			kintegrator->light_tree_lamp_root = lamp_root;
+
+			/* emitters in leaf order, followed by the leaf of every emitter,
+			 * the first emitter of every object and the emitter index of
+			 * every triangle within its mesh */
+			size_t leaf_offset = tree.emitters.size();
+			size_t object_offset = leaf_offset + tree.emitter_leaf.size();
+			size_t prim_offset = object_offset + tree_object_offset.size();
+			size_t index_size = prim_offset + tree_prim_offset.size();
+
+			uint *tree_index = dscene->light_tree_index.resize(index_size);
+
+			std::copy(tree.emitters.begin(), tree.emitters.end(), tree_index);
+			std::copy(tree.emitter_leaf.begin(), tree.emitter_leaf.end(), tree_index + leaf_offset);
+			std::copy(tree_object_offset.begin(), tree_object_offset.end(), tree_index + object_offset);
+			std::copy(tree_prim_offset.begin(), tree_prim_offset.end(), tree_index + prim_offset);
+
+			kintegrator->light_tree_leaf_offset = leaf_offset;
+			kintegrator->light_tree_object_offset = object_offset;
+			kintegrator->light_tree_prim_offset = prim_offset;
+
+			dscene->light_tree_nodes.copy(&tree.nodes[0], tree.nodes.size());
+
+			device->tex_alloc("__light_tree_nodes", dscene->light_tree_nodes);
+			device->tex_alloc("__light_tree_index", dscene->light_tree_index);
+
+			VLOG(1) << "Light tree built with " << tree.nodes.size()/LIGHT_TREE_NODE_SIZE
+			        << " nodes for " << num_triangles << " triangles and "
+			        << num_tree_lamps << " lamps.";
+		}
+
 		/* Portals */
 		if(num_background_lights > 0 && light_index != scene->lights.size()) {
 			kintegrator->portal_offset = light_index;
@@ -405,6 +605,7 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 		kintegrator->num_portals = 0;
 		kintegrator->portal_offset = 0;
 		kintegrator->portal_pdf = 0.0f;
+		kintegrator->use_light_tree = false;
 
 		kfilm->pass_shadow_scale = 1.0f;
 	}
@@ -759,11 +960,15 @@ void LightManager::device_free(Device *device, DeviceScene *dscene)
 	device->tex_free(dscene->light_data);
 	device->tex_free(dscene->light_background_marginal_cdf);
 	device->tex_free(dscene->light_background_conditional_cdf);
+	device->tex_free(dscene->light_tree_nodes);
+	device->tex_free(dscene->light_tree_index);
 
 	dscene->light_distribution.clear();
 	dscene->light_data.clear();
 	dscene->light_background_marginal_cdf.clear();
 	dscene->light_background_conditional_cdf.clear();
+	dscene->light_tree_nodes.clear();
+	dscene->light_tree_index.clear();
 }
 
 void LightManager::tag_update(Scene * /*scene*/)
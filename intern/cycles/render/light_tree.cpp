@@ -0,0 +1,152 @@
+/*
+ * Copyright 2011-2015 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+
+#include "light_tree.h"
+
+#include "kernel_types.h"
+
+#include "util_algorithm.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* merge cone b into cone a, giving the smallest cone containing both */
+static void light_tree_cone_merge(float3& axis_a, float& theta_a, float3 axis_b, float theta_b)
+{
+	if(theta_a < theta_b) {
+		swap(axis_a, axis_b);
+		swap(theta_a, theta_b);
+	}
+
+	float theta_d = safe_acosf(dot(axis_a, axis_b));
+
+	/* a already contains b */
+	if(min(theta_d + theta_b, M_PI_F) <= theta_a)
+		return;
+
+	float theta_o = 0.5f*(theta_a + theta_d + theta_b);
+
+	if(theta_o >= M_PI_F) {
+		theta_a = M_PI_F;
+		return;
+	}
+
+	/* rotate axis a towards b */
+	float3 perp = axis_b - axis_a*dot(axis_a, axis_b);
+	float perp_len = len(perp);
+
+	if(perp_len < 1e-6f) {
+		theta_a = M_PI_F;
+		return;
+	}
+
+	float theta_r = theta_o - theta_a;
+	axis_a = normalize(axis_a*cosf(theta_r) + perp*(sinf(theta_r)/perp_len));
+	theta_a = theta_o;
+}
+
+struct LightTreeCentroidCompare {
+	int dim;
+
+	LightTreeCentroidCompare(int dim_) : dim(dim_) {}
+
+	bool operator()(const LightTreePrimitive& a, const LightTreePrimitive& b) const
+	{
+		return a.bounds.center()[dim] < b.bounds.center()[dim];
+	}
+};
+
+LightTree::LightTree(int max_leaf_size_)
+: max_leaf_size(max_leaf_size_)
+{
+}
+
+int LightTree::build(vector<LightTreePrimitive>& primitives, int num_distribution)
+{
+	if(primitives.empty())
+		return -1;
+
+	if(emitter_leaf.size() < (size_t)num_distribution)
+		emitter_leaf.resize(num_distribution, ~0u);
+
+	return recursive_build(primitives, 0, primitives.size(), -1);
+}
+
+int LightTree::recursive_build(vector<LightTreePrimitive>& primitives, int start, int end, int parent)
+{
+	int node = nodes.size()/LIGHT_TREE_NODE_SIZE;
+	nodes.resize(nodes.size() + LIGHT_TREE_NODE_SIZE);
+
+	/* bounds, energy and orientation of all primitives in the node */
+	BoundBox bounds = BoundBox::empty;
+	BoundBox centroid_bounds = BoundBox::empty;
+	float energy = 0.0f;
+	float3 axis = primitives[start].axis;
+	float theta_o = primitives[start].theta_o;
+	float theta_e = 0.0f;
+
+	for(int i = start; i < end; i++) {
+		const LightTreePrimitive& prim = primitives[i];
+
+		bounds.grow(prim.bounds);
+		centroid_bounds.grow(prim.bounds.center());
+		energy += prim.energy;
+		theta_e = max(theta_e, prim.theta_e);
+
+		light_tree_cone_merge(axis, theta_o, prim.axis, prim.theta_o);
+	}
+
+	/* split at the median centroid along the largest axis, primitives with
+	 * identical centroids can't be split and end up in one leaf */
+	float3 size = centroid_bounds.size();
+	int num = end - start;
+	int child0, child1;
+
+	if(num > max_leaf_size && max(max(size.x, size.y), size.z) > 0.0f) {
+		int dim = (size.x >= size.y && size.x >= size.z)? 0: (size.y >= size.z)? 1: 2;
+		int middle = (start + end)/2;
+
+		std::nth_element(primitives.begin() + start,
+		                 primitives.begin() + middle,
+		                 primitives.begin() + end,
+		                 LightTreeCentroidCompare(dim));
+
+		child0 = recursive_build(primitives, start, middle, node);
+		child1 = recursive_build(primitives, middle, end, node);
+	}
+	else {
+		child0 = ~(int)emitters.size();
+		child1 = num;
+
+		for(int i = start; i < end; i++) {
+			emitters.push_back(primitives[i].index);
+			emitter_leaf[primitives[i].index] = node;
+		}
+	}
+
+	float4 *data = &nodes[node*LIGHT_TREE_NODE_SIZE];
+
+	data[0] = make_float4(bounds.min.x, bounds.min.y, bounds.min.z, energy);
+	data[1] = make_float4(bounds.max.x, bounds.max.y, bounds.max.z, theta_o);
+	data[2] = make_float4(axis.x, axis.y, axis.z, __int_as_float(parent));
+	data[3] = make_float4(__int_as_float(child0), __int_as_float(child1), theta_e, 0.0f);
+
+	return node;
+}
+
+CCL_NAMESPACE_END
+
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2011-2015 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __LIGHT_TREE_H__
+#define __LIGHT_TREE_H__
+
+#include "util_boundbox.h"
+#include "util_math.h"
+#include "util_types.h"
+#include "util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Light Tree Primitive
+ *
+ * Emitter as seen by the light tree: spatial bounds, a cone bounding the
+ * emitter normals (axis and theta_o) and the spread of emission around
+ * those normals (theta_e). */
+
+struct LightTreePrimitive {
+	BoundBox bounds;
+	float3 axis;
+	float theta_o;
+	float theta_e;
+	float energy;
+
+	/* index in the light distribution */
+	int index;
+
+	LightTreePrimitive()
+	: bounds(BoundBox::empty), axis(make_float3(0.0f, 0.0f, 1.0f)),
+	  theta_o(M_PI_F), theta_e(M_PI_2_F), energy(0.0f), index(0) {}
+};
+
+/* Light Tree
+ *
+ * Binary tree over emitters, used by the kernel to pick lights proportional
+ * to an estimate of their contribution to the shading point. Several trees
+ * can be built into the same node array, for triangles and lamps. Nodes are
+ * packed as LIGHT_TREE_NODE_SIZE float4:
+ *
+ * 0: bounds min, energy
+ * 1: bounds max, theta_o
+ * 2: normals axis, parent node index (-1 for the root)
+ * 3: child node indices, or ~first emitter and number of emitters for
+ *    leaves, theta_e */
+
+class LightTree {
+public:
+	/* packed nodes */
+	vector<float4> nodes;
+	/* light distribution indices of all emitters, in leaf order */
+	vector<uint> emitters;
+	/* leaf node of each emitter, indexed by light distribution index */
+	vector<uint> emitter_leaf;
+
+	explicit LightTree(int max_leaf_size = 4);
+
+	/* build a tree over the primitives, returns the index of its root node,
+	 * or -1 if there are no primitives */
+	int build(vector<LightTreePrimitive>& primitives, int num_distribution);
+
+protected:
+	int max_leaf_size;
+
+	int recursive_build(vector<LightTreePrimitive>& primitives, int start, int end, int parent);
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __LIGHT_TREE_H__ */
+
@@ -30,11 +30,14 @@
 
 #include "osl_globals.h"
 
+#include "subd_mesh.h"
+
 #include "util_cache.h"
 #include "util_foreach.h"
 #include "util_logging.h"
 #include "util_progress.h"
 #include "util_set.h"
+#include "util_time.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -71,6 +74,33 @@ void Mesh::Curve::bounds_grow(const int k, const float4 *curve_keys, BoundBox& b
 	bounds.grow(upper, mr);
 }
 
+void Mesh::Curve::bounds_grow(const int k, const float4 *curve_keys, const Transform& aligned_space, BoundBox& bounds) const
+{
+	float3 P[4];
+
+	P[0] = float4_to_float3(curve_keys[max(first_key + k - 1,first_key)]);
+	P[1] = float4_to_float3(curve_keys[first_key + k]);
+	P[2] = float4_to_float3(curve_keys[first_key + k + 1]);
+	P[3] = float4_to_float3(curve_keys[min(first_key + k + 2, first_key + num_keys - 1)]);
+
+	/* the curve is a linear combination of the keys, so rotating the keys
+	 * rotates the curve and the usual bounds apply */
+	for(int i = 0; i < 4; i++)
+		P[i] = transform_direction(&aligned_space, P[i]);
+
+	float3 lower;
+	float3 upper;
+
+	curvebounds(&lower.x, &upper.x, P, 0);
+	curvebounds(&lower.y, &upper.y, P, 1);
+	curvebounds(&lower.z, &upper.z, P, 2);
+
+	float mr = max(curve_keys[first_key + k].w, curve_keys[first_key + k + 1].w);
+
+	bounds.grow(lower, mr);
+	bounds.grow(upper, mr);
+}
+
 /* Mesh */
 
 Mesh::Mesh()
@@ -87,6 +117,7 @@ Mesh::Mesh()
 	use_motion_blur = false;
 
 	bvh = NULL;
+	subd_cache = NULL;
 
 	tri_offset = 0;
 	vert_offset = 0;
@@ -103,6 +134,7 @@ Mesh::Mesh()
 Mesh::~Mesh()
 {
 	delete bvh;
+	delete subd_cache;
 }
 
 void Mesh::reserve(int numverts, int numtris, int numcurves, int numcurvekeys)
@@ -514,8 +546,11 @@ void Mesh::compute_bvh(SceneParams *params, Progress *progress, int n, int total
 
 			BVHParams bparams;
 			bparams.use_cache = params->use_bvh_cache;
+			bparams.use_memory_cache = params->use_bvh_memory_cache;
+			bparams.use_refit = params->use_bvh_refit;
 			bparams.use_spatial_split = params->use_bvh_spatial_split;
 			bparams.use_qbvh = params->use_qbvh;
+			bparams.use_qbvh_compressed = params->use_qbvh_compressed;
 
 			delete bvh;
 			bvh = BVH::create(bparams, objects);
@@ -1083,8 +1118,10 @@ void MeshManager::device_update_bvh(Device *device, DeviceScene *dscene, Scene *
 	BVHParams bparams;
 	bparams.top_level = true;
 	bparams.use_qbvh = scene->params.use_qbvh;
+	bparams.use_qbvh_compressed = scene->params.use_qbvh_compressed;
 	bparams.use_spatial_split = scene->params.use_bvh_spatial_split;
 	bparams.use_cache = scene->params.use_bvh_cache;
+	bparams.use_memory_cache = scene->params.use_bvh_memory_cache;
 
 	delete bvh;
 	bvh = BVH::create(bparams, scene->objects);
@@ -1097,6 +1134,11 @@ void MeshManager::device_update_bvh(Device *device, DeviceScene *dscene, Scene *
 
 	PackedBVH& pack = bvh->pack;
 
+	VLOG(1) << "BVH memory: nodes " << pack.nodes.size()*sizeof(int4) << " bytes"
+	        << ((bvh->params.use_qbvh && bvh->params.use_qbvh_compressed)? " (compressed)": "")
+	        << ", leaf nodes " << pack.leaf_nodes.size()*sizeof(int4) << " bytes"
+	        << ", triangles " << pack.tri_woop.size()*sizeof(float4) << " bytes.";
+
 	if(pack.nodes.size()) {
 		dscene->bvh_nodes.reference((float4*)&pack.nodes[0], pack.nodes.size());
 		device->tex_alloc("__bvh_nodes", dscene->bvh_nodes);
@@ -1132,6 +1174,7 @@ void MeshManager::device_update_bvh(Device *device, DeviceScene *dscene, Scene *
 
 	dscene->data.bvh.root = pack.root_index;
 	dscene->data.bvh.use_qbvh = scene->params.use_qbvh;
+	dscene->data.bvh.use_qbvh_compressed = scene->params.use_qbvh && scene->params.use_qbvh_compressed;
 }
 
 void MeshManager::device_update_flags(Device * /*device*/,
@@ -1284,6 +1327,7 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 		if(mesh->need_update && !mesh->transform_applied)
 			num_bvh++;
 
+	scoped_timer bvh_timer;
 	TaskPool pool;
 
 	foreach(Mesh *mesh, scene->meshes) {
@@ -1301,6 +1345,8 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 	}
 
 	pool.wait_work();
+	scene->update_times.bvh += bvh_timer.get_time();
+
 	foreach(Shader *shader, scene->shaders)
 		shader->need_update_attributes = false;
 
@@ -1318,7 +1364,10 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 
 	if(progress.get_cancel()) return;
 
-	device_update_bvh(device, dscene, scene, progress);
+	{
+		scoped_timer top_bvh_timer(&scene->update_times.bvh);
+		device_update_bvh(device, dscene, scene, progress);
+	}
 
 	need_update = false;
 
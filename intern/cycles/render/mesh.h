@@ -37,6 +37,7 @@ class Mesh;
 class Progress;
 class Scene;
 class SceneParams;
+class SubdCache;
 class AttributeRequest;
 
 /* Mesh */
@@ -59,6 +60,8 @@ public:
 		int num_segments() { return num_keys - 1; }
 
 		void bounds_grow(const int k, const float4 *curve_keys, BoundBox& bounds) const;
+		/* bounds in the rotated space of aligned_space, radius included */
+		void bounds_grow(const int k, const float4 *curve_keys, const Transform& aligned_space, BoundBox& bounds) const;
 	};
 
 	/* Displacement */
@@ -106,6 +109,9 @@ public:
 	bool need_update;
 	bool need_update_rebuild;
 
+	/* Subdivision, diced patches kept for the next sync */
+	SubdCache *subd_cache;
+
 	/* BVH */
 	BVH *bvh;
 	size_t tri_offset;
@@ -225,6 +225,7 @@ ObjectManager::ObjectManager()
 {
 	need_update = true;
 	need_flags_update = true;
+	need_volume_majorant_update = true;
 }
 
 ObjectManager::~ObjectManager()
@@ -387,6 +388,9 @@ void ObjectManager::device_update(Device *device, DeviceScene *dscene, Scene *sc
 	
 	device_free(device, dscene);
 
+	/* object indices may have changed */
+	need_volume_majorant_update = true;
+
 	if(scene->objects.size() == 0)
 		return;
 
@@ -399,9 +403,10 @@ void ObjectManager::device_update(Device *device, DeviceScene *dscene, Scene *sc
 
 	if(progress.get_cancel()) return;
 
-	/* prepare for static BVH building */
+	/* prepare for static BVH building, mesh BVHs kept in memory can only be
+	 * reused if transforms are not applied to the meshes */
 	/* todo: do before to support getting object level coords? */
-	if(scene->params.bvh_type == SceneParams::BVH_STATIC) {
+	if(scene->params.bvh_type == SceneParams::BVH_STATIC && !scene->params.use_bvh_memory_cache) {
 		progress.set_status("Updating Objects", "Applying Static Transformations");
 		apply_static_transforms(dscene, scene, object_flag, progress);
 	}
@@ -479,6 +484,8 @@ void ObjectManager::device_free(Device *device, DeviceScene *dscene)
 
 	device->tex_free(dscene->object_flag);
 	dscene->object_flag.clear();
+
+	device_free_volume_majorant(device, dscene);
 }
 
 void ObjectManager::apply_static_transforms(DeviceScene *dscene, Scene *scene, uint *object_flag, Progress& progress)
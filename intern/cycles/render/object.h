@@ -71,6 +71,7 @@ class ObjectManager {
 public:
 	bool need_update;
 	bool need_flags_update;
+	bool need_volume_majorant_update;
 
 	ObjectManager();
 	~ObjectManager();
@@ -82,11 +83,17 @@ public:
 	                         Scene *scene,
 	                         Progress& progress,
 	                         bool bounds_valid = true);
+	void device_update_volume_majorant(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress);
 	void device_free(Device *device, DeviceScene *dscene);
+	void device_free_volume_majorant(Device *device, DeviceScene *dscene);
 
 	void tag_update(Scene *scene);
 
 	void apply_static_transforms(DeviceScene *dscene, Scene *scene, uint *object_flag, Progress& progress);
+
+protected:
+	bool volume_majorant_build(Device *device, Scene *scene, Object *object,
+	                           int object_index, vector<float>& grid, float4 *info, Progress& progress);
 };
 
 CCL_NAMESPACE_END
@@ -0,0 +1,306 @@
+/*
+ * Copyright 2011-2015 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "device.h"
+
+#include "integrator.h"
+#include "mesh.h"
+#include "object.h"
+#include "scene.h"
+#include "shader.h"
+
+#include "util_foreach.h"
+#include "util_logging.h"
+#include "util_progress.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Volume Majorant Grid
+ *
+ * Maximum extinction coefficient of heterogeneous volume objects in a coarse
+ * grid over their bounds, evaluated by running the volume shaders on the
+ * device on a lattice of points. Each cell takes the maximum of the lattice
+ * points on and inside its boundary, and of its direct neighbors, to make it
+ * unlikely to miss features smaller than the lattice spacing. Delta and
+ * ratio tracking in the kernel remain unbiased if the majorant does end up
+ * lower than the actual density somewhere, only with more noise. */
+
+/* number of cells along the largest dimension of the object */
+#define VOLUME_MAJORANT_RESOLUTION 32
+/* number of lattice intervals along each dimension of a cell */
+#define VOLUME_MAJORANT_CELL_SAMPLES 3
+
+bool ObjectManager::volume_majorant_build(Device *device,
+                                          Scene *scene,
+                                          Object *object,
+                                          int object_index,
+                                          vector<float>& grid,
+                                          float4 *info,
+                                          Progress& progress)
+{
+	Mesh *mesh = object->mesh;
+
+	/* motion blurred objects have no fixed position to evaluate the shader at */
+	if(!mesh->has_volume || object->use_motion || !object->bounds.valid())
+		return false;
+
+	/* homogeneous volumes don't need to be tracked */
+	vector<int> volume_shaders;
+	bool heterogeneous = false;
+
+	foreach(uint sindex, mesh->used_shaders) {
+		Shader *shader = scene->shaders[sindex];
+
+		if(shader->has_volume) {
+			volume_shaders.push_back(scene->shader_manager->get_shader_id(sindex, mesh));
+			heterogeneous = heterogeneous || shader->has_heterogeneous_volume;
+		}
+	}
+
+	if(!heterogeneous)
+		return false;
+
+	string msg = string_printf("Computing Volume Majorant %s", mesh->name.c_str());
+	progress.set_status("Updating Volume Majorants", msg);
+
+	/* grid resolution, with bounds slightly enlarged for precision */
+	BoundBox bounds = object->bounds;
+	float3 size = bounds.size();
+	float max_size = max(max(size.x, size.y), size.z);
+
+	if(max_size == 0.0f)
+		return false;
+
+	float3 pad = make_float3(1e-4f, 1e-4f, 1e-4f)*max_size;
+	bounds.min = bounds.min - pad;
+	bounds.max = bounds.max + pad;
+	size = bounds.size();
+	max_size = max(max(size.x, size.y), size.z);
+
+	float cell_size = max_size/VOLUME_MAJORANT_RESOLUTION;
+	int res[3];
+
+	for(int i = 0; i < 3; i++)
+		res[i] = clamp((int)ceilf(size[i]/cell_size), 1, VOLUME_MAJORANT_RESOLUTION);
+
+	/* lattice points */
+	int lattice[3];
+	for(int i = 0; i < 3; i++)
+		lattice[i] = res[i]*VOLUME_MAJORANT_CELL_SAMPLES + 1;
+
+	size_t num_points = (size_t)lattice[0]*lattice[1]*lattice[2];
+	size_t num_shaders = volume_shaders.size();
+
+	/* setup input for device task, two per point */
+	device_vector<uint4> d_input;
+	uint4 *d_input_data = d_input.resize(num_points*num_shaders*2);
+	size_t d_input_size = 0;
+
+	foreach(int shader, volume_shaders) {
+		for(int z = 0; z < lattice[2]; z++) {
+			for(int y = 0; y < lattice[1]; y++) {
+				for(int x = 0; x < lattice[0]; x++) {
+					float3 P = bounds.min + size*make_float3((float)x/(lattice[0] - 1),
+					                                         (float)y/(lattice[1] - 1),
+					                                         (float)z/(lattice[2] - 1));
+
+					d_input_data[d_input_size++] = make_uint4(__float_as_int(P.x),
+					                                          __float_as_int(P.y),
+					                                          __float_as_int(P.z),
+					                                          object_index);
+					d_input_data[d_input_size++] = make_uint4(shader, 0, 0, 0);
+				}
+			}
+		}
+	}
+
+	/* run device task */
+	device_vector<float4> d_output;
+	d_output.resize(num_points*num_shaders);
+
+	device->mem_alloc(d_input, MEM_READ_ONLY);
+	device->mem_copy_to(d_input);
+	device->mem_alloc(d_output, MEM_WRITE_ONLY);
+
+	DeviceTask task(DeviceTask::SHADER);
+	task.shader_input = d_input.device_pointer;
+	task.shader_output = d_output.device_pointer;
+	task.shader_eval_type = SHADER_EVAL_VOLUME;
+	task.shader_x = 0;
+	task.shader_w = d_output.size();
+	task.num_samples = 1;
+	task.get_cancel = function_bind(&Progress::get_cancel, &progress);
+
+	device->task_add(task);
+	device->task_wait();
+
+	if(progress.get_cancel()) {
+		device->mem_free(d_input);
+		device->mem_free(d_output);
+		return false;
+	}
+
+	device->mem_copy_from(d_output, 0, 1, d_output.size(), sizeof(float4));
+	device->mem_free(d_input);
+	device->mem_free(d_output);
+
+	/* maximum over shaders and color channels for every lattice point */
+	float4 *output = (float4*)d_output.data_pointer;
+	vector<float> point_max(num_points, 0.0f);
+
+	for(size_t s = 0; s < num_shaders; s++) {
+		for(size_t i = 0; i < num_points; i++) {
+			float4 sigma_t = output[s*num_points + i];
+			float value = max(max(sigma_t.x, sigma_t.y), sigma_t.z);
+
+			/* also catches NaN */
+			if(value > point_max[i])
+				point_max[i] = value;
+		}
+	}
+
+	/* maximum over lattice points of each cell */
+	size_t num_cells = (size_t)res[0]*res[1]*res[2];
+	vector<float> cells(num_cells, 0.0f);
+
+	for(int z = 0; z < lattice[2]; z++) {
+		for(int y = 0; y < lattice[1]; y++) {
+			for(int x = 0; x < lattice[0]; x++) {
+				float value = point_max[x + lattice[0]*(y + lattice[1]*z)];
+
+				if(value == 0.0f)
+					continue;
+
+				/* points on cell boundaries belong to all adjacent cells */
+				int p[3] = {x, y, z};
+				int cmin[3], cmax[3];
+
+				for(int i = 0; i < 3; i++) {
+					cmin[i] = max((p[i] - 1)/VOLUME_MAJORANT_CELL_SAMPLES, 0);
+					cmax[i] = min(p[i]/VOLUME_MAJORANT_CELL_SAMPLES, res[i] - 1);
+				}
+
+				for(int cz = cmin[2]; cz <= cmax[2]; cz++)
+					for(int cy = cmin[1]; cy <= cmax[1]; cy++)
+						for(int cx = cmin[0]; cx <= cmax[0]; cx++) {
+							float& cell = cells[cx + res[0]*(cy + res[1]*cz)];
+							cell = max(cell, value);
+						}
+			}
+		}
+	}
+
+	/* dilate by one cell into the final grid */
+	size_t offset = grid.size();
+	grid.resize(offset + num_cells, 0.0f);
+
+	for(int z = 0; z < res[2]; z++) {
+		for(int y = 0; y < res[1]; y++) {
+			for(int x = 0; x < res[0]; x++) {
+				float value = 0.0f;
+
+				for(int dz = max(z - 1, 0); dz <= min(z + 1, res[2] - 1); dz++)
+					for(int dy = max(y - 1, 0); dy <= min(y + 1, res[1] - 1); dy++)
+						for(int dx = max(x - 1, 0); dx <= min(x + 1, res[0] - 1); dx++)
+							value = max(value, cells[dx + res[0]*(dy + res[1]*dz)]);
+
+				grid[offset + x + res[0]*(y + res[1]*z)] = value;
+			}
+		}
+	}
+
+	/* grid bounds and mapping to cells, see kernel_volume.h */
+	float3 scale = make_float3(res[0]/size.x, res[1]/size.y, res[2]/size.z);
+	int packed_res = res[0] | (res[1] << 8) | (res[2] << 16);
+
+	info[0] = make_float4(bounds.min.x, bounds.min.y, bounds.min.z, __int_as_float((int)offset));
+	info[1] = make_float4(scale.x, scale.y, scale.z, __int_as_float(packed_res));
+
+	VLOG(1) << "Volume majorant grid for " << mesh->name.c_str() << ": "
+	        << res[0] << "x" << res[1] << "x" << res[2] << " cells.";
+
+	return true;
+}
+
+void ObjectManager::device_update_volume_majorant(Device *device,
+                                                  DeviceScene *dscene,
+                                                  Scene *scene,
+                                                  Progress& progress)
+{
+	if(!need_volume_majorant_update)
+		return;
+
+	device_free_volume_majorant(device, dscene);
+
+	if(!scene->integrator->use_volume_majorant || scene->objects.size() == 0) {
+		need_volume_majorant_update = false;
+		return;
+	}
+
+	/* needs to be up to date for attribute and image access */
+	device->const_copy_to("__data", &dscene->data, sizeof(dscene->data));
+
+	float4 *info = dscene->volume_majorant_objects.resize(scene->objects.size()*VOLUME_MAJORANT_OBJECT_SIZE);
+	vector<float> grid;
+	int num_grids = 0;
+
+	for(size_t i = 0; i < scene->objects.size(); i++) {
+		float4 *object_info = &info[i*VOLUME_MAJORANT_OBJECT_SIZE];
+
+		object_info[0] = make_float4(0.0f, 0.0f, 0.0f, __int_as_float(-1));
+		object_info[1] = make_float4(0.0f, 0.0f, 0.0f, 0.0f);
+
+		if(volume_majorant_build(device, scene, scene->objects[i], i, grid, object_info, progress))
+			num_grids++;
+
+		if(progress.get_cancel()) {
+			dscene->volume_majorant_objects.clear();
+			return;
+		}
+	}
+
+	need_volume_majorant_update = false;
+
+	if(num_grids == 0) {
+		dscene->volume_majorant_objects.clear();
+		return;
+	}
+
+	float *cells = dscene->volume_majorant.resize(grid.size());
+	memcpy(cells, &grid[0], grid.size()*sizeof(float));
+
+	device->tex_alloc("__volume_majorant_objects", dscene->volume_majorant_objects);
+	device->tex_alloc("__volume_majorant", dscene->volume_majorant);
+
+	dscene->data.integrator.use_volume_majorant = 1;
+
+	VLOG(1) << "Total " << num_grids << " volume majorant grids, "
+	        << grid.size()*sizeof(float) << " bytes.";
+}
+
+void ObjectManager::device_free_volume_majorant(Device *device, DeviceScene *dscene)
+{
+	device->tex_free(dscene->volume_majorant_objects);
+	dscene->volume_majorant_objects.clear();
+
+	device->tex_free(dscene->volume_majorant);
+	dscene->volume_majorant.clear();
+
+	dscene->data.integrator.use_volume_majorant = 0;
+}
+
+CCL_NAMESPACE_END
+
@@ -35,6 +35,7 @@
 
 #include "util_foreach.h"
 #include "util_progress.h"
+#include "util_time.h"
 
 #ifdef WITH_CYCLES_DEBUG
 #  include "util_guarded_allocator.h"
@@ -70,6 +71,7 @@ Scene::Scene(const SceneParams& params_, const DeviceInfo& device_info_)
 
 	/* Extended image limits for CPU and GPUs */
 	image_manager->set_extended_image_limits(device_info_);
+	image_manager->set_texture_cache(params.use_texture_cache, params.texture_cache_size);
 }
 
 Scene::~Scene()
@@ -148,15 +150,30 @@ void Scene::device_update(Device *device_, Progress& progress)
 	 * - Image manager uploads images used by shaders.
 	 * - Camera may be used for adaptive subdivision.
 	 * - Displacement shader must have all shader data available.
+	 * - Volume majorant grids need images and final mesh data to evaluate shaders.
 	 * - Light manager needs lookup tables and final mesh data to compute emission CDF.
 	 * - Film needs light manager to run for use_light_visibility
 	 * - Lookup tables are done a second time to handle film tables
 	 */
 	
+	update_times.reset();
+	scoped_timer timer(&update_times.total);
+
 	image_manager->set_pack_images(device->info.pack_images);
 
+	/* volume majorant grids are evaluated from shaders, meshes and images,
+	 * check for changes before the managers clear their update tags */
+	if(shader_manager->need_update || mesh_manager->need_update ||
+	   image_manager->need_update || integrator->need_update)
+	{
+		object_manager->need_volume_majorant_update = true;
+	}
+
 	progress.set_status("Updating Shaders");
-	shader_manager->device_update(device, &dscene, this, progress);
+	{
+		scoped_timer shaders_timer(&update_times.shaders);
+		shader_manager->device_update(device, &dscene, this, progress);
+	}
 
 	if(progress.get_cancel() || device->have_error()) return;
 
@@ -181,7 +198,10 @@ void Scene::device_update(Device *device_, Progress& progress)
 	if(progress.get_cancel() || device->have_error()) return;
 
 	progress.set_status("Updating Meshes");
-	mesh_manager->device_update(device, &dscene, this, progress);
+	{
+		scoped_timer geometry_timer(&update_times.geometry);
+		mesh_manager->device_update(device, &dscene, this, progress);
+	}
 
 	if(progress.get_cancel() || device->have_error()) return;
 
@@ -191,7 +211,15 @@ void Scene::device_update(Device *device_, Progress& progress)
 	if(progress.get_cancel() || device->have_error()) return;
 
 	progress.set_status("Updating Images");
-	image_manager->device_update(device, &dscene, progress);
+	{
+		scoped_timer images_timer(&update_times.images);
+		image_manager->device_update(device, &dscene, progress);
+	}
+
+	if(progress.get_cancel() || device->have_error()) return;
+
+	progress.set_status("Updating Volume Majorants");
+	object_manager->device_update_volume_majorant(device, &dscene, this, progress);
 
 	if(progress.get_cancel() || device->have_error()) return;
 
@@ -211,7 +239,10 @@ void Scene::device_update(Device *device_, Progress& progress)
 	if(progress.get_cancel() || device->have_error()) return;
 
 	progress.set_status("Updating Lights");
-	light_manager->device_update(device, &dscene, this, progress);
+	{
+		scoped_timer lights_timer(&update_times.lights);
+		light_manager->device_update(device, &dscene, this, progress);
+	}
 
 	if(progress.get_cancel() || device->have_error()) return;
 
@@ -94,6 +94,8 @@ public:
 	device_vector<float4> light_data;
 	device_vector<float2> light_background_marginal_cdf;
 	device_vector<float2> light_background_conditional_cdf;
+	device_vector<float4> light_tree_nodes;
+	device_vector<uint> light_tree_index;
 
 	/* particles */
 	device_vector<float4> particles;
@@ -103,6 +105,10 @@ public:
 	device_vector<uint> shader_flag;
 	device_vector<uint> object_flag;
 
+	/* volume majorant grids */
+	device_vector<float4> volume_majorant_objects;
+	device_vector<float> volume_majorant;
+
 	/* lookup tables */
 	device_vector<float> lookup_table;
 
@@ -113,6 +119,11 @@ public:
 	device_vector<uchar4> tex_image[TEX_EXTENDED_NUM_IMAGES_CPU];
 	device_vector<float4> tex_float_image[TEX_EXTENDED_NUM_FLOAT_IMAGES];
 
+	/* cpu compact images, in the same slots as the images above */
+	device_vector<half4> tex_half_image[TEX_EXTENDED_NUM_FLOAT_IMAGES];
+	device_vector<float> tex_float1_image[TEX_EXTENDED_NUM_FLOAT_IMAGES];
+	device_vector<uchar> tex_byte1_image[TEX_EXTENDED_NUM_IMAGES_CPU];
+
 	/* opencl images */
 	device_vector<uchar4> tex_image_packed;
 	device_vector<uint4> tex_image_packed_info;
@@ -127,27 +138,72 @@ public:
 	ShadingSystem shadingsystem;
 	enum BVHType { BVH_DYNAMIC, BVH_STATIC } bvh_type;
 	bool use_bvh_cache;
+	bool use_bvh_memory_cache;
+	bool use_bvh_refit;
 	bool use_bvh_spatial_split;
 	bool use_qbvh;
+	bool use_qbvh_compressed;
 	bool persistent_data;
+	bool use_texture_cache;
+	int texture_cache_size;
 
 	SceneParams()
 	{
 		shadingsystem = SHADINGSYSTEM_SVM;
 		bvh_type = BVH_DYNAMIC;
 		use_bvh_cache = false;
+		use_bvh_memory_cache = false;
+		use_bvh_refit = false;
 		use_bvh_spatial_split = false;
 		use_qbvh = false;
+		use_qbvh_compressed = false;
 		persistent_data = false;
+		use_texture_cache = false;
+		texture_cache_size = 1024;
 	}
 
 	bool modified(const SceneParams& params)
 	{ return !(shadingsystem == params.shadingsystem
 		&& bvh_type == params.bvh_type
 		&& use_bvh_cache == params.use_bvh_cache
+		&& use_bvh_memory_cache == params.use_bvh_memory_cache
+		&& use_bvh_refit == params.use_bvh_refit
 		&& use_bvh_spatial_split == params.use_bvh_spatial_split
 		&& use_qbvh == params.use_qbvh
-		&& persistent_data == params.persistent_data); }
+		&& use_qbvh_compressed == params.use_qbvh_compressed
+		&& persistent_data == params.persistent_data
+		&& use_texture_cache == params.use_texture_cache
+		&& texture_cache_size == params.texture_cache_size); }
+};
+
+/* Scene Update Times
+ *
+ * Wall clock time spent in the last device update in seconds, geometry
+ * includes building the BVH. */
+
+class SceneUpdateTimes {
+public:
+	double total;
+	double shaders;
+	double geometry;
+	double bvh;
+	double images;
+	double lights;
+
+	SceneUpdateTimes()
+	{
+		reset();
+	}
+
+	void reset()
+	{
+		total = 0.0;
+		shaders = 0.0;
+		geometry = 0.0;
+		bvh = 0.0;
+		images = 0.0;
+		lights = 0.0;
+	}
 };
 
 /* Scene */
@@ -191,6 +247,9 @@ public:
 	/* parameters */
 	SceneParams params;
 
+	/* timing of the last device update */
+	SceneUpdateTimes update_times;
+
 	/* mutex must be locked manually by callers */
 	thread_mutex mutex;
 
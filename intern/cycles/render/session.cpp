@@ -19,6 +19,7 @@
 
 #include "buffers.h"
 #include "camera.h"
+#include "checkpoint.h"
 #include "device.h"
 #include "graph.h"
 #include "integrator.h"
@@ -28,10 +29,13 @@
 #include "session.h"
 #include "bake.h"
 
+#include "util_algorithm.h"
 #include "util_foreach.h"
 #include "util_function.h"
+#include "util_logging.h"
 #include "util_math.h"
 #include "util_opengl.h"
+#include "util_path.h"
 #include "util_task.h"
 #include "util_time.h"
 
@@ -54,6 +58,10 @@ Session::Session(const SessionParams& params_)
 
 	device = Device::create(params.device, stats, params.background);
 
+	/* samples that converged pixels save go to tiles that are still noisy */
+	if(params.use_adaptive_sampling())
+		tile_manager.set_max_samples(params.adaptive_max_samples);
+
 	if(params.background && params.output_path.empty()) {
 		buffers = NULL;
 		display = NULL;
@@ -65,6 +73,7 @@ Session::Session(const SessionParams& params_)
 
 	session_thread = NULL;
 	scene = NULL;
+	checkpoint = NULL;
 
 	start_time = 0.0;
 	reset_time = 0.0;
@@ -119,6 +128,10 @@ Session::~Session()
 	foreach(RenderBuffers *buffers, tile_buffers)
 		delete buffers;
 
+	foreach(DenoiseTile& tile, denoise_tiles)
+		delete tile.rtile.buffers;
+
+	delete checkpoint;
 	delete buffers;
 	delete display;
 	delete scene;
@@ -307,6 +320,8 @@ void Session::run_gpu()
 		}
 	}
 
+	denoise_finish();
+
 	if(!tiles_written)
 		update_progressive_refine(true);
 }
@@ -375,7 +390,10 @@ bool Session::acquire_tile(Device *tile_device, RenderTile& rtile)
 	rtile.h = tile.h;
 	rtile.start_sample = tile_manager.state.sample;
 	rtile.num_samples = tile_manager.state.num_samples;
+	rtile.sample = rtile.start_sample;
 	rtile.resolution = tile_manager.state.resolution_divider;
+	rtile.tile_index = tile.index;
+	rtile.converged = false;
 
 	tile_lock.unlock();
 
@@ -422,6 +440,9 @@ bool Session::acquire_tile(Device *tile_device, RenderTile& rtile)
 			tile_buffers[tile.index] = tilebuffers;
 
 			tilebuffers->reset(tile_device, buffer_params);
+
+			if(checkpoint)
+				checkpoint_restore_tile(tile_device, rtile, tilebuffers);
 		}
 
 		tile_lock.unlock();
@@ -430,6 +451,9 @@ bool Session::acquire_tile(Device *tile_device, RenderTile& rtile)
 		tilebuffers = new RenderBuffers(tile_device);
 
 		tilebuffers->reset(tile_device, buffer_params);
+
+		if(checkpoint)
+			checkpoint_restore_tile(tile_device, rtile, tilebuffers);
 	}
 
 	rtile.buffer = tilebuffers->buffer.device_pointer;
@@ -464,11 +488,26 @@ void Session::release_tile(RenderTile& rtile)
 {
 	thread_scoped_lock tile_lock(tile_mutex);
 
-	if(write_render_tile_cb) {
+	if(use_tile_denoising())
+		denoise_tiles_init();
+
+	if(rtile.converged) {
+		VLOG(2) << "Tile " << rtile.tile_index << " converged after "
+		        << rtile.sample << " samples.";
+		tile_manager.set_tile_converged(rtile.tile_index);
+	}
+
+	if(use_tile_denoising()) {
+		denoise_tile_release(rtile, tile_lock);
+	}
+	else if(write_render_tile_cb) {
 		if(params.progressive_refine == false) {
 			/* todo: optimize this by making it thread safe and removing lock */
 			write_render_tile_cb(rtile);
 
+			if(checkpoint)
+				checkpoint_tile(rtile);
+
 			delete rtile.buffers;
 		}
 	}
@@ -490,6 +529,8 @@ void Session::run_cpu()
 
 		reset_(delayed_reset.params, delayed_reset.samples);
 		delayed_reset.do_reset = false;
+
+		checkpoint_begin();
 	}
 
 	while(!progress.get_cancel()) {
@@ -595,13 +636,20 @@ void Session::run_cpu()
 				progress.set_error(device->error_message());
 
 			tiles_written = update_progressive_refine(progress.get_cancel());
+
+			if(checkpoint && params.progressive)
+				checkpoint_progressive();
 		}
 
 		progress.set_update();
 	}
 
+	denoise_finish();
+
 	if(!tiles_written)
 		update_progressive_refine(true);
+
+	checkpoint_end();
 }
 
 DeviceRequestedFeatures Session::get_requested_device_features()
@@ -675,10 +723,20 @@ void Session::run()
 		/* reset number of rendered samples */
 		progress.reset_sample();
 
+		if(params.use_ray_stats) {
+			thread_scoped_lock lock(stats.ray_stats_mutex);
+			stats.ray_stats.reset();
+		}
+
+		double render_start_time = time_dt();
+
 		if(device_use_gl)
 			run_gpu();
 		else
 			run_cpu();
+
+		if(params.use_ray_stats)
+			ray_stats_report(time_dt() - render_start_time);
 	}
 
 	/* progress update */
@@ -696,8 +754,11 @@ bool Session::draw(BufferParams& buffer_params, DeviceDrawParams &draw_params)
 		return draw_cpu(buffer_params, draw_params);
 }
 
-void Session::reset_(BufferParams& buffer_params, int samples)
+void Session::reset_(BufferParams& buffer_params_, int samples)
 {
+	BufferParams buffer_params = buffer_params_;
+	add_internal_passes(buffer_params.passes);
+
 	if(buffers) {
 		if(buffer_params.modified(buffers->params)) {
 			gpu_draw_ready = false;
@@ -708,6 +769,10 @@ void Session::reset_(BufferParams& buffer_params, int samples)
 
 	tile_manager.reset(buffer_params, samples);
 
+	foreach(DenoiseTile& tile, denoise_tiles)
+		delete tile.rtile.buffers;
+	denoise_tiles.clear();
+
 	start_time = time_dt();
 	preview_time = 0.0;
 	paused_time = 0.0;
@@ -764,6 +829,19 @@ void Session::set_pause(bool pause_)
 		pause_cond.notify_all();
 }
 
+void Session::set_checkpoint(const string& filepath, const string& scene_filepath)
+{
+	/* used for the next render started, background render only */
+	checkpoint_filepath = filepath;
+	checkpoint_scene_filepath = scene_filepath;
+}
+
+void Session::set_ray_stats_report(const string& filepath)
+{
+	/* written after the next render, when collecting statistics */
+	ray_stats_filepath = filepath;
+}
+
 void Session::wait()
 {
 	session_thread->join();
@@ -799,7 +877,7 @@ void Session::update_scene()
 	if(integrator->sampling_pattern == SAMPLING_PATTERN_CMJ ||
 	   bake_manager->get_baking())
 	{
-		int aa_samples = tile_manager.num_samples;
+		int aa_samples = tile_manager.get_end_sample();
 
 		if(aa_samples != integrator->aa_samples) {
 			integrator->aa_samples = aa_samples;
@@ -807,13 +885,52 @@ void Session::update_scene()
 		}
 	}
 
+	/* adaptive sampling needs the sample count and noise estimate passes,
+	 * and denoising the feature pass */
+	vector<Pass> passes = scene->film->passes;
+
+	if(add_internal_passes(passes)) {
+		scene->film->tag_passes_update(scene, passes);
+		scene->film->tag_update(scene);
+	}
+
 	/* update scene */
 	if(scene->need_update()) {
 		progress.set_status("Updating Scene");
 		scene->device_update(device, progress);
+
+		const SceneUpdateTimes& times = scene->update_times;
+		VLOG(1) << "Scene update time " << times.total
+		        << " (shaders " << times.shaders
+		        << ", geometry " << times.geometry
+		        << ", BVH " << times.bvh
+		        << ", images " << times.images
+		        << ", lights " << times.lights << ")";
 	}
 }
 
+bool Session::add_internal_passes(vector<Pass>& passes)
+{
+	bool added = false;
+
+	if(params.use_adaptive_sampling()) {
+		if(!(Pass::contains(passes, PASS_SAMPLE_COUNT) && Pass::contains(passes, PASS_ADAPTIVE_AUX_BUFFER))) {
+			Pass::add(PASS_SAMPLE_COUNT, passes);
+			Pass::add(PASS_ADAPTIVE_AUX_BUFFER, passes);
+			added = true;
+		}
+	}
+
+	if(params.use_final_denoising()) {
+		if(!Pass::contains(passes, PASS_DENOISING)) {
+			Pass::add(PASS_DENOISING, passes);
+			added = true;
+		}
+	}
+
+	return added;
+}
+
 void Session::update_status_time(bool show_pause, bool show_done)
 {
 	int sample = tile_manager.state.sample;
@@ -858,7 +975,7 @@ void Session::update_status_time(bool show_pause, bool show_done)
 	else if(tile_manager.num_samples == USHRT_MAX)
 		substatus = string_printf("Path Tracing Sample %d", sample+1);
 	else
-		substatus = string_printf("Path Tracing Sample %d/%d", sample+1, tile_manager.num_samples);
+		substatus = string_printf("Path Tracing Sample %d/%d", sample+1, tile_manager.get_end_sample());
 	
 	if(show_pause) {
 		status = "Paused";
@@ -903,6 +1020,17 @@ void Session::path_trace()
 	task.need_finish_queue = params.progressive_refine;
 	task.integrator_branched = scene->integrator->method == Integrator::BRANCHED_PATH;
 	task.requested_tile_size = params.tile_size;
+	task.use_ray_stream = params.use_ray_stream && params.device.type == DEVICE_CPU;
+	task.use_ray_stats = params.use_ray_stats;
+
+	if(params.use_adaptive_sampling()) {
+		task.adaptive_threshold = params.adaptive_threshold;
+		task.adaptive_min_samples = params.adaptive_min_samples;
+
+		/* noise estimates from few samples are unreliable */
+		if(task.adaptive_min_samples <= 0)
+			task.adaptive_min_samples = clamp((int)sqrtf((float)tile_manager.num_samples), 4, 64);
+	}
 
 	device->task_add(task);
 }
@@ -936,7 +1064,7 @@ void Session::tonemap(int sample)
 bool Session::update_progressive_refine(bool cancel)
 {
 	int sample = tile_manager.state.sample + 1;
-	bool write = sample == tile_manager.num_samples || cancel;
+	bool write = tile_manager.done() || cancel;
 
 	double current_time = time_dt();
 
@@ -968,6 +1096,584 @@ bool Session::update_progressive_refine(bool cancel)
 	return write;
 }
 
+/* Checkpoint */
+
+void Session::checkpoint_begin()
+{
+	delete checkpoint;
+	checkpoint = NULL;
+
+	if(!params.background || params.checkpoint_interval <= 0.0 || checkpoint_filepath.empty())
+		return;
+
+	/* tiles are added to the checkpoint one by one as they are finished, or
+	 * with progressive rendering all at once after complete samples */
+	if(!params.progressive && (buffers || !write_render_tile_cb)) {
+		VLOG(1) << "Checkpoints are not supported for rendering tiles into a single buffer.";
+		return;
+	}
+
+	CheckpointParams checkpoint_params;
+	checkpoint_params.buffer = tile_manager.params;
+	checkpoint_params.num_samples = tile_manager.get_end_sample();
+	checkpoint_params.tile_size = params.tile_size;
+	checkpoint_params.progressive = params.progressive;
+	checkpoint_params.seed = scene->integrator->seed;
+
+	if(!checkpoint_scene_filepath.empty())
+		checkpoint_params.scene_time = path_modified_time(checkpoint_scene_filepath);
+
+	{
+		thread_scoped_lock scene_lock(scene->mutex);
+		checkpoint_params.hash_scene(scene);
+	}
+
+	checkpoint = new Checkpoint(checkpoint_filepath, params.checkpoint_interval, checkpoint_params);
+
+	if(!checkpoint->resumed())
+		return;
+
+	const map<int, CheckpointTile>& resume_tiles = checkpoint->resume_tiles();
+	map<int, CheckpointTile>::const_iterator it;
+
+	if(params.progressive) {
+		/* all pixels must continue from the same sample */
+		size_t num_pixels = 0;
+
+		for(it = resume_tiles.begin(); it != resume_tiles.end(); it++)
+			num_pixels += (size_t)it->second.w*it->second.h;
+
+		if(num_pixels != (size_t)tile_manager.params.width*tile_manager.params.height) {
+			VLOG(1) << "Checkpoint does not cover the full image, not resuming.";
+			return;
+		}
+
+		if(buffers) {
+			const CheckpointTile *tile = checkpoint->resume_tile(-1);
+
+			if(!tile || !checkpoint->restore_tile(*tile, device, buffers)) {
+				progress.set_error("Failed to restore render checkpoint");
+				return;
+			}
+		}
+
+		/* progressive refine restores tile buffers as they are allocated */
+		tile_manager.resume(checkpoint->resume_sample(), vector<int>());
+
+		VLOG(1) << "Resuming render at sample " << checkpoint->resume_sample() << ".";
+	}
+	else {
+		/* finished tiles are written out now and not rendered again,
+		 * partially rendered tiles are restored when acquired */
+		vector<int> finished_tiles;
+
+		for(it = resume_tiles.begin(); it != resume_tiles.end(); it++) {
+			const CheckpointTile& tile = it->second;
+
+			if(!tile.finished)
+				continue;
+
+			BufferParams buffer_params = tile_manager.params;
+			buffer_params.full_x = tile.x;
+			buffer_params.full_y = tile.y;
+			buffer_params.width = tile.w;
+			buffer_params.height = tile.h;
+
+			RenderBuffers *tilebuffers = new RenderBuffers(device);
+			tilebuffers->reset(device, buffer_params);
+
+			if(checkpoint->restore_tile(tile, device, tilebuffers)) {
+				RenderTile rtile;
+				rtile.x = tile.x;
+				rtile.y = tile.y;
+				rtile.w = tile.w;
+				rtile.h = tile.h;
+				rtile.num_samples = tile.sample;
+				rtile.sample = tile.sample;
+				rtile.tile_index = tile.index;
+				rtile.buffers = tilebuffers;
+
+				write_render_tile_cb(rtile);
+				finished_tiles.push_back(tile.index);
+			}
+
+			delete tilebuffers;
+		}
+
+		tile_manager.resume(0, finished_tiles);
+
+		VLOG(1) << "Resuming render with " << finished_tiles.size() << " finished tiles.";
+	}
+}
+
+void Session::checkpoint_end()
+{
+	if(!checkpoint)
+		return;
+
+	/* keep the checkpoint when cancelled, including partially rendered
+	 * tiles, so the render can be resumed later */
+	bool completed = !progress.get_cancel();
+
+	if(!completed && !params.progressive)
+		checkpoint->write(0);
+
+	checkpoint->finish(completed);
+
+	delete checkpoint;
+	checkpoint = NULL;
+}
+
+void Session::checkpoint_tile(RenderTile& rtile)
+{
+	/* cancelled before any samples were rendered */
+	if(rtile.sample <= 0)
+		return;
+
+	bool finished = rtile.converged || rtile.sample >= rtile.start_sample + rtile.num_samples;
+
+	rtile.buffers->copy_from_device();
+	rtile.buffers->copy_rng_state_from_device();
+	checkpoint->add_tile(rtile.tile_index, rtile.sample, finished, rtile.buffers);
+
+	if(checkpoint->need_write())
+		checkpoint->write(0);
+}
+
+void Session::checkpoint_progressive()
+{
+	/* only complete samples at full resolution can be continued from */
+	if(tile_manager.state.resolution_divider != 1 || tile_manager.state.sample < 0)
+		return;
+
+	if(progress.get_cancel()) {
+		/* progressive refine finishes the sample for all tiles when
+		 * cancelled, a single buffer is left with an incomplete sample */
+		if(!params.progressive_refine)
+			return;
+	}
+	else if(!checkpoint->need_write())
+		return;
+
+	int sample = tile_manager.state.sample + 1;
+
+	if(params.progressive_refine) {
+		for(size_t i = 0; i < tile_buffers.size(); i++) {
+			RenderBuffers *tilebuffers = tile_buffers[i];
+
+			if(tilebuffers) {
+				tilebuffers->copy_from_device();
+				tilebuffers->copy_rng_state_from_device();
+				checkpoint->add_tile(i, sample, false, tilebuffers);
+			}
+		}
+	}
+	else if(buffers) {
+		buffers->copy_from_device();
+		buffers->copy_rng_state_from_device();
+		checkpoint->add_tile(-1, sample, false, buffers);
+	}
+
+	checkpoint->write(sample);
+}
+
+void Session::checkpoint_restore_tile(Device *tile_device, RenderTile& rtile, RenderBuffers *tilebuffers)
+{
+	const CheckpointTile *tile = checkpoint->resume_tile(rtile.tile_index);
+
+	if(!tile)
+		return;
+
+	if(!checkpoint->restore_tile(*tile, tile_device, tilebuffers)) {
+		/* progressive rendering can't continue with tiles missing samples */
+		if(params.progressive)
+			progress.set_error("Failed to restore render checkpoint");
+		return;
+	}
+
+	/* progressive rendering continues at the sample of the whole image,
+	 * tiles continue where they left off */
+	if(!params.progressive) {
+		int end_sample = rtile.start_sample + rtile.num_samples;
+
+		rtile.start_sample = min(tile->sample, end_sample);
+		rtile.num_samples = end_sample - rtile.start_sample;
+		rtile.sample = rtile.start_sample;
+	}
+}
+
+/* Denoising */
+
+bool Session::use_tile_denoising()
+{
+	/* only temporary tile buffers, a permanent buffer is denoised at once
+	 * when the render is finished */
+	return params.use_final_denoising() && params.output_path.empty();
+}
+
+void Session::denoise_tiles_init()
+{
+	int num_tiles = tile_manager.state.num_tiles;
+
+	if((int)denoise_tiles.size() == num_tiles)
+		return;
+
+	denoise_tiles.clear();
+	denoise_tiles.resize(num_tiles);
+
+	/* tiles finished before the render was resumed are never released,
+	 * neither are tiles that converged in an earlier pass of this render */
+	for(int i = 0; i < num_tiles; i++) {
+		bool finished = i < (int)tile_manager.state.tile_converged.size() &&
+		                tile_manager.state.tile_converged[i];
+
+		denoise_tiles[i].state = (finished)? DENOISE_TILE_WRITTEN: DENOISE_TILE_NONE;
+	}
+}
+
+void Session::denoise_tile_release(RenderTile& rtile, thread_scoped_lock& tile_lock)
+{
+	/* the checkpoint keeps the noisy result, so the render can continue */
+	if(checkpoint)
+		checkpoint_tile(rtile);
+
+	rtile.buffers->copy_from_device();
+
+	DenoiseTile& tile = denoise_tiles[rtile.tile_index];
+	tile.rtile = rtile;
+	tile.state = DENOISE_TILE_RENDERED;
+
+	/* filter this tile and tiles around it, once all their neighbors are
+	 * rendered, without holding the lock so other threads can continue */
+	vector<int> filter_tiles;
+
+	for(int dy = -1; dy <= 1; dy++) {
+		for(int dx = -1; dx <= 1; dx++) {
+			int index = tile_manager.neighbor_tile_index(rtile.tile_index, dx, dy);
+
+			if(index != -1 && denoise_tile_ready(index)) {
+				denoise_tiles[index].state = DENOISE_TILE_FILTERING;
+				filter_tiles.push_back(index);
+			}
+		}
+	}
+
+	if(!filter_tiles.empty()) {
+		tile_lock.unlock();
+
+		double filter_start = time_dt();
+
+		foreach(int index, filter_tiles)
+			denoise_tile_filter(index);
+
+		double filter_time = time_dt() - filter_start;
+
+		tile_lock.lock();
+
+		foreach(int index, filter_tiles)
+			denoise_tiles[index].state = DENOISE_TILE_FILTERED;
+
+		stats.denoise_time += filter_time;
+	}
+
+	/* write tiles that are no longer needed to filter any of their neighbors */
+	for(int dy = -2; dy <= 2; dy++) {
+		for(int dx = -2; dx <= 2; dx++) {
+			int index = tile_manager.neighbor_tile_index(rtile.tile_index, dx, dy);
+
+			if(index != -1 && denoise_tile_writable(index))
+				denoise_tile_write(index);
+		}
+	}
+}
+
+bool Session::denoise_tile_ready(int index)
+{
+	if(denoise_tiles[index].state != DENOISE_TILE_RENDERED)
+		return false;
+
+	for(int dy = -1; dy <= 1; dy++) {
+		for(int dx = -1; dx <= 1; dx++) {
+			int neighbor = tile_manager.neighbor_tile_index(index, dx, dy);
+
+			if(neighbor != -1 && denoise_tiles[neighbor].state == DENOISE_TILE_NONE)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+bool Session::denoise_tile_writable(int index)
+{
+	if(denoise_tiles[index].state != DENOISE_TILE_FILTERED)
+		return false;
+
+	for(int dy = -1; dy <= 1; dy++) {
+		for(int dx = -1; dx <= 1; dx++) {
+			int neighbor = tile_manager.neighbor_tile_index(index, dx, dy);
+
+			if(neighbor == -1)
+				continue;
+
+			DenoiseTileState state = denoise_tiles[neighbor].state;
+
+			if(!(state == DENOISE_TILE_FILTERED || state == DENOISE_TILE_WRITTEN))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+void Session::denoise_tile_filter(int index)
+{
+	/* called without the lock, the buffers of the tile and its neighbors
+	 * stay unmodified until this tile is filtered */
+	DenoiseTile& tile = denoise_tiles[index];
+	Denoiser denoiser(params.denoising);
+
+	for(int dy = -1; dy <= 1; dy++) {
+		for(int dx = -1; dx <= 1; dx++) {
+			int neighbor = tile_manager.neighbor_tile_index(index, dx, dy);
+
+			if(neighbor != -1 && denoise_tiles[neighbor].rtile.buffers) {
+				const RenderTile& ntile = denoise_tiles[neighbor].rtile;
+				denoiser.add_buffers(ntile.buffers, ntile.sample);
+			}
+		}
+	}
+
+	const RenderTile& rtile = tile.rtile;
+	denoiser.filter(rtile.x, rtile.y, rtile.w, rtile.h, tile.result);
+}
+
+void Session::denoise_tile_write(int index)
+{
+	DenoiseTile& tile = denoise_tiles[index];
+	RenderTile& rtile = tile.rtile;
+
+	if(!tile.result.empty()) {
+		Denoiser denoiser(params.denoising);
+		denoiser.write(rtile.buffers, rtile.sample, rtile.x, rtile.y, rtile.w, rtile.h, tile.result);
+		rtile.buffers->copy_to_device();
+	}
+
+	if(write_render_tile_cb)
+		write_render_tile_cb(rtile);
+
+	delete rtile.buffers;
+	rtile.buffers = NULL;
+
+	tile.result.clear();
+	tile.state = DENOISE_TILE_WRITTEN;
+}
+
+void Session::denoise_tiles_flush()
+{
+	thread_scoped_lock tile_lock(tile_mutex);
+
+	/* tiles of which neighbors were not rendered, these are filtered with
+	 * the pixels available, or written noisy when cancelled */
+	bool cancel = progress.get_cancel();
+	double filter_start = time_dt();
+
+	for(size_t i = 0; i < denoise_tiles.size(); i++) {
+		if(denoise_tiles[i].state == DENOISE_TILE_RENDERED) {
+			if(!cancel)
+				denoise_tile_filter(i);
+
+			denoise_tiles[i].state = DENOISE_TILE_FILTERED;
+		}
+	}
+
+	stats.denoise_time += time_dt() - filter_start;
+
+	for(size_t i = 0; i < denoise_tiles.size(); i++)
+		if(denoise_tiles[i].state == DENOISE_TILE_FILTERED)
+			denoise_tile_write(i);
+}
+
+static void denoise_buffers_block(const Denoiser *denoiser, int4 rect, vector<float3> *result)
+{
+	denoiser->filter(rect.x, rect.y, rect.z, rect.w, *result);
+}
+
+void Session::denoise_buffers()
+{
+	if(!buffers->copy_from_device())
+		return;
+
+	progress.set_status("Denoising");
+
+	double filter_start = time_dt();
+
+	/* filter blocks in parallel, all reading the unmodified buffers */
+	Denoiser denoiser(params.denoising);
+	denoiser.add_buffers(buffers, tile_manager.state.sample + tile_manager.state.num_samples);
+
+	const BufferParams& bparams = buffers->params;
+	int2 block_size = params.tile_size;
+	vector<int4> blocks;
+
+	for(int y = 0; y < bparams.height; y += block_size.y) {
+		for(int x = 0; x < bparams.width; x += block_size.x) {
+			blocks.push_back(make_int4(bparams.full_x + x, bparams.full_y + y,
+			                           min(block_size.x, bparams.width - x),
+			                           min(block_size.y, bparams.height - y)));
+		}
+	}
+
+	vector<vector<float3> > results(blocks.size());
+	TaskPool pool;
+
+	for(size_t i = 0; i < blocks.size(); i++)
+		pool.push(function_bind(&denoise_buffers_block, &denoiser, blocks[i], &results[i]));
+
+	pool.wait_work();
+
+	for(size_t i = 0; i < blocks.size(); i++) {
+		const int4& rect = blocks[i];
+		denoiser.write(buffers, tile_manager.state.sample + tile_manager.state.num_samples,
+		               rect.x, rect.y, rect.z, rect.w, results[i]);
+	}
+
+	buffers->copy_to_device();
+
+	stats.denoise_time += time_dt() - filter_start;
+}
+
+void Session::denoise_finish()
+{
+	if(!params.use_final_denoising())
+		return;
+
+	if(use_tile_denoising())
+		denoise_tiles_flush();
+	else if(!params.output_path.empty() && !progress.get_cancel())
+		denoise_buffers();
+
+	VLOG(1) << "Denoising time " << stats.denoise_time << " seconds.";
+}
+
+/* Ray Statistics */
+
+struct RayStatsShaderTimeCompare {
+	const RayStats *ray_stats;
+
+	bool operator()(int a, int b) const
+	{
+		return ray_stats->shader_ticks[a] > ray_stats->shader_ticks[b];
+	}
+};
+
+static string ray_stats_json_string(const string& str)
+{
+	string result = "\"";
+
+	foreach(char c, str) {
+		if(c == '"' || c == '\\')
+			result += string("\\") + c;
+		else if((unsigned char)c < 0x20)
+			result += string_printf("\\u%04x", (int)c);
+		else
+			result += c;
+	}
+
+	return result + "\"";
+}
+
+void Session::ray_stats_report(double render_time)
+{
+	RayStats ray_stats;
+
+	{
+		thread_scoped_lock lock(stats.ray_stats_mutex);
+		ray_stats = stats.ray_stats;
+	}
+
+	double seconds_per_tick = 1.0/time_ticks_per_second();
+	uint64_t num_rays = 0;
+
+	for(int i = 0; i < RAY_STATS_NUM_RAYS; i++)
+		num_rays += ray_stats.rays[i];
+
+	if(num_rays == 0) {
+		VLOG(1) << "No ray statistics collected, they are only available "
+		        << "in debug builds on the CPU.";
+		return;
+	}
+
+	uint64_t num_path_rays = ray_stats.rays[RAY_STATS_CAMERA] + ray_stats.rays[RAY_STATS_BOUNCE];
+	double steps_per_ray = (num_path_rays)? (double)ray_stats.bvh_traversal_steps/num_path_rays: 0.0;
+
+	VLOG(1) << "Ray statistics: " << num_rays << " rays, "
+	        << steps_per_ray << " BVH traversal steps per ray, "
+	        << ray_stats.stage_ticks[RAY_STATS_STAGE_PATH]*seconds_per_tick
+	        << " seconds of path tracing on all threads.";
+
+	if(ray_stats_filepath.empty())
+		return;
+
+	/* shaders that took the most time first */
+	vector<int> shaders;
+
+	for(size_t i = 0; i < ray_stats.shader_ticks.size(); i++)
+		if(ray_stats.shader_evals[i] && i < scene->shaders.size())
+			shaders.push_back(i);
+
+	RayStatsShaderTimeCompare compare;
+	compare.ray_stats = &ray_stats;
+	sort(shaders.begin(), shaders.end(), compare);
+
+	/* report, times are summed over all threads */
+	string report = "{\n";
+
+	report += string_printf("\t\"render_time\": %f,\n", render_time);
+	report += string_printf("\t\"resolution\": [%d, %d],\n",
+	                        tile_manager.params.width, tile_manager.params.height);
+	report += string_printf("\t\"samples\": %d,\n", tile_manager.num_samples);
+
+	report += "\t\"rays\": {\n";
+	for(int i = 0; i < RAY_STATS_NUM_RAYS; i++)
+		report += string_printf("\t\t\"%s\": %llu,\n", RayStats::ray_name(i),
+		                        (unsigned long long)ray_stats.rays[i]);
+	report += string_printf("\t\t\"total\": %llu\n", (unsigned long long)num_rays);
+	report += "\t},\n";
+
+	report += string_printf("\t\"bvh_traversal_steps\": %llu,\n",
+	                        (unsigned long long)ray_stats.bvh_traversal_steps);
+	report += string_printf("\t\"bvh_traversal_steps_per_ray\": %f,\n", steps_per_ray);
+
+	report += "\t\"stage_time\": {\n";
+	for(int i = 0; i < RAY_STATS_NUM_STAGES; i++)
+		report += string_printf("\t\t\"%s\": %f%s\n", RayStats::stage_name(i),
+		                        ray_stats.stage_ticks[i]*seconds_per_tick,
+		                        (i + 1 < RAY_STATS_NUM_STAGES)? ",": "");
+	report += "\t},\n";
+
+	report += "\t\"shaders\": [\n";
+	for(size_t i = 0; i < shaders.size(); i++) {
+		int shader = shaders[i];
+
+		report += string_printf("\t\t{\"name\": %s, \"evaluations\": %llu, \"time\": %f}%s\n",
+		                        ray_stats_json_string(scene->shaders[shader]->name.c_str()).c_str(),
+		                        (unsigned long long)ray_stats.shader_evals[shader],
+		                        ray_stats.shader_ticks[shader]*seconds_per_tick,
+		                        (i + 1 < shaders.size())? ",": "");
+	}
+	report += "\t]\n";
+
+	report += "}\n";
+
+	path_create_directories(ray_stats_filepath);
+
+	if(path_write_text(ray_stats_filepath, report))
+		VLOG(1) << "Wrote ray statistics to " << ray_stats_filepath << ".";
+	else
+		VLOG(1) << "Failed to write ray statistics to " << ray_stats_filepath << ".";
+}
+
 void Session::device_free()
 {
 	scene->device_free();
@@ -18,6 +18,7 @@
 #define __SESSION_H__
 
 #include "buffers.h"
+#include "denoising.h"
 #include "device.h"
 #include "shader.h"
 #include "tile.h"
@@ -30,6 +31,7 @@
 CCL_NAMESPACE_BEGIN
 
 class BufferParams;
+class Checkpoint;
 class Device;
 class DeviceScene;
 class DeviceRequestedFeatures;
@@ -55,6 +57,30 @@ public:
 	int start_resolution;
 	int threads;
 
+	/* adaptive sampling, zero threshold disables it and zero minimum
+	 * number of samples picks one based on the number of samples,
+	 * pixels that did not converge at the number of samples continue
+	 * up to the maximum number of samples when it is larger */
+	float adaptive_threshold;
+	int adaptive_min_samples;
+	int adaptive_max_samples;
+
+	/* trace camera rays of a tile row together, CPU only */
+	bool use_ray_stream;
+
+	/* collect ray and shading statistics and report them after the
+	 * render, only available in debug builds on the CPU */
+	bool use_ray_stats;
+
+	/* seconds between writing render buffers to a checkpoint, so an
+	 * interrupted background render can be resumed, zero disables it */
+	double checkpoint_interval;
+
+	/* denoise the combined pass after rendering, final renders only and not
+	 * with progressive refine */
+	bool use_denoising;
+	DenoiseParams denoising;
+
 	bool display_buffer_linear;
 
 	double cancel_timeout;
@@ -77,6 +103,17 @@ public:
 		start_resolution = INT_MAX;
 		threads = 0;
 
+		adaptive_threshold = 0.0f;
+		adaptive_min_samples = 0;
+		adaptive_max_samples = 0;
+
+		use_ray_stream = false;
+		use_ray_stats = false;
+
+		checkpoint_interval = 0.0;
+
+		use_denoising = false;
+
 		display_buffer_linear = false;
 
 		cancel_timeout = 0.1;
@@ -100,6 +137,14 @@ public:
 		&& tile_size == params.tile_size
 		&& start_resolution == params.start_resolution
 		&& threads == params.threads
+		&& adaptive_threshold == params.adaptive_threshold
+		&& adaptive_min_samples == params.adaptive_min_samples
+		&& adaptive_max_samples == params.adaptive_max_samples
+		&& use_ray_stream == params.use_ray_stream
+		&& use_ray_stats == params.use_ray_stats
+		&& checkpoint_interval == params.checkpoint_interval
+		&& use_denoising == params.use_denoising
+		&& !denoising.modified(params.denoising)
 		&& display_buffer_linear == params.display_buffer_linear
 		&& cancel_timeout == params.cancel_timeout
 		&& reset_timeout == params.reset_timeout
@@ -108,6 +153,13 @@ public:
 		&& tile_order == params.tile_order
 		&& shadingsystem == params.shadingsystem); }
 
+	/* only the CPU device skips converged pixels */
+	bool use_adaptive_sampling() const
+	{ return adaptive_threshold > 0.0f && device.type == DEVICE_CPU; }
+
+	bool use_final_denoising() const
+	{ return use_denoising && background && !progressive_refine; }
+
 };
 
 /* Session
@@ -140,6 +192,8 @@ public:
 	void reset(BufferParams& params, int samples);
 	void set_samples(int samples);
 	void set_pause(bool pause);
+	void set_checkpoint(const string& filepath, const string& scene_filepath = "");
+	void set_ray_stats_report(const string& filepath);
 
 	void update_scene();
 	void load_kernels();
@@ -176,6 +230,41 @@ protected:
 
 	void update_progress_sample();
 
+	bool add_internal_passes(vector<Pass>& passes);
+
+	void checkpoint_begin();
+	void checkpoint_end();
+	void checkpoint_tile(RenderTile& rtile);
+	void checkpoint_progressive();
+	void checkpoint_restore_tile(Device *tile_device, RenderTile& rtile, RenderBuffers *tilebuffers);
+
+	void ray_stats_report(double render_time);
+
+	enum DenoiseTileState {
+		DENOISE_TILE_NONE = 0,
+		DENOISE_TILE_RENDERED,
+		DENOISE_TILE_FILTERING,
+		DENOISE_TILE_FILTERED,
+		DENOISE_TILE_WRITTEN
+	};
+
+	struct DenoiseTile {
+		DenoiseTileState state;
+		RenderTile rtile;
+		vector<float3> result;
+	};
+
+	bool use_tile_denoising();
+	void denoise_tiles_init();
+	void denoise_tile_release(RenderTile& rtile, thread_scoped_lock& tile_lock);
+	bool denoise_tile_ready(int index);
+	bool denoise_tile_writable(int index);
+	void denoise_tile_filter(int index);
+	void denoise_tile_write(int index);
+	void denoise_tiles_flush();
+	void denoise_buffers();
+	void denoise_finish();
+
 	bool device_use_gl;
 
 	thread *session_thread;
@@ -206,6 +295,21 @@ protected:
 
 	vector<RenderBuffers *> tile_buffers;
 
+	/* checkpoint of the render in progress, background render only */
+	Checkpoint *checkpoint;
+	string checkpoint_filepath;
+	/* file the scene was loaded from, a checkpoint is not resumed when it
+	 * was saved since */
+	string checkpoint_scene_filepath;
+
+	/* file the ray statistics report of the next render is written to */
+	string ray_stats_filepath;
+
+	/* temporary tile buffers kept until the tiles around them are rendered,
+	 * so tiles are denoised with the pixels across their borders, indexed
+	 * by tile index and protected by the tile mutex */
+	vector<DenoiseTile> denoise_tiles;
+
 	DeviceRequestedFeatures get_requested_device_features();
 
 	/* ** Split kernel routines ** */
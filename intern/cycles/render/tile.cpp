@@ -17,6 +17,7 @@
 #include "tile.h"
 
 #include "util_algorithm.h"
+#include "util_foreach.h"
 #include "util_types.h"
 
 CCL_NAMESPACE_BEGIN
@@ -29,6 +30,7 @@ TileManager::TileManager(bool progressive_, int num_samples_, int2 tile_size_, i
 	tile_order = tile_order_;
 	start_resolution = start_resolution_;
 	num_samples = num_samples_;
+	max_samples = 0;
 	num_devices = num_devices_;
 	preserve_tile_device = preserve_tile_device_;
 	background = background_;
@@ -66,6 +68,10 @@ void TileManager::reset(BufferParams& params_, int num_samples_)
 	state.num_samples = 0;
 	state.resolution_divider = divider;
 	state.tiles.clear();
+	state.tile_converged.clear();
+	state.num_converged_tiles = 0;
+
+	resume_finished_tiles.clear();
 }
 
 void TileManager::set_samples(int num_samples_)
@@ -73,6 +79,16 @@ void TileManager::set_samples(int num_samples_)
 	num_samples = num_samples_;
 }
 
+void TileManager::set_max_samples(int max_samples_)
+{
+	max_samples = max_samples_;
+}
+
+int TileManager::get_end_sample()
+{
+	return max(num_samples, max_samples);
+}
+
 /* splits image into tiles and assigns equal amount of tiles to every render device */
 void TileManager::gen_tiles_global()
 {
@@ -156,6 +172,31 @@ void TileManager::set_tiles()
 
 	state.num_tiles = state.tiles.size();
 
+	/* tiles that converged with adaptive sampling are not rendered again,
+	 * convergence is only tracked while the tile layout stays the same */
+	if((int)state.tile_converged.size() != state.num_tiles) {
+		state.tile_converged.clear();
+		state.tile_converged.resize(state.num_tiles, false);
+		state.num_converged_tiles = 0;
+
+		/* tiles finished before the render was resumed are done as well */
+		foreach(int index, resume_finished_tiles)
+			set_tile_converged(index);
+
+		resume_finished_tiles.clear();
+	}
+
+	if(state.num_converged_tiles > 0) {
+		list<Tile>::iterator iter = state.tiles.begin();
+
+		while(iter != state.tiles.end()) {
+			if(state.tile_converged[iter->index])
+				iter = state.tiles.erase(iter);
+			else
+				iter++;
+		}
+	}
+
 	state.buffer.width = image_w;
 	state.buffer.height = image_h;
 
@@ -253,7 +294,56 @@ bool TileManager::next_tile(Tile& tile, int device)
 
 bool TileManager::done()
 {
-	return (state.sample+state.num_samples >= num_samples && state.resolution_divider == 1);
+	if(state.num_tiles > 0 && state.num_converged_tiles == state.num_tiles)
+		return true;
+
+	/* passes past num_samples only contain the tiles that did not converge yet,
+	 * converged tiles are removed from the tile list by set_tiles */
+	return (state.sample+state.num_samples >= get_end_sample() && state.resolution_divider == 1);
+}
+
+void TileManager::set_tile_converged(int index)
+{
+	if(index < 0 || index >= (int)state.tile_converged.size())
+		return;
+
+	if(!state.tile_converged[index]) {
+		state.tile_converged[index] = true;
+		state.num_converged_tiles++;
+	}
+}
+
+int TileManager::neighbor_tile_index(int index, int dx, int dy)
+{
+	/* same layout as gen_tiles_global */
+	int resolution = state.resolution_divider;
+	int image_w = max(1, params.width/resolution);
+	int image_h = max(1, params.height/resolution);
+
+	int tile_w = (tile_size.x >= image_w)? 1: (image_w + tile_size.x - 1)/tile_size.x;
+	int tile_h = (tile_size.y >= image_h)? 1: (image_h + tile_size.y - 1)/tile_size.y;
+
+	int tile_x = index % tile_w + dx;
+	int tile_y = index / tile_w + dy;
+
+	if(tile_x < 0 || tile_x >= tile_w || tile_y < 0 || tile_y >= tile_h)
+		return -1;
+
+	return tile_x + tile_y*tile_w;
+}
+
+void TileManager::resume(int sample, const vector<int>& finished_tiles)
+{
+	/* skip the low resolution start, the buffers already have samples */
+	if(sample > 0) {
+		state.sample = sample - 1;
+		state.resolution_divider = 1;
+	}
+
+	if(!progressive)
+		state.num_rendered_tiles = finished_tiles.size();
+
+	resume_finished_tiles = finished_tiles;
 }
 
 bool TileManager::next()
@@ -270,10 +360,12 @@ bool TileManager::next()
 	else {
 		state.sample++;
 
+		/* without progressive rendering each tile takes all samples at once,
+		 * it stops early when converged or continues up to max_samples */
 		if(progressive)
 			state.num_samples = 1;
 		else
-			state.num_samples = num_samples;
+			state.num_samples = get_end_sample();
 
 		state.resolution_divider = 1;
 		set_tiles();
@@ -21,6 +21,7 @@
 
 #include "buffers.h"
 #include "util_list.h"
+#include "util_vector.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -65,19 +66,39 @@ public:
 		int num_tiles;
 		int num_rendered_tiles;
 		list<Tile> tiles;
+
+		/* tiles which converged with adaptive sampling, indexed by tile index */
+		vector<bool> tile_converged;
+		int num_converged_tiles;
 	} state;
 
 	int num_samples;
 
+	/* with adaptive sampling, tiles that did not converge at num_samples
+	 * keep sampling up to this many samples, ignored when not larger */
+	int max_samples;
+
 	TileManager(bool progressive, int num_samples, int2 tile_size, int start_resolution,
 	            bool preserve_tile_device, bool background, TileOrder tile_order, int num_devices = 1);
 	~TileManager();
 
 	void reset(BufferParams& params, int num_samples);
 	void set_samples(int num_samples);
+	void set_max_samples(int max_samples);
+	int get_end_sample();
 	bool next();
 	bool next_tile(Tile& tile, int device = 0);
 	bool done();
+
+	void set_tile_converged(int index);
+
+	/* index of the tile at the given offset in tiles from another tile, or
+	 * -1 outside of the image, background render tiles only */
+	int neighbor_tile_index(int index, int dx, int dy);
+
+	/* continue a render from a checkpoint, at the given sample and with
+	 * the given tiles already finished */
+	void resume(int sample, const vector<int>& finished_tiles);
 	
 	void set_tile_order(TileOrder tile_order_) { tile_order = tile_order_; }
 protected:
@@ -86,6 +107,7 @@ protected:
 
 	bool progressive;
 	int2 tile_size;
+	vector<int> resume_finished_tiles;
 	TileOrder tile_order;
 	int start_resolution;
 	int num_devices;
@@ -24,36 +24,118 @@
 
 CCL_NAMESPACE_BEGIN
 
-/* EdgeDice Base */
+/* Dice Buffer */
 
-EdgeDice::EdgeDice(const SubdParams& params_)
-: params(params_)
+void DiceBuffer::clear()
 {
-	mesh_P = NULL;
-	mesh_N = NULL;
-	vert_offset = 0;
+	P.clear();
+	N.clear();
+	ptex_uv.clear();
+	triangles.clear();
+	ptex_face_id.clear();
+}
 
-	params.mesh->attributes.add(ATTR_STD_VERTEX_NORMAL);
+void DiceBuffer::swap(DiceBuffer& other)
+{
+	P.swap(other.P);
+	N.swap(other.N);
+	ptex_uv.swap(other.ptex_uv);
+	triangles.swap(other.triangles);
+	ptex_face_id.swap(other.ptex_face_id);
+}
 
-	if(params.ptex) {
-		params.mesh->attributes.add(ATTR_STD_PTEX_UV);
-		params.mesh->attributes.add(ATTR_STD_PTEX_FACE_ID);
+void DiceBuffer::append(const DiceBuffer& from,
+                        size_t vert_start, size_t num_verts,
+                        size_t tri_start, size_t num_tris)
+{
+	int offset = (int)P.size() - (int)vert_start;
+
+	P.insert(P.end(), from.P.begin() + vert_start, from.P.begin() + vert_start + num_verts);
+	N.insert(N.end(), from.N.begin() + vert_start, from.N.begin() + vert_start + num_verts);
+
+	if(from.ptex_uv.size())
+		ptex_uv.insert(ptex_uv.end(), from.ptex_uv.begin() + vert_start, from.ptex_uv.begin() + vert_start + num_verts);
+	if(from.ptex_face_id.size())
+		ptex_face_id.insert(ptex_face_id.end(), from.ptex_face_id.begin() + tri_start, from.ptex_face_id.begin() + tri_start + num_tris);
+
+	for(size_t i = 0; i < num_tris; i++) {
+		const int3& tri = from.triangles[tri_start + i];
+		triangles.push_back(make_int3(tri.x + offset, tri.y + offset, tri.z + offset));
 	}
 }
 
-void EdgeDice::reserve(int num_verts, int num_tris)
+void DiceBuffer::add_to_mesh(const SubdParams& params) const
 {
 	Mesh *mesh = params.mesh;
+	size_t vert_offset = mesh->verts.size();
+	size_t tri_offset = mesh->triangles.size();
+
+	Attribute *attr_vN = mesh->attributes.add(ATTR_STD_VERTEX_NORMAL);
+	Attribute *attr_ptex_uv = NULL;
+	Attribute *attr_ptex_face_id = NULL;
+
+	if(params.ptex) {
+		attr_ptex_uv = mesh->attributes.add(ATTR_STD_PTEX_UV);
+		attr_ptex_face_id = mesh->attributes.add(ATTR_STD_PTEX_FACE_ID);
+	}
 
-	vert_offset = mesh->verts.size();
-	tri_offset = mesh->triangles.size();
+	mesh->reserve(vert_offset + P.size(), tri_offset + triangles.size(), 0, 0);
 
-	mesh->reserve(vert_offset + num_verts, tri_offset + num_tris, 0, 0);
+	/* vertices */
+	float3 *mesh_N = attr_vN->data_float3();
 
-	Attribute *attr_vN = mesh->attributes.add(ATTR_STD_VERTEX_NORMAL);
+	for(size_t i = 0; i < P.size(); i++) {
+		mesh->verts[vert_offset + i] = P[i];
+		mesh_N[vert_offset + i] = N[i];
+	}
+
+	/* triangles */
+	for(size_t i = 0; i < triangles.size(); i++) {
+		const int3& tri = triangles[i];
+
+		mesh->set_triangle(tri_offset + i,
+		                   vert_offset + tri.x,
+		                   vert_offset + tri.y,
+		                   vert_offset + tri.z,
+		                   params.shader, params.smooth);
+	}
+
+	/* ptex */
+	if(params.ptex) {
+		float3 *mesh_ptex_uv = attr_ptex_uv->data_float3();
+		float *mesh_ptex_face_id = attr_ptex_face_id->data_float();
 
-	mesh_P = &mesh->verts[0];
-	mesh_N = attr_vN->data_float3();
+		for(size_t i = 0; i < ptex_uv.size(); i++)
+			mesh_ptex_uv[vert_offset + i] = ptex_uv[i];
+		for(size_t i = 0; i < ptex_face_id.size(); i++)
+			mesh_ptex_face_id[tri_offset + i] = (float)ptex_face_id[i];
+	}
+}
+
+/* EdgeDice Base */
+
+EdgeDice::EdgeDice(const SubdParams& params_, DiceBuffer *buffer_)
+: params(params_), buffer(buffer_)
+{
+	vert_end = 0;
+}
+
+void EdgeDice::reserve(int num_verts, int num_tris)
+{
+	size_t size = buffer->P.size() + num_verts;
+
+	vert_end = size;
+
+	/* grow geometrically, patches are added one by one */
+	if(buffer->P.capacity() < size) {
+		if(size < buffer->P.capacity()*2)
+			size = buffer->P.capacity()*2;
+
+		buffer->P.reserve(size);
+		buffer->N.reserve(size);
+		if(params.ptex)
+			buffer->ptex_uv.reserve(size);
+	}
 }
 
 int EdgeDice::add_vert(Patch *patch, float2 uv)
@@ -63,35 +145,23 @@ int EdgeDice::add_vert(Patch *patch, float2 uv)
 	patch->eval(&P, &dPdu, &dPdv, uv.x, uv.y);
 	N = normalize(cross(dPdu, dPdv));
 
-	assert(vert_offset < params.mesh->verts.size());
+	assert(buffer->P.size() < vert_end);
 
-	mesh_P[vert_offset] = P;
-	mesh_N[vert_offset] = N;
-
-	if(params.ptex) {
-		Attribute *attr_ptex_uv = params.mesh->attributes.add(ATTR_STD_PTEX_UV);
-		params.mesh->attributes.reserve();
+	buffer->P.push_back(P);
+	buffer->N.push_back(N);
 
-		float3 *ptex_uv = attr_ptex_uv->data_float3();
-		ptex_uv[vert_offset] = make_float3(uv.x, uv.y, 0.0f);
-	}
+	if(params.ptex)
+		buffer->ptex_uv.push_back(make_float3(uv.x, uv.y, 0.0f));
 
-	return vert_offset++;
+	return buffer->P.size() - 1;
 }
 
 void EdgeDice::add_triangle(Patch *patch, int v0, int v1, int v2)
 {
-	params.mesh->add_triangle(v0, v1, v2, params.shader, params.smooth);
-
-	if(params.ptex) {
-		Attribute *attr_ptex_face_id = params.mesh->attributes.add(ATTR_STD_PTEX_FACE_ID);
-		params.mesh->attributes.reserve();
-
-		float *ptex_face_id = attr_ptex_face_id->data_float();
-		ptex_face_id[tri_offset] = (float)patch->ptex_face_id();
-	}
+	buffer->triangles.push_back(make_int3(v0, v1, v2));
 
-	tri_offset++;
+	if(params.ptex)
+		buffer->ptex_face_id.push_back(patch->ptex_face_id());
 }
 
 void EdgeDice::stitch_triangles(Patch *patch, vector<int>& outer, vector<int>& inner)
@@ -117,8 +187,9 @@ void EdgeDice::stitch_triangles(Patch *patch, vector<int>& outer, vector<int>& i
 		}
 		else {
 			/* length of diagonals */
-			float len1 = len_squared(mesh_P[inner[i]] - mesh_P[outer[j+1]]);
-			float len2 = len_squared(mesh_P[outer[j]] - mesh_P[inner[i+1]]);
+			const float3 *P = &buffer->P[0];
+			float len1 = len_squared(P[inner[i]] - P[outer[j+1]]);
+			float len2 = len_squared(P[outer[j]] - P[inner[i+1]]);
 
 			/* use smallest diagonal */
 			if(len1 < len2)
@@ -133,8 +204,8 @@ void EdgeDice::stitch_triangles(Patch *patch, vector<int>& outer, vector<int>& i
 
 /* QuadDice */
 
-QuadDice::QuadDice(const SubdParams& params_)
-: EdgeDice(params_)
+QuadDice::QuadDice(const SubdParams& params_, DiceBuffer *buffer_)
+: EdgeDice(params_, buffer_)
 {
 }
 
@@ -310,7 +381,7 @@ void QuadDice::dice(SubPatch& sub, EdgeFactors& ef)
 	Mv = max((int)ceil(S*Mv), 2); // XXX handle 0 & 1?
 
 	/* reserve space for new verts */
-	int offset = params.mesh->verts.size();
+	int offset = buffer->P.size();
 	reserve(ef, Mu, Mv);
 
 	/* corners and inner grid */
@@ -335,13 +406,13 @@ void QuadDice::dice(SubPatch& sub, EdgeFactors& ef)
 	add_side_v(sub, outer, inner, Mu, Mv, ef.tv1, 1, offset);
 	stitch_triangles(sub.patch, outer, inner);
 
-	assert(vert_offset == params.mesh->verts.size());
+	assert(buffer->P.size() == vert_end);
 }
 
 /* TriangleDice */
 
-TriangleDice::TriangleDice(const SubdParams& params_)
-: EdgeDice(params_)
+TriangleDice::TriangleDice(const SubdParams& params_, DiceBuffer *buffer_)
+: EdgeDice(params_, buffer_)
 {
 }
 
@@ -474,7 +545,7 @@ void TriangleDice::dice(SubPatch& sub, EdgeFactors& ef)
 	reserve(ef, M);
 	add_grid(sub, ef, M);
 
-	assert(vert_offset == params.mesh->verts.size());
+	assert(buffer->P.size() == vert_end);
 }
 
 CCL_NAMESPACE_END
@@ -57,17 +57,37 @@ struct SubdParams {
 
 };
 
+/* Dice Buffer
+ *
+ * Diced vertices and triangles, with vertex indices local to the buffer.
+ * Patches can be diced into separate buffers in parallel, which are then
+ * added to the mesh in order. */
+
+class DiceBuffer {
+public:
+	vector<float3> P;
+	vector<float3> N;
+	vector<float3> ptex_uv;
+	vector<int3> triangles;
+	vector<int> ptex_face_id;
+
+	void clear();
+	void swap(DiceBuffer& other);
+	void append(const DiceBuffer& from,
+	            size_t vert_start, size_t num_verts,
+	            size_t tri_start, size_t num_tris);
+	void add_to_mesh(const SubdParams& params) const;
+};
+
 /* EdgeDice Base */
 
 class EdgeDice {
 public:
 	SubdParams params;
-	float3 *mesh_P;
-	float3 *mesh_N;
-	size_t vert_offset;
-	size_t tri_offset;
+	DiceBuffer *buffer;
+	size_t vert_end;
 
-	EdgeDice(const SubdParams& params);
+	EdgeDice(const SubdParams& params, DiceBuffer *buffer);
 
 	void reserve(int num_verts, int num_tris);
 
@@ -108,7 +128,7 @@ public:
 		int tv1;
 	};
 
-	QuadDice(const SubdParams& params);
+	QuadDice(const SubdParams& params, DiceBuffer *buffer);
 
 	void reserve(EdgeFactors& ef, int Mu, int Mv);
 	float3 eval_projected(SubPatch& sub, float u, float v);
@@ -162,7 +182,7 @@ public:
 		int tw;
 	};
 
-	TriangleDice(const SubdParams& params);
+	TriangleDice(const SubdParams& params, DiceBuffer *buffer);
 
 	void reserve(EdgeFactors& ef, int M);
 
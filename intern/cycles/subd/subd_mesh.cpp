@@ -28,12 +28,150 @@
 
 #include <stdio.h>
 
+#include "mesh.h"
+
 #include "subd_mesh.h"
 #include "subd_patch.h"
 #include "subd_split.h"
 
 #include "util_debug.h"
 #include "util_foreach.h"
+#include "util_logging.h"
+#include "util_task.h"
+#include "util_time.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Parallel Tessellation
+ *
+ * Faces are split and diced in chunks by the task scheduler, each chunk into
+ * its own buffer. The buffers are added to the mesh in order afterwards, so
+ * the result is the same as dicing one patch after the other. */
+
+static void subd_tessellate_chunks(vector<SubdTessellateChunk>& chunks, int num_faces)
+{
+	int num_threads = max(TaskScheduler::num_threads(), 1);
+	int chunk_size = max(num_faces/(num_threads*8), 16);
+
+	for(int start = 0; start < num_faces; start += chunk_size) {
+		SubdTessellateChunk chunk;
+
+		chunk.start = start;
+		chunk.end = min(start + chunk_size, num_faces);
+		chunk.num_reused = 0;
+
+		chunks.push_back(chunk);
+	}
+}
+
+static SubdPatchKey subd_patch_key(DiagSplit& split, Patch *patch, const float3 *hull, int num_hull)
+{
+	SubdPatchKey key;
+
+	for(int i = 0; i < 4; i++)
+		key.hull[i] = (i < num_hull)? hull[i]: make_float3(0.0f, 0.0f, 0.0f);
+
+	if(patch->is_triangle()) {
+		TriangleDice::EdgeFactors ef = split.triangle_edge_factors(patch);
+
+		key.ef[0] = ef.tu;
+		key.ef[1] = ef.tv;
+		key.ef[2] = ef.tw;
+		key.ef[3] = 0;
+	}
+	else {
+		QuadDice::EdgeFactors ef = split.quad_edge_factors(patch);
+
+		key.ef[0] = ef.tu0;
+		key.ef[1] = ef.tu1;
+		key.ef[2] = ef.tv0;
+		key.ef[3] = ef.tv1;
+	}
+
+	return key;
+}
+
+static void subd_dice_patch(DiagSplit& split, Patch *patch, const SubdPatchKey& key, int f,
+                            const SubdCache *cache, SubdTessellateChunk *chunk)
+{
+	DiceBuffer& diced = chunk->diced;
+	SubdPatchRange range;
+
+	range.vert_start = diced.P.size();
+	range.tri_start = diced.triangles.size();
+
+	if(cache && f < (int)cache->keys.size() && key.cacheable() && cache->keys[f] == key) {
+		/* copy from previous tessellation */
+		const SubdPatchRange& cached = cache->ranges[f];
+
+		diced.append(cache->diced,
+		             cached.vert_start, cached.num_verts,
+		             cached.tri_start, cached.num_tris);
+
+		chunk->num_reused++;
+	}
+	else if(patch->is_triangle())
+		split.split_triangle(patch, &diced);
+	else
+		split.split_quad(patch, &diced);
+
+	range.num_verts = diced.P.size() - range.vert_start;
+	range.num_tris = diced.triangles.size() - range.tri_start;
+
+	chunk->keys.push_back(key);
+	chunk->ranges.push_back(range);
+}
+
+static void subd_tessellate_finish(const SubdParams& params, SubdCache *cache,
+                                   vector<SubdTessellateChunk>& chunks, double time_start)
+{
+	DiceBuffer cache_diced;
+	vector<SubdPatchKey> cache_keys;
+	vector<SubdPatchRange> cache_ranges;
+	size_t num_patches = 0, num_reused = 0, num_tris = 0;
+
+	foreach(SubdTessellateChunk& chunk, chunks) {
+		chunk.diced.add_to_mesh(params);
+
+		if(cache) {
+			size_t vert_offset = cache_diced.P.size();
+			size_t tri_offset = cache_diced.triangles.size();
+
+			cache_diced.append(chunk.diced,
+			                   0, chunk.diced.P.size(),
+			                   0, chunk.diced.triangles.size());
+
+			foreach(SubdPatchRange range, chunk.ranges) {
+				range.vert_start += vert_offset;
+				range.tri_start += tri_offset;
+				cache_ranges.push_back(range);
+			}
+
+			cache_keys.insert(cache_keys.end(), chunk.keys.begin(), chunk.keys.end());
+		}
+
+		num_patches += chunk.end - chunk.start;
+		num_reused += chunk.num_reused;
+		num_tris += chunk.diced.triangles.size();
+
+		/* free memory early */
+		DiceBuffer empty;
+		chunk.diced.swap(empty);
+	}
+
+	if(cache) {
+		cache->params_set(params);
+		cache->diced.swap(cache_diced);
+		cache->keys.swap(cache_keys);
+		cache->ranges.swap(cache_ranges);
+	}
+
+	VLOG(1) << "Tessellated " << params.mesh->name.c_str() << ": "
+	        << num_patches << " patches (" << num_reused << " from cache) into "
+	        << num_tris << " triangles in " << (time_dt() - time_start) << " seconds.";
+}
+
+CCL_NAMESPACE_END
 
 #ifdef WITH_OPENSUBDIV
 
@@ -212,6 +350,9 @@ void OpenSubdMesh::add_face(int *index, int num)
 
 	OsdHbrFace *face = hbrmesh->NewFace(num, index, 0);
 
+	face_verts.push_back(num);
+	face_verts.insert(face_verts.end(), index, index + num);
+
 	/* this is required for limit eval patch table? */
 	face->SetPtexIndex(num_ptex_faces);
 
@@ -232,11 +373,13 @@ bool OpenSubdMesh::finish()
 	return true;
 }
 
-void OpenSubdMesh::tessellate(DiagSplit *split)
+void OpenSubdMesh::tessellate(DiagSplit *split, SubdCache *cache)
 {
 	if(num_ptex_faces == 0)
 		return;
 
+	double time_start = time_dt();
+
 	const int level = 3;
 	const bool requirefvar = false;
 
@@ -261,12 +404,32 @@ void OpenSubdMesh::tessellate(DiagSplit *split)
 	compute_controller->Refine(compute_context, farmesh->GetKernelBatches(), vbuf_base);
 	compute_controller->Synchronize();
 
+	/* limit surface patches depend on neighboring faces, so only use the
+	 * cache when the whole control mesh is unchanged */
+	bool use_cache = cache &&
+	                 cache->params_match(split->params) &&
+	                 cache->control_P == positions &&
+	                 cache->control_faces == face_verts;
+
 	/* split & dice patches */
-	OpenSubdPatch patch(farmesh, vbuf_base);
+	vector<SubdTessellateChunk> chunks;
+	subd_tessellate_chunks(chunks, num_ptex_faces);
 
-	for(int f = 0; f < num_ptex_faces; f++) {
-		patch.face_id = f;
-		split->split_quad(&patch);
+	TaskPool pool;
+
+	foreach(SubdTessellateChunk& chunk, chunks) {
+		pool.push(function_bind(&OpenSubdMesh::tessellate_chunk, this,
+		                        split->params, (use_cache)? cache: NULL, &chunk,
+		                        (void*)farmesh, (void*)vbuf_base));
+	}
+
+	pool.wait_work();
+
+	subd_tessellate_finish(split->params, cache, chunks, time_start);
+
+	if(cache) {
+		cache->control_P = positions;
+		cache->control_faces = face_verts;
 	}
 
 	/* clean up */
@@ -276,6 +439,22 @@ void OpenSubdMesh::tessellate(DiagSplit *split)
 	delete vbuf_base;
 }
 
+void OpenSubdMesh::tessellate_chunk(const SubdParams& params, SubdCache *cache,
+                                    SubdTessellateChunk *chunk, void *farmesh, void *vbuf_base)
+{
+	DiagSplit split(params);
+
+	/* evaluation buffers are part of the patch, one per task */
+	OpenSubdPatch patch((OsdFarMesh*)farmesh, (OsdCpuVertexBuffer*)vbuf_base);
+
+	for(int f = chunk->start; f < chunk->end; f++) {
+		patch.face_id = f;
+
+		SubdPatchKey key = subd_patch_key(split, &patch, NULL, 0);
+		subd_dice_patch(split, &patch, key, f, cache, chunk);
+	}
+}
+
 CCL_NAMESPACE_END
 
 #else /* WITH_OPENSUBDIV */
@@ -373,11 +552,33 @@ bool SubdMesh::finish()
 	return true;
 }
 
-void SubdMesh::tessellate(DiagSplit *split)
+void SubdMesh::tessellate(DiagSplit *split, SubdCache *cache)
 {
+	double time_start = time_dt();
 	int num_faces = faces.size();
-		        
-	for(int f = 0; f < num_faces; f++) {
+	bool use_cache = cache && cache->params_match(split->params);
+
+	vector<SubdTessellateChunk> chunks;
+	subd_tessellate_chunks(chunks, num_faces);
+
+	TaskPool pool;
+
+	foreach(SubdTessellateChunk& chunk, chunks) {
+		pool.push(function_bind(&SubdMesh::tessellate_chunk, this,
+		                        split->params, (use_cache)? cache: NULL, &chunk));
+	}
+
+	pool.wait_work();
+
+	subd_tessellate_finish(split->params, cache, chunks, time_start);
+}
+
+void SubdMesh::tessellate_chunk(const SubdParams& params, SubdCache *cache,
+                                SubdTessellateChunk *chunk)
+{
+	DiagSplit split(params);
+
+	for(int f = chunk->start; f < chunk->end; f++) {
 		SubdFace *face = faces[f];
 		Patch *patch;
 		float3 *hull;
@@ -403,10 +604,8 @@ void SubdMesh::tessellate(DiagSplit *split)
 		if(face->numverts == 4)
 			swap(hull[2], hull[3]);
 
-		if(patch->is_triangle())
-			split->split_triangle(patch);
-		else
-			split->split_quad(patch);
+		SubdPatchKey key = subd_patch_key(split, patch, hull, face->numverts);
+		subd_dice_patch(split, patch, key, f, cache, chunk);
 
 		delete patch;
 	}
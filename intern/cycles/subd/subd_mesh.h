@@ -29,6 +29,8 @@
 #ifndef __SUBD_MESH_H__
 #define __SUBD_MESH_H__
 
+#include "subd_dice.h"
+
 #include "util_map.h"
 #include "util_types.h"
 #include "util_vector.h"
@@ -42,6 +44,99 @@ class SubdFace;
 
 class DiagSplit;
 class Mesh;
+class Patch;
+
+/* Subd Cache
+ *
+ * Diced patches from the previous tessellation of a mesh. A patch is copied
+ * from the cache instead of diced again when its hull and the edge factors
+ * of its boundary are unchanged, and all edge factors are uniform so that
+ * the boundary doesn't depend on splitting in the patch interior. */
+
+struct SubdPatchKey {
+	float3 hull[4];
+	int ef[4];
+
+	bool cacheable() const
+	{
+		for(int i = 0; i < 4; i++)
+			if(ef[i] < 0)
+				return false;
+		return true;
+	}
+
+	bool operator==(const SubdPatchKey& other) const
+	{
+		for(int i = 0; i < 4; i++) {
+			if(ef[i] != other.ef[i] ||
+			   hull[i].x != other.hull[i].x ||
+			   hull[i].y != other.hull[i].y ||
+			   hull[i].z != other.hull[i].z)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+};
+
+struct SubdPatchRange {
+	size_t vert_start, num_verts;
+	size_t tri_start, num_tris;
+};
+
+class SubdCache {
+public:
+	SubdCache()
+	{
+		dicing_rate = 0.0f;
+		test_steps = 0;
+		split_threshold = 0;
+		ptex = false;
+	}
+
+	bool params_match(const SubdParams& params) const
+	{
+		return dicing_rate == params.dicing_rate &&
+		       test_steps == params.test_steps &&
+		       split_threshold == params.split_threshold &&
+		       ptex == params.ptex;
+	}
+
+	void params_set(const SubdParams& params)
+	{
+		dicing_rate = params.dicing_rate;
+		test_steps = params.test_steps;
+		split_threshold = params.split_threshold;
+		ptex = params.ptex;
+	}
+
+	/* parameters the patches were diced with */
+	float dicing_rate;
+	int test_steps;
+	int split_threshold;
+	bool ptex;
+
+	/* control mesh, for limit surfaces which depend on neighboring faces */
+	vector<float> control_P;
+	vector<int> control_faces;
+
+	/* diced patches by face */
+	vector<SubdPatchKey> keys;
+	vector<SubdPatchRange> ranges;
+	DiceBuffer diced;
+};
+
+/* Patches diced by a single task */
+struct SubdTessellateChunk {
+	int start, end;
+	int num_reused;
+
+	DiceBuffer diced;
+	vector<SubdPatchKey> keys;
+	vector<SubdPatchRange> ranges;
+};
 
 /* Subd Mesh with simple linear subdivision */
 
@@ -58,12 +153,21 @@ public:
 	SubdFace *add_face(int *index, int num);
 
 	bool finish();
-	void tessellate(DiagSplit *split);
+	void tessellate(DiagSplit *split, SubdCache *cache = NULL);
 
 protected:
+#ifdef WITH_OPENSUBDIV
+	void tessellate_chunk(const SubdParams& params, SubdCache *cache,
+	                      SubdTessellateChunk *chunk, void *farmesh, void *vbuf_base);
+#else
+	void tessellate_chunk(const SubdParams& params, SubdCache *cache,
+	                      SubdTessellateChunk *chunk);
+#endif
+
 #ifdef WITH_OPENSUBDIV
 	void *_hbrmesh;
 	vector<float> positions;
+	vector<int> face_verts;
 	int num_verts, num_ptex_faces;
 #else
 	vector<SubdVert*> verts;
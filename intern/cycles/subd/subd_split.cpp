@@ -241,23 +241,42 @@ void DiagSplit::split(QuadDice::SubPatch& sub, QuadDice::EdgeFactors& ef, int de
 		dispatch(sub, ef);
 }
 
-void DiagSplit::split_triangle(Patch *patch)
+TriangleDice::EdgeFactors DiagSplit::triangle_edge_factors(Patch *patch)
+{
+	TriangleDice::EdgeFactors ef;
+
+	ef.tu = T(patch, make_float2(0.0f, 1.0f), make_float2(0.0f, 0.0f));
+	ef.tv = T(patch, make_float2(0.0f, 0.0f), make_float2(1.0f, 0.0f));
+	ef.tw = T(patch, make_float2(1.0f, 0.0f), make_float2(0.0f, 1.0f));
+
+	return ef;
+}
+
+QuadDice::EdgeFactors DiagSplit::quad_edge_factors(Patch *patch)
+{
+	QuadDice::EdgeFactors ef;
+
+	ef.tu0 = T(patch, make_float2(0.0f, 0.0f), make_float2(1.0f, 0.0f));
+	ef.tu1 = T(patch, make_float2(0.0f, 1.0f), make_float2(1.0f, 1.0f));
+	ef.tv0 = T(patch, make_float2(0.0f, 0.0f), make_float2(0.0f, 1.0f));
+	ef.tv1 = T(patch, make_float2(1.0f, 0.0f), make_float2(1.0f, 1.0f));
+
+	return ef;
+}
+
+void DiagSplit::split_triangle(Patch *patch, DiceBuffer *buffer)
 {
 	TriangleDice::SubPatch sub_split;
-	TriangleDice::EdgeFactors ef_split;
+	TriangleDice::EdgeFactors ef_split = triangle_edge_factors(patch);
 
 	sub_split.patch = patch;
 	sub_split.Pu = make_float2(1.0f, 0.0f);
 	sub_split.Pv = make_float2(0.0f, 1.0f);
 	sub_split.Pw = make_float2(0.0f, 0.0f);
 
-	ef_split.tu = T(patch, sub_split.Pv, sub_split.Pw);
-	ef_split.tv = T(patch, sub_split.Pw, sub_split.Pu);
-	ef_split.tw = T(patch, sub_split.Pu, sub_split.Pv);
-
 	split(sub_split, ef_split);
 
-	TriangleDice dice(params);
+	TriangleDice dice(params, buffer);
 
 	for(size_t i = 0; i < subpatches_triangle.size(); i++) {
 		TriangleDice::SubPatch& sub = subpatches_triangle[i];
@@ -278,10 +297,10 @@ void DiagSplit::split_triangle(Patch *patch)
 	edgefactors_triangle.clear();
 }
 
-void DiagSplit::split_quad(Patch *patch)
+void DiagSplit::split_quad(Patch *patch, DiceBuffer *buffer)
 {
 	QuadDice::SubPatch sub_split;
-	QuadDice::EdgeFactors ef_split;
+	QuadDice::EdgeFactors ef_split = quad_edge_factors(patch);
 
 	sub_split.patch = patch;
 	sub_split.P00 = make_float2(0.0f, 0.0f);
@@ -289,14 +308,9 @@ void DiagSplit::split_quad(Patch *patch)
 	sub_split.P01 = make_float2(0.0f, 1.0f);
 	sub_split.P11 = make_float2(1.0f, 1.0f);
 
-	ef_split.tu0 = T(patch, sub_split.P00, sub_split.P10);
-	ef_split.tu1 = T(patch, sub_split.P01, sub_split.P11);
-	ef_split.tv0 = T(patch, sub_split.P00, sub_split.P01);
-	ef_split.tv1 = T(patch, sub_split.P10, sub_split.P11);
-
 	split(sub_split, ef_split);
 
-	QuadDice dice(params);
+	QuadDice dice(params, buffer);
 
 	for(size_t i = 0; i < subpatches_quad.size(); i++) {
 		QuadDice::SubPatch& sub = subpatches_quad[i];
@@ -314,5 +328,19 @@ void DiagSplit::split_quad(Patch *patch)
 	edgefactors_quad.clear();
 }
 
+void DiagSplit::split_triangle(Patch *patch)
+{
+	DiceBuffer buffer;
+	split_triangle(patch, &buffer);
+	buffer.add_to_mesh(params);
+}
+
+void DiagSplit::split_quad(Patch *patch)
+{
+	DiceBuffer buffer;
+	split_quad(patch, &buffer);
+	buffer.add_to_mesh(params);
+}
+
 CCL_NAMESPACE_END
 
@@ -56,6 +56,14 @@ public:
 	void dispatch(TriangleDice::SubPatch& sub, TriangleDice::EdgeFactors& ef);
 	void split(TriangleDice::SubPatch& sub, TriangleDice::EdgeFactors& ef, int depth=0);
 
+	TriangleDice::EdgeFactors triangle_edge_factors(Patch *patch);
+	QuadDice::EdgeFactors quad_edge_factors(Patch *patch);
+
+	/* split and dice into a buffer */
+	void split_triangle(Patch *patch, DiceBuffer *buffer);
+	void split_quad(Patch *patch, DiceBuffer *buffer);
+
+	/* split and dice into the mesh */
 	void split_triangle(Patch *patch);
 	void split_quad(Patch *patch);
 };
@@ -0,0 +1,190 @@
+/*
+ * Copyright 2011-2016 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "testing/testing.h"
+
+#include <string.h>
+
+#include "util_compress.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Compress and decompress a buffer, returns the compressed size. */
+static size_t round_trip(const void *data, size_t size)
+{
+	vector<uint8_t> compressed;
+	util_compress_buffer(data, size, compressed);
+
+	vector<uint8_t> result(size + 1, 0xaa);
+	EXPECT_TRUE(util_decompress_buffer(&compressed[0], compressed.size(), &result[0], size));
+	EXPECT_EQ(0, memcmp(data, &result[0], size));
+	/* nothing written past the end */
+	EXPECT_EQ(0xaa, result[size]);
+
+	return compressed.size();
+}
+
+/* Smooth gradient, like a render buffer. */
+static void gradient_floats(vector<float>& data, size_t num)
+{
+	data.resize(num);
+	for(size_t i = 0; i < num; i++)
+		data[i] = 0.5f + 0.25f*(float)(i % 97)/97.0f + 0.001f*(float)(i/97);
+}
+
+TEST(util_compress, empty)
+{
+	vector<uint8_t> compressed;
+	util_compress_buffer(NULL, 0, compressed);
+
+	EXPECT_FALSE(compressed.empty());
+	EXPECT_TRUE(util_decompress_buffer(&compressed[0], compressed.size(), NULL, 0));
+
+	/* empty input is not a valid compressed buffer */
+	uint8_t result[4];
+	EXPECT_FALSE(util_decompress_buffer(NULL, 0, result, sizeof(result)));
+}
+
+TEST(util_compress, incompressible)
+{
+	vector<uint8_t> data(1 << 20);
+	uint32_t state = 12345;
+
+	for(size_t i = 0; i < data.size(); i++) {
+		state = state*1664525u + 1013904223u;
+		data[i] = (uint8_t)(state >> 24);
+	}
+
+	/* stored as is, with only the method byte added */
+	EXPECT_EQ(data.size() + 1, round_trip(&data[0], data.size()));
+}
+
+TEST(util_compress, repetitive)
+{
+	vector<float> data(1 << 18, 1.0f);
+	size_t size = data.size()*sizeof(float);
+
+	EXPECT_LT(round_trip(&data[0], size), size/100);
+
+	/* short repeating pattern, with matches overlapping their output */
+	for(size_t i = 0; i < data.size(); i++)
+		data[i] = (float)(i % 3);
+
+	EXPECT_LT(round_trip(&data[0], size), size/100);
+}
+
+TEST(util_compress, odd_length_floats)
+{
+	vector<float> data;
+	gradient_floats(data, 12345);
+	size_t size = data.size()*sizeof(float);
+
+	EXPECT_LT(round_trip(&data[0], size), size);
+
+	/* sizes that are not a multiple of the float size */
+	for(size_t tail = 1; tail < 4; tail++)
+		round_trip(&data[0], size - tail);
+
+	/* single values */
+	round_trip(&data[0], sizeof(float));
+	round_trip(&data[0], 1);
+}
+
+TEST(util_compress, truncated)
+{
+	vector<float> data;
+	gradient_floats(data, 4096);
+	size_t size = data.size()*sizeof(float);
+
+	vector<uint8_t> compressed;
+	util_compress_buffer(&data[0], size, compressed);
+
+	vector<float> result(data.size());
+
+	for(size_t i = 0; i < compressed.size(); i++)
+		EXPECT_FALSE(util_decompress_buffer(&compressed[0], i, &result[0], size));
+
+	/* buffers stored as is */
+	vector<uint8_t> stored(size + 1);
+	stored[0] = 0;
+	memcpy(&stored[1], &data[0], size);
+
+	EXPECT_TRUE(util_decompress_buffer(&stored[0], stored.size(), &result[0], size));
+	EXPECT_FALSE(util_decompress_buffer(&stored[0], stored.size() - 1, &result[0], size));
+}
+
+TEST(util_compress, wrong_size)
+{
+	vector<float> data;
+	gradient_floats(data, 4096);
+	size_t size = data.size()*sizeof(float);
+
+	vector<uint8_t> compressed;
+	util_compress_buffer(&data[0], size, compressed);
+
+	vector<float> result(data.size() + 1);
+
+	EXPECT_FALSE(util_decompress_buffer(&compressed[0], compressed.size(), &result[0], size - 4));
+	EXPECT_FALSE(util_decompress_buffer(&compressed[0], compressed.size(), &result[0], size + 4));
+}
+
+TEST(util_compress, corrupt)
+{
+	uint8_t result[64];
+
+	/* unknown method */
+	const uint8_t method[] = {7, 0, 0, 0, 0};
+	EXPECT_FALSE(util_decompress_buffer(method, sizeof(method), result, 4));
+
+	/* match before the start of the output */
+	const uint8_t offset[] = {1, 0x10, 'a', 2, 0, 0x00};
+	EXPECT_FALSE(util_decompress_buffer(offset, sizeof(offset), result, 5));
+
+	/* zero offset */
+	const uint8_t zero_offset[] = {1, 0x10, 'a', 0, 0, 0x00};
+	EXPECT_FALSE(util_decompress_buffer(zero_offset, sizeof(zero_offset), result, 5));
+
+	/* literals past the end of the input */
+	const uint8_t literals[] = {1, 0x40, 'a', 'b'};
+	EXPECT_FALSE(util_decompress_buffer(literals, sizeof(literals), result, 4));
+
+	/* the same sequences are valid when well formed */
+	const uint8_t valid[] = {1, 0x10, 'a', 1, 0, 0x00};
+	EXPECT_TRUE(util_decompress_buffer(valid, sizeof(valid), result, 5));
+	EXPECT_EQ(0, memcmp(result, "aaaaa", 5));
+}
+
+TEST(util_compress, corrupt_bytes)
+{
+	vector<float> data;
+	gradient_floats(data, 1024);
+	size_t size = data.size()*sizeof(float);
+
+	vector<uint8_t> compressed;
+	util_compress_buffer(&data[0], size, compressed);
+
+	/* any damaged byte must either fail or decode within the output, which
+	 * is checked by running under a memory checker */
+	vector<float> result(data.size());
+
+	for(size_t i = 0; i < compressed.size(); i++) {
+		vector<uint8_t> damaged = compressed;
+		damaged[i] ^= 0xff;
+		util_decompress_buffer(&damaged[0], damaged.size(), &result[0], size);
+	}
+}
+
+CCL_NAMESPACE_END
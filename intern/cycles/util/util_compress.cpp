@@ -0,0 +1,292 @@
+/*
+ * Copyright 2011-2015 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include "util_compress.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Format
+ *
+ * First byte is the method, followed by the data:
+ *
+ * - COMPRESS_NONE: data stored as is.
+ * - COMPRESS_SHUFFLE_LZ: shuffled data compressed as a list of sequences. Each
+ *   sequence starts with a token, the high 4 bits are the number of literals
+ *   and the low 4 bits the match length minus COMPRESS_MIN_MATCH. A value of
+ *   15 means more bytes follow to add to the length, until a byte below 255.
+ *   Then the literals follow and a 2 byte little endian match offset. The
+ *   last sequence has literals only. */
+
+enum {
+	COMPRESS_NONE = 0,
+	COMPRESS_SHUFFLE_LZ = 1,
+};
+
+#define COMPRESS_MIN_MATCH 4
+#define COMPRESS_MAX_OFFSET 65535
+#define COMPRESS_HASH_BITS 14
+
+/* Shuffle */
+
+static void compress_shuffle(const uint8_t *data, size_t size, uint8_t *result)
+{
+	size_t num = size/4;
+
+	for(size_t i = 0; i < num; i++) {
+		result[i] = data[i*4 + 0];
+		result[num + i] = data[i*4 + 1];
+		result[num*2 + i] = data[i*4 + 2];
+		result[num*3 + i] = data[i*4 + 3];
+	}
+
+	/* remaining bytes */
+	for(size_t i = num*4; i < size; i++)
+		result[i] = data[i];
+}
+
+static void compress_unshuffle(const uint8_t *data, size_t size, uint8_t *result)
+{
+	size_t num = size/4;
+
+	for(size_t i = 0; i < num; i++) {
+		result[i*4 + 0] = data[i];
+		result[i*4 + 1] = data[num + i];
+		result[i*4 + 2] = data[num*2 + i];
+		result[i*4 + 3] = data[num*3 + i];
+	}
+
+	for(size_t i = num*4; i < size; i++)
+		result[i] = data[i];
+}
+
+/* LZ77 */
+
+static inline uint32_t compress_read32(const uint8_t *p)
+{
+	uint32_t value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+static inline uint32_t compress_hash(uint32_t value)
+{
+	return (value*2654435761u) >> (32 - COMPRESS_HASH_BITS);
+}
+
+static void compress_write_length(vector<uint8_t>& result, size_t length)
+{
+	while(length >= 255) {
+		result.push_back(255);
+		length -= 255;
+	}
+
+	result.push_back((uint8_t)length);
+}
+
+static void compress_write_sequence(vector<uint8_t>& result,
+                                    const uint8_t *literals, size_t num_literals,
+                                    size_t offset, size_t match_length)
+{
+	size_t match_code = (match_length)? match_length - COMPRESS_MIN_MATCH: 0;
+	uint8_t token = (uint8_t)((((num_literals < 15)? num_literals: 15) << 4) |
+	                          ((match_code < 15)? match_code: 15));
+
+	result.push_back(token);
+
+	if(num_literals >= 15)
+		compress_write_length(result, num_literals - 15);
+
+	result.insert(result.end(), literals, literals + num_literals);
+
+	if(match_length) {
+		result.push_back((uint8_t)(offset & 0xff));
+		result.push_back((uint8_t)(offset >> 8));
+
+		if(match_code >= 15)
+			compress_write_length(result, match_code - 15);
+	}
+}
+
+static void compress_lz(const uint8_t *data, size_t size, vector<uint8_t>& result)
+{
+	vector<size_t> table(1 << COMPRESS_HASH_BITS, (size_t)-1);
+	size_t literal_start = 0;
+	size_t i = 0;
+
+	while(i + COMPRESS_MIN_MATCH <= size) {
+		uint32_t value = compress_read32(data + i);
+		uint32_t hash = compress_hash(value);
+		size_t candidate = table[hash];
+
+		table[hash] = i;
+
+		if(candidate != (size_t)-1 &&
+		   i - candidate <= COMPRESS_MAX_OFFSET &&
+		   compress_read32(data + candidate) == value)
+		{
+			/* extend match */
+			size_t length = COMPRESS_MIN_MATCH;
+
+			while(i + length < size && data[candidate + length] == data[i + length])
+				length++;
+
+			compress_write_sequence(result, data + literal_start, i - literal_start,
+			                        i - candidate, length);
+
+			i += length;
+			literal_start = i;
+		}
+		else
+			i++;
+	}
+
+	/* last literals */
+	compress_write_sequence(result, data + literal_start, size - literal_start, 0, 0);
+}
+
+static bool compress_read_length(const uint8_t *&p, const uint8_t *end, size_t& length)
+{
+	for(;;) {
+		if(p == end)
+			return false;
+
+		uint8_t byte = *(p++);
+		length += byte;
+
+		if(byte != 255)
+			return true;
+	}
+}
+
+static bool decompress_lz(const uint8_t *data, size_t size, uint8_t *result, size_t result_size)
+{
+	const uint8_t *p = data;
+	const uint8_t *end = data + size;
+	size_t out = 0;
+
+	for(;;) {
+		/* the stream ends with a literals only sequence, so a truncated
+		 * stream is detected even when it was cut after a match */
+		if(p == end)
+			return false;
+
+		uint8_t token = *(p++);
+
+		/* literals */
+		size_t num_literals = token >> 4;
+
+		if(num_literals == 15 && !compress_read_length(p, end, num_literals))
+			return false;
+		if(num_literals > (size_t)(end - p) || num_literals > result_size - out)
+			return false;
+
+		memcpy(result + out, p, num_literals);
+		p += num_literals;
+		out += num_literals;
+
+		/* last sequence */
+		if(p == end)
+			break;
+
+		/* match */
+		if(end - p < 2)
+			return false;
+
+		size_t offset = p[0] | (p[1] << 8);
+		size_t length = token & 15;
+		p += 2;
+
+		if(length == 15 && !compress_read_length(p, end, length))
+			return false;
+
+		length += COMPRESS_MIN_MATCH;
+
+		if(offset == 0 || offset > out || length > result_size - out)
+			return false;
+
+		/* matches may overlap the output */
+		const uint8_t *match = result + out - offset;
+
+		for(size_t j = 0; j < length; j++)
+			result[out + j] = match[j];
+
+		out += length;
+	}
+
+	return out == result_size;
+}
+
+/* Buffers */
+
+void util_compress_buffer(const void *data, size_t size, vector<uint8_t>& result)
+{
+	result.clear();
+
+	if(size == 0) {
+		result.push_back(COMPRESS_NONE);
+		return;
+	}
+
+	vector<uint8_t> shuffled(size);
+
+	result.reserve(size/2 + 16);
+	result.push_back(COMPRESS_SHUFFLE_LZ);
+
+	compress_shuffle((const uint8_t*)data, size, &shuffled[0]);
+	compress_lz(&shuffled[0], size, result);
+
+	/* store as is if compression didn't help */
+	if(result.size() > size + 1) {
+		result.resize(size + 1);
+		result[0] = COMPRESS_NONE;
+		memcpy(&result[1], data, size);
+	}
+}
+
+bool util_decompress_buffer(const uint8_t *data, size_t size, void *result, size_t result_size)
+{
+	if(size == 0)
+		return false;
+
+	if(data[0] == COMPRESS_NONE) {
+		if(size - 1 != result_size)
+			return false;
+
+		if(result_size)
+			memcpy(result, data + 1, result_size);
+
+		return true;
+	}
+	else if(data[0] == COMPRESS_SHUFFLE_LZ) {
+		if(result_size == 0)
+			return false;
+
+		vector<uint8_t> shuffled(result_size);
+
+		if(!decompress_lz(data + 1, size - 1, &shuffled[0], result_size))
+			return false;
+
+		compress_unshuffle(&shuffled[0], result_size, (uint8_t*)result);
+		return true;
+	}
+
+	return false;
+}
+
+CCL_NAMESPACE_END
+
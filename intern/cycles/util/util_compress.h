@@ -0,0 +1,40 @@
+/*
+ * Copyright 2011-2015 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __UTIL_COMPRESS_H__
+#define __UTIL_COMPRESS_H__
+
+#include "util_types.h"
+#include "util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Buffer Compression
+ *
+ * Fast lossless compression for buffers of 32 bit values such as render
+ * results. The bytes of each value are first shuffled into separate planes,
+ * which puts sign, exponent and high mantissa bits of neighboring floats
+ * next to each other, followed by LZ77 compression with a small hash table.
+ * This is meant for sending data over the network, it trades compression
+ * ratio for speed. Buffers that don't compress are stored as they are. */
+
+void util_compress_buffer(const void *data, size_t size, vector<uint8_t>& result);
+bool util_decompress_buffer(const uint8_t *data, size_t size, void *result, size_t result_size);
+
+CCL_NAMESPACE_END
+
+#endif /* __UTIL_COMPRESS_H__ */
+
@@ -85,6 +85,43 @@ ccl_device_inline void float4_store_half(half *h, float4 f, float scale)
 #endif
 }
 
+ccl_device_inline float half_to_float(half h)
+{
+	/* full conversion, unlike the store above images can contain any value */
+	union { uint i; float f; } out;
+	uint sign = ((uint)(h & 0x8000)) << 16;
+	uint exponent = (h >> 10) & 0x1F;
+	uint mantissa = h & 0x3FF;
+
+	if(exponent == 0) {
+		/* zero and denormals */
+		out.f = (float)mantissa * (1.0f/16777216.0f);
+		out.i |= sign;
+	}
+	else if(exponent == 0x1F) {
+		/* infinity and nan */
+		out.i = sign | 0x7F800000 | (mantissa << 13);
+	}
+	else {
+		out.i = sign | ((exponent + 112) << 23) | (mantissa << 13);
+	}
+
+	return out.f;
+}
+
+ccl_device_inline float4 half4_to_float4(half4 h)
+{
+#ifdef __KERNEL_AVX2__
+	ssef r = _mm_cvtph_ps(_mm_loadl_epi64((__m128i*)&h));
+	return (float4&)r;
+#else
+	return make_float4(half_to_float(h.x),
+	                   half_to_float(h.y),
+	                   half_to_float(h.z),
+	                   half_to_float(h.w));
+#endif
+}
+
 #endif
 
 #endif
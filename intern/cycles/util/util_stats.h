@@ -18,12 +18,112 @@
 #define __UTIL_STATS_H__
 
 #include "util_atomic.h"
+#include "util_thread.h"
+#include "util_types.h"
+#include "util_vector.h"
 
 CCL_NAMESPACE_BEGIN
 
+/* Ray and Shading Statistics
+ *
+ * Number of rays traced and time spent in stages of the path integrator and
+ * in each shader, collected per thread by the CPU kernel in builds with
+ * WITH_CYCLES_DEBUG, and merged when the threads finish. Stages are timed
+ * inclusively, direct lighting includes its shadow rays and shader
+ * evaluation, and everything is part of the path stage. Times are in ticks
+ * of time_ticks(). */
+
+enum RayStatsRay {
+	RAY_STATS_CAMERA = 0,
+	RAY_STATS_BOUNCE,
+	RAY_STATS_SHADOW,
+	RAY_STATS_SUBSURFACE,
+	RAY_STATS_VOLUME,
+	RAY_STATS_NUM_RAYS
+};
+
+enum RayStatsStage {
+	RAY_STATS_STAGE_PATH = 0,
+	RAY_STATS_STAGE_INTERSECT,
+	RAY_STATS_STAGE_SURFACE,
+	RAY_STATS_STAGE_LIGHT,
+	RAY_STATS_STAGE_SHADOW,
+	RAY_STATS_STAGE_SUBSURFACE,
+	RAY_STATS_STAGE_VOLUME,
+	RAY_STATS_NUM_STAGES
+};
+
+class RayStats {
+public:
+	RayStats() { reset(); }
+
+	void reset() {
+		for(int i = 0; i < RAY_STATS_NUM_RAYS; i++)
+			rays[i] = 0;
+		for(int i = 0; i < RAY_STATS_NUM_STAGES; i++)
+			stage_ticks[i] = 0;
+
+		bvh_traversal_steps = 0;
+		shader_ticks.clear();
+		shader_evals.clear();
+	}
+
+	void add(const RayStats& other) {
+		for(int i = 0; i < RAY_STATS_NUM_RAYS; i++)
+			rays[i] += other.rays[i];
+		for(int i = 0; i < RAY_STATS_NUM_STAGES; i++)
+			stage_ticks[i] += other.stage_ticks[i];
+
+		bvh_traversal_steps += other.bvh_traversal_steps;
+
+		if(shader_ticks.size() < other.shader_ticks.size()) {
+			shader_ticks.resize(other.shader_ticks.size(), 0);
+			shader_evals.resize(other.shader_ticks.size(), 0);
+		}
+
+		for(size_t i = 0; i < other.shader_ticks.size(); i++) {
+			shader_ticks[i] += other.shader_ticks[i];
+			shader_evals[i] += other.shader_evals[i];
+		}
+	}
+
+	void add_shader(int shader, uint64_t ticks, uint64_t evals) {
+		if(shader >= (int)shader_ticks.size()) {
+			shader_ticks.resize(shader + 1, 0);
+			shader_evals.resize(shader + 1, 0);
+		}
+
+		shader_ticks[shader] += ticks;
+		shader_evals[shader] += evals;
+	}
+
+	static const char *ray_name(int type) {
+		static const char *names[RAY_STATS_NUM_RAYS] = {
+			"camera", "bounce", "shadow", "subsurface", "volume"};
+		return names[type];
+	}
+
+	static const char *stage_name(int stage) {
+		static const char *names[RAY_STATS_NUM_STAGES] = {
+			"path", "intersect", "surface", "light", "shadow", "subsurface", "volume"};
+		return names[stage];
+	}
+
+	uint64_t rays[RAY_STATS_NUM_RAYS];
+	uint64_t stage_ticks[RAY_STATS_NUM_STAGES];
+
+	/* BVH nodes and primitives visited by camera and bounce rays */
+	uint64_t bvh_traversal_steps;
+
+	/* surface shader evaluations, indexed by shader in the scene */
+	vector<uint64_t> shader_ticks;
+	vector<uint64_t> shader_evals;
+};
+
 class Stats {
 public:
-	Stats() : mem_used(0), mem_peak(0) {}
+	Stats() : mem_used(0), mem_peak(0), texture_cache_hits(0), texture_cache_misses(0),
+	          denoise_time(0.0) {}
 
 	void mem_alloc(size_t size) {
 		atomic_add_z(&mem_used, size);
@@ -35,8 +135,30 @@ public:
 		atomic_sub_z(&mem_used, size);
 	}
 
+	/* counters only ever grow, but may be reported from multiple threads */
+	void texture_cache_update(size_t hits, size_t misses) {
+		atomic_update_max_z(&texture_cache_hits, hits);
+		atomic_update_max_z(&texture_cache_misses, misses);
+	}
+
+	/* merge statistics of a render thread */
+	void ray_stats_add(const RayStats& stats) {
+		thread_scoped_lock lock(ray_stats_mutex);
+		ray_stats.add(stats);
+	}
+
 	size_t mem_used;
 	size_t mem_peak;
+
+	/* tile lookups in the texture cache, misses had to be read from file */
+	size_t texture_cache_hits;
+	size_t texture_cache_misses;
+
+	RayStats ray_stats;
+	thread_mutex ray_stats_mutex;
+
+	/* seconds spent denoising, summed over render threads */
+	double denoise_time;
 };
 
 CCL_NAMESPACE_END
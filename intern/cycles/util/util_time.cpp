@@ -79,3 +79,30 @@ CCL_NAMESPACE_END
 
 #endif
 
+CCL_NAMESPACE_BEGIN
+
+double time_ticks_per_second()
+{
+#ifdef __UTIL_TIME_TSC__
+	static double ticks_per_second = 0.0;
+
+	/* measure against the system clock once, over a short interval */
+	if(ticks_per_second == 0.0) {
+		double start_time = time_dt(), end_time;
+		uint64_t start_ticks = time_ticks();
+
+		do {
+			end_time = time_dt();
+		} while(end_time - start_time < 0.01);
+
+		ticks_per_second = (double)(time_ticks() - start_ticks)/(end_time - start_time);
+	}
+
+	return ticks_per_second;
+#else
+	return 1e9;
+#endif
+}
+
+CCL_NAMESPACE_END
+
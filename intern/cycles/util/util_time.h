@@ -17,6 +17,17 @@
 #ifndef __UTIL_TIME_H__
 #define __UTIL_TIME_H__
 
+#include "util_types.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#  define __UTIL_TIME_TSC__
+#  ifdef _MSC_VER
+#    include <intrin.h>
+#  else
+#    include <x86intrin.h>
+#  endif
+#endif
+
 CCL_NAMESPACE_BEGIN
 
 /* Give current time in seconds in double precision, with good accuracy. */
@@ -27,6 +38,52 @@ double time_dt();
 
 void time_sleep(double t);
 
+/* Cheap timestamp for timing short sections of code, in ticks of a length
+ * given by time_ticks_per_second(). Uses the processor timestamp counter
+ * where available. */
+
+static inline uint64_t time_ticks()
+{
+#ifdef __UTIL_TIME_TSC__
+	return __rdtsc();
+#else
+	return (uint64_t)(time_dt()*1e9);
+#endif
+}
+
+double time_ticks_per_second();
+
+/* Wall clock time of a scope, added to value when the timer goes out of
+ * scope if given. */
+
+class scoped_timer {
+public:
+	explicit scoped_timer(double *value = NULL) : value_(value)
+	{
+		time_start_ = time_dt();
+	}
+
+	~scoped_timer()
+	{
+		if(value_ != NULL)
+			*value_ += get_time();
+	}
+
+	double get_start() const
+	{
+		return time_start_;
+	}
+
+	double get_time() const
+	{
+		return time_dt() - time_start_;
+	}
+
+protected:
+	double *value_;
+	double time_start_;
+};
+
 CCL_NAMESPACE_END
 
 #endif
@@ -37,6 +37,14 @@
 
 /* Types */
 
+/* Number of slots in the local deque of every worker thread, must be a power
+ * of two. Tasks pushed while the deque is full go to the scheduler queue. */
+#define TASK_DEQUE_SIZE 1024
+#define TASK_DEQUE_MASK (TASK_DEQUE_SIZE - 1)
+
+/* Number of freed tasks every worker thread keeps around for re-use. */
+#define TASK_MEMPOOL_SIZE 256
+
 typedef struct Task {
 	struct Task *next, *prev;
 
@@ -56,40 +64,208 @@ struct TaskPool {
 	ThreadMutex num_mutex;
 	ThreadCondition num_cond;
 
+	/* Threads sleeping in BLI_task_pool_work_and_wait() and total number of
+	 * pushed tasks, so pushes only have to wake up waiters if there are any. */
+	volatile size_t num_waiting;
+	volatile size_t num_pushed;
+
 	void *userdata;
 	ThreadMutex user_mutex;
 
 	volatile bool do_cancel;
 };
 
+/* Work-stealing deque (Chase-Lev) with a fixed capacity.
+ *
+ * Only the owning thread pushes and pops at the bottom, any other thread can
+ * steal from the top. The pool of every queued task is mirrored in a separate
+ * array, so thieves can check it before they own the task. */
+typedef struct TaskDeque {
+	uint32_t top;
+	/* Keep top and bottom on separate cache lines. */
+	char pad[64 - sizeof(uint32_t)];
+	uint32_t bottom;
+
+	Task *tasks[TASK_DEQUE_SIZE];
+	TaskPool *pools[TASK_DEQUE_SIZE];
+} TaskDeque;
+
+typedef struct TaskMemPool {
+	int num_tasks;
+	Task *tasks[TASK_MEMPOOL_SIZE];
+} TaskMemPool;
+
+typedef struct TaskThread {
+	TaskScheduler *scheduler;
+	int id;
+
+	TaskDeque deque;
+	TaskMemPool mempool;
+} TaskThread;
+
 struct TaskScheduler {
 	pthread_t *threads;
 	struct TaskThread *task_threads;
 	int num_threads;
 
+	/* Per worker thread TaskThread, NULL for all other threads. */
+	pthread_key_t thread_key;
+
+	/* Tasks pushed from threads which are not workers of this scheduler,
+	 * tasks from pools with limited number of threads and tasks which did not
+	 * fit into the deque of a worker. */
 	ListBase queue;
 	ThreadMutex queue_mutex;
 	ThreadCondition queue_cond;
 
+	/* Number of tasks in the worker deques and number of workers sleeping on
+	 * queue_cond, used to decide whether sleeping workers are to be woken up. */
+	volatile size_t num_queued;
+	volatile size_t num_sleeping;
+
 	volatile bool do_exit;
 };
 
-typedef struct TaskThread {
-	TaskScheduler *scheduler;
-	int id;
-} TaskThread;
+/* Task Deque */
+
+BLI_INLINE uint32_t task_deque_load(const uint32_t *value)
+{
+	return *(volatile const uint32_t *)value;
+}
+
+static bool task_deque_push(TaskDeque *deque, Task *task)
+{
+	uint32_t bottom = deque->bottom;
+	uint32_t top = task_deque_load(&deque->top);
+
+	if ((int32_t)(bottom - top) >= TASK_DEQUE_SIZE) {
+		return false;
+	}
+
+	deque->tasks[bottom & TASK_DEQUE_MASK] = task;
+	deque->pools[bottom & TASK_DEQUE_MASK] = task->pool;
+
+	/* Atomic increment makes the task visible to thieves only after it was
+	 * stored in the deque. */
+	atomic_add_uint32(&deque->bottom, 1);
+
+	return true;
+}
+
+static Task *task_deque_pop(TaskDeque *deque)
+{
+	uint32_t bottom, top;
+	Task *task;
+
+	/* Reserve the bottom slot before looking at top, thieves do the opposite. */
+	atomic_sub_uint32(&deque->bottom, 1);
+	bottom = deque->bottom;
+	top = task_deque_load(&deque->top);
+
+	if ((int32_t)(bottom - top) < 0) {
+		/* Deque was empty. */
+		deque->bottom = top;
+		return NULL;
+	}
+
+	task = deque->tasks[bottom & TASK_DEQUE_MASK];
+
+	if (bottom != top) {
+		return task;
+	}
+
+	/* Last task in the deque, race against thieves for it. */
+	if (atomic_cas_uint32(&deque->top, top, top + 1) != top) {
+		task = NULL;
+	}
+	deque->bottom = top + 1;
+
+	return task;
+}
+
+/* Steal a task from the top of the deque. When pool is not NULL only a task
+ * from this pool is taken. Might fail spuriously when racing other threads. */
+static Task *task_deque_steal(TaskDeque *deque, TaskPool *pool)
+{
+	uint32_t top, bottom;
+	Task *task;
+
+	/* Compare-and-swap which never changes the value, an atomic read of top
+	 * ordered before the read of bottom. */
+	top = atomic_cas_uint32(&deque->top, 0, 0);
+	bottom = task_deque_load(&deque->bottom);
+
+	if ((int32_t)(bottom - top) <= 0) {
+		return NULL;
+	}
+
+	/* Task might already be taken by the time we read it, this is detected by
+	 * the compare-and-swap below. */
+	if (pool != NULL && deque->pools[top & TASK_DEQUE_MASK] != pool) {
+		return NULL;
+	}
+	task = deque->tasks[top & TASK_DEQUE_MASK];
+
+	if (atomic_cas_uint32(&deque->top, top, top + 1) != top) {
+		return NULL;
+	}
+
+	return task;
+}
+
+/* Check whether the deque contains a task from the given pool, only to be
+ * called from the owning thread. */
+static bool task_deque_has_pool(TaskDeque *deque, TaskPool *pool)
+{
+	uint32_t bottom = deque->bottom;
+	uint32_t i;
+
+	for (i = task_deque_load(&deque->top); (int32_t)(bottom - i) > 0; i++) {
+		if (deque->pools[i & TASK_DEQUE_MASK] == pool) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* Task Memory Pool */
+
+static Task *task_alloc(TaskThread *thread)
+{
+	if (thread != NULL && thread->mempool.num_tasks > 0) {
+		return thread->mempool.tasks[--thread->mempool.num_tasks];
+	}
+
+	return MEM_mallocN(sizeof(Task), "Task");
+}
+
+static void task_free(TaskThread *thread, Task *task)
+{
+	if (task->free_taskdata)
+		MEM_freeN(task->taskdata);
+
+	if (thread != NULL && thread->mempool.num_tasks < TASK_MEMPOOL_SIZE) {
+		thread->mempool.tasks[thread->mempool.num_tasks++] = task;
+	}
+	else {
+		MEM_freeN(task);
+	}
+}
 
 /* Task Scheduler */
 
 static void task_pool_num_decrease(TaskPool *pool, size_t done)
 {
-	BLI_mutex_lock(&pool->num_mutex);
-
 	BLI_assert(pool->num >= done);
 
-	pool->num -= done;
-	atomic_sub_z(&pool->currently_running_tasks, done);
-	pool->done += done;
+	/* The last decrease and its notification happen inside the mutex, the
+	 * waiter only returns after seeing zero tasks inside the same mutex. So the
+	 * pool can't be freed while this thread still accesses it. */
+	BLI_mutex_lock(&pool->num_mutex);
+
+	atomic_add_z((size_t *)&pool->done, done);
+	atomic_sub_z((size_t *)&pool->num, done);
 
 	if (pool->num == 0)
 		BLI_condition_notify_all(&pool->num_cond);
@@ -99,51 +275,194 @@ static void task_pool_num_decrease(TaskPool *pool, size_t done)
 
 static void task_pool_num_increase(TaskPool *pool)
 {
-	BLI_mutex_lock(&pool->num_mutex);
+	atomic_add_z((size_t *)&pool->num, 1);
+}
 
-	pool->num++;
-	BLI_condition_notify_all(&pool->num_cond);
+static void task_pool_notify_pushed(TaskPool *pool)
+{
+	atomic_add_z((size_t *)&pool->num_pushed, 1);
 
-	BLI_mutex_unlock(&pool->num_mutex);
+	/* Wake up threads waiting for this pool, they can help running the task. */
+	if (pool->num_waiting != 0) {
+		BLI_mutex_lock(&pool->num_mutex);
+		BLI_condition_notify_all(&pool->num_cond);
+		BLI_mutex_unlock(&pool->num_mutex);
+	}
+}
+
+BLI_INLINE TaskThread *task_scheduler_thread_get(TaskScheduler *scheduler)
+{
+	return pthread_getspecific(scheduler->thread_key);
+}
+
+BLI_INLINE bool task_pool_can_run(TaskPool *pool)
+{
+	return (pool->num_threads == 0 ||
+	        pool->currently_running_tasks < pool->num_threads);
+}
+
+/* Pop a task from the scheduler queue, optionally only from the given pool.
+ * Must be called with queue_mutex locked. */
+static Task *task_scheduler_queue_pop_locked(TaskScheduler *scheduler, TaskPool *pool)
+{
+	Task *task;
+
+	for (task = scheduler->queue.first; task; task = task->next) {
+		if ((pool == NULL || task->pool == pool) && task_pool_can_run(task->pool)) {
+			BLI_remlink(&scheduler->queue, task);
+			if (task->pool->num_threads != 0) {
+				atomic_add_z(&task->pool->currently_running_tasks, 1);
+			}
+			return task;
+		}
+	}
+
+	return NULL;
 }
 
-static bool task_scheduler_thread_wait_pop(TaskScheduler *scheduler, Task **task)
+static Task *task_scheduler_queue_pop(TaskScheduler *scheduler, TaskPool *pool)
 {
-	bool found_task = false;
+	Task *task;
+
+	/* Unlocked check to avoid taking the lock when there is nothing to do. */
+	if (scheduler->queue.first == NULL) {
+		return NULL;
+	}
+
 	BLI_mutex_lock(&scheduler->queue_mutex);
+	task = task_scheduler_queue_pop_locked(scheduler, pool);
+	BLI_mutex_unlock(&scheduler->queue_mutex);
 
-	while (!scheduler->queue.first && !scheduler->do_exit)
-		BLI_condition_wait(&scheduler->queue_cond, &scheduler->queue_mutex);
+	return task;
+}
 
-	do {
-		Task *current_task;
-		if (!scheduler->queue.first) {
-			BLI_mutex_unlock(&scheduler->queue_mutex);
-			BLI_assert(scheduler->do_exit);
-			return false;
+static Task *task_scheduler_steal(TaskScheduler *scheduler, TaskThread *thief, TaskPool *pool)
+{
+	int num_threads = scheduler->num_threads;
+	/* Start with the neighbour of the thief, so not all threads hammer the
+	 * same victim. */
+	int start = (thief != NULL) ? thief->id : 0;
+	int i;
+
+	for (i = 0; i < num_threads; i++) {
+		TaskThread *victim = &scheduler->task_threads[(start + i) % num_threads];
+		Task *task;
+
+		if (victim == thief) {
+			continue;
 		}
-		for (current_task = scheduler->queue.first;
-		     current_task != NULL;
-		     current_task = current_task->next)
-		{
-			TaskPool *pool = current_task->pool;
-			if (pool->num_threads == 0 ||
-			    pool->currently_running_tasks < pool->num_threads)
-			{
-				*task = current_task;
-				found_task = true;
-				atomic_add_z(&pool->currently_running_tasks, 1);
-				BLI_remlink(&scheduler->queue, *task);
-				break;
+
+		task = task_deque_steal(&victim->deque, pool);
+		if (task != NULL) {
+			atomic_sub_z((size_t *)&scheduler->num_queued, 1);
+			return task;
+		}
+	}
+
+	return NULL;
+}
+
+/* Find a task to run for the given thread, which is NULL for threads which
+ * are not workers of the scheduler. When pool is not NULL, only tasks from this
+ * pool are considered, running tasks from other pools while waiting for a pool
+ * can lead to deadlocks. */
+static Task *task_scheduler_find(TaskScheduler *scheduler, TaskThread *thread, TaskPool *pool)
+{
+	Task *task;
+
+	/* Own deque first, most recently pushed tasks are most likely in cache. */
+	if (thread != NULL) {
+		task = task_deque_pop(&thread->deque);
+		if (task != NULL) {
+			if (pool == NULL || task->pool == pool) {
+				atomic_sub_z((size_t *)&scheduler->num_queued, 1);
+				return task;
 			}
+			/* Task from another pool, put it back where it was. */
+			task_deque_push(&thread->deque, task);
 		}
-		if (!found_task)
-			BLI_condition_wait(&scheduler->queue_cond, &scheduler->queue_mutex);
-	} while (!found_task);
+	}
+
+	task = task_scheduler_queue_pop(scheduler, pool);
+	if (task != NULL) {
+		return task;
+	}
+
+	return task_scheduler_steal(scheduler, thread, pool);
+}
+
+/* Move all tasks from the deque of the thread to the scheduler queue, so they
+ * can be found by pool regardless of their position in the deque. */
+static void task_scheduler_thread_spill(TaskScheduler *scheduler, TaskThread *thread)
+{
+	Task *task;
+
+	BLI_mutex_lock(&scheduler->queue_mutex);
+
+	while ((task = task_deque_pop(&thread->deque))) {
+		atomic_sub_z((size_t *)&scheduler->num_queued, 1);
+		BLI_addhead(&scheduler->queue, task);
+	}
 
+	BLI_condition_notify_all(&scheduler->queue_cond);
 	BLI_mutex_unlock(&scheduler->queue_mutex);
+}
 
-	return true;
+static void task_scheduler_run(TaskThread *thread, Task *task, int thread_id)
+{
+	TaskPool *pool = task->pool;
+
+	/* Tasks still in the deques when the pool gets canceled are skipped, the
+	 * same as the ones removed from the scheduler queue. */
+	if (!pool->do_cancel) {
+		task->run(pool, task->taskdata, thread_id);
+	}
+
+	if (pool->num_threads != 0) {
+		atomic_sub_z(&pool->currently_running_tasks, 1);
+	}
+
+	task_free(thread, task);
+
+	/* notify pool task was done */
+	task_pool_num_decrease(pool, 1);
+}
+
+static bool task_scheduler_thread_wait_pop(TaskThread *thread, Task **task)
+{
+	TaskScheduler *scheduler = thread->scheduler;
+
+	while (true) {
+		*task = task_scheduler_find(scheduler, thread, NULL);
+		if (*task != NULL) {
+			return true;
+		}
+
+		BLI_mutex_lock(&scheduler->queue_mutex);
+
+		/* Registering as sleeping before looking at the number of queued tasks
+		 * makes sure pushes happening from now on will wake us up. */
+		atomic_add_z((size_t *)&scheduler->num_sleeping, 1);
+
+		while (!scheduler->do_exit && scheduler->num_queued == 0) {
+			*task = task_scheduler_queue_pop_locked(scheduler, NULL);
+			if (*task != NULL) {
+				break;
+			}
+			BLI_condition_wait(&scheduler->queue_cond, &scheduler->queue_mutex);
+		}
+
+		atomic_sub_z((size_t *)&scheduler->num_sleeping, 1);
+
+		BLI_mutex_unlock(&scheduler->queue_mutex);
+
+		if (*task != NULL) {
+			return true;
+		}
+		if (scheduler->do_exit) {
+			return false;
+		}
+	}
 }
 
 static void *task_scheduler_thread_run(void *thread_p)
@@ -153,20 +472,11 @@ static void *task_scheduler_thread_run(void *thread_p)
 	int thread_id = thread->id;
 	Task *task;
 
-	/* keep popping off tasks */
-	while (task_scheduler_thread_wait_pop(scheduler, &task)) {
-		TaskPool *pool = task->pool;
-
-		/* run task */
-		task->run(pool, task->taskdata, thread_id);
-
-		/* delete task */
-		if (task->free_taskdata)
-			MEM_freeN(task->taskdata);
-		MEM_freeN(task);
+	pthread_setspecific(scheduler->thread_key, thread);
 
-		/* notify pool task was done */
-		task_pool_num_decrease(pool, 1);
+	/* keep popping off tasks */
+	while (task_scheduler_thread_wait_pop(thread, &task)) {
+		task_scheduler_run(thread, task, thread_id);
 	}
 
 	return NULL;
@@ -184,6 +494,8 @@ TaskScheduler *BLI_task_scheduler_create(int num_threads)
 	BLI_mutex_init(&scheduler->queue_mutex);
 	BLI_condition_init(&scheduler->queue_cond);
 
+	pthread_key_create(&scheduler->thread_key, NULL);
+
 	if (num_threads == 0) {
 		/* automatic number of threads will be main thread + num cores */
 		num_threads = BLI_system_thread_count();
@@ -207,7 +519,6 @@ TaskScheduler *BLI_task_scheduler_create(int num_threads)
 
 			if (pthread_create(&scheduler->threads[i], NULL, task_scheduler_thread_run, thread) != 0) {
 				fprintf(stderr, "TaskScheduler failed to launch thread %d/%d\n", i, num_threads);
-				MEM_freeN(thread);
 			}
 		}
 	}
@@ -239,6 +550,21 @@ void BLI_task_scheduler_free(TaskScheduler *scheduler)
 
 	/* Delete task thread data */
 	if (scheduler->task_threads) {
+		int i;
+
+		for (i = 0; i < scheduler->num_threads; i++) {
+			TaskThread *thread = &scheduler->task_threads[i];
+
+			/* delete leftover tasks */
+			while ((task = task_deque_pop(&thread->deque))) {
+				task_free(NULL, task);
+			}
+
+			while (thread->mempool.num_tasks > 0) {
+				MEM_freeN(thread->mempool.tasks[--thread->mempool.num_tasks]);
+			}
+		}
+
 		MEM_freeN(scheduler->task_threads);
 	}
 
@@ -249,6 +575,8 @@ void BLI_task_scheduler_free(TaskScheduler *scheduler)
 	}
 	BLI_freelistN(&scheduler->queue);
 
+	pthread_key_delete(scheduler->thread_key);
+
 	/* delete mutex/condition */
 	BLI_mutex_end(&scheduler->queue_mutex);
 	BLI_condition_end(&scheduler->queue_cond);
@@ -261,9 +589,32 @@ int BLI_task_scheduler_num_threads(TaskScheduler *scheduler)
 	return scheduler->num_threads + 1;
 }
 
-static void task_scheduler_push(TaskScheduler *scheduler, Task *task, TaskPriority priority)
+static void task_scheduler_push(TaskScheduler *scheduler, TaskThread *thread, Task *task, TaskPriority priority)
 {
-	task_pool_num_increase(task->pool);
+	TaskPool *pool = task->pool;
+
+	task_pool_num_increase(pool);
+
+	/* Tasks pushed from a worker thread, which is how running tasks spawn new
+	 * ones, go to the deque of the worker. It will run them without taking any
+	 * lock, unless other threads run out of work and steal them. */
+	if (thread != NULL && pool->num_threads == 0) {
+		atomic_add_z((size_t *)&scheduler->num_queued, 1);
+
+		if (task_deque_push(&thread->deque, task)) {
+			if (scheduler->num_sleeping != 0) {
+				BLI_mutex_lock(&scheduler->queue_mutex);
+				BLI_condition_notify_one(&scheduler->queue_cond);
+				BLI_mutex_unlock(&scheduler->queue_mutex);
+			}
+
+			task_pool_notify_pushed(pool);
+			return;
+		}
+
+		/* Deque is full, use the scheduler queue. */
+		atomic_sub_z((size_t *)&scheduler->num_queued, 1);
+	}
 
 	/* add task to queue */
 	BLI_mutex_lock(&scheduler->queue_mutex);
@@ -275,6 +626,8 @@ static void task_scheduler_push(TaskScheduler *scheduler, Task *task, TaskPriori
 
 	BLI_condition_notify_one(&scheduler->queue_cond);
 	BLI_mutex_unlock(&scheduler->queue_mutex);
+
+	task_pool_notify_pushed(pool);
 }
 
 static void task_scheduler_clear(TaskScheduler *scheduler, TaskPool *pool)
@@ -284,7 +637,8 @@ static void task_scheduler_clear(TaskScheduler *scheduler, TaskPool *pool)
 
 	BLI_mutex_lock(&scheduler->queue_mutex);
 
-	/* free all tasks from this pool from the queue */
+	/* free all tasks from this pool from the queue, tasks in the deques of
+	 * worker threads are skipped when they are popped from there */
 	for (task = scheduler->queue.first; task; task = nexttask) {
 		nexttask = task->next;
 
@@ -300,7 +654,9 @@ static void task_scheduler_clear(TaskScheduler *scheduler, TaskPool *pool)
 	BLI_mutex_unlock(&scheduler->queue_mutex);
 
 	/* notify done */
-	task_pool_num_decrease(pool, done);
+	if (done != 0) {
+		task_pool_num_decrease(pool, done);
+	}
 }
 
 /* Task Pool */
@@ -313,6 +669,8 @@ TaskPool *BLI_task_pool_create(TaskScheduler *scheduler, void *userdata)
 	pool->num = 0;
 	pool->num_threads = 0;
 	pool->currently_running_tasks = 0;
+	pool->num_waiting = 0;
+	pool->num_pushed = 0;
 	pool->do_cancel = false;
 
 	BLI_mutex_init(&pool->num_mutex);
@@ -349,72 +707,68 @@ void BLI_task_pool_free(TaskPool *pool)
 void BLI_task_pool_push(TaskPool *pool, TaskRunFunction run,
 	void *taskdata, bool free_taskdata, TaskPriority priority)
 {
-	Task *task = MEM_callocN(sizeof(Task), "Task");
+	TaskScheduler *scheduler = pool->scheduler;
+	TaskThread *thread = task_scheduler_thread_get(scheduler);
+	Task *task = task_alloc(thread);
 
+	task->next = task->prev = NULL;
 	task->run = run;
 	task->taskdata = taskdata;
 	task->free_taskdata = free_taskdata;
 	task->pool = pool;
 
-	task_scheduler_push(pool->scheduler, task, priority);
+	task_scheduler_push(scheduler, thread, task, priority);
 }
 
 void BLI_task_pool_work_and_wait(TaskPool *pool)
 {
 	TaskScheduler *scheduler = pool->scheduler;
+	TaskThread *thread = task_scheduler_thread_get(scheduler);
+	int thread_id = (thread != NULL) ? thread->id : 0;
 
-	BLI_mutex_lock(&pool->num_mutex);
-
-	while (pool->num != 0) {
-		Task *task, *work_task = NULL;
-		bool found_task = false;
-
-		BLI_mutex_unlock(&pool->num_mutex);
-
-		BLI_mutex_lock(&scheduler->queue_mutex);
+	while (true) {
+		size_t num_pushed = pool->num_pushed;
+		Task *task;
 
 		/* find task from this pool. if we get a task from another pool,
 		 * we can get into deadlock */
+		if (pool->num != 0 && task_pool_can_run(pool)) {
+			task = task_scheduler_find(scheduler, thread, pool);
 
-		if (pool->num_threads == 0 ||
-		    pool->currently_running_tasks < pool->num_threads)
-		{
-			for (task = scheduler->queue.first; task; task = task->next) {
-				if (task->pool == pool) {
-					work_task = task;
-					found_task = true;
-					BLI_remlink(&scheduler->queue, task);
-					break;
-				}
+			/* if found task, do it, otherwise wait until other tasks are done */
+			if (task != NULL) {
+				task_scheduler_run(thread, task, thread_id);
+				continue;
 			}
-		}
-
-		BLI_mutex_unlock(&scheduler->queue_mutex);
-
-		/* if found task, do it, otherwise wait until other tasks are done */
-		if (found_task) {
-			/* run task */
-			atomic_add_z(&pool->currently_running_tasks, 1);
-			work_task->run(pool, work_task->taskdata, 0);
 
-			/* delete task */
-			if (work_task->free_taskdata)
-				MEM_freeN(work_task->taskdata);
-			MEM_freeN(work_task);
-
-			/* notify pool task was done */
-			task_pool_num_decrease(pool, 1);
+			/* Tasks from this pool might be buried below tasks of other pools
+			 * in our own deque, make them reachable. */
+			if (thread != NULL && task_deque_has_pool(&thread->deque, pool)) {
+				task_scheduler_thread_spill(scheduler, thread);
+				continue;
+			}
 		}
 
 		BLI_mutex_lock(&pool->num_mutex);
-		if (pool->num == 0)
+
+		/* Only leave after the worker which finished the last task has released
+		 * the mutex, see task_pool_num_decrease. */
+		if (pool->num == 0) {
+			BLI_mutex_unlock(&pool->num_mutex);
 			break;
+		}
+
+		/* Registering as waiting before checking for new tasks makes sure
+		 * pushes happening from now on will wake us up. */
+		atomic_add_z((size_t *)&pool->num_waiting, 1);
 
-		if (!found_task)
+		if (pool->num_pushed == num_pushed)
 			BLI_condition_wait(&pool->num_cond, &pool->num_mutex);
-	}
 
-	BLI_mutex_unlock(&pool->num_mutex);
+		atomic_sub_z((size_t *)&pool->num_waiting, 1);
+
+		BLI_mutex_unlock(&pool->num_mutex);
+	}
 }
 
 int BLI_pool_get_num_threads(TaskPool *pool)
@@ -439,11 +793,9 @@ void BLI_task_pool_cancel(TaskPool *pool)
 
 	task_scheduler_clear(pool->scheduler, pool);
 
-	/* wait until all entries are cleared */
-	BLI_mutex_lock(&pool->num_mutex);
-	while (pool->num)
-		BLI_condition_wait(&pool->num_cond, &pool->num_mutex);
-	BLI_mutex_unlock(&pool->num_mutex);
+	/* wait until all entries are cleared, tasks of this pool which are still
+	 * in the deques of worker threads are popped without running them */
+	BLI_task_pool_work_and_wait(pool);
 
 	pool->do_cancel = false;
 }
@@ -109,6 +109,12 @@ typedef enum OrderOfChunks {
 #define COM_NUM_CHANNELS_VECTOR 3
 #define COM_NUM_CHANNELS_COLOR 4
 
+/**
+ * @brief maximum number of pixels executed at once by SocketReader.executeRow
+ * @ingroup Execution
+ */
+#define COM_ROW_LENGTH 64
+
 #define COM_BLUR_BOKEH_PIXELS 512
 
 #endif  /* __COM_DEFINES_H__ */
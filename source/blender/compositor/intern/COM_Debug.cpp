@@ -23,6 +23,7 @@
 
 #ifdef COM_DEBUG
 
+#include <stdio.h>
 #include <typeinfo>
 #include <map>
 #include <vector>
@@ -36,10 +37,13 @@ extern "C" {
 #include "BKE_node.h"
 }
 
+#include "PIL_time.h"
+
 #include "COM_Node.h"
 #include "COM_ExecutionSystem.h"
 #include "COM_ExecutionGroup.h"
 
+#include "COM_FusedPixelOperation.h"
 #include "COM_ReadBufferOperation.h"
 #include "COM_ViewerOperation.h"
 #include "COM_WriteBufferOperation.h"
@@ -51,6 +55,8 @@ DebugInfo::OpNameMap DebugInfo::m_op_names;
 std::string DebugInfo::m_current_node_name;
 std::string DebugInfo::m_current_op_name;
 DebugInfo::GroupStateMap DebugInfo::m_group_states;
+DebugInfo::GroupTimingMap DebugInfo::m_group_timings;
+double DebugInfo::m_execute_start_time = 0.0;
 
 std::string DebugInfo::node_name(const Node *node)
 {
@@ -79,8 +85,29 @@ void DebugInfo::execute_started(const ExecutionSystem *system)
 {
 	m_file_index = 1;
 	m_group_states.clear();
+	m_group_timings.clear();
 	for (ExecutionSystem::Groups::const_iterator it = system->m_groups.begin(); it != system->m_groups.end(); ++it)
 		m_group_states[*it] = EG_WAIT;
+	m_execute_start_time = PIL_check_seconds_timer();
+}
+
+void DebugInfo::execute_finished(const ExecutionSystem *system)
+{
+	printf("Compositor execution: %.2f ms\n", (PIL_check_seconds_timer() - m_execute_start_time) * 1000.0);
+	int totgroups = system->m_groups.size();
+	for (int i = 0; i < totgroups; ++i) {
+		const ExecutionGroup *group = system->m_groups[i];
+		GroupTimingMap::const_iterator it = m_group_timings.find(group);
+		if (it == m_group_timings.end())
+			continue;
+		
+		const GroupTiming &timing = it->second;
+		const double start = (group->m_executionStartTime - m_execute_start_time) * 1000.0;
+		const double finish = (timing.finish_time - m_execute_start_time) * 1000.0;
+		printf("  cluster_%d %s: %u/%u chunks, %.2f - %.2f ms (%.2f ms)\n",
+		       i, operation_name(group->getOutputOperation()).c_str(),
+		       timing.chunks, group->m_numberOfChunks, start, finish, finish - start);
+	}
 }
 
 void DebugInfo::node_added(const Node *node)
@@ -113,6 +140,13 @@ void DebugInfo::execution_group_finished(const ExecutionGroup *group)
 	m_group_states[group] = EG_FINISHED;
 }
 
+void DebugInfo::execution_group_chunk_finished(const ExecutionGroup *group)
+{
+	GroupTiming &timing = m_group_timings[group];
+	timing.finish_time = PIL_check_seconds_timer();
+	timing.chunks++;
+}
+
 int DebugInfo::graphviz_operation(const ExecutionSystem *system, const NodeOperation *operation, const ExecutionGroup *group, char *str, int maxlen)
 {
 	int len = 0;
@@ -139,6 +173,9 @@ int DebugInfo::graphviz_operation(const ExecutionSystem *system, const NodeOpera
 	else if (operation->isWriteBufferOperation()) {
 		fillcolor = "darkorange";
 	}
+	else if (operation->isFusedOperation()) {
+		fillcolor = "plum";
+	}
 	
 	len += snprintf(str + len, maxlen > len ? maxlen - len : 0, "// OPERATION: %p\r\n", operation);
 	if (group)
@@ -172,7 +209,19 @@ int DebugInfo::graphviz_operation(const ExecutionSystem *system, const NodeOpera
 		len += snprintf(str + len, maxlen > len ? maxlen - len : 0, "|");
 	}
 	
-	len += snprintf(str + len, maxlen > len ? maxlen - len : 0, "%s\\n(%s)", m_op_names[operation].c_str(), typeid(*operation).name());
+	if (operation->isFusedOperation()) {
+		/* list the fused operations, in execution order */
+		const FusedPixelOperation *fused = (const FusedPixelOperation *)operation;
+		const FusedPixelOperation::Operations &fused_ops = fused->getFusedOperations();
+		len += snprintf(str + len, maxlen > len ? maxlen - len : 0, "Fused (%d)", (int)fused_ops.size());
+		for (FusedPixelOperation::Operations::const_iterator it = fused_ops.begin(); it != fused_ops.end(); ++it) {
+			const NodeOperation *fused_op = *it;
+			len += snprintf(str + len, maxlen > len ? maxlen - len : 0, "\\n%s (%s)", m_op_names[fused_op].c_str(), typeid(*fused_op).name());
+		}
+	}
+	else {
+		len += snprintf(str + len, maxlen > len ? maxlen - len : 0, "%s\\n(%s)", m_op_names[operation].c_str(), typeid(*operation).name());
+	}
 	
 	len += snprintf(str + len, maxlen > len ? maxlen - len : 0, " (%d,%d)", operation->getWidth(), operation->getHeight());
 	
@@ -246,6 +295,7 @@ int DebugInfo::graphviz_legend(char *str, int maxlen)
 	len += graphviz_legend_color("Write Buffer", "darkorange", str + len, maxlen > len ? maxlen - len : 0);
 	len += graphviz_legend_color("Read Buffer", "darkolivegreen3", str + len, maxlen > len ? maxlen - len : 0);
 	len += graphviz_legend_color("Input Value", "khaki1", str + len, maxlen > len ? maxlen - len : 0);
+	len += graphviz_legend_color("Fused Pixel Chain", "plum", str + len, maxlen > len ? maxlen - len : 0);
 
 	len += snprintf(str + len, maxlen > len ? maxlen - len : 0, "<TR><TD></TD></TR>\r\n");
 
@@ -414,12 +464,14 @@ std::string DebugInfo::node_name(const Node * /*node*/) { return ""; }
 std::string DebugInfo::operation_name(const NodeOperation * /*op*/) { return ""; }
 void DebugInfo::convert_started() {}
 void DebugInfo::execute_started(const ExecutionSystem * /*system*/) {}
+void DebugInfo::execute_finished(const ExecutionSystem * /*system*/) {}
 void DebugInfo::node_added(const Node * /*node*/) {}
 void DebugInfo::node_to_operations(const Node * /*node*/) {}
 void DebugInfo::operation_added(const NodeOperation * /*operation*/) {}
 void DebugInfo::operation_read_write_buffer(const NodeOperation * /*operation*/) {}
 void DebugInfo::execution_group_started(const ExecutionGroup * /*group*/) {}
 void DebugInfo::execution_group_finished(const ExecutionGroup * /*group*/) {}
+void DebugInfo::execution_group_chunk_finished(const ExecutionGroup * /*group*/) {}
 void DebugInfo::graphviz(const ExecutionSystem * /*system*/) {}
 
 #endif
@@ -44,11 +44,18 @@ public:
 	typedef std::map<const NodeOperation *, std::string> OpNameMap;
 	typedef std::map<const ExecutionGroup *, GroupState> GroupStateMap;
 	
+	typedef struct GroupTiming {
+		double finish_time;		/**< time the last chunk was finished */
+		unsigned int chunks;	/**< number of chunks calculated */
+	} GroupTiming;
+	typedef std::map<const ExecutionGroup *, GroupTiming> GroupTimingMap;
+	
 	static std::string node_name(const Node *node);
 	static std::string operation_name(const NodeOperation *op);
 	
 	static void convert_started();
 	static void execute_started(const ExecutionSystem *system);
+	static void execute_finished(const ExecutionSystem *system);
 	
 	static void node_added(const Node *node);
 	static void node_to_operations(const Node *node);
@@ -57,6 +64,8 @@ public:
 	
 	static void execution_group_started(const ExecutionGroup *group);
 	static void execution_group_finished(const ExecutionGroup *group);
+	/** @note called by the devices, serialized by the WorkScheduler */
+	static void execution_group_chunk_finished(const ExecutionGroup *group);
 	
 	static void graphviz(const ExecutionSystem *system);
 	
@@ -76,6 +85,8 @@ private:
 	static std::string m_current_node_name;		/**< base name for all operations added by a node */
 	static std::string m_current_op_name;		/**< base name for automatic sub-operations */
 	static GroupStateMap m_group_states;		/**< for visualizing group states */
+	static GroupTimingMap m_group_timings;		/**< for reporting the time spent per group */
+	static double m_execute_start_time;
 #endif
 };
 
@@ -44,6 +44,8 @@
 #include "WM_api.h"
 #include "WM_types.h"
 
+#include "atomic_ops.h"
+
 ExecutionGroup::ExecutionGroup()
 {
 	this->m_isOutput = false;
@@ -62,6 +64,8 @@ ExecutionGroup::ExecutionGroup()
 	this->m_chunksFinished = 0;
 	BLI_rcti_init(&this->m_viewerBorder, 0, 0, 0, 0);
 	this->m_executionStartTime = 0;
+	this->m_chunkOrder = NULL;
+	this->m_chunkOrderStartIndex = 0;
 }
 
 CompositorPriority ExecutionGroup::getRenderPriotrity()
@@ -116,6 +120,7 @@ void ExecutionGroup::initExecution()
 	determineNumberOfChunks();
 
 	this->m_chunkExecutionStates = NULL;
+	this->m_executionStartTime = 0;
 	if (this->m_numberOfChunks != 0) {
 		this->m_chunkExecutionStates = (ChunkExecutionState *)MEM_mallocN(sizeof(ChunkExecutionState) * this->m_numberOfChunks, __func__);
 		for (index = 0; index < this->m_numberOfChunks; index++) {
@@ -151,6 +156,28 @@ void ExecutionGroup::deinitExecution()
 	this->m_cachedReadOperations.clear();
 	this->m_bTree = NULL;
 }
+
+bool ExecutionGroup::isExecuted() const
+{
+	if (this->m_chunkExecutionStates == NULL) {
+		return false;
+	}
+	for (unsigned int index = 0; index < this->m_numberOfChunks; index++) {
+		if (this->m_chunkExecutionStates[index] != COM_ES_EXECUTED) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void ExecutionGroup::setChunksExecuted()
+{
+	for (unsigned int index = 0; index < this->m_numberOfChunks; index++) {
+		this->m_chunkExecutionStates[index] = COM_ES_EXECUTED;
+	}
+	this->m_chunksFinished = this->m_numberOfChunks;
+}
+
 void ExecutionGroup::determineResolution(unsigned int resolution[2])
 {
 	NodeOperation *operation = this->getOutputOperation();
@@ -180,21 +207,21 @@ void ExecutionGroup::determineNumberOfChunks()
 /**
  * this method is called for the top execution groups. containing the compositor node or the preview node or the viewer node)
  */
-void ExecutionGroup::execute(ExecutionSystem *graph)
+bool ExecutionGroup::startExecution(ExecutionSystem *graph)
 {
 	const CompositorContext &context = graph->getContext();
 	const bNodeTree *bTree = context.getbNodeTree();
-	if (this->m_width == 0 || this->m_height == 0) {return; } /// @note: break out... no pixels to calculate.
-	if (bTree->test_break && bTree->test_break(bTree->tbh)) {return; } /// @note: early break out for blur and preview nodes
-	if (this->m_numberOfChunks == 0) {return; } /// @note: early break out
+	if (this->m_width == 0 || this->m_height == 0) {return false; } /// @note: break out... no pixels to calculate.
+	if (bTree->test_break && bTree->test_break(bTree->tbh)) {return false; } /// @note: early break out for blur and preview nodes
+	if (this->m_numberOfChunks == 0) {return false; } /// @note: early break out
 	unsigned int chunkNumber;
 
-	this->m_executionStartTime = PIL_check_seconds_timer();
-
 	this->m_chunksFinished = 0;
 	this->m_bTree = bTree;
+	this->m_chunkOrderStartIndex = 0;
 	unsigned int index;
 	unsigned int *chunkOrder = (unsigned int *)MEM_mallocN(sizeof(unsigned int) * this->m_numberOfChunks, __func__);
+	this->m_chunkOrder = chunkOrder;
 
 	for (chunkNumber = 0; chunkNumber < this->m_numberOfChunks; chunkNumber++) {
 		chunkOrder[chunkNumber] = chunkNumber;
@@ -300,53 +327,54 @@ void ExecutionGroup::execute(ExecutionSystem *graph)
 			break;
 	}
 
-	DebugInfo::execution_group_started(this);
 	DebugInfo::graphviz(graph);
 
-	bool breaked = false;
-	bool finished = false;
-	unsigned int startIndex = 0;
+	return true;
+}
+
+bool ExecutionGroup::scheduleChunks(ExecutionSystem *graph)
+{
+	const bNodeTree *bTree = this->m_bTree;
 	const int maxNumberEvaluated = BLI_system_thread_count() * 2;
+	bool startEvaluated = false;
+	bool finished = true;
+	int numberEvaluated = 0;
+	unsigned int index;
 
-	while (!finished && !breaked) {
-		bool startEvaluated = false;
-		finished = true;
-		int numberEvaluated = 0;
-
-		for (index = startIndex; index < this->m_numberOfChunks && numberEvaluated < maxNumberEvaluated; index++) {
-			chunkNumber = chunkOrder[index];
-			int yChunk = chunkNumber / this->m_numberOfXChunks;
-			int xChunk = chunkNumber - (yChunk * this->m_numberOfXChunks);
-			const ChunkExecutionState state = this->m_chunkExecutionStates[chunkNumber];
-			if (state == COM_ES_NOT_SCHEDULED) {
-				scheduleChunkWhenPossible(graph, xChunk, yChunk);
-				finished = false;
-				startEvaluated = true;
-				numberEvaluated++;
-
-				if (bTree->update_draw)
-					bTree->update_draw(bTree->udh);
-			}
-			else if (state == COM_ES_SCHEDULED) {
-				finished = false;
-				startEvaluated = true;
-				numberEvaluated++;
-			}
-			else if (state == COM_ES_EXECUTED && !startEvaluated) {
-				startIndex = index + 1;
-			}
+	for (index = this->m_chunkOrderStartIndex; index < this->m_numberOfChunks && numberEvaluated < maxNumberEvaluated; index++) {
+		const unsigned int chunkNumber = this->m_chunkOrder[index];
+		int yChunk = chunkNumber / this->m_numberOfXChunks;
+		int xChunk = chunkNumber - (yChunk * this->m_numberOfXChunks);
+		const ChunkExecutionState state = this->m_chunkExecutionStates[chunkNumber];
+		if (state == COM_ES_NOT_SCHEDULED) {
+			scheduleChunkWhenPossible(graph, xChunk, yChunk);
+			finished = false;
+			startEvaluated = true;
+			numberEvaluated++;
+
+			if (bTree->update_draw)
+				bTree->update_draw(bTree->udh);
 		}
-
-		WorkScheduler::finish();
-
-		if (bTree->test_break && bTree->test_break(bTree->tbh)) {
-			breaked = true;
+		else if (state == COM_ES_SCHEDULED) {
+			finished = false;
+			startEvaluated = true;
+			numberEvaluated++;
+		}
+		else if (state == COM_ES_EXECUTED && !startEvaluated) {
+			this->m_chunkOrderStartIndex = index + 1;
 		}
 	}
+
+	return finished;
+}
+
+void ExecutionGroup::finishExecution(ExecutionSystem *graph)
+{
 	DebugInfo::execution_group_finished(this);
 	DebugInfo::graphviz(graph);
 
-	MEM_freeN(chunkOrder);
+	MEM_freeN(this->m_chunkOrder);
+	this->m_chunkOrder = NULL;
 }
 
 MemoryBuffer **ExecutionGroup::getInputBuffersOpenCL(int chunkNumber)
@@ -382,7 +410,8 @@ void ExecutionGroup::finalizeChunkExecution(int chunkNumber, MemoryBuffer **memo
 	if (this->m_chunkExecutionStates[chunkNumber] == COM_ES_SCHEDULED)
 		this->m_chunkExecutionStates[chunkNumber] = COM_ES_EXECUTED;
 	
-	this->m_chunksFinished++;
+	/* chunks of the same group are finished by multiple devices at once */
+	atomic_add_u(&this->m_chunksFinished, 1);
 	if (memoryBuffers) {
 		for (unsigned int index = 0; index < this->m_cachedMaxReadBufferOffset; index++) {
 			MemoryBuffer *buffer = memoryBuffers[index];
@@ -485,6 +514,10 @@ bool ExecutionGroup::scheduleChunk(unsigned int chunkNumber)
 {
 	if (this->m_chunkExecutionStates[chunkNumber] == COM_ES_NOT_SCHEDULED) {
 		this->m_chunkExecutionStates[chunkNumber] = COM_ES_SCHEDULED;
+		if (this->m_executionStartTime == 0.0) {
+			this->m_executionStartTime = PIL_check_seconds_timer();
+			DebugInfo::execution_group_started(this);
+		}
 		WorkScheduler::schedule(this, chunkNumber);
 		return true;
 	}
@@ -174,9 +174,20 @@ private:
 	rcti m_viewerBorder;
 
 	/**
-	 * @brief start time of execution
+	 * @brief start time of execution, when the first chunk is scheduled
 	 */
 	double m_executionStartTime;
+	
+	/**
+	 * @brief order in which the chunks of an output ExecutionGroup are scheduled
+	 * @see startExecution
+	 */
+	unsigned int *m_chunkOrder;
+	
+	/**
+	 * @brief index in m_chunkOrder before which all chunks have been executed
+	 */
+	unsigned int m_chunkOrderStartIndex;
 
 	// methods
 	/**
@@ -303,6 +314,17 @@ public:
 	 */
 	bool isComplex() const { return m_complex; }
 	
+	/**
+	 * @brief have all chunks of this ExecutionGroup been executed
+	 */
+	bool isExecuted() const;
+	
+	/**
+	 * @brief mark all chunks as executed, when the output buffer is already filled
+	 * @see ResultCache.restore
+	 */
+	void setChunksExecuted();
+	
 	
 	/**
 	 * @brief get the output operation of this ExecutionGroup
@@ -361,20 +383,36 @@ public:
 	
 	
 	/**
-	 * @brief schedule an ExecutionGroup
-	 * @note this method will return when all chunks have been calculated, or the execution has breaked (by user)
+	 * @brief start the execution of an output ExecutionGroup
 	 *
 	 * first the order of the chunks will be determined. This is determined by finding the ViewerOperation and get the relevant information from it.
 	 *   - ChunkOrdering
 	 *   - CenterX
 	 *   - CenterY
 	 *
-	 * After determining the order of the chunks the chunks will be scheduled
+	 * After determining the order of the chunks the chunks are scheduled by scheduleChunks
 	 *
 	 * @see ViewerOperation
 	 * @param system
+	 * @return false when there is nothing to execute, finishExecution must not be called
+	 */
+	bool startExecution(ExecutionSystem *system);
+	
+	/**
+	 * @brief schedule the next chunks of an output ExecutionGroup
+	 * @note this method does not wait for the chunks, a limited number of chunks is scheduled or waiting at a time.
+	 * Chunks whose input areas are not calculated yet schedule the chunks of the ExecutionGroups they depend on.
+	 * It is called again when chunks have finished, chunks of other groups are scheduled in between.
+	 *
+	 * @see ExecutionSystem.executeGroups
+	 * @return true when all chunks have been calculated
+	 */
+	bool scheduleChunks(ExecutionSystem *system);
+	
+	/**
+	 * @brief finish the execution of an output ExecutionGroup, after all chunks are calculated or the execution has breaked (by user)
 	 */
-	void execute(ExecutionSystem *system);
+	void finishExecution(ExecutionSystem *system);
 	
 	/**
 	 * @brief this method determines the MemoryProxy's where this execution group depends on.
@@ -34,6 +34,7 @@ extern "C" {
 #include "COM_ExecutionGroup.h"
 #include "COM_WorkScheduler.h"
 #include "COM_ReadBufferOperation.h"
+#include "COM_ResultCache.h"
 #include "COM_Debug.h"
 
 #include "BKE_global.h"
@@ -174,6 +175,17 @@ void ExecutionSystem::execute()
 		executionGroup->initExecution();
 	}
 
+	// restore the results of the previous executions, the other groups store their result when executed
+	vector<std::pair<ExecutionGroup *, ResultCacheKey> > storeGroups;
+	ResultCache::beginExecution(this->m_context);
+	for (index = 0; index < this->m_groups.size(); index++) {
+		ExecutionGroup *executionGroup = this->m_groups[index];
+		ResultCacheKey key;
+		if (ResultCache::groupKey(executionGroup, &key) && !ResultCache::restore(executionGroup, key)) {
+			storeGroups.push_back(std::make_pair(executionGroup, key));
+		}
+	}
+
 	WorkScheduler::start(this->m_context);
 
 	executeGroups(COM_PRIORITY_HIGH);
@@ -185,6 +197,13 @@ void ExecutionSystem::execute()
 	WorkScheduler::finish();
 	WorkScheduler::stop();
 
+	DebugInfo::execute_finished(this);
+
+	for (index = 0; index < storeGroups.size(); index++) {
+		ResultCache::store(storeGroups[index].first, storeGroups[index].second);
+	}
+	ResultCache::endExecution(editingtree);
+
 	editingtree->stats_draw(editingtree->sdh, (char *)"Compositing | Deinitializing execution");
 	for (index = 0; index < this->m_operations.size(); index++) {
 		NodeOperation *operation = this->m_operations[index];
@@ -198,13 +217,50 @@ void ExecutionSystem::execute()
 
 void ExecutionSystem::executeGroups(CompositorPriority priority)
 {
+	const bNodeTree *bTree = this->m_context.getbNodeTree();
 	unsigned int index;
 	vector<ExecutionGroup *> executionGroups;
+	vector<ExecutionGroup *> activeGroups;
 	this->findOutputExecutionGroup(&executionGroups, priority);
 
 	for (index = 0; index < executionGroups.size(); index++) {
 		ExecutionGroup *group = executionGroups[index];
-		group->execute(this);
+		if (group->startExecution(this)) {
+			activeGroups.push_back(group);
+		}
+	}
+
+	/* The chunks of all output groups are scheduled together, every time chunks have finished.
+	 * The devices keep calculating chunks of other groups while a group waits for its last chunks
+	 * or for the chunks of the groups it depends on. */
+	bool breaked = false;
+	while (!activeGroups.empty() && !breaked) {
+		index = 0;
+		while (index < activeGroups.size()) {
+			ExecutionGroup *group = activeGroups[index];
+			if (group->scheduleChunks(this)) {
+				group->finishExecution(this);
+				activeGroups.erase(activeGroups.begin() + index);
+			}
+			else {
+				index++;
+			}
+		}
+
+		if (!activeGroups.empty()) {
+			WorkScheduler::waitForProgress();
+		}
+
+		if (bTree->test_break && bTree->test_break(bTree->tbh)) {
+			breaked = true;
+		}
+	}
+
+	/* groups of a lower priority start when all scheduled chunks are calculated */
+	WorkScheduler::finish();
+
+	for (index = 0; index < activeGroups.size(); index++) {
+		activeGroups[index]->finishExecution(this);
 	}
 }
 
@@ -250,6 +250,43 @@ public:
 		memcpy(result, buffer, sizeof(float) * this->m_num_channels);
 	}
 	
+	/**
+	 * @brief read a row of pixels, COM_NUM_CHANNELS_COLOR floats per pixel
+	 * @note pixels outside the buffer are zero, like read() with COM_MB_CLIP
+	 */
+	inline void readRow(float *result, int x, int y, int length)
+	{
+		const int num_channels = this->m_num_channels;
+
+		if (y < m_rect.ymin || y >= m_rect.ymax) {
+			memset(result, 0, sizeof(float) * COM_NUM_CHANNELS_COLOR * length);
+			return;
+		}
+
+		/* part of the row inside the buffer */
+		const int start = min_ii(max_ii(m_rect.xmin - x, 0), length);
+		const int end = max_ii(min_ii(m_rect.xmax - x, length), start);
+
+		if (start > 0) {
+			memset(result, 0, sizeof(float) * COM_NUM_CHANNELS_COLOR * start);
+		}
+
+		const float *buffer = &this->m_buffer[((y - m_rect.ymin) * this->m_width + (x + start - m_rect.xmin)) * num_channels];
+		if (num_channels == COM_NUM_CHANNELS_COLOR) {
+			memcpy(&result[start * COM_NUM_CHANNELS_COLOR], buffer, sizeof(float) * COM_NUM_CHANNELS_COLOR * (end - start));
+		}
+		else {
+			for (int i = start; i < end; i++) {
+				memcpy(&result[i * COM_NUM_CHANNELS_COLOR], buffer, sizeof(float) * num_channels);
+				buffer += num_channels;
+			}
+		}
+
+		if (end < length) {
+			memset(&result[end * COM_NUM_CHANNELS_COLOR], 0, sizeof(float) * COM_NUM_CHANNELS_COLOR * (length - end));
+		}
+	}
+
 	void writePixel(int x, int y, const float color[4]);
 	void addPixel(int x, int y, const float color[4]);
 	inline void readBilinear(float *result, float x, float y,
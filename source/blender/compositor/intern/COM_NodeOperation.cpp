@@ -41,6 +41,8 @@ NodeOperation::NodeOperation()
 	this->m_isResolutionSet = false;
 	this->m_openCL = false;
 	this->m_btree = NULL;
+	this->m_settingsKey = 0;
+	this->m_cacheable = true;
 }
 
 NodeOperation::~NodeOperation()
@@ -142,6 +144,18 @@ SocketReader *NodeOperation::getInputSocketReader(unsigned int inputSocketIndex)
 	return this->getInputSocket(inputSocketIndex)->getReader();
 }
 
+void NodeOperation::executeRow(float *output, int x, int y, int length)
+{
+	int index = getTransformInputSocketIndex();
+	if (index == -1) {
+		SocketReader::executeRow(output, x, y, length);
+		return;
+	}
+	
+	getInputSocketReader(index)->readRow(output, x, y, length);
+	transformRow(output, x, y, length);
+}
+
 NodeOperation *NodeOperation::getInputOperation(unsigned int inputSocketIndex)
 {
 	NodeOperationInput *input = getInputSocket(inputSocketIndex);
@@ -36,6 +36,7 @@ extern "C" {
 #include "COM_Node.h"
 #include "COM_MemoryBuffer.h"
 #include "COM_MemoryProxy.h"
+#include "COM_ResultCache.h"
 #include "COM_SocketReader.h"
 
 #include "clew.h"
@@ -125,6 +126,18 @@ private:
 	 * @brief set to truth when resolution for this operation is set
 	 */
 	bool m_isResolutionSet;
+
+	/**
+	 * @brief key of the settings of the node this operation was created for
+	 * @see ResultCache
+	 */
+	ResultCacheKey m_settingsKey;
+
+	/**
+	 * @brief can results depending on this operation be cached
+	 * @see ResultCache.nodeKey
+	 */
+	bool m_cacheable;
 	
 public:
 	virtual ~NodeOperation();
@@ -293,9 +306,46 @@ public:
 	virtual bool isPreviewOperation() const { return false; }
 	virtual bool isFileOutputOperation() const { return false; }
 	virtual bool isProxyOperation() const { return false; }
+	virtual bool isFusedOperation() const { return false; }
 	
 	virtual bool useDatatypeConversion() const { return true; }
 	
+	/**
+	 * @brief index of the input socket whose row is transformed in place by transformRow
+	 *
+	 * Operations that compute their output from one input pixel-by-pixel return the index of that input.
+	 * These operations get executeRow for free, and can be fused with the operations before them.
+	 *
+	 * @return the input socket index, or -1 when rows are not transformed in place
+	 * @see FusedPixelOperation
+	 */
+	virtual int getTransformInputSocketIndex() const { return -1; }
+
+	/**
+	 * @brief transform a row in place
+	 * @param row array holding the row of the transform input socket, overwritten with the result
+	 * @param x the x-coordinate of the first pixel in image space
+	 * @param y the y-coordinate of the row in image space
+	 * @param length the number of pixels in the row, at most COM_ROW_LENGTH
+	 * @see getTransformInputSocketIndex
+	 */
+	virtual void transformRow(float * /*row*/, int /*x*/, int /*y*/, int /*length*/) {}
+
+	void setSettingsKey(ResultCacheKey key, bool cacheable) { this->m_settingsKey = key; this->m_cacheable = cacheable; }
+	ResultCacheKey getSettingsKey() const { return this->m_settingsKey; }
+	bool isCacheable() const { return this->m_cacheable; }
+
+	/**
+	 * @brief add the data this operation reads from outside of the node tree to the key of its result
+	 *
+	 * Called after initExecution. Input operations reading images or render results hash their buffers,
+	 * settings that are not stored in the node are hashed by the operation itself.
+	 *
+	 * @return false when the result of this operation can't be cached
+	 * @see ResultCache
+	 */
+	virtual bool hashCacheData(ResultCacheHash & /*hash*/) { return true; }
+	
 	inline bool isBreaked() const {
 		return this->m_btree->test_break(this->m_btree->tbh);
 	}
@@ -315,6 +365,8 @@ protected:
 	SocketReader *getInputSocketReader(unsigned int inputSocketindex);
 	NodeOperation *getInputOperation(unsigned int inputSocketindex);
 
+	void executeRow(float *output, int x, int y, int length);
+
 	void deinitMutex();
 	void initMutex();
 	void lockMutex();
@@ -31,6 +31,7 @@ extern "C" {
 #include "COM_SocketProxyNode.h"
 
 #include "COM_NodeOperation.h"
+#include "COM_FusedPixelOperation.h"
 #include "COM_PreviewOperation.h"
 #include "COM_SetValueOperation.h"
 #include "COM_SetVectorOperation.h"
@@ -45,6 +46,8 @@ extern "C" {
 NodeOperationBuilder::NodeOperationBuilder(const CompositorContext *context, bNodeTree *b_nodetree) :
     m_context(context),
     m_current_node(NULL),
+    m_current_node_key(0),
+    m_current_node_cacheable(true),
     m_active_viewer(NULL)
 {
 	m_graph.from_bNodeTree(*context, b_nodetree);
@@ -59,10 +62,13 @@ void NodeOperationBuilder::convertToOperations(ExecutionSystem *system)
 	/* interface handle for nodes */
 	NodeConverter converter(this);
 	
+	DebugInfo::convert_started();
+	
 	for (int index = 0; index < m_graph.nodes().size(); index++) {
 		Node *node = (Node *)m_graph.nodes()[index];
 		
 		m_current_node = node;
+		m_current_node_cacheable = ResultCache::nodeKey(node->getbNode(), *m_context, &m_current_node_key);
 		
 		DebugInfo::node_to_operations(node);
 		node->convertToOperations(converter, *m_context);
@@ -112,6 +118,9 @@ void NodeOperationBuilder::convertToOperations(ExecutionSystem *system)
 	/* surround complex ops with read/write buffer */
 	add_complex_operation_buffers();
 	
+	/* execute chains of per-pixel ops as one op */
+	fuse_pixel_operations();
+	
 	/* links not available from here on */
 	/* XXX make m_links a local variable to avoid confusion! */
 	m_links.clear();
@@ -130,6 +139,9 @@ void NodeOperationBuilder::convertToOperations(ExecutionSystem *system)
 
 void NodeOperationBuilder::addOperation(NodeOperation *operation)
 {
+	DebugInfo::operation_added(operation);
+	if (m_current_node)
+		operation->setSettingsKey(m_current_node_key, m_current_node_cacheable);
 	m_operations.push_back(operation);
 }
 
@@ -568,6 +580,99 @@ void NodeOperationBuilder::add_complex_operation_buffers()
 	}
 }
 
+static bool is_fusable_operation(NodeOperation *op)
+{
+	return (op->getTransformInputSocketIndex() != -1 &&
+	        !op->isComplex() &&
+	        !op->isSingleThreaded() &&
+	        op->getNumberOfOutputSockets() == 1);
+}
+
+void NodeOperationBuilder::fuse_pixel_operations()
+{
+	typedef std::map<NodeOperationOutput *, int> LinkCountMap;
+	typedef std::map<NodeOperation *, NodeOperation *> OperationMap;
+	
+	/* the output of a fused op can only be used by the next op in the chain */
+	LinkCountMap link_count;
+	for (Links::const_iterator it = m_links.begin(); it != m_links.end(); ++it)
+		link_count[it->from()]++;
+	
+	/* find the ops that transform the output of another fusable op */
+	OperationMap prev_ops, next_ops;
+	for (Operations::const_iterator it = m_operations.begin(); it != m_operations.end(); ++it) {
+		NodeOperation *op = *it;
+		if (!is_fusable_operation(op))
+			continue;
+		
+		NodeOperationInput *input = op->getInputSocket(op->getTransformInputSocketIndex());
+		if (!input->isConnected())
+			continue;
+		
+		NodeOperationOutput *output = input->getLink();
+		NodeOperation *from_op = &output->getOperation();
+		if (!is_fusable_operation(from_op) || link_count[output] != 1)
+			continue;
+		if (from_op->getWidth() != op->getWidth() || from_op->getHeight() != op->getHeight())
+			continue;
+		
+		prev_ops[op] = from_op;
+		next_ops[from_op] = op;
+	}
+	
+	if (next_ops.empty())
+		return;
+	
+	std::set<NodeOperation *> chain_ops;
+	Operations fused_ops;
+	for (Operations::const_iterator it = m_operations.begin(); it != m_operations.end(); ++it) {
+		NodeOperation *op = *it;
+		
+		/* chains start at ops that are not transforming a fused op themselves */
+		if (next_ops.find(op) == next_ops.end() || prev_ops.find(op) != prev_ops.end())
+			continue;
+		
+		FusedPixelOperation::Operations chain;
+		while (op) {
+			/* fused ops are not initialized by the execution system */
+			op->setbNodeTree(m_context->getbNodeTree());
+			chain.push_back(op);
+			chain_ops.insert(op);
+			
+			OperationMap::const_iterator next = next_ops.find(op);
+			op = (next != next_ops.end() ? next->second : NULL);
+		}
+		
+		FusedPixelOperation *fused_op = new FusedPixelOperation(chain);
+		fused_op->setbNodeTree(m_context->getbNodeTree());
+		fused_ops.push_back(fused_op);
+		
+		/* links into the chain are mirrored, the fused ops keep reading their own inputs */
+		for (int index = 0; index < fused_op->getNumberOfInputSockets(); index++) {
+			NodeOperationInput *input = fused_op->getFusedInputSocket(index);
+			if (input->isConnected())
+				addLink(input->getLink(), fused_op->getInputSocket(index));
+		}
+		
+		/* links from the end of the chain are replaced */
+		OpInputs targets = cache_output_links(chain.back()->getOutputSocket());
+		for (OpInputs::const_iterator it_target = targets.begin(); it_target != targets.end(); ++it_target) {
+			NodeOperationInput *target = *it_target;
+			removeInputLink(target);
+			addLink(fused_op->getOutputSocket(), target);
+		}
+	}
+	
+	/* fused ops are owned by the fused operation */
+	Operations operations;
+	for (Operations::const_iterator it = m_operations.begin(); it != m_operations.end(); ++it) {
+		if (chain_ops.find(*it) == chain_ops.end())
+			operations.push_back(*it);
+	}
+	operations.insert(operations.end(), fused_ops.begin(), fused_ops.end());
+	m_operations = operations;
+}
+
 typedef std::set<NodeOperation*> Tags;
 
 static void find_reachable_operations_recursive(Tags &reachable, NodeOperation *op)
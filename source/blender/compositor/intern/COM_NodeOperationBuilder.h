@@ -27,6 +27,7 @@
 #include <vector>
 
 #include "COM_NodeGraph.h"
+#include "COM_ResultCache.h"
 
 using std::vector;
 
@@ -87,6 +88,9 @@ private:
 	OutputSocketMap m_output_map;
 	
 	Node *m_current_node;
+	/** Key of the settings of the current node, given to its operations for the ResultCache */
+	ResultCacheKey m_current_node_key;
+	bool m_current_node_cacheable;
 	
 	/** Operation that will be writing to the viewer image
 	 *  Only one operation can occupy this place at a time,
@@ -149,6 +153,9 @@ protected:
 	void add_input_buffers(NodeOperation *operation, NodeOperationInput *input);
 	void add_output_buffers(NodeOperation *operation, NodeOperationOutput *output);
 	
+	/** Replace linear chains of per-pixel operations by fused operations */
+	void fuse_pixel_operations();
+	
 	/** Remove unreachable operations */
 	void prune_operations();
 	
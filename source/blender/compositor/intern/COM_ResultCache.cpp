@@ -0,0 +1,480 @@
+/*
+ * Copyright 2015, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <map>
+#include <stdio.h>
+#include <string.h>
+#include <typeinfo>
+
+#include "COM_ResultCache.h"
+#include "COM_CompositorContext.h"
+#include "COM_ExecutionGroup.h"
+#include "COM_FusedPixelOperation.h"
+#include "COM_MemoryBuffer.h"
+#include "COM_MemoryProxy.h"
+#include "COM_NodeOperation.h"
+#include "COM_ReadBufferOperation.h"
+#include "COM_WriteBufferOperation.h"
+
+#include "MEM_guardedalloc.h"
+#include "MEM_CacheLimiterC-Api.h"
+
+extern "C" {
+#include "BLI_string.h"
+#include "BLI_utildefines.h"
+#include "DNA_camera_types.h"
+#include "DNA_color_types.h"
+#include "DNA_node_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+#include "BKE_camera.h"
+#include "BKE_global.h"
+#include "BKE_node.h"
+}
+
+/* ******** ResultCacheHash ******** */
+
+ResultCacheHash::ResultCacheHash()
+{
+	BLI_hash_mm2a_init(&this->m_low, 0);
+	BLI_hash_mm2a_init(&this->m_high, 0x9747b28c);
+}
+
+void ResultCacheHash::add(const void *data, size_t size)
+{
+	BLI_hash_mm2a_add(&this->m_low, (const unsigned char *)data, size);
+	BLI_hash_mm2a_add(&this->m_high, (const unsigned char *)data, size);
+}
+
+void ResultCacheHash::addInt(int value)
+{
+	BLI_hash_mm2a_add_int(&this->m_low, value);
+	BLI_hash_mm2a_add_int(&this->m_high, value);
+}
+
+void ResultCacheHash::addFloat(float value)
+{
+	add(&value, sizeof(value));
+}
+
+void ResultCacheHash::addString(const char *str)
+{
+	if (str) {
+		add(str, strlen(str));
+	}
+	/* separates consecutive strings */
+	addInt(0);
+}
+
+void ResultCacheHash::addKey(ResultCacheKey key)
+{
+	add(&key, sizeof(key));
+}
+
+ResultCacheKey ResultCacheHash::end()
+{
+	ResultCacheKey low = BLI_hash_mm2a_end(&this->m_low);
+	ResultCacheKey high = BLI_hash_mm2a_end(&this->m_high);
+	return (high << 32) | low;
+}
+
+/* ******** ResultCache ******** */
+
+typedef struct ResultCacheEntry {
+	ResultCacheKey key;
+	float *buffer;
+	unsigned int width, height, num_channels;
+	MEM_CacheLimiterHandleC *handle;
+} ResultCacheEntry;
+
+typedef std::map<ResultCacheKey, ResultCacheEntry *> ResultCacheEntries;
+typedef std::map<NodeOperation *, std::pair<bool, ResultCacheKey> > OperationKeys;
+typedef std::map<const void *, std::pair<size_t, ResultCacheKey> > BufferKeys;
+
+/** @brief cached results by key */
+static ResultCacheEntries g_entries;
+/** @brief manages the memory of the cached results, created on first use */
+static MEM_CacheLimiterC *g_limiter = NULL;
+
+/** @brief key of the CompositorContext of the current execution */
+static ResultCacheKey g_context_key = 0;
+/** @brief keys of the operations of the current execution */
+static OperationKeys g_operation_keys;
+/** @brief keys of the buffers read during the current execution */
+static BufferKeys g_buffer_keys;
+
+/** @brief statistics of the current execution */
+static unsigned int g_hits = 0;
+static unsigned int g_misses = 0;
+
+static size_t result_cache_entry_size(ResultCacheEntry *entry)
+{
+	return sizeof(ResultCacheEntry) + sizeof(float) * entry->width * entry->height * entry->num_channels;
+}
+
+static void result_cache_entry_free(ResultCacheEntry *entry)
+{
+	g_entries.erase(entry->key);
+	MEM_freeN(entry->buffer);
+	MEM_freeN(entry);
+}
+
+/* called by the limiter, which unmanages the entry itself */
+static void result_cache_destructor(void *data)
+{
+	result_cache_entry_free((ResultCacheEntry *)data);
+}
+
+static size_t result_cache_data_size(void *data)
+{
+	return result_cache_entry_size((ResultCacheEntry *)data);
+}
+
+static void curvemapping_hash(ResultCacheHash &hash, const CurveMapping *cumap)
+{
+	hash.addInt(cumap->flag);
+	hash.add(&cumap->clipr, sizeof(cumap->clipr));
+	hash.add(cumap->black, sizeof(cumap->black));
+	hash.add(cumap->white, sizeof(cumap->white));
+
+	for (int index = 0; index < CM_TOT; index++) {
+		const CurveMap *cuma = &cumap->cm[index];
+		hash.addInt(cuma->totpoint);
+		hash.addInt(cuma->flag);
+		hash.add(cuma->ext_in, sizeof(cuma->ext_in));
+		hash.add(cuma->ext_out, sizeof(cuma->ext_out));
+		if (cuma->curve) {
+			hash.add(cuma->curve, sizeof(CurveMapPoint) * cuma->totpoint);
+		}
+	}
+}
+
+static void socket_values_hash(ResultCacheHash &hash, const ListBase *sockets)
+{
+	for (bNodeSocket *sock = (bNodeSocket *)sockets->first; sock; sock = sock->next) {
+		if (sock->default_value) {
+			hash.add(sock->default_value, MEM_allocN_len(sock->default_value));
+		}
+	}
+}
+
+/* defocus reads the lens and focus of the scene camera */
+static void defocus_camera_hash(ResultCacheHash &hash, const bNode *node, const CompositorContext &context)
+{
+	Scene *scene = node->id ? (Scene *)node->id : context.getScene();
+	Object *camob = scene ? scene->camera : NULL;
+
+	hash.add(&camob, sizeof(camob));
+	if (camob && camob->type == OB_CAMERA) {
+		Camera *camera = (Camera *)camob->data;
+		hash.addFloat(camera->lens);
+		hash.addFloat(BKE_camera_sensor_size(camera->sensor_fit, camera->sensor_x, camera->sensor_y));
+		hash.addFloat(BKE_camera_object_dof_distance(camob));
+	}
+}
+
+bool ResultCache::nodeKey(const bNode *node, const CompositorContext &context, ResultCacheKey *r_key)
+{
+	ResultCacheHash hash;
+	bool cacheable = true;
+
+	if (node == NULL) {
+		*r_key = 0;
+		return true;
+	}
+
+	hash.addInt(node->type);
+	hash.addInt(node->flag & NODE_MUTED);
+	hash.addInt(node->custom1);
+	hash.addInt(node->custom2);
+	hash.addFloat(node->custom3);
+	hash.addFloat(node->custom4);
+
+	if (node->storage) {
+		if (ELEM(node->type, CMP_NODE_TIME, CMP_NODE_CURVE_VEC, CMP_NODE_CURVE_RGB, CMP_NODE_HUECORRECT)) {
+			/* the only storage with pointers to its settings */
+			curvemapping_hash(hash, (const CurveMapping *)node->storage);
+		}
+		else {
+			hash.add(node->storage, MEM_allocN_len(node->storage));
+		}
+	}
+
+	socket_values_hash(hash, &node->inputs);
+	socket_values_hash(hash, &node->outputs);
+
+	if (node->type == CMP_NODE_DEFOCUS) {
+		defocus_camera_hash(hash, node, context);
+	}
+	else if (node->id) {
+		hash.add(&node->id, sizeof(node->id));
+
+		/* the pixels of images, render results and movie clips are part of the keys of the
+		 * input operations (see NodeOperation.hashCacheData), the contents of node groups are
+		 * converted as nodes of their own. Other datablocks can change without the key changing. */
+		if (!(GS(node->id->name) == ID_NT ||
+		      ELEM(node->type, CMP_NODE_IMAGE, CMP_NODE_R_LAYERS, CMP_NODE_MOVIECLIP)))
+		{
+			cacheable = false;
+		}
+	}
+
+	*r_key = hash.end();
+	return cacheable;
+}
+
+ResultCacheKey ResultCache::bufferKey(const void *buffer, size_t size)
+{
+	BufferKeys::const_iterator it = g_buffer_keys.find(buffer);
+	if (it != g_buffer_keys.end() && it->second.first == size) {
+		return it->second.second;
+	}
+
+	ResultCacheHash hash;
+	hash.addInt((int)(size >> 32));
+	hash.addInt((int)size);
+	if (buffer) {
+		hash.add(buffer, size);
+	}
+	ResultCacheKey key = hash.end();
+
+	g_buffer_keys[buffer] = std::make_pair(size, key);
+	return key;
+}
+
+void ResultCache::beginExecution(const CompositorContext &context)
+{
+	const RenderData *rd = context.getRenderData();
+	const ColorManagedViewSettings *view_settings = context.getViewSettings();
+	const ColorManagedDisplaySettings *display_settings = context.getDisplaySettings();
+	const Scene *scene = context.getScene();
+	ResultCacheHash hash;
+
+	if (g_limiter == NULL) {
+		g_limiter = new_MEM_CacheLimiter(result_cache_destructor, result_cache_data_size);
+	}
+
+	hash.add(&scene, sizeof(scene));
+	hash.addInt(rd->cfra);
+	hash.addFloat(rd->subframe);
+	hash.addInt(rd->xsch);
+	hash.addInt(rd->ysch);
+	hash.addInt(rd->size);
+	hash.addInt(context.getQuality());
+	hash.addInt(context.isRendering());
+	hash.addInt(context.isFastCalculation());
+	hash.addInt(context.getHasActiveOpenCLDevices());
+	hash.addString(context.getViewName());
+	if (view_settings) {
+		hash.addInt(view_settings->flag);
+		hash.addString(view_settings->look);
+		hash.addString(view_settings->view_transform);
+		hash.addFloat(view_settings->exposure);
+		hash.addFloat(view_settings->gamma);
+	}
+	if (display_settings) {
+		hash.addString(display_settings->display_device);
+	}
+
+	g_context_key = hash.end();
+	g_operation_keys.clear();
+	g_buffer_keys.clear();
+	g_hits = 0;
+	g_misses = 0;
+}
+
+/* the type, node settings and resolution of an operation, without its inputs */
+static bool operation_settings_hash(ResultCacheHash &hash, NodeOperation *operation)
+{
+	hash.addString(typeid(*operation).name());
+	hash.addKey(operation->getSettingsKey());
+	hash.addInt(operation->getWidth());
+	hash.addInt(operation->getHeight());
+	hash.addInt(operation->getNumberOfInputSockets());
+	return operation->isCacheable();
+}
+
+static int output_socket_index(NodeOperationOutput *output)
+{
+	NodeOperation &operation = output->getOperation();
+	for (unsigned int index = 0; index < operation.getNumberOfOutputSockets(); index++) {
+		if (operation.getOutputSocket(index) == output) {
+			return index;
+		}
+	}
+	return -1;
+}
+
+bool ResultCache::operationKey(NodeOperation *operation, ResultCacheKey *r_key)
+{
+	OperationKeys::const_iterator it = g_operation_keys.find(operation);
+	if (it != g_operation_keys.end()) {
+		*r_key = it->second.second;
+		return it->second.first;
+	}
+
+	ResultCacheHash hash;
+	bool cacheable = operation_settings_hash(hash, operation);
+
+	/* the fused operations mirror their inputs, their order defines the links between them */
+	if (cacheable && operation->isFusedOperation()) {
+		const FusedPixelOperation::Operations &fused_ops = ((FusedPixelOperation *)operation)->getFusedOperations();
+		for (unsigned int index = 0; index < fused_ops.size() && cacheable; index++) {
+			cacheable = operation_settings_hash(hash, fused_ops[index]) && fused_ops[index]->hashCacheData(hash);
+		}
+	}
+
+	/* read buffers depend on the subgraph of their write buffer */
+	if (cacheable && operation->isReadBufferOperation()) {
+		ReadBufferOperation *readOperation = (ReadBufferOperation *)operation;
+		ResultCacheKey key;
+		cacheable = operationKey(readOperation->getMemoryProxy()->getWriteBufferOperation(), &key);
+		hash.addKey(key);
+	}
+
+	for (unsigned int index = 0; index < operation->getNumberOfInputSockets() && cacheable; index++) {
+		NodeOperationInput *input = operation->getInputSocket(index);
+		if (input->isConnected()) {
+			NodeOperationOutput *output = input->getLink();
+			ResultCacheKey key;
+			cacheable = operationKey(&output->getOperation(), &key);
+			hash.addKey(key);
+			hash.addInt(output_socket_index(output));
+		}
+		else {
+			hash.addInt(-1);
+		}
+	}
+
+	/* last, so buffers are only hashed when everything else can be cached */
+	if (cacheable) {
+		cacheable = operation->hashCacheData(hash);
+	}
+
+	*r_key = hash.end();
+	g_operation_keys[operation] = std::make_pair(cacheable, *r_key);
+	return cacheable;
+}
+
+bool ResultCache::groupKey(ExecutionGroup *group, ResultCacheKey *r_key)
+{
+	NodeOperation *operation = group->getOutputOperation();
+
+	/* only the expensive buffered results are cached, the other groups are cheap to calculate */
+	if (!group->isComplex() || !operation->isWriteBufferOperation()) {
+		return false;
+	}
+
+	ResultCacheKey key;
+	if (!operationKey(operation, &key)) {
+		return false;
+	}
+
+	ResultCacheHash hash;
+	hash.addKey(g_context_key);
+	hash.addKey(key);
+	*r_key = hash.end();
+	return true;
+}
+
+bool ResultCache::restore(ExecutionGroup *group, ResultCacheKey key)
+{
+	ResultCacheEntries::const_iterator it = g_entries.find(key);
+	MemoryBuffer *buffer = ((WriteBufferOperation *)group->getOutputOperation())->getMemoryProxy()->getBuffer();
+
+	if (it == g_entries.end()) {
+		g_misses++;
+		return false;
+	}
+
+	ResultCacheEntry *entry = it->second;
+	if (entry->width != (unsigned int)buffer->getWidth() ||
+	    entry->height != (unsigned int)buffer->getHeight() ||
+	    entry->num_channels != buffer->get_num_channels())
+	{
+		g_misses++;
+		return false;
+	}
+
+	memcpy(buffer->getBuffer(), entry->buffer, sizeof(float) * entry->width * entry->height * entry->num_channels);
+	buffer->setCreatedState();
+	group->setChunksExecuted();
+
+	MEM_CacheLimiter_touch(entry->handle);
+	g_hits++;
+	return true;
+}
+
+void ResultCache::store(ExecutionGroup *group, ResultCacheKey key)
+{
+	MemoryBuffer *buffer = ((WriteBufferOperation *)group->getOutputOperation())->getMemoryProxy()->getBuffer();
+
+	/* partial results, for example after a break, are not stored */
+	if (!group->isExecuted() || g_entries.find(key) != g_entries.end()) {
+		return;
+	}
+
+	ResultCacheEntry *entry = (ResultCacheEntry *)MEM_mallocN(sizeof(ResultCacheEntry), __func__);
+	entry->key = key;
+	entry->width = buffer->getWidth();
+	entry->height = buffer->getHeight();
+	entry->num_channels = buffer->get_num_channels();
+	entry->buffer = (float *)MEM_mallocN(sizeof(float) * entry->width * entry->height * entry->num_channels, __func__);
+	memcpy(entry->buffer, buffer->getBuffer(), sizeof(float) * entry->width * entry->height * entry->num_channels);
+	g_entries[key] = entry;
+
+	/* the new entry is referenced so it isn't freed right away */
+	entry->handle = MEM_CacheLimiter_insert(g_limiter, entry);
+	MEM_CacheLimiter_ref(entry->handle);
+	MEM_CacheLimiter_enforce_limits(g_limiter);
+	MEM_CacheLimiter_unref(entry->handle);
+}
+
+void ResultCache::endExecution(const bNodeTree *tree)
+{
+	size_t memory = g_limiter ? MEM_CacheLimiter_get_memory_in_use(g_limiter) : 0;
+
+	if (g_hits || g_misses) {
+		char buf[128];
+		BLI_snprintf(buf, sizeof(buf), "Compositing | Cached results %u/%u, %.1f MB",
+		             g_hits, g_hits + g_misses, (double)memory / (1024.0 * 1024.0));
+		tree->stats_draw(tree->sdh, buf);
+	}
+
+	if (G.debug & G_DEBUG) {
+		printf("Compositor result cache: %u hits, %u misses, %u results using %.1f MB\n",
+		       g_hits, g_misses, (unsigned int)g_entries.size(), (double)memory / (1024.0 * 1024.0));
+	}
+
+	g_operation_keys.clear();
+	g_buffer_keys.clear();
+}
+
+void ResultCache::free()
+{
+	while (!g_entries.empty()) {
+		ResultCacheEntry *entry = g_entries.begin()->second;
+		MEM_CacheLimiter_unmanage(entry->handle);
+		result_cache_entry_free(entry);
+	}
+
+	if (g_limiter) {
+		delete_MEM_CacheLimiter(g_limiter);
+		g_limiter = NULL;
+	}
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright 2015, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _COM_ResultCache_h
+#define _COM_ResultCache_h
+
+extern "C" {
+#include "BLI_hash_mm2a.h"
+}
+
+class CompositorContext;
+class ExecutionGroup;
+class MemoryBuffer;
+class NodeOperation;
+struct bNode;
+struct bNodeTree;
+
+/**
+ * @brief key of a cached result, a hash of everything the result depends on
+ */
+typedef uint64_t ResultCacheKey;
+
+/**
+ * @brief incremental hash used to build a ResultCacheKey
+ * @note two 32 bit murmur hashes with different seeds, so a collision is unlikely enough
+ * to use the key as the identity of a result.
+ */
+class ResultCacheHash {
+private:
+	BLI_HashMurmur2A m_low;
+	BLI_HashMurmur2A m_high;
+
+public:
+	ResultCacheHash();
+
+	void add(const void *data, size_t size);
+	void addInt(int value);
+	void addFloat(float value);
+	void addString(const char *str);
+	void addKey(ResultCacheKey key);
+
+	/**
+	 * @brief finish the hash, can only be called once
+	 */
+	ResultCacheKey end();
+};
+
+/**
+ * @brief cache of the results of complex ExecutionGroups between executions of the compositor
+ *
+ * When a node is edited the whole tree is converted and executed again, but most buffered results
+ * (defocus, vector blur, glare, ...) don't depend on the edited node. The buffer written by a complex
+ * ExecutionGroup is stored with a key that hashes the settings of every operation in the subgraph
+ * that calculates it, the data the input operations read and the CompositorContext.
+ * When an execution finds its key, the buffer is copied into the MemoryProxy and the group and its
+ * upstream groups are not executed.
+ *
+ * The memory of the cached buffers is managed by a MEM_CacheLimiter, so the cache stays within the
+ * memory cache limit of the user preferences, the least recently used results are freed first.
+ *
+ * Nodes are only cached when all data they use is part of the key, see ResultCache::nodeKey
+ * and NodeOperation.hashCacheData.
+ *
+ * @note Like the WorkScheduler this is a static class, executions are serialized by COM_execute.
+ * @ingroup execution
+ */
+class ResultCache {
+public:
+	/**
+	 * @brief the key of the settings of a node
+	 * @param node the node the operations are created for
+	 * @param context the context of the conversion, for data the node reads from the scene
+	 * @param r_key the key of the settings of the node
+	 * @return false when the result of the node depends on data outside of the node tree
+	 * that isn't part of the key, results depending on this node are not cached.
+	 */
+	static bool nodeKey(const bNode *node, const CompositorContext &context, ResultCacheKey *r_key);
+
+	/**
+	 * @brief the key of the contents of a buffer read by an input operation
+	 * @note keys are remembered during an execution, so buffers read by multiple operations are hashed once
+	 */
+	static ResultCacheKey bufferKey(const void *buffer, size_t size);
+
+	/**
+	 * @brief start using the cache for an execution
+	 * @note all operations need to be initialized, their data is part of the keys
+	 */
+	static void beginExecution(const CompositorContext &context);
+
+	/**
+	 * @brief the key of the result of an ExecutionGroup
+	 * @param group an initialized ExecutionGroup
+	 * @param r_key the key of the result
+	 * @return false when the result of the group can't be cached
+	 */
+	static bool groupKey(ExecutionGroup *group, ResultCacheKey *r_key);
+
+	/**
+	 * @brief copy the cached result of an ExecutionGroup into its MemoryProxy
+	 * @return true when the result was found, all chunks of the group are then executed
+	 */
+	static bool restore(ExecutionGroup *group, ResultCacheKey key);
+
+	/**
+	 * @brief store the result of an executed group for the next executions
+	 * @note the result is only stored when all chunks of the group have been executed
+	 */
+	static void store(ExecutionGroup *group, ResultCacheKey key);
+
+	/**
+	 * @brief finish the execution and report the cache statistics
+	 */
+	static void endExecution(const bNodeTree *tree);
+
+	/**
+	 * @brief free all cached results
+	 */
+	static void free();
+
+private:
+	/**
+	 * @brief the key of the output of an operation and all operations it depends on
+	 * @return false when the output can't be cached
+	 */
+	static bool operationKey(NodeOperation *operation, ResultCacheKey *r_key);
+};
+
+#endif
@@ -96,6 +96,22 @@ protected:
 	                                  float /*dx*/[2], float /*dy*/[2],
 	                                  PixelSampler /*sampler*/) {}
 
+	/**
+	 * @brief calculate a row of pixels
+	 * @note this method is called for non-complex, operations implement it to
+	 * process whole rows in a tight loop instead of one virtual call per pixel per input
+	 * @param output array of length * COM_NUM_CHANNELS_COLOR floats to store the result,
+	 * value and vector results only fill the first channels of each pixel
+	 * @param x the x-coordinate of the first pixel to calculate in image space
+	 * @param y the y-coordinate of the row to calculate in image space
+	 * @param length the number of pixels to calculate, at most COM_ROW_LENGTH
+	 */
+	virtual void executeRow(float *output, int x, int y, int length) {
+		for (int i = 0; i < length; i++) {
+			executePixelSampled(&output[i * COM_NUM_CHANNELS_COLOR], x + i, y, COM_PS_NEAREST);
+		}
+	}
+
 public:
 	inline void readSampled(float result[4], float x, float y, PixelSampler sampler) {
 		executePixelSampled(result, x, y, sampler);
@@ -106,6 +122,9 @@ public:
 	inline void readFiltered(float result[4], float x, float y, float dx[2], float dy[2], PixelSampler sampler) {
 		executePixelFiltered(result, x, y, dx, dy, sampler);
 	}
+	inline void readRow(float *result, int x, int y, int length) {
+		executeRow(result, x, y, length);
+	}
 
 	virtual void *initializeTileData(rcti * /*rect*/) { return 0; }
 	virtual void deinitializeTileData(rcti * /*rect*/, void * /*data*/) {}
@@ -30,10 +30,12 @@
 #include "COM_OpenCLKernels.cl.h"
 #include "clew.h"
 #include "COM_WriteBufferOperation.h"
+#include "COM_Debug.h"
 
 #include "MEM_guardedalloc.h"
 
 #include "PIL_time.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 
 #include "BKE_global.h"
@@ -59,6 +61,13 @@ static bool g_cpuInitialized = false;
 /// @brief all scheduled work for the cpu
 static ThreadQueue *g_cpuqueue;
 static ThreadQueue *g_gpuqueue;
+/// @brief signaled when a work package has been executed, see waitForProgress
+static ThreadMutex g_progressMutex;
+static ThreadCondition g_progressCondition;
+static unsigned int g_scheduledPackages;
+static unsigned int g_finishedPackages;
+/// @brief number of finished packages seen by the last waitForProgress
+static unsigned int g_progressPackages;
 #ifdef COM_OPENCL_ENABLED
 static cl_context g_context;
 static cl_program g_program;
@@ -151,6 +160,15 @@ int COM_isHighlightedbNode(bNode *bnode)
 } // end extern "C"
 
 #if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+static void work_package_finished(WorkPackage *work)
+{
+	BLI_mutex_lock(&g_progressMutex);
+	DebugInfo::execution_group_chunk_finished(work->getExecutionGroup());
+	g_finishedPackages++;
+	BLI_condition_notify_all(&g_progressCondition);
+	BLI_mutex_unlock(&g_progressMutex);
+}
+
 void *WorkScheduler::thread_execute_cpu(void *data)
 {
 	Device *device = (Device *)data;
@@ -159,6 +177,7 @@ void *WorkScheduler::thread_execute_cpu(void *data)
 	while ((work = (WorkPackage *)BLI_thread_queue_pop(g_cpuqueue))) {
 		HIGHLIGHT(work);
 		device->execute(work);
+		work_package_finished(work);
 		delete work;
 	}
 	
@@ -173,6 +192,7 @@ void *WorkScheduler::thread_execute_gpu(void *data)
 	while ((work = (WorkPackage *)BLI_thread_queue_pop(g_gpuqueue))) {
 		HIGHLIGHT(work);
 		device->execute(work);
+		work_package_finished(work);
 		delete work;
 	}
 	
@@ -188,8 +208,10 @@ void WorkScheduler::schedule(ExecutionGroup *group, int chunkNumber)
 #if COM_CURRENT_THREADING_MODEL == COM_TM_NOTHREAD
 	CPUDevice device;
 	device.execute(package);
+	DebugInfo::execution_group_chunk_finished(group);
 	delete package;
 #elif COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+	g_scheduledPackages++;
 #ifdef COM_OPENCL_ENABLED
 	if (group->isOpenCL() && g_openclActive) {
 		BLI_thread_queue_push(g_gpuqueue, package);
@@ -207,6 +229,11 @@ void WorkScheduler::start(CompositorContext &context)
 {
 #if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
 	unsigned int index;
+	BLI_mutex_init(&g_progressMutex);
+	BLI_condition_init(&g_progressCondition);
+	g_scheduledPackages = 0;
+	g_finishedPackages = 0;
+	g_progressPackages = 0;
 	g_cpuqueue = BLI_thread_queue_init();
 	BLI_init_threads(&g_cputhreads, thread_execute_cpu, g_cpudevices.size());
 	for (index = 0; index < g_cpudevices.size(); index++) {
@@ -245,6 +272,17 @@ void WorkScheduler::finish()
 #endif
 #endif
 }
+void WorkScheduler::waitForProgress()
+{
+#if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
+	BLI_mutex_lock(&g_progressMutex);
+	while (g_finishedPackages == g_progressPackages && g_finishedPackages != g_scheduledPackages) {
+		BLI_condition_wait(&g_progressCondition, &g_progressMutex);
+	}
+	g_progressPackages = g_finishedPackages;
+	BLI_mutex_unlock(&g_progressMutex);
+#endif
+}
 void WorkScheduler::stop()
 {
 #if COM_CURRENT_THREADING_MODEL == COM_TM_QUEUE
@@ -260,6 +298,8 @@ void WorkScheduler::stop()
 		g_gpuqueue = NULL;
 	}
 #endif
+	BLI_condition_end(&g_progressCondition);
+	BLI_mutex_end(&g_progressMutex);
 #endif
 }
 
@@ -276,6 +316,50 @@ bool WorkScheduler::hasGPUDevices()
 #endif
 }
 
+typedef struct ParallelRangeBlock {
+	WorkScheduler::RangeFunc func;
+	void *userdata;
+	int start;
+	int stop;
+} ParallelRangeBlock;
+
+static void parallel_range_block_execute(TaskPool *__restrict /*pool*/, void *taskdata, int /*threadid*/)
+{
+	ParallelRangeBlock *block = (ParallelRangeBlock *)taskdata;
+	block->func(block->userdata, block->start, block->stop);
+}
+
+void WorkScheduler::parallel_range(int start, int stop, void *userdata, RangeFunc func, int min_block_size)
+{
+	int num_threads = max_ii(1, (int)g_cpudevices.size());
+	int length = stop - start;
+
+	if (length <= 0)
+		return;
+
+	/* a few blocks per thread so uneven blocks are balanced */
+	int num_blocks = min_ii(num_threads * 4, length / max_ii(1, min_block_size));
+	if (num_threads == 1 || num_blocks <= 1) {
+		func(userdata, start, stop);
+		return;
+	}
+
+	TaskPool *pool = BLI_task_pool_create(BLI_task_scheduler_get(), userdata);
+	BLI_pool_set_num_threads(pool, num_threads);
+
+	for (int index = 0; index < num_blocks; index++) {
+		ParallelRangeBlock *block = (ParallelRangeBlock *)MEM_mallocN(sizeof(ParallelRangeBlock), __func__);
+		block->func = func;
+		block->userdata = userdata;
+		block->start = start + (int)(((long long)length * index) / num_blocks);
+		block->stop = start + (int)(((long long)length * (index + 1)) / num_blocks);
+		BLI_task_pool_push(pool, parallel_range_block_execute, block, true, TASK_PRIORITY_HIGH);
+	}
+
+	BLI_task_pool_work_and_wait(pool);
+	BLI_task_pool_free(pool);
+}
+
 static void CL_CALLBACK clContextError(const char *errinfo,
                                        const void * /*private_info*/,
                                        size_t /*cb*/,
@@ -105,6 +105,13 @@ public:
 	 */
 	static void finish();
 
+	/**
+	 * @brief wait until work has been completed since the previous call.
+	 * Returns immediately when no scheduled work is left.
+	 * @see ExecutionSystem.executeGroups
+	 */
+	static void waitForProgress();
+
 	/**
 	 * @brief Are there OpenCL capable GPU devices initialized?
 	 * the result of this method is stored in the CompositorContext
@@ -113,6 +120,27 @@ public:
 	 */
 	static bool hasGPUDevices();
 
+	/**
+	 * @brief callback of parallel_range, calculates the items [start, stop)
+	 */
+	typedef void (*RangeFunc)(void *userdata, int start, int stop);
+
+	/**
+	 * @brief calculate a range of independent items on the CPU threads of the compositor.
+	 *
+	 * Meant for operations that calculate the whole image at once (in initializeTileData), while
+	 * the other CPUDevices wait for the result. The range is split in consecutive blocks that are
+	 * calculated by the task scheduler, limited to the number of CPUDevices.
+	 * The calling thread calculates blocks as well and returns when all blocks are done.
+	 *
+	 * @param start first item of the range
+	 * @param stop end of the range (exclusive)
+	 * @param userdata passed to func
+	 * @param func called once for every block
+	 * @param min_block_size the minimum number of items in a block, small ranges are calculated on the calling thread
+	 */
+	static void parallel_range(int start, int stop, void *userdata, RangeFunc func, int min_block_size = 1);
+
 #ifdef WITH_CXX_GUARDEDALLOC
 	MEM_CXX_CLASS_ALLOC_FUNCS("COM:WorkScheduler")
 #endif
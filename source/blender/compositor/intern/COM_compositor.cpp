@@ -31,6 +31,7 @@ extern "C" {
 
 #include "COM_compositor.h"
 #include "COM_ExecutionSystem.h"
+#include "COM_ResultCache.h"
 #include "COM_WorkScheduler.h"
 #include "clew.h"
 #include "COM_MovieDistortionOperation.h"
@@ -41,6 +42,7 @@ static bool is_compositorMutex_init = false;
 static void intern_freeCompositorCaches()
 {
 	deintializeDistortionCache();
+	ResultCache::free();
 }
 
 void COM_execute(RenderData *rd, Scene *scene, bNodeTree *editingtree, int rendering,
@@ -21,8 +21,10 @@
  */
 
 #include "COM_CalculateMeanOperation.h"
+#include "COM_WorkScheduler.h"
 #include "BLI_math.h"
 #include "BLI_utildefines.h"
+#include "MEM_guardedalloc.h"
 
 extern "C" {
 #include "IMB_colormanagement.h"
@@ -86,47 +88,84 @@ void *CalculateMeanOperation::initializeTileData(rcti *rect)
 	return NULL;
 }
 
-void CalculateMeanOperation::calculateMean(MemoryBuffer *tile)
+typedef struct MeanSumData {
+	MemoryBuffer *tile;
+	int setting;
+	double *sums;
+	int *pixels;
+} MeanSumData;
+
+static void mean_sum_rows(void *userdata, int start, int stop)
 {
-	this->m_result = 0.0f;
-	float *buffer = tile->getBuffer();
-	int size = tile->getWidth() * tile->getHeight();
-	int pixels = 0;
-	float sum = 0.0f;
-	for (int i = 0, offset = 0; i < size; i++, offset += 4) {
-		if (buffer[offset + 3] > 0) {
-			pixels++;
-	
-			switch (this->m_setting) {
-				case 1:
-				{
-					sum += IMB_colormanagement_get_luminance(&buffer[offset]);
-					break;
-				}
-				case 2:
-				{
-					sum += buffer[offset];
-					break;
-				}
-				case 3:
-				{
-					sum += buffer[offset + 1];
-					break;
-				}
-				case 4:
-				{
-					sum += buffer[offset + 2];
-					break;
-				}
-				case 5:
-				{
-					float yuv[3];
-					rgb_to_yuv(buffer[offset], buffer[offset + 1], buffer[offset + 2], &yuv[0], &yuv[1], &yuv[2]);
-					sum += yuv[0];
-					break;
+	MeanSumData *data = (MeanSumData *)userdata;
+	int width = data->tile->getWidth();
+
+	for (int y = start; y < stop; y++) {
+		float *buffer = data->tile->getBuffer() + (size_t)y * width * COM_NUM_CHANNELS_COLOR;
+		int pixels = 0;
+		double sum = 0.0;
+		for (int x = 0, offset = 0; x < width; x++, offset += 4) {
+			if (buffer[offset + 3] > 0) {
+				pixels++;
+
+				switch (data->setting) {
+					case 1:
+					{
+						sum += IMB_colormanagement_get_luminance(&buffer[offset]);
+						break;
+					}
+					case 2:
+					{
+						sum += buffer[offset];
+						break;
+					}
+					case 3:
+					{
+						sum += buffer[offset + 1];
+						break;
+					}
+					case 4:
+					{
+						sum += buffer[offset + 2];
+						break;
+					}
+					case 5:
+					{
+						float yuv[3];
+						rgb_to_yuv(buffer[offset], buffer[offset + 1], buffer[offset + 2], &yuv[0], &yuv[1], &yuv[2]);
+						sum += yuv[0];
+						break;
+					}
 				}
 			}
 		}
+		data->sums[y] = sum;
+		data->pixels[y] = pixels;
 	}
+}
+
+void CalculateMeanOperation::calculateMean(MemoryBuffer *tile)
+{
+	this->m_result = 0.0f;
+	int height = tile->getHeight();
+	MeanSumData data;
+	data.tile = tile;
+	data.setting = this->m_setting;
+	data.sums = (double *)MEM_mallocN(sizeof(double) * height, __func__);
+	data.pixels = (int *)MEM_mallocN(sizeof(int) * height, __func__);
+
+	/* rows are summed in parallel and added in order, so the result doesn't depend on the threads,
+	 * summing in double keeps it within float precision of a single sequential sum */
+	WorkScheduler::parallel_range(0, height, &data, mean_sum_rows);
+
+	int pixels = 0;
+	double sum = 0.0;
+	for (int y = 0; y < height; y++) {
+		pixels += data.pixels[y];
+		sum += data.sums[y];
+	}
+	MEM_freeN(data.sums);
+	MEM_freeN(data.pixels);
+
 	this->m_result = sum / pixels;
 }
@@ -21,8 +21,10 @@
  */
 
 #include "COM_CalculateStandardDeviationOperation.h"
+#include "COM_WorkScheduler.h"
 #include "BLI_math.h"
 #include "BLI_utildefines.h"
+#include "MEM_guardedalloc.h"
 
 extern "C" {
 #include "IMB_colormanagement.h"
@@ -40,23 +42,29 @@ void CalculateStandardDeviationOperation::executePixel(float output[4],
 	output[0] = this->m_standardDeviation;
 }
 
-void *CalculateStandardDeviationOperation::initializeTileData(rcti *rect)
+typedef struct DeviationSumData {
+	MemoryBuffer *tile;
+	int setting;
+	float mean;
+	double *sums;
+	int *pixels;
+} DeviationSumData;
+
+static void deviation_sum_rows(void *userdata, int start, int stop)
 {
-	lockMutex();
-	if (!this->m_iscalculated) {
-		MemoryBuffer *tile = (MemoryBuffer *)this->m_imageReader->initializeTileData(rect);
-		CalculateMeanOperation::calculateMean(tile);
-		this->m_standardDeviation = 0.0f;
-		float *buffer = tile->getBuffer();
-		int size = tile->getWidth() * tile->getHeight();
+	DeviationSumData *data = (DeviationSumData *)userdata;
+	int width = data->tile->getWidth();
+	float mean = data->mean;
+
+	for (int y = start; y < stop; y++) {
+		float *buffer = data->tile->getBuffer() + (size_t)y * width * COM_NUM_CHANNELS_COLOR;
 		int pixels = 0;
-		float sum = 0.0f;
-		float mean = this->m_result;
-		for (int i = 0, offset = 0; i < size; i++, offset += 4) {
+		double sum = 0.0;
+		for (int x = 0, offset = 0; x < width; x++, offset += 4) {
 			if (buffer[offset + 3] > 0) {
 				pixels++;
-		
-				switch (this->m_setting) {
+
+				switch (data->setting) {
 					case 1:  /* rgb combined */
 					{
 						float value = IMB_colormanagement_get_luminance(&buffer[offset]);
@@ -94,7 +102,39 @@ void *CalculateStandardDeviationOperation::initializeTileData(rcti *rect)
 				}
 			}
 		}
-		this->m_standardDeviation = sqrt(sum / (float)(pixels - 1));
+		data->sums[y] = sum;
+		data->pixels[y] = pixels;
+	}
+}
+
+void *CalculateStandardDeviationOperation::initializeTileData(rcti *rect)
+{
+	lockMutex();
+	if (!this->m_iscalculated) {
+		MemoryBuffer *tile = (MemoryBuffer *)this->m_imageReader->initializeTileData(rect);
+		CalculateMeanOperation::calculateMean(tile);
+		this->m_standardDeviation = 0.0f;
+		int height = tile->getHeight();
+		DeviationSumData data;
+		data.tile = tile;
+		data.setting = this->m_setting;
+		data.mean = this->m_result;
+		data.sums = (double *)MEM_mallocN(sizeof(double) * height, __func__);
+		data.pixels = (int *)MEM_mallocN(sizeof(int) * height, __func__);
+
+		/* summed per row in double, so the result stays within float precision of a sequential sum */
+		WorkScheduler::parallel_range(0, height, &data, deviation_sum_rows);
+
+		int pixels = 0;
+		double sum = 0.0;
+		for (int y = 0; y < height; y++) {
+			pixels += data.pixels[y];
+			sum += data.sums[y];
+		}
+		MEM_freeN(data.sums);
+		MEM_freeN(data.pixels);
+
+		this->m_standardDeviation = sqrt(sum / (double)(pixels - 1));
 		this->m_iscalculated = true;
 	}
 	unlockMutex();
@@ -50,7 +50,23 @@ void ColorCorrectionOperation::executePixelSampled(float output[4], float x, flo
 	float inputMask[4];
 	this->m_inputImage->readSampled(inputImageColor, x, y, sampler);
 	this->m_inputMask->readSampled(inputMask, x, y, sampler);
-	
+
+	correctPixel(output, inputImageColor, inputMask[0]);
+}
+
+void ColorCorrectionOperation::transformRow(float *row, int x, int y, int length)
+{
+	float inputMask[COM_ROW_LENGTH * COM_NUM_CHANNELS_COLOR];
+	this->m_inputMask->readRow(inputMask, x, y, length);
+
+	for (int i = 0; i < length; i++) {
+		float *color = &row[i * COM_NUM_CHANNELS_COLOR];
+		correctPixel(color, color, inputMask[i * COM_NUM_CHANNELS_COLOR]);
+	}
+}
+
+void ColorCorrectionOperation::correctPixel(float output[4], const float inputImageColor[4], float maskValue)
+{
 	float level = (inputImageColor[0] + inputImageColor[1] + inputImageColor[2]) / 3.0f;
 	float contrast = this->m_data->master.contrast;
 	float saturation = this->m_data->master.saturation;
@@ -59,7 +75,7 @@ void ColorCorrectionOperation::executePixelSampled(float output[4], float x, flo
 	float lift = this->m_data->master.lift;
 	float r, g, b;
 	
-	float value = inputMask[0];
+	float value = maskValue;
 	value = min(1.0f, value);
 	const float mvalue = 1.0f - value;
 	
@@ -38,6 +38,9 @@ private:
 	bool m_greenChannelEnabled;
 	bool m_blueChannelEnabled;
 
+	/* output may be the same array as inputImageColor */
+	void correctPixel(float output[4], const float inputImageColor[4], float maskValue);
+
 public:
 	ColorCorrectionOperation();
 	
@@ -45,6 +48,8 @@ public:
 	 * the inner loop of this program
 	 */
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	int getTransformInputSocketIndex() const { return 0; }
+	void transformRow(float *row, int x, int y, int length);
 	
 	/**
 	 * Initialize the execution
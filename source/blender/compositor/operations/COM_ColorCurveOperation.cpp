@@ -96,6 +96,41 @@ void ColorCurveOperation::executePixelSampled(float output[4], float x, float y,
 	output[3] = image[3];
 }
 
+void ColorCurveOperation::transformRow(float *row, int x, int y, int length)
+{
+	CurveMapping *cumap = this->m_curveMapping;
+
+	float fac[COM_ROW_LENGTH * COM_NUM_CHANNELS_COLOR];
+	float black[COM_ROW_LENGTH * COM_NUM_CHANNELS_COLOR];
+	float white[COM_ROW_LENGTH * COM_NUM_CHANNELS_COLOR];
+	float bwmul[3];
+
+	this->m_inputBlackProgram->readRow(black, x, y, length);
+	this->m_inputWhiteProgram->readRow(white, x, y, length);
+	this->m_inputFacProgram->readRow(fac, x, y, length);
+
+	for (int i = 0; i < length; i++) {
+		const int offset = i * COM_NUM_CHANNELS_COLOR;
+		const float f = fac[offset];
+		float *image = &row[offset];
+
+		if (f <= 0.0f) {
+			continue;
+		}
+
+		curvemapping_set_black_white_ex(&black[offset], &white[offset], bwmul);
+
+		float col[3];
+		curvemapping_evaluate_premulRGBF_ex(cumap, col, image, &black[offset], bwmul);
+		if (f >= 1.0f) {
+			copy_v3_v3(image, col);
+		}
+		else {
+			interp_v3_v3v3(image, image, col, f);
+		}
+	}
+}
+
 void ColorCurveOperation::deinitExecution()
 {
 	CurveBaseOperation::deinitExecution();
@@ -152,6 +187,31 @@ void ConstantLevelColorCurveOperation::executePixelSampled(float output[4], floa
 	output[3] = image[3];
 }
 
+void ConstantLevelColorCurveOperation::transformRow(float *row, int x, int y, int length)
+{
+	float fac[COM_ROW_LENGTH * COM_NUM_CHANNELS_COLOR];
+
+	this->m_inputFacProgram->readRow(fac, x, y, length);
+
+	for (int i = 0; i < length; i++) {
+		const float f = fac[i * COM_NUM_CHANNELS_COLOR];
+		float *image = &row[i * COM_NUM_CHANNELS_COLOR];
+
+		if (f <= 0.0f) {
+			continue;
+		}
+
+		float col[3];
+		curvemapping_evaluate_premulRGBF(this->m_curveMapping, col, image);
+		if (f >= 1.0f) {
+			copy_v3_v3(image, col);
+		}
+		else {
+			interp_v3_v3v3(image, image, col, f);
+		}
+	}
+}
+
 void ConstantLevelColorCurveOperation::deinitExecution()
 {
 	CurveBaseOperation::deinitExecution();
@@ -42,6 +42,8 @@ public:
 	 * the inner loop of this program
 	 */
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	int getTransformInputSocketIndex() const { return 1; }
+	void transformRow(float *row, int x, int y, int length);
 	
 	/**
 	 * Initialize the execution
@@ -71,6 +73,8 @@ public:
 	 * the inner loop of this program
 	 */
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	int getTransformInputSocketIndex() const { return 1; }
+	void transformRow(float *row, int x, int y, int length);
 	
 	/**
 	 * Initialize the execution
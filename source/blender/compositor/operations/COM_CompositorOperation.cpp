@@ -130,7 +130,7 @@ void CompositorOperation::deinitExecution()
 
 void CompositorOperation::executeRegion(rcti *rect, unsigned int /*tileNumber*/)
 {
-	float color[8]; // 7 is enough
+	float row[COM_ROW_LENGTH * COM_NUM_CHANNELS_COLOR];
 	float *buffer = this->m_outputBuffer;
 	float *zbuffer = this->m_depthBuffer;
 
@@ -187,23 +187,28 @@ void CompositorOperation::executeRegion(rcti *rect, unsigned int /*tileNumber*/)
 #endif
 
 	for (y = y1; y < y2 && (!breaked); y++) {
-		for (x = x1; x < x2 && (!breaked); x++) {
+		for (x = x1; x < x2; x += COM_ROW_LENGTH) {
+			const int length = min(x2 - x, COM_ROW_LENGTH);
 			int input_x = x + dx, input_y = y + dy;
+			int i;
 
-			this->m_imageInput->readSampled(color, input_x, input_y, COM_PS_NEAREST);
+			this->m_imageInput->readRow(buffer + offset4, input_x, input_y, length);
 			if (this->m_useAlphaInput) {
-				this->m_alphaInput->readSampled(&(color[3]), input_x, input_y, COM_PS_NEAREST);
+				this->m_alphaInput->readRow(row, input_x, input_y, length);
+				for (i = 0; i < length; i++) {
+					buffer[offset4 + i * COM_NUM_CHANNELS_COLOR + 3] = row[i * COM_NUM_CHANNELS_COLOR];
+				}
 			}
 
-			copy_v4_v4(buffer + offset4, color);
-
-			this->m_depthInput->readSampled(color, input_x, input_y, COM_PS_NEAREST);
-			zbuffer[offset] = color[0];
-			offset4 += COM_NUM_CHANNELS_COLOR;
-			offset++;
-			if (isBreaked()) {
-				breaked = true;
+			this->m_depthInput->readRow(row, input_x, input_y, length);
+			for (i = 0; i < length; i++) {
+				zbuffer[offset + i] = row[i * COM_NUM_CHANNELS_COLOR];
 			}
+			offset4 += length * COM_NUM_CHANNELS_COLOR;
+			offset += length;
+		}
+		if (isBreaked()) {
+			breaked = true;
 		}
 		offset += add;
 		offset4 += add * COM_NUM_CHANNELS_COLOR;
@@ -58,6 +58,15 @@ void ConvertValueToColorOperation::executePixelSampled(float output[4], float x,
 	output[3] = 1.0f;
 }
 
+void ConvertValueToColorOperation::transformRow(float *row, int /*x*/, int /*y*/, int length)
+{
+	for (int i = 0; i < length; i++) {
+		float *out = &row[i * COM_NUM_CHANNELS_COLOR];
+		out[1] = out[2] = out[0];
+		out[3] = 1.0f;
+	}
+}
+
 
 /* ******** Color to Value ******** */
 
@@ -74,6 +83,14 @@ void ConvertColorToValueOperation::executePixelSampled(float output[4], float x,
 	output[0] = (inputColor[0] + inputColor[1] + inputColor[2]) / 3.0f;
 }
 
+void ConvertColorToValueOperation::transformRow(float *row, int /*x*/, int /*y*/, int length)
+{
+	for (int i = 0; i < length; i++) {
+		float *out = &row[i * COM_NUM_CHANNELS_COLOR];
+		out[0] = (out[0] + out[1] + out[2]) / 3.0f;
+	}
+}
+
 
 /* ******** Color to BW ******** */
 
@@ -90,6 +107,14 @@ void ConvertColorToBWOperation::executePixelSampled(float output[4], float x, fl
 	output[0] = IMB_colormanagement_get_luminance(inputColor);
 }
 
+void ConvertColorToBWOperation::transformRow(float *row, int /*x*/, int /*y*/, int length)
+{
+	for (int i = 0; i < length; i++) {
+		float *out = &row[i * COM_NUM_CHANNELS_COLOR];
+		out[0] = IMB_colormanagement_get_luminance(out);
+	}
+}
+
 
 /* ******** Color to Vector ******** */
 
@@ -105,6 +130,11 @@ void ConvertColorToVectorOperation::executePixelSampled(float output[4], float x
 	this->m_inputOperation->readSampled(color, x, y, sampler);
 	copy_v3_v3(output, color);}
 
+void ConvertColorToVectorOperation::transformRow(float * /*row*/, int /*x*/, int /*y*/, int /*length*/)
+{
+	/* the color is used as is, the vector ignores alpha */
+}
+
 
 /* ******** Value to Vector ******** */
 
@@ -121,6 +151,14 @@ void ConvertValueToVectorOperation::executePixelSampled(float output[4], float x
 	output[0] = output[1] = output[2] = value;
 }
 
+void ConvertValueToVectorOperation::transformRow(float *row, int /*x*/, int /*y*/, int length)
+{
+	for (int i = 0; i < length; i++) {
+		float *out = &row[i * COM_NUM_CHANNELS_COLOR];
+		out[1] = out[2] = out[0];
+	}
+}
+
 
 /* ******** Vector to Color ******** */
 
@@ -136,6 +174,13 @@ void ConvertVectorToColorOperation::executePixelSampled(float output[4], float x
 	output[3] = 1.0f;
 }
 
+void ConvertVectorToColorOperation::transformRow(float *row, int /*x*/, int /*y*/, int length)
+{
+	for (int i = 0; i < length; i++) {
+		row[i * COM_NUM_CHANNELS_COLOR + 3] = 1.0f;
+	}
+}
+
 
 /* ******** Vector to Value ******** */
 
@@ -152,6 +197,14 @@ void ConvertVectorToValueOperation::executePixelSampled(float output[4], float x
 	output[0] = (input[0] + input[1] + input[2]) / 3.0f;
 }
 
+void ConvertVectorToValueOperation::transformRow(float *row, int /*x*/, int /*y*/, int length)
+{
+	for (int i = 0; i < length; i++) {
+		float *out = &row[i * COM_NUM_CHANNELS_COLOR];
+		out[0] = (out[0] + out[1] + out[2]) / 3.0f;
+	}
+}
+
 
 /* ******** RGB to YCC ******** */
 
@@ -327,6 +380,20 @@ void ConvertPremulToStraightOperation::executePixelSampled(float output[4], floa
 	output[3] = alpha;
 }
 
+void ConvertPremulToStraightOperation::transformRow(float *row, int /*x*/, int /*y*/, int length)
+{
+	for (int i = 0; i < length; i++) {
+		float *out = &row[i * COM_NUM_CHANNELS_COLOR];
+		const float alpha = out[3];
+		if (fabsf(alpha) < 1e-5f) {
+			zero_v3(out);
+		}
+		else {
+			mul_v3_fl(out, 1.0f / alpha);
+		}
+	}
+}
+
 
 /* ******** Straight to Premul ******** */
 
@@ -350,6 +417,14 @@ void ConvertStraightToPremulOperation::executePixelSampled(float output[4], floa
 	output[3] = alpha;
 }
 
+void ConvertStraightToPremulOperation::transformRow(float *row, int /*x*/, int /*y*/, int length)
+{
+	for (int i = 0; i < length; i++) {
+		float *out = &row[i * COM_NUM_CHANNELS_COLOR];
+		mul_v3_fl(out, out[3]);
+	}
+}
+
 
 /* ******** Separate Channels ******** */
 
@@ -43,6 +43,8 @@ public:
 	ConvertValueToColorOperation();
 	
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	int getTransformInputSocketIndex() const { return 0; }
+	void transformRow(float *row, int x, int y, int length);
 };
 
 
@@ -51,6 +53,8 @@ public:
 	ConvertColorToValueOperation();
 	
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	int getTransformInputSocketIndex() const { return 0; }
+	void transformRow(float *row, int x, int y, int length);
 };
 
 
@@ -59,6 +63,8 @@ public:
 	ConvertColorToBWOperation();
 	
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	int getTransformInputSocketIndex() const { return 0; }
+	void transformRow(float *row, int x, int y, int length);
 };
 
 
@@ -67,6 +73,8 @@ public:
 	ConvertColorToVectorOperation();
 	
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	int getTransformInputSocketIndex() const { return 0; }
+	void transformRow(float *row, int x, int y, int length);
 };
 
 
@@ -75,6 +83,8 @@ public:
 	ConvertValueToVectorOperation();
 	
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	int getTransformInputSocketIndex() const { return 0; }
+	void transformRow(float *row, int x, int y, int length);
 };
 
 
@@ -83,6 +93,8 @@ public:
 	ConvertVectorToColorOperation();
 	
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	int getTransformInputSocketIndex() const { return 0; }
+	void transformRow(float *row, int x, int y, int length);
 };
 
 
@@ -91,6 +103,8 @@ public:
 	ConvertVectorToValueOperation();
 	
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	int getTransformInputSocketIndex() const { return 0; }
+	void transformRow(float *row, int x, int y, int length);
 };
 
 
@@ -159,6 +173,8 @@ public:
 	ConvertPremulToStraightOperation();
 
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	int getTransformInputSocketIndex() const { return 0; }
+	void transformRow(float *row, int x, int y, int length);
 };
 
 
@@ -167,6 +183,8 @@ public:
 	ConvertStraightToPremulOperation();
 
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	int getTransformInputSocketIndex() const { return 0; }
+	void transformRow(float *row, int x, int y, int length);
 };
 
 
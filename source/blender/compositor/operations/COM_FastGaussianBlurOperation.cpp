@@ -23,6 +23,7 @@
 #include <limits.h>
 
 #include "COM_FastGaussianBlurOperation.h"
+#include "COM_WorkScheduler.h"
 #include "MEM_guardedalloc.h"
 #include "BLI_utildefines.h"
 
@@ -111,23 +112,123 @@ void *FastGaussianBlurOperation::initializeTileData(rcti *rect)
 	return this->m_iirgaus;
 }
 
-void FastGaussianBlurOperation::IIR_gauss(MemoryBuffer *src, float sigma, unsigned int chan, unsigned int xy)
+#define YVV(L)                                                                          \
+{                                                                                       \
+	W[0] = cf[0] * X[0] + cf[1] * X[0] + cf[2] * X[0] + cf[3] * X[0];                   \
+	W[1] = cf[0] * X[1] + cf[1] * W[0] + cf[2] * X[0] + cf[3] * X[0];                   \
+	W[2] = cf[0] * X[2] + cf[1] * W[1] + cf[2] * W[0] + cf[3] * X[0];                   \
+	for (i = 3; i < L; i++) {                                                           \
+		W[i] = cf[0] * X[i] + cf[1] * W[i - 1] + cf[2] * W[i - 2] + cf[3] * W[i - 3];   \
+	}                                                                                   \
+	tsu[0] = W[L - 1] - X[L - 1];                                                       \
+	tsu[1] = W[L - 2] - X[L - 1];                                                       \
+	tsu[2] = W[L - 3] - X[L - 1];                                                       \
+	tsv[0] = tsM[0] * tsu[0] + tsM[1] * tsu[1] + tsM[2] * tsu[2] + X[L - 1];            \
+	tsv[1] = tsM[3] * tsu[0] + tsM[4] * tsu[1] + tsM[5] * tsu[2] + X[L - 1];            \
+	tsv[2] = tsM[6] * tsu[0] + tsM[7] * tsu[1] + tsM[8] * tsu[2] + X[L - 1];            \
+	Y[L - 1] = cf[0] * W[L - 1] + cf[1] * tsv[0] + cf[2] * tsv[1] + cf[3] * tsv[2];     \
+	Y[L - 2] = cf[0] * W[L - 2] + cf[1] * Y[L - 1] + cf[2] * tsv[0] + cf[3] * tsv[1];   \
+	Y[L - 3] = cf[0] * W[L - 3] + cf[1] * Y[L - 2] + cf[2] * Y[L - 1] + cf[3] * tsv[0]; \
+	/* 'i != UINT_MAX' is really 'i >= 0', but necessary for unsigned int wrapping */   \
+	for (i = L - 4; i != UINT_MAX; i--) {                                               \
+		Y[i] = cf[0] * W[i] + cf[1] * Y[i + 1] + cf[2] * Y[i + 2] + cf[3] * Y[i + 3];   \
+	}                                                                                   \
+} (void)0
+
+/* filter coefficients and buffer shared by the threads filtering the lines of one channel */
+typedef struct IIRGaussData {
+	double cf[4], tsM[9];
+	float *buffer;
+	unsigned int width, height;
+	unsigned int num_channels;
+	unsigned int chan;
+} IIRGaussData;
+
+/* lines are filtered independently, every block of lines has its own intermediate buffers */
+static void IIR_gauss_rows(void *userdata, int start, int stop)
 {
-	double q, q2, sc, cf[4], tsM[9], tsu[3], tsv[3];
+	IIRGaussData *data = (IIRGaussData *)userdata;
+	const double *cf = data->cf, *tsM = data->tsM;
+	double tsu[3], tsv[3];
 	double *X, *Y, *W;
+	const unsigned int src_width = data->width;
+	const unsigned int num_channels = data->num_channels;
+	float *buffer = data->buffer;
+	unsigned int x, i;
+	int offset;
+
+	X = (double *)MEM_callocN(src_width * sizeof(double), "IIR_gauss X buf");
+	Y = (double *)MEM_callocN(src_width * sizeof(double), "IIR_gauss Y buf");
+	W = (double *)MEM_callocN(src_width * sizeof(double), "IIR_gauss W buf");
+	for (int y = start; y < stop; ++y) {
+		const int yx = y * src_width;
+		offset = yx * num_channels + data->chan;
+		for (x = 0; x < src_width; ++x) {
+			X[x] = buffer[offset];
+			offset += num_channels;
+		}
+		YVV(src_width);
+		offset = yx * num_channels + data->chan;
+		for (x = 0; x < src_width; ++x) {
+			buffer[offset] = Y[x];
+			offset += num_channels;
+		}
+	}
+	MEM_freeN(X);
+	MEM_freeN(W);
+	MEM_freeN(Y);
+}
+
+static void IIR_gauss_columns(void *userdata, int start, int stop)
+{
+	IIRGaussData *data = (IIRGaussData *)userdata;
+	const double *cf = data->cf, *tsM = data->tsM;
+	double tsu[3], tsv[3];
+	double *X, *Y, *W;
+	const unsigned int src_height = data->height;
+	const unsigned int num_channels = data->num_channels;
+	float *buffer = data->buffer;
+	unsigned int y, i;
+	int offset;
+	const int add = data->width * num_channels;
+
+	X = (double *)MEM_callocN(src_height * sizeof(double), "IIR_gauss X buf");
+	Y = (double *)MEM_callocN(src_height * sizeof(double), "IIR_gauss Y buf");
+	W = (double *)MEM_callocN(src_height * sizeof(double), "IIR_gauss W buf");
+	for (int x = start; x < stop; ++x) {
+		offset = x * num_channels + data->chan;
+		for (y = 0; y < src_height; ++y) {
+			X[y] = buffer[offset];
+			offset += add;
+		}
+		YVV(src_height);
+		offset = x * num_channels + data->chan;
+		for (y = 0; y < src_height; ++y) {
+			buffer[offset] = Y[y];
+			offset += add;
+		}
+	}
+	MEM_freeN(X);
+	MEM_freeN(W);
+	MEM_freeN(Y);
+}
+
+#undef YVV
+
+void FastGaussianBlurOperation::IIR_gauss(MemoryBuffer *src, float sigma, unsigned int chan, unsigned int xy)
+{
+	IIRGaussData data;
+	double q, q2, sc;
+	double *cf = data.cf, *tsM = data.tsM;
 	const unsigned int src_width = src->getWidth();
 	const unsigned int src_height = src->getHeight();
-	unsigned int x, y, sz;
-	unsigned int i;
-	float *buffer = src->getBuffer();
-	const unsigned int num_channels = src->get_num_channels();
 	
 	// <0.5 not valid, though can have a possibly useful sort of sharpening effect
 	if (sigma < 0.5f) return;
 	
 	if ((xy < 1) || (xy > 3)) xy = 3;
 	
-	// XXX The YVV macro defined below explicitly expects sources of at least 3x3 pixels,
+	// XXX The YVV macro defined above explicitly expects sources of at least 3x3 pixels,
 	//     so just skiping blur along faulty direction if src's def is below that limit!
 	if (src_width < 3) xy &= ~1;
 	if (src_height < 3) xy &= ~2;
@@ -167,75 +268,18 @@ void FastGaussianBlurOperation::IIR_gauss(MemoryBuffer *src, float sigma, unsign
 	tsM[7] = sc * (cf[1] * cf[2] + cf[3] * cf[2] * cf[2] - cf[1] * cf[3] * cf[3] - cf[3] * cf[3] * cf[3] - cf[3] * cf[2] + cf[3]);
 	tsM[8] = sc * (cf[3] * (cf[1] + cf[3] * cf[2]));
 	
-#define YVV(L)                                                                          \
-{                                                                                       \
-	W[0] = cf[0] * X[0] + cf[1] * X[0] + cf[2] * X[0] + cf[3] * X[0];                   \
-	W[1] = cf[0] * X[1] + cf[1] * W[0] + cf[2] * X[0] + cf[3] * X[0];                   \
-	W[2] = cf[0] * X[2] + cf[1] * W[1] + cf[2] * W[0] + cf[3] * X[0];                   \
-	for (i = 3; i < L; i++) {                                                           \
-		W[i] = cf[0] * X[i] + cf[1] * W[i - 1] + cf[2] * W[i - 2] + cf[3] * W[i - 3];   \
-	}                                                                                   \
-	tsu[0] = W[L - 1] - X[L - 1];                                                       \
-	tsu[1] = W[L - 2] - X[L - 1];                                                       \
-	tsu[2] = W[L - 3] - X[L - 1];                                                       \
-	tsv[0] = tsM[0] * tsu[0] + tsM[1] * tsu[1] + tsM[2] * tsu[2] + X[L - 1];            \
-	tsv[1] = tsM[3] * tsu[0] + tsM[4] * tsu[1] + tsM[5] * tsu[2] + X[L - 1];            \
-	tsv[2] = tsM[6] * tsu[0] + tsM[7] * tsu[1] + tsM[8] * tsu[2] + X[L - 1];            \
-	Y[L - 1] = cf[0] * W[L - 1] + cf[1] * tsv[0] + cf[2] * tsv[1] + cf[3] * tsv[2];     \
-	Y[L - 2] = cf[0] * W[L - 2] + cf[1] * Y[L - 1] + cf[2] * tsv[0] + cf[3] * tsv[1];   \
-	Y[L - 3] = cf[0] * W[L - 3] + cf[1] * Y[L - 2] + cf[2] * Y[L - 1] + cf[3] * tsv[0]; \
-	/* 'i != UINT_MAX' is really 'i >= 0', but necessary for unsigned int wrapping */   \
-	for (i = L - 4; i != UINT_MAX; i--) {                                               \
-		Y[i] = cf[0] * W[i] + cf[1] * Y[i + 1] + cf[2] * Y[i + 2] + cf[3] * Y[i + 3];   \
-	}                                                                                   \
-} (void)0
-	
-	// intermediate buffers
-	sz = max(src_width, src_height);
-	X = (double *)MEM_callocN(sz * sizeof(double), "IIR_gauss X buf");
-	Y = (double *)MEM_callocN(sz * sizeof(double), "IIR_gauss Y buf");
-	W = (double *)MEM_callocN(sz * sizeof(double), "IIR_gauss W buf");
+	data.buffer = src->getBuffer();
+	data.width = src_width;
+	data.height = src_height;
+	data.num_channels = src->get_num_channels();
+	data.chan = chan;
+
 	if (xy & 1) {   // H
-		int offset;
-		for (y = 0; y < src_height; ++y) {
-			const int yx = y * src_width;
-			offset = yx * num_channels + chan;
-			for (x = 0; x < src_width; ++x) {
-				X[x] = buffer[offset];
-				offset += num_channels;
-			}
-			YVV(src_width);
-			offset = yx * num_channels + chan;
-			for (x = 0; x < src_width; ++x) {
-				buffer[offset] = Y[x];
-				offset += num_channels;
-			}
-		}
+		WorkScheduler::parallel_range(0, src_height, &data, IIR_gauss_rows, 16);
 	}
 	if (xy & 2) {   // V
-		int offset;
-		const int add = src_width * num_channels;
-
-		for (x = 0; x < src_width; ++x) {
-			offset = x * num_channels + chan;
-			for (y = 0; y < src_height; ++y) {
-				X[y] = buffer[offset];
-				offset += add;
-			}
-			YVV(src_height);
-			offset = x * num_channels + chan;
-			for (y = 0; y < src_height; ++y) {
-				buffer[offset] = Y[y];
-				offset += add;
-			}
-		}
+		WorkScheduler::parallel_range(0, src_width, &data, IIR_gauss_columns, 16);
 	}
-	
-	MEM_freeN(X);
-	MEM_freeN(W);
-	MEM_freeN(Y);
-#undef YVV
-	
 }
 
 
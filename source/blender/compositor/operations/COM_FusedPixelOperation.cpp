@@ -0,0 +1,82 @@
+/*
+ * Copyright 2015, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "COM_FusedPixelOperation.h"
+
+FusedPixelOperation::FusedPixelOperation(const Operations &operations) : NodeOperation()
+{
+	this->m_operations = operations;
+
+	for (unsigned int index = 0; index < operations.size(); index++) {
+		NodeOperation *operation = operations[index];
+		/* the transform input of all but the first operation is the operation before it */
+		int skip = (index == 0) ? -1 : operation->getTransformInputSocketIndex();
+
+		for (unsigned int i = 0; i < operation->getNumberOfInputSockets(); i++) {
+			if ((int)i == skip)
+				continue;
+
+			NodeOperationInput *input = operation->getInputSocket(i);
+			this->addInputSocket(input->getDataType(), input->getResizeMode());
+			this->m_fusedInputs.push_back(input);
+		}
+	}
+
+	NodeOperation *last = operations.back();
+	this->addOutputSocket(last->getOutputSocket()->getDataType());
+
+	unsigned int resolution[2] = {last->getWidth(), last->getHeight()};
+	this->setResolution(resolution);
+}
+
+FusedPixelOperation::~FusedPixelOperation()
+{
+	for (unsigned int index = 0; index < this->m_operations.size(); index++) {
+		delete this->m_operations[index];
+	}
+	this->m_operations.clear();
+}
+
+void FusedPixelOperation::initExecution()
+{
+	for (unsigned int index = 0; index < this->m_operations.size(); index++) {
+		this->m_operations[index]->initExecution();
+	}
+}
+
+void FusedPixelOperation::deinitExecution()
+{
+	for (unsigned int index = 0; index < this->m_operations.size(); index++) {
+		this->m_operations[index]->deinitExecution();
+	}
+}
+
+void FusedPixelOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
+{
+	/* single pixels are pulled through the links between the fused operations */
+	this->m_operations.back()->readSampled(output, x, y, sampler);
+}
+
+void FusedPixelOperation::executeRow(float *output, int x, int y, int length)
+{
+	this->m_operations.front()->readRow(output, x, y, length);
+
+	for (unsigned int index = 1; index < this->m_operations.size(); index++) {
+		this->m_operations[index]->transformRow(output, x, y, length);
+	}
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2015, Blender Foundation.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _COM_FusedPixelOperation_h_
+#define _COM_FusedPixelOperation_h_
+
+#include "COM_NodeOperation.h"
+
+/**
+ * @brief a linear chain of per-pixel operations executed as a single operation
+ *
+ * Each operation after the first one transforms the output of the operation before it,
+ * see NodeOperation.getTransformInputSocketIndex. A row is calculated by the first operation
+ * and then transformed in place by the others, instead of every operation pulling its input.
+ *
+ * The fused operations keep their links to each other and to their other inputs,
+ * so they still read those inputs themselves. The other inputs are mirrored as inputs of
+ * this operation, so the graph around it (groups, areas of interest) stays the same.
+ *
+ * @see NodeOperationBuilder.fuse_pixel_operations
+ */
+class FusedPixelOperation : public NodeOperation {
+public:
+	typedef std::vector<NodeOperation *> Operations;
+
+private:
+	/**
+	 * @brief the fused operations in execution order, owned by this operation
+	 */
+	Operations m_operations;
+
+	/**
+	 * @brief input sockets of the fused operations, in the order of the input sockets of this operation
+	 */
+	std::vector<NodeOperationInput *> m_fusedInputs;
+
+public:
+	FusedPixelOperation(const Operations &operations);
+	~FusedPixelOperation();
+
+	const Operations &getFusedOperations() const { return this->m_operations; }
+
+	/**
+	 * @brief the input socket of a fused operation that is mirrored by an input socket of this operation
+	 */
+	NodeOperationInput *getFusedInputSocket(unsigned int index) const { return this->m_fusedInputs[index]; }
+
+	bool isFusedOperation() const { return true; }
+
+	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+
+	void initExecution();
+	void deinitExecution();
+
+protected:
+	void executeRow(float *output, int x, int y, int length);
+};
+
+#endif
@@ -21,6 +21,7 @@
  */
 
 #include "COM_GlareFogGlowOperation.h"
+#include "COM_WorkScheduler.h"
 #include "MEM_guardedalloc.h"
 
 /*
@@ -119,6 +120,19 @@ static void FHT(fREAL *data, unsigned int M, unsigned int inverse)
 	}
 }
 //------------------------------------------------------------------------------
+typedef struct FHTRowsData {
+	fREAL *data;
+	unsigned int Nx, Mx, inverse;
+} FHTRowsData;
+
+// rows are transformed independently, so they can be done in parallel
+static void FHT_rows(void *userdata, int start, int stop)
+{
+	FHTRowsData *rows = (FHTRowsData *)userdata;
+	for (int j = start; j < stop; ++j)
+		FHT(&rows->data[rows->Nx * j], rows->Mx, rows->inverse);
+}
+//------------------------------------------------------------------------------
 /* 2D Fast Hartley Transform, Mx/My -> log2 of width/height,
  * nzp -> the row where zero pad data starts,
  * inverse -> see above */
@@ -127,14 +141,18 @@ static void FHT2D(fREAL *data, unsigned int Mx, unsigned int My,
 {
 	unsigned int i, j, Nx, Ny, maxy;
 	fREAL t;
+	FHTRowsData rows;
 
 	Nx = 1 << Mx;
 	Ny = 1 << My;
 
 	// rows (forward transform skips 0 pad data)
 	maxy = inverse ? Ny : nzp;
-	for (j = 0; j < maxy; ++j)
-		FHT(&data[Nx * j], Mx, inverse);
+	rows.data = data;
+	rows.Nx = Nx;
+	rows.Mx = Mx;
+	rows.inverse = inverse;
+	WorkScheduler::parallel_range(0, maxy, &rows, FHT_rows, 4);
 
 	// transpose data
 	if (Nx == Ny) {  // square
@@ -162,8 +180,9 @@ static void FHT2D(fREAL *data, unsigned int Mx, unsigned int My,
 	i = Mx, Mx = My, My = i;
 
 	// now columns == transposed rows
-	for (j = 0; j < Ny; ++j)
-		FHT(&data[Nx * j], Mx, inverse);
+	rows.Nx = Nx;
+	rows.Mx = Mx;
+	WorkScheduler::parallel_range(0, Ny, &rows, FHT_rows, 4);
 
 	// finalize
 	for (j = 0; j <= (Ny >> 1); j++) {
@@ -23,6 +23,7 @@
 #include "COM_GlareGhostOperation.h"
 #include "BLI_math.h"
 #include "COM_FastGaussianBlurOperation.h"
+#include "COM_WorkScheduler.h"
 
 static float smoothMask(float x, float y)
 {
@@ -37,13 +38,77 @@ static float smoothMask(float x, float y)
 	}
 }
 
+typedef struct GhostData {
+	NodeOperation *operation;
+	MemoryBuffer *gbuf, *tbuf1, *tbuf2;
+	const fRGB *cm;
+	const float *scalef;
+	int n;
+} GhostData;
+
+/* the ghost buffer from the two blurred images, every row only writes its own pixels,
+ * rows stop when the operation is breaked and the caller checks isBreaked() afterwards */
+static void ghost_base_rows(void *userdata, int start, int stop)
+{
+	GhostData *ghost = (GhostData *)userdata;
+	MemoryBuffer *gbuf = ghost->gbuf;
+	fRGB c, tc;
+	float u, v, sm, s, t;
+	const float sc = 2.13f, isc = -0.97f;
+
+	for (int y = start; y < stop && (!ghost->operation->isBreaked()); y++) {
+		v = ((float)y + 0.5f) / (float)gbuf->getHeight();
+		for (int x = 0; x < gbuf->getWidth(); x++) {
+			u = ((float)x + 0.5f) / (float)gbuf->getWidth();
+			s = (u - 0.5f) * sc + 0.5f, t = (v - 0.5f) * sc + 0.5f;
+			ghost->tbuf1->readBilinear(c, s * gbuf->getWidth(), t * gbuf->getHeight());
+			sm = smoothMask(s, t);
+			mul_v3_fl(c, sm);
+			s = (u - 0.5f) * isc + 0.5f, t = (v - 0.5f) * isc + 0.5f;
+			ghost->tbuf2->readBilinear(tc, s * gbuf->getWidth() - 0.5f, t * gbuf->getHeight() - 0.5f);
+			sm = smoothMask(s, t);
+			madd_v3_v3fl(c, tc, sm);
+
+			gbuf->writePixel(x, y, c);
+		}
+	}
+}
+
+/* one iteration of the ghosts, reads gbuf and adds to the own pixels of tbuf1 */
+static void ghost_iteration_rows(void *userdata, int start, int stop)
+{
+	GhostData *ghost = (GhostData *)userdata;
+	MemoryBuffer *gbuf = ghost->gbuf;
+	fRGB c, tc;
+	float u, v, sm, s, t;
+	int p, np;
+
+	for (int y = start; y < stop && (!ghost->operation->isBreaked()); y++) {
+		v = ((float)y + 0.5f) / (float)gbuf->getHeight();
+		for (int x = 0; x < gbuf->getWidth(); x++) {
+			u = ((float)x + 0.5f) / (float)gbuf->getWidth();
+			tc[0] = tc[1] = tc[2] = 0.f;
+			for (p = 0; p < 4; p++) {
+				np = (ghost->n << 2) + p;
+				s = (u - 0.5f) * ghost->scalef[np] + 0.5f;
+				t = (v - 0.5f) * ghost->scalef[np] + 0.5f;
+				gbuf->readBilinear(c, s * gbuf->getWidth() - 0.5f, t * gbuf->getHeight() - 0.5f);
+				mul_v3_v3(c, ghost->cm[np]);
+				sm = smoothMask(s, t) * 0.25f;
+				madd_v3_v3fl(tc, c, sm);
+			}
+			ghost->tbuf1->addPixel(x, y, tc);
+		}
+	}
+}
+
 void GlareGhostOperation::generateGlare(float *data, MemoryBuffer *inputTile, NodeGlare *settings)
 {
 	const int qt = 1 << settings->quality;
 	const float s1 = 4.f / (float)qt, s2 = 2.f * s1;
-	int x, y, n, p, np;
-	fRGB c, tc, cm[64];
-	float sc, isc, u, v, sm, s, t, ofs, scalef[64];
+	int x, y, n;
+	fRGB cm[64];
+	float ofs, scalef[64];
 	const float cmo = 1.f - settings->colmod;
 
 	MemoryBuffer *gbuf = inputTile->duplicate();
@@ -76,47 +141,22 @@ void GlareGhostOperation::generateGlare(float *data, MemoryBuffer *inputTile, No
 		if (x & 1) scalef[x] = -0.99f / scalef[x];
 	}
 
-	sc = 2.13;
-	isc = -0.97;
-	for (y = 0; y < gbuf->getHeight() && (!breaked); y++) {
-		v = ((float)y + 0.5f) / (float)gbuf->getHeight();
-		for (x = 0; x < gbuf->getWidth(); x++) {
-			u = ((float)x + 0.5f) / (float)gbuf->getWidth();
-			s = (u - 0.5f) * sc + 0.5f, t = (v - 0.5f) * sc + 0.5f;
-			tbuf1->readBilinear(c, s * gbuf->getWidth(), t * gbuf->getHeight());
-			sm = smoothMask(s, t);
-			mul_v3_fl(c, sm);
-			s = (u - 0.5f) * isc + 0.5f, t = (v - 0.5f) * isc + 0.5f;
-			tbuf2->readBilinear(tc, s * gbuf->getWidth() - 0.5f, t * gbuf->getHeight() - 0.5f);
-			sm = smoothMask(s, t);
-			madd_v3_v3fl(c, tc, sm);
-
-			gbuf->writePixel(x, y, c);
-		}
-		if (isBreaked()) breaked = true;
-
-	}
+	GhostData ghost;
+	ghost.operation = this;
+	ghost.gbuf = gbuf;
+	ghost.tbuf1 = tbuf1;
+	ghost.tbuf2 = tbuf2;
+	ghost.cm = cm;
+	ghost.scalef = scalef;
+	ghost.n = 0;
+	if (!breaked) WorkScheduler::parallel_range(0, gbuf->getHeight(), &ghost, ghost_base_rows, 8);
+	if (isBreaked()) breaked = true;
 
 	memset(tbuf1->getBuffer(), 0, tbuf1->getWidth() * tbuf1->getHeight() * COM_NUM_CHANNELS_COLOR * sizeof(float));
 	for (n = 1; n < settings->iter && (!breaked); n++) {
-		for (y = 0; y < gbuf->getHeight() && (!breaked); y++) {
-			v = ((float)y + 0.5f) / (float)gbuf->getHeight();
-			for (x = 0; x < gbuf->getWidth(); x++) {
-				u = ((float)x + 0.5f) / (float)gbuf->getWidth();
-				tc[0] = tc[1] = tc[2] = 0.f;
-				for (p = 0; p < 4; p++) {
-					np = (n << 2) + p;
-					s = (u - 0.5f) * scalef[np] + 0.5f;
-					t = (v - 0.5f) * scalef[np] + 0.5f;
-					gbuf->readBilinear(c, s * gbuf->getWidth() - 0.5f, t * gbuf->getHeight() - 0.5f);
-					mul_v3_v3(c, cm[np]);
-					sm = smoothMask(s, t) * 0.25f;
-					madd_v3_v3fl(tc, c, sm);
-				}
-				tbuf1->addPixel(x, y, tc);
-			}
-			if (isBreaked()) breaked = true;
-		}
+		ghost.n = n;
+		WorkScheduler::parallel_range(0, gbuf->getHeight(), &ghost, ghost_iteration_rows, 8);
+		if (isBreaked()) breaked = true;
 		memcpy(gbuf->getBuffer(), tbuf1->getBuffer(), tbuf1->getWidth() * tbuf1->getHeight() * COM_NUM_CHANNELS_COLOR * sizeof(float));
 	}
 	memcpy(data, gbuf->getBuffer(), gbuf->getWidth() * gbuf->getHeight() * COM_NUM_CHANNELS_COLOR * sizeof(float));
@@ -21,13 +21,58 @@
  */
 
 #include "COM_GlareStreaksOperation.h"
+#include "COM_WorkScheduler.h"
 #include "BLI_math.h"
 
+typedef struct StreakPassData {
+	NodeOperation *operation;
+	MemoryBuffer *tsrc, *tdst;
+	int n;
+	float vxp, vyp, wt, cmo;
+} StreakPassData;
+
+/* one pass of a streak, every pixel of tdst only depends on tsrc so the rows are independent,
+ * rows stop when the operation is breaked and the caller checks isBreaked() afterwards */
+static void streak_pass_rows(void *userdata, int start, int stop)
+{
+	StreakPassData *pass = (StreakPassData *)userdata;
+	MemoryBuffer *tsrc = pass->tsrc;
+	const int n = pass->n;
+	const float vxp = pass->vxp, vyp = pass->vyp, wt = pass->wt, cmo = pass->cmo;
+	float c1[4], c2[4], c3[4], c4[4];
+	int x, y;
+
+	for (y = start; y < stop && (!pass->operation->isBreaked()); ++y) {
+		float *tdstcol = pass->tdst->getBuffer() + (size_t)y * tsrc->getWidth() * 4;
+		for (x = 0; x < tsrc->getWidth(); ++x, tdstcol += 4) {
+			// first pass no offset, always same for every pass, exact copy,
+			// otherwise results in uneven brightness, only need once
+			if (n == 0) tsrc->read(c1, x, y); else c1[0] = c1[1] = c1[2] = 0;
+			tsrc->readBilinear(c2, x + vxp, y + vyp);
+			tsrc->readBilinear(c3, x + vxp * 2.f, y + vyp * 2.f);
+			tsrc->readBilinear(c4, x + vxp * 3.f, y + vyp * 3.f);
+			// modulate color to look vaguely similar to a color spectrum
+			c2[1] *= cmo;
+			c2[2] *= cmo;
+
+			c3[0] *= cmo;
+			c3[1] *= cmo;
+
+			c4[0] *= cmo;
+			c4[2] *= cmo;
+
+			tdstcol[0] = 0.5f * (tdstcol[0] + c1[0] + wt * (c2[0] + wt * (c3[0] + wt * c4[0])));
+			tdstcol[1] = 0.5f * (tdstcol[1] + c1[1] + wt * (c2[1] + wt * (c3[1] + wt * c4[1])));
+			tdstcol[2] = 0.5f * (tdstcol[2] + c1[2] + wt * (c2[2] + wt * (c3[2] + wt * c4[2])));
+			tdstcol[3] = 1.0f;
+		}
+	}
+}
+
 void GlareStreaksOperation::generateGlare(float *data, MemoryBuffer *inputTile, NodeGlare *settings)
 {
-	int x, y, n;
+	int n;
 	unsigned int nump = 0;
-	float c1[4], c2[4], c3[4], c4[4];
 	float a, ang = DEG2RADF(360.0f) / (float)settings->angle;
 
 	int size = inputTile->getWidth() * inputTile->getHeight();
@@ -48,34 +93,17 @@ void GlareStreaksOperation::generateGlare(float *data, MemoryBuffer *inputTile,
 			const float vxp = vx * p4, vyp = vy * p4;
 			const float wt = pow((double)settings->fade, (double)p4);
 			const float cmo = 1.f - (float)pow((double)settings->colmod, (double)n + 1);  // colormodulation amount relative to current pass
-			float *tdstcol = tdst->getBuffer();
-			for (y = 0; y < tsrc->getHeight() && (!breaked); ++y) {
-				for (x = 0; x < tsrc->getWidth(); ++x, tdstcol += 4) {
-					// first pass no offset, always same for every pass, exact copy,
-					// otherwise results in uneven brightness, only need once
-					if (n == 0) tsrc->read(c1, x, y); else c1[0] = c1[1] = c1[2] = 0;
-					tsrc->readBilinear(c2, x + vxp, y + vyp);
-					tsrc->readBilinear(c3, x + vxp * 2.f, y + vyp * 2.f);
-					tsrc->readBilinear(c4, x + vxp * 3.f, y + vyp * 3.f);
-					// modulate color to look vaguely similar to a color spectrum
-					c2[1] *= cmo;
-					c2[2] *= cmo;
-
-					c3[0] *= cmo;
-					c3[1] *= cmo;
-
-					c4[0] *= cmo;
-					c4[2] *= cmo;
-
-					tdstcol[0] = 0.5f * (tdstcol[0] + c1[0] + wt * (c2[0] + wt * (c3[0] + wt * c4[0])));
-					tdstcol[1] = 0.5f * (tdstcol[1] + c1[1] + wt * (c2[1] + wt * (c3[1] + wt * c4[1])));
-					tdstcol[2] = 0.5f * (tdstcol[2] + c1[2] + wt * (c2[2] + wt * (c3[2] + wt * c4[2])));
-					tdstcol[3] = 1.0f;
-				}
-				if (isBreaked()) {
-					breaked = true;
-				}
-			}
+			StreakPassData pass;
+			pass.operation = this;
+			pass.tsrc = tsrc;
+			pass.tdst = tdst;
+			pass.n = n;
+			pass.vxp = vxp;
+			pass.vyp = vyp;
+			pass.wt = wt;
+			pass.cmo = cmo;
+			WorkScheduler::parallel_range(0, tsrc->getHeight(), &pass, streak_pass_rows, 8);
+			if (isBreaked()) breaked = true;
 			memcpy(tsrc->getBuffer(), tdst->getBuffer(), sizeof(float) * size4);
 		}
 
@@ -107,6 +107,32 @@ void BaseImageOperation::deinitExecution()
 	BKE_image_release_ibuf(this->m_image, this->m_buffer, NULL);
 }
 
+bool BaseImageOperation::hashCacheData(ResultCacheHash &hash)
+{
+	ImBuf *ibuf = this->m_buffer;
+	const size_t num_pixels = (size_t)this->m_imagewidth * this->m_imageheight;
+
+	if (ibuf == NULL) {
+		hash.addInt(0);
+		return true;
+	}
+
+	hash.addInt(this->m_imagewidth);
+	hash.addInt(this->m_imageheight);
+	if (this->m_imageFloatBuffer) {
+		hash.addKey(ResultCache::bufferKey(this->m_imageFloatBuffer, sizeof(float) * num_pixels * this->m_numberOfChannels));
+		hash.add(&ibuf->float_colorspace, sizeof(ibuf->float_colorspace));
+	}
+	else {
+		hash.addKey(ResultCache::bufferKey(this->m_imageByteBuffer, sizeof(unsigned int) * num_pixels));
+		hash.add(&ibuf->rect_colorspace, sizeof(ibuf->rect_colorspace));
+	}
+	if (this->m_depthBuffer) {
+		hash.addKey(ResultCache::bufferKey(this->m_depthBuffer, sizeof(float) * num_pixels));
+	}
+	return true;
+}
+
 void BaseImageOperation::determineResolution(unsigned int resolution[2], unsigned int /*preferredResolution*/[2])
 {
 	ImBuf *stackbuf = getImBuf();
@@ -24,6 +24,7 @@
 
 #include "COM_InpaintOperation.h"
 #include "COM_OpenCLDevice.h"
+#include "COM_WorkScheduler.h"
 
 #include "BLI_math.h"
 
@@ -96,23 +97,29 @@ int InpaintSimpleOperation::mdist(int x, int y)
 	return this->m_manhatten_distance[y * width + x];
 }
 
-bool InpaintSimpleOperation::next_pixel(int &x, int &y, int & curr, int iters)
+/* the pixels of m_pixelorder from curr up to end all have the same distance */
+bool InpaintSimpleOperation::next_ring(int curr, int &end, int iters)
 {
 	int width = this->getWidth();
 
 	if (curr >= this->m_area_size) {
 		return false;
 	}
-	
-	int r = this->m_pixelorder[curr++];
 
-	x = r % width;
-	y = r / width;
+	int r = this->m_pixelorder[curr];
+	int d = this->mdist(r % width, r / width);
 
-	if (this->mdist(x, y) > iters) {
+	if (d > iters) {
 		return false;
 	}
-	
+
+	for (end = curr + 1; end < this->m_area_size; end++) {
+		r = this->m_pixelorder[end];
+		if (this->mdist(r % width, r / width) != d) {
+			break;
+		}
+	}
+
 	return true;
 }
 
@@ -215,6 +222,17 @@ void InpaintSimpleOperation::pix_step(int x, int y)
 	}
 }
 
+void InpaintSimpleOperation::pix_step_range(void *userdata, int start, int stop)
+{
+	InpaintSimpleOperation *operation = (InpaintSimpleOperation *)userdata;
+	int width = operation->getWidth();
+
+	for (int curr = start; curr < stop; curr++) {
+		int r = operation->m_pixelorder[curr];
+		operation->pix_step(r % width, r / width);
+	}
+}
+
 void *InpaintSimpleOperation::initializeTileData(rcti *rect)
 {
 	if (this->m_cached_buffer_ready) {
@@ -228,11 +246,13 @@ void *InpaintSimpleOperation::initializeTileData(rcti *rect)
 		this->calc_manhatten_distance();
 
 		int curr = 0;
-		int x, y;
+		int end;
 
-	
-		while (this->next_pixel(x, y, curr, this->m_iterations)) {
-			this->pix_step(x, y);
+		/* pix_step only reads pixels with a smaller distance,
+		 * so the pixels of a ring can be filled in parallel */
+		while (this->next_ring(curr, end, this->m_iterations)) {
+			WorkScheduler::parallel_range(curr, end, this, pix_step_range, 1024);
+			curr = end;
 		}
 		this->m_cached_buffer_ready = true;
 	}
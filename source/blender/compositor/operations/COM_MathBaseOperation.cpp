@@ -72,6 +72,26 @@ void MathBaseOperation::clampIfNeeded(float *color)
 	}
 }
 
+void MathBaseOperation::clampRowIfNeeded(float *output, int length)
+{
+	if (this->m_useClamp) {
+		for (int i = 0; i < length; i++) {
+			CLAMP(output[i * COM_NUM_CHANNELS_COLOR], 0.0f, 1.0f);
+		}
+	}
+}
+
+void MathBaseOperation::readRowInputs(RowInputs *inputs, const float *row, int x, int y, int length)
+{
+	this->m_inputValue2Operation->readRow(inputs->value2, x, y, length);
+
+	/* pack the first channel, so the operations loop over contiguous values */
+	for (int i = 0; i < length; i++) {
+		inputs->value1[i] = row[i * COM_NUM_CHANNELS_COLOR];
+		inputs->value2[i] = inputs->value2[i * COM_NUM_CHANNELS_COLOR];
+	}
+}
+
 void MathAddOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
@@ -85,6 +105,20 @@ void MathAddOperation::executePixelSampled(float output[4], float x, float y, Pi
 	clampIfNeeded(output);
 }
 
+void MathAddOperation::transformRow(float *row, int x, int y, int length)
+{
+	RowInputs inputs;
+	readRowInputs(&inputs, row, x, y, length);
+
+	const float *value1 = inputs.value1;
+	const float *value2 = inputs.value2;
+	for (int i = 0; i < length; i++) {
+		row[i * COM_NUM_CHANNELS_COLOR] = value1[i] + value2[i];
+	}
+
+	clampRowIfNeeded(row, length);
+}
+
 void MathSubtractOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
@@ -98,6 +132,20 @@ void MathSubtractOperation::executePixelSampled(float output[4], float x, float
 	clampIfNeeded(output);
 }
 
+void MathSubtractOperation::transformRow(float *row, int x, int y, int length)
+{
+	RowInputs inputs;
+	readRowInputs(&inputs, row, x, y, length);
+
+	const float *value1 = inputs.value1;
+	const float *value2 = inputs.value2;
+	for (int i = 0; i < length; i++) {
+		row[i * COM_NUM_CHANNELS_COLOR] = value1[i] - value2[i];
+	}
+
+	clampRowIfNeeded(row, length);
+}
+
 void MathMultiplyOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
@@ -111,6 +159,20 @@ void MathMultiplyOperation::executePixelSampled(float output[4], float x, float
 	clampIfNeeded(output);
 }
 
+void MathMultiplyOperation::transformRow(float *row, int x, int y, int length)
+{
+	RowInputs inputs;
+	readRowInputs(&inputs, row, x, y, length);
+
+	const float *value1 = inputs.value1;
+	const float *value2 = inputs.value2;
+	for (int i = 0; i < length; i++) {
+		row[i * COM_NUM_CHANNELS_COLOR] = value1[i] * value2[i];
+	}
+
+	clampRowIfNeeded(row, length);
+}
+
 void MathDivideOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
@@ -127,6 +189,20 @@ void MathDivideOperation::executePixelSampled(float output[4], float x, float y,
 	clampIfNeeded(output);
 }
 
+void MathDivideOperation::transformRow(float *row, int x, int y, int length)
+{
+	RowInputs inputs;
+	readRowInputs(&inputs, row, x, y, length);
+
+	const float *value1 = inputs.value1;
+	const float *value2 = inputs.value2;
+	for (int i = 0; i < length; i++) {
+		row[i * COM_NUM_CHANNELS_COLOR] = (value2[i] == 0.0f) ? 0.0f : value1[i] / value2[i];
+	}
+
+	clampRowIfNeeded(row, length);
+}
+
 void MathSineOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
@@ -265,6 +341,20 @@ void MathMinimumOperation::executePixelSampled(float output[4], float x, float y
 	clampIfNeeded(output);
 }
 
+void MathMinimumOperation::transformRow(float *row, int x, int y, int length)
+{
+	RowInputs inputs;
+	readRowInputs(&inputs, row, x, y, length);
+
+	const float *value1 = inputs.value1;
+	const float *value2 = inputs.value2;
+	for (int i = 0; i < length; i++) {
+		row[i * COM_NUM_CHANNELS_COLOR] = min(value1[i], value2[i]);
+	}
+
+	clampRowIfNeeded(row, length);
+}
+
 void MathMaximumOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
@@ -278,6 +368,20 @@ void MathMaximumOperation::executePixelSampled(float output[4], float x, float y
 	clampIfNeeded(output);
 }
 
+void MathMaximumOperation::transformRow(float *row, int x, int y, int length)
+{
+	RowInputs inputs;
+	readRowInputs(&inputs, row, x, y, length);
+
+	const float *value1 = inputs.value1;
+	const float *value2 = inputs.value2;
+	for (int i = 0; i < length; i++) {
+		row[i * COM_NUM_CHANNELS_COLOR] = max(value1[i], value2[i]);
+	}
+
+	clampRowIfNeeded(row, length);
+}
+
 void MathRoundOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
@@ -304,6 +408,20 @@ void MathLessThanOperation::executePixelSampled(float output[4], float x, float
 	clampIfNeeded(output);
 }
 
+void MathLessThanOperation::transformRow(float *row, int x, int y, int length)
+{
+	RowInputs inputs;
+	readRowInputs(&inputs, row, x, y, length);
+
+	const float *value1 = inputs.value1;
+	const float *value2 = inputs.value2;
+	for (int i = 0; i < length; i++) {
+		row[i * COM_NUM_CHANNELS_COLOR] = value1[i] < value2[i] ? 1.0f : 0.0f;
+	}
+
+	clampRowIfNeeded(row, length);
+}
+
 void MathGreaterThanOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
@@ -317,6 +435,20 @@ void MathGreaterThanOperation::executePixelSampled(float output[4], float x, flo
 	clampIfNeeded(output);
 }
 
+void MathGreaterThanOperation::transformRow(float *row, int x, int y, int length)
+{
+	RowInputs inputs;
+	readRowInputs(&inputs, row, x, y, length);
+
+	const float *value1 = inputs.value1;
+	const float *value2 = inputs.value2;
+	for (int i = 0; i < length; i++) {
+		row[i * COM_NUM_CHANNELS_COLOR] = value1[i] > value2[i] ? 1.0f : 0.0f;
+	}
+
+	clampRowIfNeeded(row, length);
+}
+
 void MathModuloOperation::executePixelSampled(float output[4], float x, float y, PixelSampler sampler)
 {
 	float inputValue1[4];
@@ -46,6 +46,17 @@ protected:
 	MathBaseOperation();
 
 	void clampIfNeeded(float color[4]);
+	void clampRowIfNeeded(float *output, int length);
+
+	/**
+	 * Rows of the inputs for transformRow, packed to one float per pixel
+	 */
+	struct RowInputs {
+		float value1[COM_ROW_LENGTH];
+		float value2[COM_ROW_LENGTH * COM_NUM_CHANNELS_COLOR];
+	};
+
+	void readRowInputs(RowInputs *inputs, const float *row, int x, int y, int length);
 public:
 	/**
 	 * the inner loop of this program
@@ -74,21 +85,29 @@ class MathAddOperation : public MathBaseOperation {
 public:
 	MathAddOperation() : MathBaseOperation() {}
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	int getTransformInputSocketIndex() const { return 0; }
+	void transformRow(float *row, int x, int y, int length);
 };
 class MathSubtractOperation : public MathBaseOperation {
 public:
 	MathSubtractOperation() : MathBaseOperation() {}
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	int getTransformInputSocketIndex() const { return 0; }
+	void transformRow(float *row, int x, int y, int length);
 };
 class MathMultiplyOperation : public MathBaseOperation {
 public:
 	MathMultiplyOperation() : MathBaseOperation() {}
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	int getTransformInputSocketIndex() const { return 0; }
+	void transformRow(float *row, int x, int y, int length);
 };
 class MathDivideOperation : public MathBaseOperation {
 public:
 	MathDivideOperation() : MathBaseOperation() {}
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	int getTransformInputSocketIndex() const { return 0; }
+	void transformRow(float *row, int x, int y, int length);
 };
 class MathSineOperation : public MathBaseOperation {
 public:
@@ -135,11 +154,15 @@ class MathMinimumOperation : public MathBaseOperation {
 public:
 	MathMinimumOperation() : MathBaseOperation() {}
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	int getTransformInputSocketIndex() const { return 0; }
+	void transformRow(float *row, int x, int y, int length);
 };
 class MathMaximumOperation : public MathBaseOperation {
 public:
 	MathMaximumOperation() : MathBaseOperation() {}
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	int getTransformInputSocketIndex() const { return 0; }
+	void transformRow(float *row, int x, int y, int length);
 };
 class MathRoundOperation : public MathBaseOperation {
 public:
@@ -150,11 +173,15 @@ class MathLessThanOperation : public MathBaseOperation {
 public:
 	MathLessThanOperation() : MathBaseOperation() {}
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	int getTransformInputSocketIndex() const { return 0; }
+	void transformRow(float *row, int x, int y, int length);
 };
 class MathGreaterThanOperation : public MathBaseOperation {
 public:
 	MathGreaterThanOperation() : MathBaseOperation() {}
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	int getTransformInputSocketIndex() const { return 0; }
+	void transformRow(float *row, int x, int y, int length);
 };
 
 class MathModuloOperation : public MathBaseOperation {
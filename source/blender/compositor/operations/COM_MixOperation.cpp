@@ -69,6 +69,23 @@ void MixBaseOperation::executePixelSampled(float output[4], float x, float y, Pi
 	output[3] = inputColor1[3];
 }
 
+void MixBaseOperation::readRowInputs(RowInputs *inputs, int x, int y, int length)
+{
+	/* value row is read into color2 first, only the first channel is used */
+	this->m_inputValueOperation->readRow(inputs->color2, x, y, length);
+	for (int i = 0; i < length; i++) {
+		inputs->value[i] = inputs->color2[i * COM_NUM_CHANNELS_COLOR];
+	}
+
+	this->m_inputColor2Operation->readRow(inputs->color2, x, y, length);
+
+	if (this->useValueAlphaMultiply()) {
+		for (int i = 0; i < length; i++) {
+			inputs->value[i] *= inputs->color2[i * COM_NUM_CHANNELS_COLOR + 3];
+		}
+	}
+}
+
 void MixBaseOperation::determineResolution(unsigned int resolution[2], unsigned int preferredResolution[2])
 {
 	NodeOperationInput *socket;
@@ -129,6 +146,26 @@ void MixAddOperation::executePixelSampled(float output[4], float x, float y, Pix
 	clampIfNeeded(output);
 }
 
+void MixAddOperation::transformRow(float *row, int x, int y, int length)
+{
+	RowInputs inputs;
+	readRowInputs(&inputs, x, y, length);
+
+	for (int i = 0; i < length; i++) {
+		const float value = inputs.value[i];
+		const float *color1 = &row[i * COM_NUM_CHANNELS_COLOR];
+		const float *color2 = &inputs.color2[i * COM_NUM_CHANNELS_COLOR];
+		float *out = &row[i * COM_NUM_CHANNELS_COLOR];
+
+		out[0] = color1[0] + value * color2[0];
+		out[1] = color1[1] + value * color2[1];
+		out[2] = color1[2] + value * color2[2];
+		out[3] = color1[3];
+	}
+
+	clampRowIfNeeded(row, length);
+}
+
 /* ******** Mix Blend Operation ******** */
 
 MixBlendOperation::MixBlendOperation() : MixBaseOperation()
@@ -160,6 +197,27 @@ void MixBlendOperation::executePixelSampled(float output[4], float x, float y, P
 	clampIfNeeded(output);
 }
 
+void MixBlendOperation::transformRow(float *row, int x, int y, int length)
+{
+	RowInputs inputs;
+	readRowInputs(&inputs, x, y, length);
+
+	for (int i = 0; i < length; i++) {
+		const float value = inputs.value[i];
+		const float valuem = 1.0f - value;
+		const float *color1 = &row[i * COM_NUM_CHANNELS_COLOR];
+		const float *color2 = &inputs.color2[i * COM_NUM_CHANNELS_COLOR];
+		float *out = &row[i * COM_NUM_CHANNELS_COLOR];
+
+		out[0] = valuem * color1[0] + value * color2[0];
+		out[1] = valuem * color1[1] + value * color2[1];
+		out[2] = valuem * color1[2] + value * color2[2];
+		out[3] = color1[3];
+	}
+
+	clampRowIfNeeded(row, length);
+}
+
 /* ******** Mix Burn Operation ******** */
 
 MixBurnOperation::MixBurnOperation() : MixBaseOperation()
@@ -300,6 +358,27 @@ void MixDarkenOperation::executePixelSampled(float output[4], float x, float y,
 	clampIfNeeded(output);
 }
 
+void MixDarkenOperation::transformRow(float *row, int x, int y, int length)
+{
+	RowInputs inputs;
+	readRowInputs(&inputs, x, y, length);
+
+	for (int i = 0; i < length; i++) {
+		const float value = inputs.value[i];
+		const float valuem = 1.0f - value;
+		const float *color1 = &row[i * COM_NUM_CHANNELS_COLOR];
+		const float *color2 = &inputs.color2[i * COM_NUM_CHANNELS_COLOR];
+		float *out = &row[i * COM_NUM_CHANNELS_COLOR];
+
+		out[0] = min_ff(color1[0], color2[0]) * value + color1[0] * valuem;
+		out[1] = min_ff(color1[1], color2[1]) * value + color1[1] * valuem;
+		out[2] = min_ff(color1[2], color2[2]) * value + color1[2] * valuem;
+		out[3] = color1[3];
+	}
+
+	clampRowIfNeeded(row, length);
+}
+
 /* ******** Mix Difference Operation ******** */
 
 MixDifferenceOperation::MixDifferenceOperation() : MixBaseOperation()
@@ -330,6 +409,27 @@ void MixDifferenceOperation::executePixelSampled(float output[4], float x, float
 	clampIfNeeded(output);
 }
 
+void MixDifferenceOperation::transformRow(float *row, int x, int y, int length)
+{
+	RowInputs inputs;
+	readRowInputs(&inputs, x, y, length);
+
+	for (int i = 0; i < length; i++) {
+		const float value = inputs.value[i];
+		const float valuem = 1.0f - value;
+		const float *color1 = &row[i * COM_NUM_CHANNELS_COLOR];
+		const float *color2 = &inputs.color2[i * COM_NUM_CHANNELS_COLOR];
+		float *out = &row[i * COM_NUM_CHANNELS_COLOR];
+
+		out[0] = valuem * color1[0] + value * fabsf(color1[0] - color2[0]);
+		out[1] = valuem * color1[1] + value * fabsf(color1[1] - color2[1]);
+		out[2] = valuem * color1[2] + value * fabsf(color1[2] - color2[2]);
+		out[3] = color1[3];
+	}
+
+	clampRowIfNeeded(row, length);
+}
+
 /* ******** Mix Difference Operation ******** */
 
 MixDivideOperation::MixDivideOperation() : MixBaseOperation()
@@ -371,6 +471,27 @@ void MixDivideOperation::executePixelSampled(float output[4], float x, float y,
 	clampIfNeeded(output);
 }
 
+void MixDivideOperation::transformRow(float *row, int x, int y, int length)
+{
+	RowInputs inputs;
+	readRowInputs(&inputs, x, y, length);
+
+	for (int i = 0; i < length; i++) {
+		const float value = inputs.value[i];
+		const float valuem = 1.0f - value;
+		const float *color1 = &row[i * COM_NUM_CHANNELS_COLOR];
+		const float *color2 = &inputs.color2[i * COM_NUM_CHANNELS_COLOR];
+		float *out = &row[i * COM_NUM_CHANNELS_COLOR];
+
+		out[0] = (color2[0] != 0.0f) ? valuem * color1[0] + value * color1[0] / color2[0] : 0.0f;
+		out[1] = (color2[1] != 0.0f) ? valuem * color1[1] + value * color1[1] / color2[1] : 0.0f;
+		out[2] = (color2[2] != 0.0f) ? valuem * color1[2] + value * color1[2] / color2[2] : 0.0f;
+		out[3] = color1[3];
+	}
+
+	clampRowIfNeeded(row, length);
+}
+
 /* ******** Mix Dodge Operation ******** */
 
 MixDodgeOperation::MixDodgeOperation() : MixBaseOperation()
@@ -554,6 +675,26 @@ void MixLightenOperation::executePixelSampled(float output[4], float x, float y,
 	clampIfNeeded(output);
 }
 
+void MixLightenOperation::transformRow(float *row, int x, int y, int length)
+{
+	RowInputs inputs;
+	readRowInputs(&inputs, x, y, length);
+
+	for (int i = 0; i < length; i++) {
+		const float value = inputs.value[i];
+		const float *color1 = &row[i * COM_NUM_CHANNELS_COLOR];
+		const float *color2 = &inputs.color2[i * COM_NUM_CHANNELS_COLOR];
+		float *out = &row[i * COM_NUM_CHANNELS_COLOR];
+
+		out[0] = max_ff(value * color2[0], color1[0]);
+		out[1] = max_ff(value * color2[1], color1[1]);
+		out[2] = max_ff(value * color2[2], color1[2]);
+		out[3] = color1[3];
+	}
+
+	clampRowIfNeeded(row, length);
+}
+
 /* ******** Mix Linear Light Operation ******** */
 
 MixLinearLightOperation::MixLinearLightOperation() : MixBaseOperation()
@@ -623,6 +764,27 @@ void MixMultiplyOperation::executePixelSampled(float output[4], float x, float y
 	clampIfNeeded(output);
 }
 
+void MixMultiplyOperation::transformRow(float *row, int x, int y, int length)
+{
+	RowInputs inputs;
+	readRowInputs(&inputs, x, y, length);
+
+	for (int i = 0; i < length; i++) {
+		const float value = inputs.value[i];
+		const float valuem = 1.0f - value;
+		const float *color1 = &row[i * COM_NUM_CHANNELS_COLOR];
+		const float *color2 = &inputs.color2[i * COM_NUM_CHANNELS_COLOR];
+		float *out = &row[i * COM_NUM_CHANNELS_COLOR];
+
+		out[0] = color1[0] * (valuem + value * color2[0]);
+		out[1] = color1[1] * (valuem + value * color2[1]);
+		out[2] = color1[2] * (valuem + value * color2[2]);
+		out[3] = color1[3];
+	}
+
+	clampRowIfNeeded(row, length);
+}
+
 /* ******** Mix Ovelray Operation ******** */
 
 MixOverlayOperation::MixOverlayOperation() : MixBaseOperation()
@@ -740,6 +902,27 @@ void MixScreenOperation::executePixelSampled(float output[4], float x, float y,
 	clampIfNeeded(output);
 }
 
+void MixScreenOperation::transformRow(float *row, int x, int y, int length)
+{
+	RowInputs inputs;
+	readRowInputs(&inputs, x, y, length);
+
+	for (int i = 0; i < length; i++) {
+		const float value = inputs.value[i];
+		const float valuem = 1.0f - value;
+		const float *color1 = &row[i * COM_NUM_CHANNELS_COLOR];
+		const float *color2 = &inputs.color2[i * COM_NUM_CHANNELS_COLOR];
+		float *out = &row[i * COM_NUM_CHANNELS_COLOR];
+
+		out[0] = 1.0f - (valuem + value * (1.0f - color2[0])) * (1.0f - color1[0]);
+		out[1] = 1.0f - (valuem + value * (1.0f - color2[1])) * (1.0f - color1[1]);
+		out[2] = 1.0f - (valuem + value * (1.0f - color2[2])) * (1.0f - color1[2]);
+		out[3] = color1[3];
+	}
+
+	clampRowIfNeeded(row, length);
+}
+
 /* ******** Mix Soft Light Operation ******** */
 
 MixSoftLightOperation::MixSoftLightOperation() : MixBaseOperation()
@@ -806,6 +989,26 @@ void MixSubtractOperation::executePixelSampled(float output[4], float x, float y
 	clampIfNeeded(output);
 }
 
+void MixSubtractOperation::transformRow(float *row, int x, int y, int length)
+{
+	RowInputs inputs;
+	readRowInputs(&inputs, x, y, length);
+
+	for (int i = 0; i < length; i++) {
+		const float value = inputs.value[i];
+		const float *color1 = &row[i * COM_NUM_CHANNELS_COLOR];
+		const float *color2 = &inputs.color2[i * COM_NUM_CHANNELS_COLOR];
+		float *out = &row[i * COM_NUM_CHANNELS_COLOR];
+
+		out[0] = color1[0] - value * color2[0];
+		out[1] = color1[1] - value * color2[1];
+		out[2] = color1[2] - value * color2[2];
+		out[3] = color1[3];
+	}
+
+	clampRowIfNeeded(row, length);
+}
+
 /* ******** Mix Value Operation ******** */
 
 MixValueOperation::MixValueOperation() : MixBaseOperation()
@@ -50,6 +50,26 @@ protected:
 			CLAMP(color[3], 0.0f, 1.0f);
 		}
 	}
+
+	inline void clampRowIfNeeded(float *output, int length)
+	{
+		if (m_useClamp) {
+			for (int i = 0; i < length * COM_NUM_CHANNELS_COLOR; i++) {
+				CLAMP(output[i], 0.0f, 1.0f);
+			}
+		}
+	}
+
+	/**
+	 * Rows of the inputs for transformRow, the value of each pixel
+	 * already includes the alpha multiply, color1 is the transformed row
+	 */
+	struct RowInputs {
+		float value[COM_ROW_LENGTH];
+		float color2[COM_ROW_LENGTH * COM_NUM_CHANNELS_COLOR];
+	};
+
+	void readRowInputs(RowInputs *inputs, int x, int y, int length);
 	
 public:
 	/**
@@ -84,12 +104,16 @@ class MixAddOperation : public MixBaseOperation {
 public:
 	MixAddOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	int getTransformInputSocketIndex() const { return 1; }
+	void transformRow(float *row, int x, int y, int length);
 };
 
 class MixBlendOperation : public MixBaseOperation {
 public:
 	MixBlendOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	int getTransformInputSocketIndex() const { return 1; }
+	void transformRow(float *row, int x, int y, int length);
 };
 
 class MixBurnOperation : public MixBaseOperation {
@@ -108,18 +132,24 @@ class MixDarkenOperation : public MixBaseOperation {
 public:
 	MixDarkenOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	int getTransformInputSocketIndex() const { return 1; }
+	void transformRow(float *row, int x, int y, int length);
 };
 
 class MixDifferenceOperation : public MixBaseOperation {
 public:
 	MixDifferenceOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	int getTransformInputSocketIndex() const { return 1; }
+	void transformRow(float *row, int x, int y, int length);
 };
 
 class MixDivideOperation : public MixBaseOperation {
 public:
 	MixDivideOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	int getTransformInputSocketIndex() const { return 1; }
+	void transformRow(float *row, int x, int y, int length);
 };
 
 class MixDodgeOperation : public MixBaseOperation {
@@ -144,6 +174,8 @@ class MixLightenOperation : public MixBaseOperation {
 public:
 	MixLightenOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	int getTransformInputSocketIndex() const { return 1; }
+	void transformRow(float *row, int x, int y, int length);
 };
 
 class MixLinearLightOperation : public MixBaseOperation {
@@ -156,6 +188,8 @@ class MixMultiplyOperation : public MixBaseOperation {
 public:
 	MixMultiplyOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	int getTransformInputSocketIndex() const { return 1; }
+	void transformRow(float *row, int x, int y, int length);
 };
 
 class MixOverlayOperation : public MixBaseOperation {
@@ -174,6 +208,8 @@ class MixScreenOperation : public MixBaseOperation {
 public:
 	MixScreenOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	int getTransformInputSocketIndex() const { return 1; }
+	void transformRow(float *row, int x, int y, int length);
 };
 
 class MixSoftLightOperation : public MixBaseOperation {
@@ -186,6 +222,8 @@ class MixSubtractOperation : public MixBaseOperation {
 public:
 	MixSubtractOperation();
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	int getTransformInputSocketIndex() const { return 1; }
+	void transformRow(float *row, int x, int y, int length);
 };
 
 class MixValueOperation : public MixBaseOperation {
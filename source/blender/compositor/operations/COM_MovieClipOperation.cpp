@@ -71,6 +71,21 @@ void MovieClipBaseOperation::deinitExecution()
 	}
 }
 
+bool MovieClipBaseOperation::hashCacheData(ResultCacheHash &hash)
+{
+	ImBuf *ibuf = this->m_movieClipBuffer;
+
+	if (ibuf == NULL) {
+		hash.addInt(0);
+		return true;
+	}
+
+	hash.addInt(ibuf->x);
+	hash.addInt(ibuf->y);
+	hash.addKey(ResultCache::bufferKey(ibuf->rect_float, sizeof(float) * ibuf->x * ibuf->y * ibuf->channels));
+	return true;
+}
+
 void MovieClipBaseOperation::determineResolution(unsigned int resolution[2], unsigned int /*preferredResolution*/[2])
 {
 	resolution[0] = 0;
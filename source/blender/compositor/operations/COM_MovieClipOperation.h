@@ -51,6 +51,7 @@ public:
 	MovieClipBaseOperation();
 	
 	void initExecution();
+	bool hashCacheData(ResultCacheHash &hash);
 	void deinitExecution();
 	void setMovieClip(MovieClip *image) { this->m_movieClip = image; }
 	void setMovieClipUser(MovieClipUser *imageuser) { this->m_movieClipUser = imageuser; }
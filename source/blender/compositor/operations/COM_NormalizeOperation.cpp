@@ -20,6 +20,8 @@
  */
 
 #include "COM_NormalizeOperation.h"
+#include "COM_WorkScheduler.h"
+#include "MEM_guardedalloc.h"
 
 NormalizeOperation::NormalizeOperation() : NodeOperation()
 {
@@ -80,23 +82,25 @@ bool NormalizeOperation::determineDependingAreaOfInterest(rcti * /*input*/, Read
 /* The code below assumes all data is inside range +- this, and that input buffer is single channel */
 #define BLENDER_ZMAX 10000.0f
 
-void *NormalizeOperation::initializeTileData(rcti *rect)
+typedef struct NormalizeRangeData {
+	MemoryBuffer *tile;
+	float *minv;
+	float *maxv;
+} NormalizeRangeData;
+
+static void normalize_range_rows(void *userdata, int start, int stop)
 {
-	lockMutex();
-	if (this->m_cachedInstance == NULL) {
-		MemoryBuffer *tile = (MemoryBuffer *)this->m_imageReader->initializeTileData(rect);
-		/* using generic two floats struct to store x: min  y: mult */
-		NodeTwoFloats *minmult = new NodeTwoFloats();
+	NormalizeRangeData *data = (NormalizeRangeData *)userdata;
+	int width = data->tile->getWidth();
 
-		float *buffer = tile->getBuffer();
-		int p = tile->getWidth() * tile->getHeight();
-		float *bc = buffer;
+	for (int y = start; y < stop; y++) {
+		float *bc = data->tile->getBuffer() + (size_t)y * width;
 
 		float minv = 1.0f + BLENDER_ZMAX;
 		float maxv = -1.0f - BLENDER_ZMAX;
 
 		float value;
-		while (p--) {
+		for (int x = 0; x < width; x++) {
 			value = bc[0];
 			if ((value > maxv) && (value <= BLENDER_ZMAX)) {
 				maxv = value;
@@ -107,6 +111,37 @@ void *NormalizeOperation::initializeTileData(rcti *rect)
 			bc ++;
 		}
 
+		data->minv[y] = minv;
+		data->maxv[y] = maxv;
+	}
+}
+
+void *NormalizeOperation::initializeTileData(rcti *rect)
+{
+	lockMutex();
+	if (this->m_cachedInstance == NULL) {
+		MemoryBuffer *tile = (MemoryBuffer *)this->m_imageReader->initializeTileData(rect);
+		/* using generic two floats struct to store x: min  y: mult */
+		NodeTwoFloats *minmult = new NodeTwoFloats();
+
+		/* range of every row is found in parallel */
+		int height = tile->getHeight();
+		NormalizeRangeData data;
+		data.tile = tile;
+		data.minv = (float *)MEM_mallocN(sizeof(float) * height, __func__);
+		data.maxv = (float *)MEM_mallocN(sizeof(float) * height, __func__);
+		WorkScheduler::parallel_range(0, height, &data, normalize_range_rows);
+
+		float minv = 1.0f + BLENDER_ZMAX;
+		float maxv = -1.0f - BLENDER_ZMAX;
+
+		for (int y = 0; y < height; y++) {
+			maxv = max(maxv, data.maxv[y]);
+			minv = min(minv, data.minv[y]);
+		}
+		MEM_freeN(data.minv);
+		MEM_freeN(data.maxv);
+
 		minmult->x = minv;
 		/* The rare case of flat buffer  would cause a divide by 0 */
 		minmult->y = ((maxv != minv) ? 1.0f / (maxv - minv) : 0.f);
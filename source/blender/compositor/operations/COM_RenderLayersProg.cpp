@@ -179,6 +179,15 @@ void RenderLayersBaseProg::deinitExecution()
 	this->m_inputBuffer = NULL;
 }
 
+bool RenderLayersBaseProg::hashCacheData(ResultCacheHash &hash)
+{
+	const size_t size = sizeof(float) * this->getWidth() * this->getHeight() * this->m_elementsize;
+
+	hash.addInt(this->m_renderpass);
+	hash.addKey(ResultCache::bufferKey(this->m_inputBuffer, this->m_inputBuffer ? size : 0));
+	return true;
+}
+
 void RenderLayersBaseProg::determineResolution(unsigned int resolution[2], unsigned int /*preferredResolution*/[2])
 {
 	Scene *sce = this->getScene();
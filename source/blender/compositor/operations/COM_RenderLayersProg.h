@@ -106,6 +106,7 @@ public:
 	const char *getViewName() { return this->m_viewName; }
 	void initExecution();
 	void deinitExecution();
+	bool hashCacheData(ResultCacheHash &hash);
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
 };
 
@@ -48,6 +48,17 @@ void SetAlphaOperation::executePixelSampled(float output[4], float x, float y, P
 	output[3] = alphaInput[0];
 }
 
+void SetAlphaOperation::transformRow(float *row, int x, int y, int length)
+{
+	float alphaInput[COM_ROW_LENGTH * COM_NUM_CHANNELS_COLOR];
+
+	this->m_inputAlpha->readRow(alphaInput, x, y, length);
+
+	for (int i = 0; i < length; i++) {
+		row[i * COM_NUM_CHANNELS_COLOR + 3] = alphaInput[i * COM_NUM_CHANNELS_COLOR];
+	}
+}
+
 void SetAlphaOperation::deinitExecution()
 {
 	this->m_inputColor = NULL;
@@ -44,6 +44,8 @@ public:
 	 * the inner loop of this program
 	 */
 	void executePixelSampled(float output[4], float x, float y, PixelSampler sampler);
+	int getTransformInputSocketIndex() const { return 0; }
+	void transformRow(float *row, int x, int y, int length);
 	
 	void initExecution();
 	void deinitExecution();
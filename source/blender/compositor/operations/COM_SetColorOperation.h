@@ -59,6 +59,7 @@ public:
 
 	void determineResolution(unsigned int resolution[2], unsigned int preferredResolution[2]);
 	bool isSetOperation() const { return true; }
+	bool hashCacheData(ResultCacheHash &hash) { hash.add(this->m_color, sizeof(this->m_color)); return true; }
 
 };
 #endif
@@ -50,5 +50,6 @@ public:
 	void determineResolution(unsigned int resolution[2], unsigned int preferredResolution[2]);
 	
 	bool isSetOperation() const { return true; }
+	bool hashCacheData(ResultCacheHash &hash) { hash.addFloat(this->m_value); return true; }
 };
 #endif
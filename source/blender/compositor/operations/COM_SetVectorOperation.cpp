@@ -37,6 +37,14 @@ void SetVectorOperation::executePixelSampled(float output[4],
 	output[2] = this->m_z;
 }
 
+bool SetVectorOperation::hashCacheData(ResultCacheHash &hash)
+{
+	hash.addFloat(this->m_x);
+	hash.addFloat(this->m_y);
+	hash.addFloat(this->m_z);
+	return true;
+}
+
 void SetVectorOperation::determineResolution(unsigned int resolution[2], unsigned int preferredResolution[2])
 {
 	resolution[0] = preferredResolution[0];
@@ -58,6 +58,7 @@ public:
 
 	void determineResolution(unsigned int resolution[2], unsigned int preferredResolution[2]);
 	bool isSetOperation() const { return true; }
+	bool hashCacheData(ResultCacheHash &hash);
 
 	void setVector(const float vector[3]) {
 		setX(vector[0]);
@@ -21,8 +21,10 @@
  */
 
 #include "COM_TonemapOperation.h"
+#include "COM_WorkScheduler.h"
 #include "BLI_math.h"
 #include "BLI_utildefines.h"
+#include "MEM_guardedalloc.h"
 
 extern "C" {
 #include "IMB_colormanagement.h"
@@ -112,6 +114,49 @@ bool TonemapOperation::determineDependingAreaOfInterest(rcti * /*input*/, ReadBu
 	return false;
 }
 
+/* luminance sums of a single row, the rows are summed in order afterwards
+ * so the result doesn't depend on how the rows are distributed over the threads,
+ * double sums keep it within float precision of a single sequential sum */
+typedef struct TonemapRowSums {
+	double Lav;
+	double cav[3];
+	double lsum;
+	float maxl, minl;
+} TonemapRowSums;
+
+typedef struct TonemapSumData {
+	MemoryBuffer *tile;
+	TonemapRowSums *rows;
+} TonemapSumData;
+
+static void tonemap_sum_rows(void *userdata, int start, int stop)
+{
+	TonemapSumData *data = (TonemapSumData *)userdata;
+	int width = data->tile->getWidth();
+
+	for (int y = start; y < stop; y++) {
+		TonemapRowSums *row = &data->rows[y];
+		float *bc = data->tile->getBuffer() + (size_t)y * width * COM_NUM_CHANNELS_COLOR;
+
+		row->Lav = 0.0;
+		row->cav[0] = row->cav[1] = row->cav[2] = 0.0;
+		row->lsum = 0.0;
+		row->maxl = -1e10f;
+		row->minl = 1e10f;
+		for (int x = 0; x < width; x++) {
+			float L = IMB_colormanagement_get_luminance(bc);
+			row->Lav += L;
+			row->cav[0] += bc[0];
+			row->cav[1] += bc[1];
+			row->cav[2] += bc[2];
+			row->lsum += logf(MAX2(L, 0.0f) + 1e-5f);
+			row->maxl = (L > row->maxl) ? L : row->maxl;
+			row->minl = (L < row->minl) ? L : row->minl;
+			bc += 4;
+		}
+	}
+}
+
 void *TonemapOperation::initializeTileData(rcti *rect)
 {
 	lockMutex();
@@ -119,26 +164,34 @@ void *TonemapOperation::initializeTileData(rcti *rect)
 		MemoryBuffer *tile = (MemoryBuffer *)this->m_imageReader->initializeTileData(rect);
 		AvgLogLum *data = new AvgLogLum();
 
-		float *buffer = tile->getBuffer();
+		int height = tile->getHeight();
+		TonemapSumData sumdata;
+		sumdata.tile = tile;
+		sumdata.rows = (TonemapRowSums *)MEM_mallocN(sizeof(TonemapRowSums) * height, __func__);
+		WorkScheduler::parallel_range(0, height, &sumdata, tonemap_sum_rows);
 
-		float lsum = 0.0f;
+		double lsum = 0.0;
 		int p = tile->getWidth() * tile->getHeight();
-		float *bc = buffer;
 		float avl, maxl = -1e10f, minl = 1e10f;
 		const float sc = 1.0f / p;
-		float Lav = 0.f;
-		float cav[4] = {0.0f, 0.0f, 0.0f, 0.0f};
-		while (p--) {
-			float L = IMB_colormanagement_get_luminance(bc);
-			Lav += L;
-			add_v3_v3(cav, bc);
-			lsum += logf(MAX2(L, 0.0f) + 1e-5f);
-			maxl = (L > maxl) ? L : maxl;
-			minl = (L < minl) ? L : minl;
-			bc += 4;
+		double Lav = 0.0;
+		double cav[3] = {0.0, 0.0, 0.0};
+		for (int y = 0; y < height; y++) {
+			TonemapRowSums *row = &sumdata.rows[y];
+			Lav += row->Lav;
+			cav[0] += row->cav[0];
+			cav[1] += row->cav[1];
+			cav[2] += row->cav[2];
+			lsum += row->lsum;
+			maxl = (row->maxl > maxl) ? row->maxl : maxl;
+			minl = (row->minl < minl) ? row->minl : minl;
 		}
+		MEM_freeN(sumdata.rows);
+
 		data->lav = Lav * sc;
-		mul_v3_v3fl(data->cav, cav, sc);
+		data->cav[0] = cav[0] * sc;
+		data->cav[1] = cav[1] * sc;
+		data->cav[2] = cav[2] * sc;
 		maxl = log((double)maxl + 1e-5); minl = log((double)minl + 1e-5); avl = lsum * sc;
 		data->auto_key = (maxl > minl) ? ((maxl - avl) / (maxl - minl)) : 1.f;
 		float al = exp((double)avl);
@@ -93,14 +93,24 @@ void WriteBufferOperation::executeRegion(rcti *rect, unsigned int /*tileNumber*/
 		int x2 = rect->xmax;
 		int y2 = rect->ymax;
 
+		float row[COM_ROW_LENGTH * COM_NUM_CHANNELS_COLOR];
 		int x;
 		int y;
 		bool breaked = false;
 		for (y = y1; y < y2 && (!breaked); y++) {
 			int offset4 = (y * memoryBuffer->getWidth() + x1) * num_channels;
-			for (x = x1; x < x2; x++) {
-				this->m_input->readSampled(&(buffer[offset4]), x, y, COM_PS_NEAREST);
-				offset4 += num_channels;
+			for (x = x1; x < x2; x += COM_ROW_LENGTH) {
+				const int length = min(x2 - x, COM_ROW_LENGTH);
+				if (num_channels == COM_NUM_CHANNELS_COLOR) {
+					this->m_input->readRow(&(buffer[offset4]), x, y, length);
+				}
+				else {
+					this->m_input->readRow(row, x, y, length);
+					for (int i = 0; i < length; i++) {
+						memcpy(&(buffer[offset4 + i * num_channels]), &row[i * COM_NUM_CHANNELS_COLOR], sizeof(float) * num_channels);
+					}
+				}
+				offset4 += length * num_channels;
 			}
 			if (isBreaked()) {
 				breaked = true;
@@ -769,6 +769,7 @@ static void rna_def_render_pass(BlenderRNA *brna)
 
 	static EnumPropertyItem render_pass_debug_type_items[] = {
 		{RENDER_PASS_DEBUG_BVH_TRAVERSAL_STEPS, "BVH_TRAVERSAL_STEPS", 0, "BVH Traversal Steps", ""},
+		{RENDER_PASS_DEBUG_RENDER_TIME, "RENDER_TIME", 0, "Render Time", ""},
 		{0, NULL, 0, NULL, NULL}
 	};
 
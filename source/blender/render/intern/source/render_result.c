@@ -531,6 +531,8 @@ static const char *debug_pass_type_name_get(int debug_type)
 	switch (debug_type) {
 		case RENDER_PASS_DEBUG_BVH_TRAVERSAL_STEPS:
 			return "BVH Traversal Steps";
+		case RENDER_PASS_DEBUG_RENDER_TIME:
+			return "Render Time";
 	}
 	return "Unknown";
 }
@@ -704,6 +706,8 @@ RenderResult *render_result_new(Render *re, rcti *partrct, int crop, int savebuf
 			if (BKE_scene_use_new_shading_nodes(re->scene)) {
 				render_layer_add_debug_pass(rr, rl, 1, SCE_PASS_DEBUG,
 				        RENDER_PASS_DEBUG_BVH_TRAVERSAL_STEPS, view);
+				render_layer_add_debug_pass(rr, rl, 1, SCE_PASS_DEBUG,
+				        RENDER_PASS_DEBUG_RENDER_TIME, view);
 			}
 #endif
 		}
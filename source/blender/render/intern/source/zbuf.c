@@ -43,6 +43,7 @@
 #include "BLI_math.h"
 #include "BLI_blenlib.h"
 #include "BLI_jitter.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 #include "BLI_utildefines.h"
 
@@ -2658,7 +2659,9 @@ typedef struct DrawBufPixel {
 } DrawBufPixel;
 
 
-static void zbuf_fill_in_rgba(ZSpan *zspan, DrawBufPixel *col, float *v1, float *v2, float *v3, float *v4)
+/* only rows miny to maxy are written, the other rows are stepped over so the result
+ * is exactly the same as when the whole quad is filled in */
+static void zbuf_fill_in_rgba(ZSpan *zspan, DrawBufPixel *col, float *v1, float *v2, float *v3, float *v4, int miny, int maxy)
 {
 	DrawBufPixel *rectpofs, *rp;
 	double zxd, zyd, zy0, zverg;
@@ -2686,6 +2689,7 @@ static void zbuf_fill_in_rgba(ZSpan *zspan, DrawBufPixel *col, float *v1, float
 	
 	//	printf("my %d %d\n", my0, my2);
 	if (my2<my0) return;
+	if (my2<miny || my0>maxy) return;
 	
 	/* ZBUF DX DY, in floats still */
 	x1= v1[0]- v2[0];
@@ -2722,30 +2726,32 @@ static void zbuf_fill_in_rgba(ZSpan *zspan, DrawBufPixel *col, float *v1, float
 		span2= zspan->span1+my2;
 	}
 	
-	for (y=my2; y>=my0; y--, span1--, span2--) {
-		
-		sn1= floor(*span1);
-		sn2= floor(*span2);
-		sn1++; 
-		
-		if (sn2>=rectx) sn2= rectx-1;
-		if (sn1<0) sn1= 0;
+	for (y=my2; y>=my0 && y>=miny; y--, span1--, span2--) {
 		
-		if (sn2>=sn1) {
-			zverg= (double)sn1*zxd + zy0;
-			rz= rectzofs+sn1;
-			rp= rectpofs+sn1;
-			x= sn2-sn1;
+		if (y<=maxy) {
+			sn1= floor(*span1);
+			sn2= floor(*span2);
+			sn1++; 
 			
-			while (x>=0) {
-				if (zverg < (double)*rz) {
-					*rz= zverg;
-					*rp= *col;
+			if (sn2>=rectx) sn2= rectx-1;
+			if (sn1<0) sn1= 0;
+			
+			if (sn2>=sn1) {
+				zverg= (double)sn1*zxd + zy0;
+				rz= rectzofs+sn1;
+				rp= rectpofs+sn1;
+				x= sn2-sn1;
+				
+				while (x>=0) {
+					if (zverg < (double)*rz) {
+						*rz= zverg;
+						*rp= *col;
+					}
+					zverg+= zxd;
+					rz++; 
+					rp++; 
+					x--;
 				}
-				zverg+= zxd;
-				rz++; 
-				rp++; 
-				x--;
 			}
 		}
 		
@@ -2883,33 +2889,188 @@ static void set_quad_bezier_ipo(float fac, float *data)
 	data[2]= fac*fac;
 }
 
-void RE_zbuf_accumulate_vecblur(NodeBlurData *nbd, int xsize, int ysize, float *newrect, float *imgrect, float *vecbufrect, float *zbufrect)
+typedef struct VecBlurBandData {
+	NodeBlurData *nbd;
+	int xsize, ysize, samples, band_size;
+	float *newrect, *imgrect, *zbufrect, *rectvz;
+	float *rectz, *rectweight, *rectmax;
+	DrawBufPixel *rectdraw;
+	char *rectmove;
+	int *rowmin, *rowmax;
+	float (*jit)[2];
+} VecBlurBandData;
+
+/* accumulate and blend a band of rows. every band draws all quads that can reach it, in the
+ * same order as for the whole image, but only fills in its own rows of the shared buffers */
+static void vecblur_band(TaskPool * __restrict pool, void *taskdata, int UNUSED(threadid))
 {
+	VecBlurBandData *data= BLI_task_pool_userdata(pool);
+	NodeBlurData *nbd= data->nbd;
 	ZSpan zspan;
-	DrawBufPixel *rectdraw, *dr;
-	static float jit[256][2];
+	DrawBufPixel *rectdraw= data->rectdraw, *dr;
 	float v1[3], v2[3], v3[3], v4[3], fx, fy;
-	float *rectvz, *dvz, *dimg, *dvec1, *dvec2, *dz, *dz1, *dz2, *rectz;
-	float *minvecbufrect= NULL, *rectweight, *rw, *rectmax, *rm, *ro;
-	float maxspeedsq= (float)nbd->maxspeed*nbd->maxspeed;
-	int y, x, step, maxspeed=nbd->maxspeed, samples= nbd->samples;
-	int tsktsk= 0;
-	static int firsttime= 1;
-	char *rectmove, *dm;
+	float *dimg, *dz, *dz1, *dz2, *rectz= data->rectz, *rw, *rm, *ro;
+	int xsize= data->xsize, ysize= data->ysize, samples= data->samples;
+	int miny= GET_INT_FROM_POINTER(taskdata)*data->band_size;
+	int maxy= min_ii(miny + data->band_size, ysize) - 1;
+	int ofs= miny*xsize, tot= (maxy - miny + 1)*xsize;
+	int y, x, step;
+	char *rectmove= data->rectmove, *dm;
 	
 	zbuf_alloc_span(&zspan, xsize, ysize, 1.0f);
 	zspan.zmulx=  ((float)xsize)/2.0f;
 	zspan.zmuly=  ((float)ysize)/2.0f;
 	zspan.zofsx= 0.0f;
 	zspan.zofsy= 0.0f;
+	zspan.rectz= (int *)rectz;
+	zspan.rectp= (int *)rectdraw;
+	
+	for (step= 1; step<=samples; step++) {
+		float speedfac= 0.5f*nbd->fac*(float)step/(float)(samples+1);
+		int side;
+		
+		for (side=0; side<2; side++) {
+			float blendfac, ipodata[4];
+			
+			/* clear zbuf, if we draw future we fill in not moving pixels */
+			for (x= ofs+tot-1; x>=ofs; x--) {
+				if (rectmove[x]==0)
+					rectz[x]= data->zbufrect[x];
+				else
+					rectz[x]= 10e16;
+			}
+			
+			/* clear drawing buffer */
+			for (x= ofs+tot-1; x>=ofs; x--) rectdraw[x].colpoin= NULL;
+			
+			if (side) {
+				speedfac= -speedfac;
+			}
+			
+			set_quad_bezier_ipo(0.5f + 0.5f*speedfac, ipodata);
+			
+			for (fy= -0.5f+data->jit[step & 255][0], y=0; y<ysize; y++, fy+=1.0f) {
+				/* none of the quads of this row reach the band */
+				if (data->rowmax[y]<miny || data->rowmin[y]>maxy)
+					continue;
+				
+				dimg= data->imgrect + 4*y*xsize;
+				dm= rectmove + y*xsize;
+				dz= data->zbufrect + y*xsize;
+				dz1= data->rectvz + 4*y*(xsize + 1);
+				dz2= dz1 + 4*(xsize + 1);
+				
+				if (side && nbd->curved==0) {
+					dz1+= 2;
+					dz2+= 2;
+				}
+				
+				for (fx= -0.5f+data->jit[step & 255][1], x=0; x<xsize; x++, fx+=1.0f, dimg+=4, dz1+=4, dz2+=4, dm++, dz++) {
+					if (*dm>1) {
+						float jfx = fx + 0.5f;
+						float jfy = fy + 0.5f;
+						DrawBufPixel col;
+						
+						/* make vertices */
+						if (nbd->curved) {	/* curved */
+							quad_bezier_2d(v1, dz1, dz1+2, ipodata);
+							v1[0]+= jfx; v1[1]+= jfy; v1[2]= *dz;
+
+							quad_bezier_2d(v2, dz1+4, dz1+4+2, ipodata);
+							v2[0]+= jfx+1.0f; v2[1]+= jfy; v2[2]= *dz;
+
+							quad_bezier_2d(v3, dz2+4, dz2+4+2, ipodata);
+							v3[0]+= jfx+1.0f; v3[1]+= jfy+1.0f; v3[2]= *dz;
+							
+							quad_bezier_2d(v4, dz2, dz2+2, ipodata);
+							v4[0]+= jfx; v4[1]+= jfy+1.0f; v4[2]= *dz;
+						}
+						else {
+							v1[0]= speedfac*dz1[0]+jfx;			v1[1]= speedfac*dz1[1]+jfy;			v1[2]= *dz;
+							v2[0]= speedfac*dz1[4]+jfx+1.0f;		v2[1]= speedfac*dz1[5]+jfy;			v2[2]= *dz;
+							v3[0]= speedfac*dz2[4]+jfx+1.0f;		v3[1]= speedfac*dz2[5]+jfy+1.0f;		v3[2]= *dz;
+							v4[0]= speedfac*dz2[0]+jfx;			v4[1]= speedfac*dz2[1]+jfy+1.0f;		v4[2]= *dz;
+						}
+						if (*dm==255) col.alpha= 1.0f;
+						else if (*dm<2) col.alpha= 0.0f;
+						else col.alpha= ((float)*dm)/255.0f;
+						col.colpoin= dimg;
+
+						zbuf_fill_in_rgba(&zspan, &col, v1, v2, v3, v4, miny, maxy);
+					}
+				}
+			}
+
+			/* blend with a falloff. this fixes the ugly effect you get with
+			 * a fast moving object. then it looks like a solid object overlayed
+			 * over a very transparent moving version of itself. in reality, the
+			 * whole object should become transparent if it is moving fast, be
+			 * we don't know what is behind it so we don't do that. this hack
+			 * overestimates the contribution of foreground pixels but looks a
+			 * bit better without a sudden cutoff. */
+			blendfac= ((samples - step)/(float)samples);
+			/* smoothstep to make it look a bit nicer as well */
+			blendfac= 3.0f*pow(blendfac, 2.0f) - 2.0f*pow(blendfac, 3.0f);
+
+			/* accum */
+			rw= data->rectweight + ofs;
+			rm= data->rectmax + ofs;
+			for (dr= rectdraw + ofs, dz2= data->newrect + 4*ofs, x= tot-1; x>=0; x--, dr++, dz2+=4, rw++, rm++) {
+				if (dr->colpoin) {
+					float bfac= dr->alpha*blendfac;
+					
+					dz2[0] += bfac*dr->colpoin[0];
+					dz2[1] += bfac*dr->colpoin[1];
+					dz2[2] += bfac*dr->colpoin[2];
+					dz2[3] += bfac*dr->colpoin[3];
+
+					*rw += bfac;
+					*rm= MAX2(*rm, bfac);
+				}
+			}
+		}
+	}
+	
+	/* blend between original images and accumulated image */
+	rw= data->rectweight + ofs;
+	rm= data->rectmax + ofs;
+	ro= data->imgrect + 4*ofs;
+	for (dz2= data->newrect + 4*ofs, x= tot-1; x>=0; x--, dz2+=4, ro+=4, rw++, rm++) {
+		float mfac = *rm;
+		float fac = (*rw == 0.0f)? 0.0f: mfac/(*rw);
+		float nfac = 1.0f - mfac;
+
+		dz2[0]= fac*dz2[0] + nfac*ro[0];
+		dz2[1]= fac*dz2[1] + nfac*ro[1];
+		dz2[2]= fac*dz2[2] + nfac*ro[2];
+		dz2[3]= fac*dz2[3] + nfac*ro[3];
+	}
+	
+	zbuf_free_span(&zspan);
+}
+
+void RE_zbuf_accumulate_vecblur(NodeBlurData *nbd, int xsize, int ysize, float *newrect, float *imgrect, float *vecbufrect, float *zbufrect)
+{
+	VecBlurBandData data;
+	TaskScheduler *task_scheduler;
+	TaskPool *task_pool;
+	DrawBufPixel *rectdraw;
+	static float jit[256][2];
+	float *rectvz, *dvz, *dvec1, *dvec2, *dz1, *dz2, *rectz, *rowspeed;
+	float *minvecbufrect= NULL, *rectweight, *rectmax;
+	float maxspeedsq= (float)nbd->maxspeed*nbd->maxspeed;
+	float maxfac= 0.0f;
+	int y, x, step, maxspeed=nbd->maxspeed, samples= nbd->samples;
+	int *rowmin, *rowmax, band, totband;
+	int tsktsk= 0;
+	static int firsttime= 1;
+	char *rectmove, *dm;
 	
 	/* the buffers */
 	rectz= MEM_mapallocN(sizeof(float)*xsize*ysize, "zbuf accum");
-	zspan.rectz= (int *)rectz;
 	
 	rectmove= MEM_mapallocN(xsize*ysize, "rectmove");
 	rectdraw= MEM_mapallocN(sizeof(DrawBufPixel)*xsize*ysize, "rect draw");
-	zspan.rectp= (int *)rectdraw;
 
 	rectweight= MEM_mapallocN(sizeof(float)*xsize*ysize, "rect weight");
 	rectmax= MEM_mapallocN(sizeof(float)*xsize*ysize, "rect max");
@@ -3068,127 +3229,74 @@ void RE_zbuf_accumulate_vecblur(NodeBlurData *nbd, int xsize, int ysize, float *
 
 	/* accumulate */
 	samples/= 2;
+	
+	/* the largest factor the speed vectors are scaled with, for the linear and the curved vertices */
 	for (step= 1; step<=samples; step++) {
 		float speedfac= 0.5f*nbd->fac*(float)step/(float)(samples+1);
+		float ipodata[4];
 		int side;
 		
-		for (side=0; side<2; side++) {
-			float blendfac, ipodata[4];
-			
-			/* clear zbuf, if we draw future we fill in not moving pixels */
-			if (0)
-				for (x= xsize*ysize-1; x>=0; x--) rectz[x]= 10e16;
-			else 
-				for (x= xsize*ysize-1; x>=0; x--) {
-					if (rectmove[x]==0)
-						rectz[x]= zbufrect[x];
-					else
-						rectz[x]= 10e16;
-				}
-			
-			/* clear drawing buffer */
-			for (x= xsize*ysize-1; x>=0; x--) rectdraw[x].colpoin= NULL;
-			
-			dimg= imgrect;
-			dm= rectmove;
-			dz= zbufrect;
-			dz1= rectvz;
-			dz2= rectvz + 4*(xsize + 1);
-			
-			if (side) {
-				if (nbd->curved==0) {
-					dz1+= 2;
-					dz2+= 2;
-				}
-				speedfac= -speedfac;
-			}
-			
+		for (side=0; side<2; side++, speedfac= -speedfac) {
 			set_quad_bezier_ipo(0.5f + 0.5f*speedfac, ipodata);
-			
-			for (fy= -0.5f+jit[step & 255][0], y=0; y<ysize; y++, fy+=1.0f) {
-				for (fx= -0.5f+jit[step & 255][1], x=0; x<xsize; x++, fx+=1.0f, dimg+=4, dz1+=4, dz2+=4, dm++, dz++) {
-					if (*dm>1) {
-						float jfx = fx + 0.5f;
-						float jfy = fy + 0.5f;
-						DrawBufPixel col;
-						
-						/* make vertices */
-						if (nbd->curved) {	/* curved */
-							quad_bezier_2d(v1, dz1, dz1+2, ipodata);
-							v1[0]+= jfx; v1[1]+= jfy; v1[2]= *dz;
-
-							quad_bezier_2d(v2, dz1+4, dz1+4+2, ipodata);
-							v2[0]+= jfx+1.0f; v2[1]+= jfy; v2[2]= *dz;
-
-							quad_bezier_2d(v3, dz2+4, dz2+4+2, ipodata);
-							v3[0]+= jfx+1.0f; v3[1]+= jfy+1.0f; v3[2]= *dz;
-							
-							quad_bezier_2d(v4, dz2, dz2+2, ipodata);
-							v4[0]+= jfx; v4[1]+= jfy+1.0f; v4[2]= *dz;
-						}
-						else {
-							v1[0]= speedfac*dz1[0]+jfx;			v1[1]= speedfac*dz1[1]+jfy;			v1[2]= *dz;
-							v2[0]= speedfac*dz1[4]+jfx+1.0f;		v2[1]= speedfac*dz1[5]+jfy;			v2[2]= *dz;
-							v3[0]= speedfac*dz2[4]+jfx+1.0f;		v3[1]= speedfac*dz2[5]+jfy+1.0f;		v3[2]= *dz;
-							v4[0]= speedfac*dz2[0]+jfx;			v4[1]= speedfac*dz2[1]+jfy+1.0f;		v4[2]= *dz;
-						}
-						if (*dm==255) col.alpha= 1.0f;
-						else if (*dm<2) col.alpha= 0.0f;
-						else col.alpha= ((float)*dm)/255.0f;
-						col.colpoin= dimg;
-
-						zbuf_fill_in_rgba(&zspan, &col, v1, v2, v3, v4);
-					}
-				}
-				dz1+=4;
-				dz2+=4;
-			}
-
-			/* blend with a falloff. this fixes the ugly effect you get with
-			 * a fast moving object. then it looks like a solid object overlayed
-			 * over a very transparent moving version of itself. in reality, the
-			 * whole object should become transparent if it is moving fast, be
-			 * we don't know what is behind it so we don't do that. this hack
-			 * overestimates the contribution of foreground pixels but looks a
-			 * bit better without a sudden cutoff. */
-			blendfac= ((samples - step)/(float)samples);
-			/* smoothstep to make it look a bit nicer as well */
-			blendfac= 3.0f*pow(blendfac, 2.0f) - 2.0f*pow(blendfac, 3.0f);
-
-			/* accum */
-			rw= rectweight;
-			rm= rectmax;
-			for (dr= rectdraw, dz2=newrect, x= xsize*ysize-1; x>=0; x--, dr++, dz2+=4, rw++, rm++) {
-				if (dr->colpoin) {
-					float bfac= dr->alpha*blendfac;
-					
-					dz2[0] += bfac*dr->colpoin[0];
-					dz2[1] += bfac*dr->colpoin[1];
-					dz2[2] += bfac*dr->colpoin[2];
-					dz2[3] += bfac*dr->colpoin[3];
-
-					*rw += bfac;
-					*rm= MAX2(*rm, bfac);
-				}
-			}
+			maxfac= max_ff(maxfac, fabsf(speedfac));
+			maxfac= max_ff(maxfac, fabsf(ipodata[0]) + fabsf(ipodata[1]) + fabsf(ipodata[2]));
 		}
 	}
 	
-	/* blend between original images and accumulated image */
-	rw= rectweight;
-	rm= rectmax;
-	ro= imgrect;
-	dm= rectmove;
-	for (dz2=newrect, x= xsize*ysize-1; x>=0; x--, dz2+=4, ro+=4, rw++, rm++, dm++) {
-		float mfac = *rm;
-		float fac = (*rw == 0.0f)? 0.0f: mfac/(*rw);
-		float nfac = 1.0f - mfac;
-
-		dz2[0]= fac*dz2[0] + nfac*ro[0];
-		dz2[1]= fac*dz2[1] + nfac*ro[1];
-		dz2[2]= fac*dz2[2] + nfac*ro[2];
-		dz2[3]= fac*dz2[3] + nfac*ro[3];
+	/* rows that the quads of a row of pixels can reach, so bands can skip the other rows */
+	rowspeed= MEM_mallocN(sizeof(float)*(ysize+1), "vecblur row speed");
+	rowmin= MEM_mallocN(sizeof(int)*ysize, "vecblur row min");
+	rowmax= MEM_mallocN(sizeof(int)*ysize, "vecblur row max");
+	for (dvz= rectvz, y=0; y<=ysize; y++) {
+		rowspeed[y]= 0.0f;
+		for (x= 4*(xsize+1); x>0; x-=2, dvz+=2) {
+			float speed= fabsf(dvz[1]);
+			/* invalid speeds reach all rows */
+			if (!(speed < FLT_MAX)) speed= FLT_MAX;
+			rowspeed[y]= max_ff(rowspeed[y], speed);
+		}
+	}
+	for (y=0; y<ysize; y++) {
+		float reach= maxfac*max_ff(rowspeed[y], rowspeed[y+1]);
+		
+		if (reach < (float)ysize) {
+			rowmin[y]= (int)floorf((float)y - reach) - 2;
+			rowmax[y]= (int)ceilf((float)y + 2.0f + reach) + 2;
+		}
+		else {
+			rowmin[y]= 0;
+			rowmax[y]= ysize;
+		}
 	}
+	
+	/* bands of rows are independent, they are accumulated in parallel */
+	task_scheduler= BLI_task_scheduler_get();
+	task_pool= BLI_task_pool_create(task_scheduler, &data);
+	
+	data.nbd= nbd;
+	data.xsize= xsize;
+	data.ysize= ysize;
+	data.samples= samples;
+	data.band_size= max_ii(16, ysize/(4*BLI_task_scheduler_num_threads(task_scheduler)) + 1);
+	data.newrect= newrect;
+	data.imgrect= imgrect;
+	data.zbufrect= zbufrect;
+	data.rectvz= rectvz;
+	data.rectz= rectz;
+	data.rectweight= rectweight;
+	data.rectmax= rectmax;
+	data.rectdraw= rectdraw;
+	data.rectmove= rectmove;
+	data.rowmin= rowmin;
+	data.rowmax= rowmax;
+	data.jit= jit;
+	
+	totband= (ysize + data.band_size - 1)/data.band_size;
+	for (band= 0; band<totband; band++)
+		BLI_task_pool_push(task_pool, vecblur_band, SET_INT_IN_POINTER(band), false, TASK_PRIORITY_HIGH);
+	
+	BLI_task_pool_work_and_wait(task_pool);
+	BLI_task_pool_free(task_pool);
 
 	MEM_freeN(rectz);
 	MEM_freeN(rectmove);
@@ -3196,8 +3304,10 @@ void RE_zbuf_accumulate_vecblur(NodeBlurData *nbd, int xsize, int ysize, float *
 	MEM_freeN(rectvz);
 	MEM_freeN(rectweight);
 	MEM_freeN(rectmax);
+	MEM_freeN(rowspeed);
+	MEM_freeN(rowmin);
+	MEM_freeN(rowmax);
 	if (minvecbufrect) MEM_freeN(vecbufrect);  /* rects were swapped! */
-	zbuf_free_span(&zspan);
 }
 
 /* ******************** ABUF ************************* */
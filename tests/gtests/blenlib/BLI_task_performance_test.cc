@@ -0,0 +1,150 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "BLI_utildefines.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "MEM_guardedalloc.h"
+#include "PIL_time.h"
+
+#include "atomic_ops.h"
+}
+
+/* Scaling of the task scheduler with the number of threads, for tasks with
+ * very little work each, which is where scheduling overhead dominates. */
+
+#define NUM_TASKS 100000
+#define FANOUT_DEPTH 16
+#define WORK_ITERATIONS 100
+
+/* Task pools rely on the threaded malloc lock from the threading API. */
+static TaskScheduler *task_test_scheduler_create(int num_threads)
+{
+	BLI_threadapi_init();
+	return BLI_task_scheduler_create(num_threads);
+}
+
+typedef struct TaskPerfData {
+	size_t num_runs;
+} TaskPerfData;
+
+static void task_perf_work(void)
+{
+	volatile float value = 0.0f;
+	int i;
+
+	for (i = 0; i < WORK_ITERATIONS; i++) {
+		value += 1.0f;
+	}
+}
+
+static void task_perf_run(TaskPool *__restrict pool, void *UNUSED(taskdata), int UNUSED(threadid))
+{
+	TaskPerfData *data = (TaskPerfData *)BLI_task_pool_userdata(pool);
+
+	task_perf_work();
+	atomic_add_z(&data->num_runs, 1);
+}
+
+/* Binary tree of tasks, every task pushes its children like the dependency
+ * graph evaluation does. */
+static void task_perf_fanout_run(TaskPool *__restrict pool, void *taskdata, int UNUSED(threadid))
+{
+	TaskPerfData *data = (TaskPerfData *)BLI_task_pool_userdata(pool);
+	int depth = GET_INT_FROM_POINTER(taskdata);
+
+	task_perf_work();
+	atomic_add_z(&data->num_runs, 1);
+
+	if (depth < FANOUT_DEPTH) {
+		BLI_task_pool_push(pool, task_perf_fanout_run, SET_INT_IN_POINTER(depth + 1), false, TASK_PRIORITY_LOW);
+		BLI_task_pool_push(pool, task_perf_fanout_run, SET_INT_IN_POINTER(depth + 1), false, TASK_PRIORITY_LOW);
+	}
+}
+
+static void task_perf_flat(int num_threads)
+{
+	TaskScheduler *scheduler = task_test_scheduler_create(num_threads);
+	TaskPerfData data = {0};
+	TaskPool *pool = BLI_task_pool_create(scheduler, &data);
+	double time_start = PIL_check_seconds_timer();
+	int i;
+
+	for (i = 0; i < NUM_TASKS; i++) {
+		BLI_task_pool_push(pool, task_perf_run, NULL, false, TASK_PRIORITY_LOW);
+	}
+	BLI_task_pool_work_and_wait(pool);
+
+	printf("Flat pool, %2d threads: %f sec\n", num_threads, PIL_check_seconds_timer() - time_start);
+	EXPECT_EQ((size_t)NUM_TASKS, data.num_runs);
+
+	BLI_task_pool_free(pool);
+	BLI_task_scheduler_free(scheduler);
+}
+
+static void task_perf_fanout(int num_threads)
+{
+	TaskScheduler *scheduler = task_test_scheduler_create(num_threads);
+	TaskPerfData data = {0};
+	TaskPool *pool = BLI_task_pool_create(scheduler, &data);
+	double time_start = PIL_check_seconds_timer();
+
+	BLI_task_pool_push(pool, task_perf_fanout_run, SET_INT_IN_POINTER(0), false, TASK_PRIORITY_LOW);
+	BLI_task_pool_work_and_wait(pool);
+
+	printf("Fan-out pool, %2d threads: %f sec\n", num_threads, PIL_check_seconds_timer() - time_start);
+	EXPECT_EQ((size_t)((1 << (FANOUT_DEPTH + 1)) - 1), data.num_runs);
+
+	BLI_task_pool_free(pool);
+	BLI_task_scheduler_free(scheduler);
+}
+
+static void task_perf_range_func(void *userdata, int UNUSED(iter))
+{
+	TaskPerfData *data = (TaskPerfData *)userdata;
+
+	task_perf_work();
+	atomic_add_z(&data->num_runs, 1);
+}
+
+TEST(task, FlatPoolScaling)
+{
+	int max_threads = BLI_system_thread_count();
+	int num_threads;
+
+	for (num_threads = 1; num_threads < max_threads; num_threads *= 2) {
+		task_perf_flat(num_threads);
+	}
+	task_perf_flat(max_threads);
+}
+
+TEST(task, FanoutPoolScaling)
+{
+	int max_threads = BLI_system_thread_count();
+	int num_threads;
+
+	for (num_threads = 1; num_threads < max_threads; num_threads *= 2) {
+		task_perf_fanout(num_threads);
+	}
+	task_perf_fanout(max_threads);
+}
+
+TEST(task, ParallelRange)
+{
+	TaskPerfData data = {0};
+	double time_start;
+
+	BLI_threadapi_init();
+
+	time_start = PIL_check_seconds_timer();
+	BLI_task_parallel_range_ex(0, NUM_TASKS, &data, task_perf_range_func, 0, true);
+	printf("Parallel range, %2d threads: %f sec\n",
+	       BLI_task_scheduler_num_threads(BLI_task_scheduler_get()),
+	       PIL_check_seconds_timer() - time_start);
+
+	EXPECT_EQ((size_t)NUM_TASKS, data.num_runs);
+
+	BLI_threadapi_exit();
+}
@@ -0,0 +1,233 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "BLI_utildefines.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "MEM_guardedalloc.h"
+#include "PIL_time.h"
+
+#include "atomic_ops.h"
+}
+
+#define NUM_THREADS 4
+#define NUM_TASKS 10000
+
+static TaskScheduler *nested_scheduler = NULL;
+
+/* Task pools rely on the threaded malloc lock from the threading API. */
+static TaskScheduler *task_test_scheduler_create(int num_threads)
+{
+	BLI_threadapi_init();
+	return BLI_task_scheduler_create(num_threads);
+}
+
+/* Counts every run, optionally pushing more tasks from inside the task. */
+typedef struct TaskTestData {
+	size_t num_runs;
+	int depth;
+} TaskTestData;
+
+static void task_count_run(TaskPool *__restrict pool, void *UNUSED(taskdata), int UNUSED(threadid))
+{
+	TaskTestData *data = (TaskTestData *)BLI_task_pool_userdata(pool);
+	atomic_add_z(&data->num_runs, 1);
+}
+
+static void task_fanout_run(TaskPool *__restrict pool, void *taskdata, int UNUSED(threadid))
+{
+	TaskTestData *data = (TaskTestData *)BLI_task_pool_userdata(pool);
+	int depth = GET_INT_FROM_POINTER(taskdata);
+
+	atomic_add_z(&data->num_runs, 1);
+
+	if (depth < data->depth) {
+		BLI_task_pool_push(pool, task_fanout_run, SET_INT_IN_POINTER(depth + 1), false, TASK_PRIORITY_LOW);
+		BLI_task_pool_push(pool, task_fanout_run, SET_INT_IN_POINTER(depth + 1), false, TASK_PRIORITY_HIGH);
+	}
+}
+
+static void task_nested_pool_run(TaskPool *__restrict pool, void *UNUSED(taskdata), int UNUSED(threadid))
+{
+	TaskTestData *data = (TaskTestData *)BLI_task_pool_userdata(pool);
+	TaskTestData nested_data = {0, 0};
+	TaskPool *nested_pool = BLI_task_pool_create(nested_scheduler, &nested_data);
+	int i;
+
+	for (i = 0; i < 100; i++) {
+		BLI_task_pool_push(nested_pool, task_count_run, NULL, false, TASK_PRIORITY_LOW);
+	}
+
+	BLI_task_pool_work_and_wait(nested_pool);
+	BLI_task_pool_free(nested_pool);
+
+	atomic_add_z(&data->num_runs, nested_data.num_runs);
+}
+
+TEST(task, PoolPush)
+{
+	TaskScheduler *scheduler = task_test_scheduler_create(NUM_THREADS);
+	TaskTestData data = {0, 0};
+	TaskPool *pool = BLI_task_pool_create(scheduler, &data);
+	int i;
+
+	for (i = 0; i < NUM_TASKS; i++) {
+		BLI_task_pool_push(pool, task_count_run, NULL, false, (i % 2) ? TASK_PRIORITY_HIGH : TASK_PRIORITY_LOW);
+	}
+
+	BLI_task_pool_work_and_wait(pool);
+
+	EXPECT_EQ((size_t)NUM_TASKS, data.num_runs);
+	EXPECT_EQ((size_t)NUM_TASKS, BLI_task_pool_tasks_done(pool));
+
+	BLI_task_pool_free(pool);
+	BLI_task_scheduler_free(scheduler);
+}
+
+TEST(task, PoolPushFromTask)
+{
+	TaskScheduler *scheduler = task_test_scheduler_create(NUM_THREADS);
+	TaskTestData data = {0, 14};
+	TaskPool *pool = BLI_task_pool_create(scheduler, &data);
+
+	BLI_task_pool_push(pool, task_fanout_run, SET_INT_IN_POINTER(0), false, TASK_PRIORITY_LOW);
+	BLI_task_pool_work_and_wait(pool);
+
+	/* Full binary tree of tasks. */
+	EXPECT_EQ((size_t)((1 << (data.depth + 1)) - 1), data.num_runs);
+
+	BLI_task_pool_free(pool);
+	BLI_task_scheduler_free(scheduler);
+}
+
+TEST(task, PoolNested)
+{
+	TaskScheduler *scheduler = task_test_scheduler_create(NUM_THREADS);
+	TaskTestData data = {0, 0};
+	TaskPool *pool = BLI_task_pool_create(scheduler, &data);
+	int i;
+
+	nested_scheduler = scheduler;
+
+	for (i = 0; i < 100; i++) {
+		BLI_task_pool_push(pool, task_nested_pool_run, NULL, false, TASK_PRIORITY_LOW);
+	}
+
+	BLI_task_pool_work_and_wait(pool);
+
+	EXPECT_EQ((size_t)(100 * 100), data.num_runs);
+
+	BLI_task_pool_free(pool);
+	BLI_task_scheduler_free(scheduler);
+}
+
+TEST(task, PoolNumThreads)
+{
+	TaskScheduler *scheduler = task_test_scheduler_create(NUM_THREADS);
+	TaskTestData data = {0, 10};
+	TaskPool *pool = BLI_task_pool_create(scheduler, &data);
+
+	BLI_pool_set_num_threads(pool, 1);
+
+	BLI_task_pool_push(pool, task_fanout_run, SET_INT_IN_POINTER(0), false, TASK_PRIORITY_LOW);
+	BLI_task_pool_work_and_wait(pool);
+
+	EXPECT_EQ((size_t)((1 << (data.depth + 1)) - 1), data.num_runs);
+
+	BLI_task_pool_free(pool);
+	BLI_task_scheduler_free(scheduler);
+}
+
+TEST(task, PoolSingleThread)
+{
+	TaskScheduler *scheduler = task_test_scheduler_create(TASK_SCHEDULER_SINGLE_THREAD);
+	TaskTestData data = {0, 10};
+	TaskPool *pool = BLI_task_pool_create(scheduler, &data);
+
+	EXPECT_EQ(1, BLI_task_scheduler_num_threads(scheduler));
+
+	BLI_task_pool_push(pool, task_fanout_run, SET_INT_IN_POINTER(0), false, TASK_PRIORITY_LOW);
+	BLI_task_pool_work_and_wait(pool);
+
+	EXPECT_EQ((size_t)((1 << (data.depth + 1)) - 1), data.num_runs);
+
+	BLI_task_pool_free(pool);
+	BLI_task_scheduler_free(scheduler);
+}
+
+/* Blocks until the pool is canceled, so only the tasks already running when
+ * canceling can finish. */
+typedef struct TaskCancelData {
+	size_t num_runs;
+	size_t num_running;
+} TaskCancelData;
+
+static void task_wait_cancel_run(TaskPool *__restrict pool, void *UNUSED(taskdata), int UNUSED(threadid))
+{
+	TaskCancelData *data = (TaskCancelData *)BLI_task_pool_userdata(pool);
+
+	atomic_add_z(&data->num_running, 1);
+	while (!BLI_task_pool_canceled(pool)) {
+		PIL_sleep_ms(1);
+	}
+	atomic_add_z(&data->num_runs, 1);
+	atomic_sub_z(&data->num_running, 1);
+}
+
+TEST(task, PoolCancel)
+{
+	TaskScheduler *scheduler = task_test_scheduler_create(NUM_THREADS);
+	TaskCancelData data = {0, 0};
+	TaskPool *pool = BLI_task_pool_create(scheduler, &data);
+	int i;
+
+	for (i = 0; i < NUM_TASKS; i++) {
+		int *taskdata = (int *)MEM_mallocN(sizeof(int), __func__);
+		BLI_task_pool_push(pool, task_wait_cancel_run, taskdata, true, TASK_PRIORITY_LOW);
+	}
+
+	BLI_task_pool_cancel(pool);
+
+	/* no task is running anymore once cancel returns */
+	EXPECT_EQ((size_t)0, data.num_running);
+	size_t num_runs = data.num_runs;
+	PIL_sleep_ms(10);
+	EXPECT_EQ(num_runs, data.num_runs);
+	EXPECT_EQ((size_t)0, data.num_running);
+
+	/* only the tasks running on the worker threads were not skipped */
+	EXPECT_LT(data.num_runs, (size_t)NUM_TASKS);
+	EXPECT_GE((size_t)NUM_THREADS, data.num_runs);
+	EXPECT_EQ((size_t)NUM_TASKS, BLI_task_pool_tasks_done(pool));
+	EXPECT_FALSE(BLI_task_pool_canceled(pool));
+
+	BLI_task_pool_free(pool);
+	BLI_task_scheduler_free(scheduler);
+}
+
+static void parallel_range_func(void *userdata, int iter)
+{
+	int *values = (int *)userdata;
+	values[iter] = iter;
+}
+
+TEST(task, ParallelRange)
+{
+	const int num_items = 100000;
+	int *values = (int *)MEM_callocN(sizeof(int) * num_items, __func__);
+	int i;
+
+	BLI_threadapi_init();
+
+	BLI_task_parallel_range_ex(0, num_items, values, parallel_range_func, 0, true);
+
+	for (i = 0; i < num_items; i++) {
+		EXPECT_EQ(i, values[i]);
+	}
+
+	MEM_freeN(values);
+
+	BLI_threadapi_exit();
+}